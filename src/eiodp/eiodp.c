@@ -1,1004 +1,5365 @@
-/*
-    文件名：eiodp.c
-    作者：zouzhiqiang
-
-    说明：
-                                《嵌入式通用io数据协议框架》
-    通过制定一套协议框架，让用户快速实现主从设备的交互，尤其是让从设备能够轻松构建服务响应（类似http）
-    框架适用于所有支持标准io（read write）的通讯类型。可以在eiodp_config.h中配置相关接口。
-
-    数据包协议通过一个头帧+包类型来确定一个数据包。头帧为2字节：0xeb90,包类型也占2字节。而数据包尾则占
-    4个字节。包尾根据不同的包类型来确定内容：固定尾帧、校验和、crc32。
-
-    框架会开启一个接收数据服务线程，该线程会根据接收的数据做响应的处理。（同一个硬件设备可以同时做主从，这
-    里的主从设备是虚拟的，io必须要是双工的）
-
-    接受线程会根据TYPE的不同来进行不同的操作、发送不同的信号量、压入不同的ringbuf
-
-    数据包格式与占用长度
-    +------+------+------+-------------+------+------+
-    |  2B  |  2B  |  2B  |      nB     |      4B     |
-    +------+------+------+-------------+------+------+
-    | eb90 | size | TYPE |     DATA    |     CHECK   |
-    +------+------+------+-------------+------+------+
-
-    根据type的不同 data与check也有所不同
-
-    type最高位代表是发送包还是返回包，1是发送包；0是返回包
-    type
-    ---------------------------------
-    | | 1b  | 1b  |
-    +-+-----+-----+
-    |1|发送包| OK  |
-    +-+-----+-----+
-    |0|返回包|ERROR|
-    +-+-----+-----|
-
-【设备空间读写操作】TYPE=0xEC01、0xEC02 
-    从设备一般会分配一些内存空间，用于记录配置与设备信息等等。主设备可以通过读写地址操作来操作从设备的空
-    间地址数据。
-
-    [写地址数据操作]将长度为len字节的数据，写入从设备地址为addr往后的len位上。
-    +------+------+------+------+------+-------------+------+------+
-    |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
-    +------+------+------+------+------+-------------+------+------+
-    | eb90 | size | EC01 | addr |  len |     DATA    |     CRC32   |
-    +------+------+------+------+------+-------------+------+------+
-
-    [读地址数据操作]读取从设备从addr地址往后的len位数据，该操作有返回响应。
-    +------+------+------+------+------+------+------+
-    |  2B  |  2B  |  2B  |  2B  |  2B  |      4B     |
-    +------+------+------+------+------+------+------+
-    | eb90 | size | EC02 | addr |  len |     CRC32   |
-    +------+------+------+------+------+------+------+
-        返回正确
-        +------+------+------+------+------+-------------+------+------+
-        |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
-        +------+------+------+------+------+-------------+------+------+
-        | eb90 | size | 6C02 | addr |  len |     DATA    |     CRC32   |
-        +------+------+------+------+------+-------------+------+------+
-        返回错误，eCODE代表错误码:0x1地址非法
-        +------+------+------+-----+------+------+
-        |  2B  |  2B  |  2B  | 1B  |      4B     |
-        +------+------+------+-----+------+------+
-        | eb90 | size | 2C02 |eCODE|     CRC32   |
-        +------+------+------+-----+------+------+
-
-【function】TYPE=0xEC03
-    通用函数接口。有返回。
-    +------+------+------+------+------+-------------+------+------+
-    |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
-    +------+------+------+------+------+-------------+------+------+
-    | eb90 | size | EC03 | func |  len |     arg     |     CRC32   |
-    +------+------+------+------+------+-------------+------+------+
-        返回正确
-        +------+------+------+------+------+-------------+------+------+
-        |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
-        +------+------+------+------+------+-------------+------+------+
-        | eb90 | size | 6C03 | func |  len | returnDATA  |     CRC32   |
-        +------+------+------+------+------+-------------+------+------+
-        返回错误，eCODE代表错误码
-        +------+------+------+-----+------+------+
-        |  2B  |  2B  |  2B  | 1B  |      4B     |
-        +------+------+------+-----+------+------+
-        | eb90 | size | 2C03 |eCODE|     CRC32   |
-        +------+------+------+-----+------+------+
-
-
-*/
-
-#include "eiodp.h"
-#include "eiodp_config.h"
-
-
-int eiodp_recvpushTask(eIODP_TYPE* eiodp_fd);
-int eiodp_recvProcessTask(eIODP_TYPE* eiodp_fd);
-
-/************************************************************
-    @brief:
-        初始化框架，准备缓存取、信号量、创建接受服务线程
-    @param:
-        fd：依赖的io设备句柄，eiodp协议需要作用于标准io设备。
-        readfunc：fd设备读数据函数
-        writefunc：fd设备写数据函数
-    @return:
-        创建的eIODP_TYPE指针，可以通过这个指针来操作iodp
-*************************************************************/
-eIODP_TYPE* eiodp_init(unsigned int fd, 
-                int (*readfunc)(int, char*, int),
-                int (*writefunc)(int, char*, int))
-{
-    crc32_init();
-    //入参检查
-    if(fd==NULL){
-        printf("error: eiodp_init fd = NULL\n");
-        return NULL;
-    }
-    if(readfunc == NULL || writefunc == NULL){
-        printf("error: eiodp_init func = NULL\n");
-        return NULL;
-    }
-
-    eIODP_TYPE* pDev = MOONOS_MALLOC(sizeof(eIODP_TYPE));
-    if(pDev == NULL)return NULL;
-    pDev->recv_ringbuf=creat_ring(IODP_RECV_MAX_LEN);
-    if(pDev->recv_ringbuf == NULL){
-        MOONOS_FREE(pDev);
-        printf("recv_ringbuf melloc error\n");
-        return NULL;
-    }
-
-    pDev->retbuf_func=creat_ring(IODP_RETURN_BUFFER);
-    if(pDev->retbuf_func == NULL){
-        delate_ring(pDev->recv_ringbuf);
-        MOONOS_FREE(pDev);
-        printf("retbuf_func melloc error\n");
-        return NULL;
-    }
-
-    pDev->retbuf_readaddr=creat_ring(IODP_RETURN_BUFFER);
-    if(pDev->retbuf_readaddr == NULL){
-        delate_ring(pDev->retbuf_func);
-        delate_ring(pDev->recv_ringbuf);
-        MOONOS_FREE(pDev);
-        printf("retbuf_func melloc error\n");
-        return NULL;
-    }
-
-    pDev->configmemSize=IODP_CONFIGMEM_SIZE;
-    pDev->iodevHandle=fd;
-    pDev->iodevRead = readfunc;
-    pDev->iodevWrite = writefunc;
-    pDev->pFuncHead = nullptr;
-    
-
-#if (IODP_OS==IODP_OS_LINUX)
-    sem_init(&pDev->readaddr_retsem, 0, 0);
-    sem_init(&pDev->func_retsem, 0, 0);
-    sem_init(&pDev->sem_recvSync, 0, 0);
-    pthread_mutex_init(&(pDev->mutex_recv),NULL);
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#endif
-
-
-    //开启服务
-#if (IODP_OS==IODP_OS_LINUX)
-    pthread_create(&pDev->ptRecvPushTask,NULL,eiodp_recvpushTask,pDev);
-    pthread_create(&pDev->ptRecvProcessTask,NULL,eiodp_recvProcessTask,pDev);
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#endif
-
-    return pDev;
-}
-
-//找到帧头
-static char* findhead(char* buf,int buflen)
-{
-    int i=0;
-    for(i=0;i<buflen-1;i++){
-        if(buf[i]==0xeb && buf[i+1]==0x90){
-            return &buf[i];
-        }
-    }
-    return NULL;
-}
-
-//通过code找到服务函数node
-static eIODP_FUNC_NODE* findFuncNode(eIODP_FUNC_NODE* pHead,uint16 code)
-{
-    eIODP_FUNC_NODE* p=pHead;
-    while(p){
-        if(p->funcode == code){
-            return p;
-        }
-        p=p->pNext;
-    }
-    return NULL;
-}
-//往服务函数链表中插入新函数节点
-static int addFuncNode(eIODP_FUNC_NODE* pHead,eIODP_FUNC_NODE* node)
-{
-    if(node == NULL){
-        return IODP_ERROR_PARAM;
-    }
-    if(node->pNext != NULL){
-        return IODP_ERROR_PARAM;//不是一个单独的节点
-    }
-    //find
-    eIODP_FUNC_NODE* p=pHead;
-    while(p){
-        if(p->funcode == node->funcode){
-            return IODP_ERROR_APINODE_REPEAT;//有重复code
-        }
-        if(p->pNext==NULL){
-            //add
-            p->pNext=node;
-            return 1;
-        }
-        p=p->pNext;
-    }
-
-    return -4;
-}
-
-
-/************************************************************
-    @brief:
-        写地址处理函数 type EC01
-    @param:
-        eiodp_fd：eiodp句柄
-        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
-        pktsize：数据包长度
-    @return:
-        -1为帧头错误 
-        0为地址溢出错误（会有返回iodp） 
-        1为正确
-*************************************************************/
-static int writeaddr_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize){
-    if(pktbuf[0]!=0xec || pktbuf[1]!=0x01)return IODP_ERROR_WADDR_HEAD;
-    unsigned short addr = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
-    unsigned short len = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
-    int i=0;
-    for(i=0;i<len;i++){
-        if((addr+i)>=eiodp_fd->configmemSize)return 0;
-        eiodp_fd->configmem[addr+i]=pktbuf[i+6];
-    }
-    return 1;
-}
-
-/************************************************************
-    @brief:
-        读地址处理函数 type EC02
-    @param:
-        eiodp_fd：eiodp句柄
-        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
-        pktsize：数据包长度
-    @return:
-        IODP_ERROR_RADDR_HEAD 为帧头错误 
-        0为地址溢出错误（会有返回iodp） 
-        1为正确
-*************************************************************/
-static int readaddr_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
-{
-    if(pktbuf[0]!=0xec || pktbuf[1]!=0x02)return IODP_ERROR_RADDR_HEAD;
-    unsigned short addr = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
-    unsigned short len = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
-    unsigned int devfd=eiodp_fd->iodevHandle;
-
-    if(addr>=eiodp_fd->configmemSize){
-        unsigned char retbuf[11];
-        unsigned short retpktsize=7;
-        retbuf[0]=0xeb;
-        retbuf[1]=0x90;
-        retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
-        retbuf[3]=(unsigned char)(retpktsize)&0xff;
-        retbuf[4]=0x2c; //type error pkt
-        retbuf[5]=0x02;
-        retbuf[6]=0x01; //error code
-        updatepktcrc(retbuf,11);
-        //IOWRITE(devfd,retbuf,11);
-        eiodp_fd->iodevWrite(devfd,retbuf,11);
-        return 0;
-    }
-
-    unsigned char *retbuf = MOONOS_MALLOC(14+len);
-    unsigned short retlen = len;
-    if(len>(eiodp_fd->configmemSize-addr))retlen = (eiodp_fd->configmemSize-addr);
-    unsigned short retpktsize=10+retlen;
-    retbuf[0]=0xeb;
-    retbuf[1]=0x90;
-    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
-    retbuf[3]=(unsigned char)(retpktsize)&0xff;
-    retbuf[4]=0x6c;
-    retbuf[5]=0x02;
-    retbuf[6]=(unsigned char)(addr>>8)&0xff;
-    retbuf[7]=(unsigned char)(addr)&0xff;
-    retbuf[8]=(unsigned char)(retlen>>8)&0xff;
-    retbuf[9]=(unsigned char)(retlen)&0xff;
-    memcpy(&retbuf[10],&(eiodp_fd->configmem[addr]),retlen);
-    updatepktcrc(retbuf,retpktsize+4);
-    //IOWRITE(devfd,retbuf,retpktsize+4);
-    eiodp_fd->iodevWrite(devfd,retbuf,retpktsize+4);
-    MOONOS_FREE(retbuf);
-    return 1;
-}
-
-/************************************************************
-    @brief:
-    服务函数处理 type EC03
-    @param:
-        eiodp_fd：eiodp句柄
-        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
-        pktsize：数据包长度
-    @return:
-        -1为帧头错误 
-        0为地址溢出错误（会有返回iodp） 
-        1为正确
-*************************************************************/
-static int function_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
-{
-    if(pktbuf[0]!=0xec || pktbuf[1]!=0x03)return IODP_ERROR_API_HEAD;
-    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
-    unsigned short fcode = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
-    unsigned short arglen = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
-    eIODP_FUNC_NODE* pnode = findFuncNode(eiodp_fd->pFuncHead,fcode);
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    if(pnode!=nullptr)
-    {
-        unsigned char retdata[IODP_FUNCPKT_RET_LEN];
-        unsigned short retlen=0;
-        pnode->callbackFunc(arglen,&pktbuf[6],&retlen,&retdata[10]);
-        unsigned short retpktsize = retlen+10;
-        //make return pkt
-        retdata[0]=0xeb;
-        retdata[1]=0x90;
-        retdata[2]=(unsigned char)(retpktsize>>8)&0xff;
-        retdata[3]=(unsigned char)(retpktsize)&0xff;
-        retdata[4]=0x6c;
-        retdata[5]=0x03;
-        retdata[6]=(unsigned char)(fcode>>8)&0xff;
-        retdata[7]=(unsigned char)(fcode)&0xff;
-        retdata[8]=(unsigned char)(retlen>>8)&0xff;
-        retdata[9]=(unsigned char)(retlen)&0xff;
-        updatepktcrc(retdata,retpktsize+4);
-        eiodp_fd->iodevWrite(devfd,retdata,retpktsize+4);
-    }
-    else{
-        unsigned char retdata[11];
-        unsigned short retpktsize = 7;
-        //make return pkt
-        retdata[0]=0xeb;
-        retdata[1]=0x90;
-        retdata[2]=(unsigned char)(retpktsize>>8)&0xff;
-        retdata[3]=(unsigned char)(retpktsize)&0xff;
-        retdata[4]=0x2c; //type error pkt
-        retdata[5]=0x03;
-        retdata[6]=0x01; //error code
-        updatepktcrc(retdata,11);
-        eiodp_fd->iodevWrite(devfd,retdata,11);
-    }
-    return IODP_OK;
-
-
-}
-
-#if (IODP_OS!=IODP_OS_NULL)
-
-/************************************************************
-    @brief:
-        接受数据压入循环缓存-任务
-    @param:
-        eiodp_fd:eiodp句柄
-*************************************************************/
-int eiodp_recvpushTask(eIODP_TYPE* eiodp_fd)
-{
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    unsigned char recvbuf[1024]={0};
-    int recvlen=0;
-    int putret=0;
-    while(1){
-        //recvlen=IOREAD(devfd,recvbuf,1024);
-        recvlen = eiodp_fd->iodevRead(devfd,recvbuf,1024);
-        if(recvlen<=0) continue;
-        putret = put_ring(eiodp_fd->recv_ringbuf,recvbuf,recvlen);
-        if(putret == -1){
-            IODP_LOGMSG("put_ring out\n");
-        }
-    }
-}
-
-/************************************************************
-    @brief:
-        接收服务函数-任务
-    @param:
-        eiodp_fd:eiodp句柄
-*************************************************************/
-int eiodp_recvProcessTask(eIODP_TYPE* eiodp_fd)
-{
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    unsigned char recvbuf[1024]={0};
-    int recvlen=0;
-    unsigned short pktlen=0;
-    while(1)
-    {
-        recvlen=get_ring(eiodp_fd->recv_ringbuf, recvbuf,1);
-        if(recvlen<=0){continue;}
-        //确定帧头,并持续接受4字节
-        if(recvbuf[0]!=0xeb){IODP_LOGMSG("recvbuf[0]!=0xeb\n");continue;}
-        while(recvlen<4){
-            recvlen+=get_ring(eiodp_fd->recv_ringbuf,&recvbuf[recvlen],4-recvlen);
-        }
-        if(recvbuf[1]!=0x90){IODP_LOGMSG("recvbuf[1]!=0x90\n");continue;}
-        //此时已经读取了4位数据
-        pktlen = ((unsigned short)recvbuf[2] << 8) | ((unsigned short)recvbuf[3]) ;
-        if(pktlen>=1024-4){IODP_LOGMSG("pktlen>=1024-4\n");continue;}
-        pktlen += 4;
-        while(recvlen<pktlen){
-            recvlen+=get_ring(eiodp_fd->recv_ringbuf,&recvbuf[recvlen],pktlen-recvlen);
-        }
-
-        //------------------确定包类型
-        if(((recvbuf[4])&IODP_TYPEBIT_SR_MASK)==0)//确定包为返回类型
-        {
-            //接受到返回类型的包，先校验，再根据返回类型确定不同的返回缓冲区，再给信号
-            if(checkpktcrc(recvbuf,recvlen)==0){
-                IODP_LOGMSG("retpkt crc error\n");
-                continue;
-            }
-            //check pkt type code
-            if(recvbuf[5]==0x2)//readaddr
-            {
-                put_ring(eiodp_fd->retbuf_readaddr,&recvbuf[4],recvlen-8);//去掉头和crc
-#if (IODP_OS==IODP_OS_LINUX)
-                sem_post(&(eiodp_fd->readaddr_retsem));
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#endif
-            }
-            else if(recvbuf[5]==0x3)//function
-            {
-                put_ring(eiodp_fd->retbuf_func,&recvbuf[4],recvlen-8);//去掉头和crc
-#if (IODP_OS==IODP_OS_LINUX)
-                sem_post(&(eiodp_fd->func_retsem));
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#endif
-            }
-            else {IODP_LOGMSG("pkt recvbuf[5] no match \n");continue;}
-        }
-        else                                 //确定包为发送类型
-        {
-            //接受到发送类型的包需要 更具type代码分别转向不同的服务类型
-            if(recvbuf[5]==0x01)//write addr
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("write addr pkt crc error\n");continue;}
-                writeaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else if(recvbuf[5]==0x02)//readaddr
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("readaddr pkt crc error\n");continue;}
-                readaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else if(recvbuf[5]==0x03)//function
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("readaddr pkt crc error\n");continue;}
-                function_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else {IODP_LOGMSG("retpkt recvbuf[5] no match \n");continue;}
-        }
-
-    }
-}
-#endif
-
-/************************************************************
-    @brief:
-        接收服务函数-任务(无操作系统，连续字符read) 在无操作系统的程序里 需要连续调用
-    @param:
-        eiodp_fd:eiodp句柄
-*************************************************************/
-#if (IODP_OS==IODP_OS_NULL)
-int eiodp_recvProcessTask_nos(eIODP_TYPE* eiodp_fd)
-{
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    unsigned char recvbuf[1024]={0};
-    int recvlen=0;
-    unsigned short pktlen=0;
-    {
-        recvlen=eiodp_fd->iodevRead(devfd, recvbuf,1);
-        if(recvlen<=0){return -1;}
-        //确定帧头,并持续接受4字节
-        if(recvbuf[0]!=0xeb){IODP_LOGMSG("recvbuf[0]!=0xeb\n");return -1;}
-        while(recvlen<4){
-            recvlen+=eiodp_fd->iodevRead(devfd,&recvbuf[recvlen],4-recvlen);
-        }
-        if(recvbuf[1]!=0x90){IODP_LOGMSG("recvbuf[1]!=0x90\n");return -1;}
-        //此时已经读取了4位数据
-        pktlen = ((unsigned short)recvbuf[2] << 8) | ((unsigned short)recvbuf[3]) ;
-        if(pktlen>=1024-4){IODP_LOGMSG("pktlen>=1024-4\n");return -1;}
-        pktlen += 4;
-        while(recvlen<pktlen){
-            recvlen+=eiodp_fd->iodevRead(devfd,&recvbuf[recvlen],pktlen-recvlen);
-        }
-
-        //------------------确定包类型
-        if(((recvbuf[4])&IODP_TYPEBIT_SR_MASK)==0)//确定包为返回类型
-        {
-            //接受到返回类型的包，先校验，再根据返回类型确定不同的返回缓冲区，再给信号
-            if(checkpktcrc(recvbuf,recvlen)==0){
-                IODP_LOGMSG("retpkt crc error\n");
-                return -1;
-            }
-            //check pkt type code
-            if(recvbuf[5]==0x2)//readaddr
-            {
-                put_ring(eiodp_fd->retbuf_readaddr,&recvbuf[4],recvlen-8);//去掉头和crc
-            }
-            else if(recvbuf[5]==0x3)//function
-            {
-                put_ring(eiodp_fd->retbuf_func,&recvbuf[4],recvlen-8);//去掉头和crc
-            }
-            else {IODP_LOGMSG("pkt recvbuf[5] no match \n");return -1;}
-        }
-        else                                 //确定包为发送类型
-        {
-            //接受到发送类型的包需要 更具type代码分别转向不同的服务类型
-            if(recvbuf[5]==0x01)//write addr
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("write addr pkt crc error\n");return -1;}
-                writeaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else if(recvbuf[5]==0x02)//readaddr
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("readaddr pkt crc error\n");return -1;}
-                readaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else if(recvbuf[5]==0x03)//function
-            {
-                if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGMSG("readaddr pkt crc error\n");return -1;}
-                function_Process(eiodp_fd,&recvbuf[4],recvlen-8);
-            }
-            else {IODP_LOGMSG("retpkt recvbuf[5] no match \n");return -1;}
-        }
-
-    }
-    return 0;
-}
-#endif
-
-//---------------------------send cmd----------------------------
-
-/************************************************************
-    @brief:
-        写地址操作，将数据写到对方的配置空间上
-        此操作主要是在对方的iodp配置空间的addr偏移地址上写指定长度的数据。
-    @param:
-        eiodp_fd:eiodp句柄
-        addr：在对方的配置空间addr地址往后写数据
-        len：数据长度，在[addr,addr+len]上覆盖数据
-        sdbuf：数据头指针
-*************************************************************/
-void eiodpWriteAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf){
-    unsigned int devfd=eiodp_fd->iodevHandle;
-
-    unsigned short pktsize=10+len;
-    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
-
-    sendbuf[0]=0xeb;
-    sendbuf[1]=0x90;
-    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
-    sendbuf[3]=(unsigned char)(pktsize)&0xff;
-    sendbuf[4]=0xec;
-    sendbuf[5]=0x01;
-    sendbuf[6]=(unsigned char)(addr>>8)&0xff;
-    sendbuf[7]=(unsigned char)(addr)&0xff;
-    sendbuf[8]=(unsigned char)(len>>8)&0xff;
-    sendbuf[9]=(unsigned char)(len)&0xff;
-    memcpy(&sendbuf[10],sdbuf,len);
-
-    updatepktcrc(sendbuf,pktsize+4);
-
-    //IOWRITE(devfd,sendbuf,pktsize+4);
-    eiodp_fd->iodevWrite(devfd,sendbuf,pktsize+4);
-    MOONOS_FREE(sendbuf);
-}
-/************************************************************
-    @brief:
-        读地址操作，读取对方的配置空间数据
-        此操作主要是将对方的addr地址往后len个数据都读取出来
-    @param:
-        eiodp_fd:eiodp句柄
-        addr：读取地址
-        len：数据长度
-        recvbuf：将数据存入该数组
-    @return:
-        -6 - time out
-        -1 - recvlen长度不对
-        -4 - 返回包中地址对不上
-        -5 - 返回包包长度与实际不符
-        -3 - 有返回包，但是返回了错误代码
-        -2 - 返回type不对
-         0 - 成功
-*************************************************************/
-int eiodpReadAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* recvbuf)
-{
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    int ret=0;
-
-    unsigned short pktsize=10;
-    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
-
-    sendbuf[0]=0xeb;
-    sendbuf[1]=0x90;
-    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
-    sendbuf[3]=(unsigned char)(pktsize)&0xff;
-    sendbuf[4]=0xec;
-    sendbuf[5]=0x02;
-    sendbuf[6]=(unsigned char)(addr>>8)&0xff;
-    sendbuf[7]=(unsigned char)(addr)&0xff;
-    sendbuf[8]=(unsigned char)(len>>8)&0xff;
-    sendbuf[9]=(unsigned char)(len)&0xff;
-    updatepktcrc(sendbuf,pktsize+4);
-
-    //IOWRITE(devfd,sendbuf,pktsize+4);
-    eiodp_fd->iodevWrite(devfd,sendbuf,pktsize+4);
-
-    MOONOS_FREE(sendbuf);
-
-    //等待返回
-#if (IODP_OS==IODP_OS_LINUX)
-    struct timespec tv;
-    clock_gettime(CLOCK_REALTIME, &tv);
-    tv.tv_sec += 3; // 这个是设置等待时长的。单位是秒
-    int timeres=0;
-    timeres = sem_timedwait(&(eiodp_fd->readaddr_retsem),&tv);
-    if(timeres == -1){IODP_LOGMSG("time out\n");return IODP_ERROR_TIMEOUT;}
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#elif (IODP_OS==IODP_OS_NULL)
-    long timeout=0;
-    while (eiodp_recvProcessTask_nos(eiodp_fd)==-1)
-    {
-        timeout++;
-        if(timeout>1000*10000){
-            IODP_LOGMSG("time out\n");
-            return IODP_ERROR_TIMEOUT;
-        }
-    } 
-#endif
-    unsigned char *retbuf=MOONOS_MALLOC(len+14);
-    unsigned short recvlen=0;
-    recvlen = get_ring(eiodp_fd->retbuf_readaddr,retbuf,len+14);
-    if(recvlen<7){ret=IODP_ERROR_SMOLL_RECVLEN;goto FAIL;}
-    if(retbuf[0]==0x6c && retbuf[1]==0x02)
-    {
-        unsigned short retaddr = ((unsigned short)retbuf[2] << 8) | ((unsigned short)retbuf[3]) ;
-        unsigned short retlen = ((unsigned short)retbuf[4] << 8) | ((unsigned short)retbuf[5]) ;
-        if(retaddr!=addr){ret=IODP_ERROR_RETCODE;goto FAIL;}
-        if(retlen!=recvlen-6){ret=IODP_ERROR_RECVLEN;goto FAIL;}
-        memcpy(recvbuf,&retbuf[6],retlen);
-        MOONOS_FREE(retbuf);
-        return retlen;
-    }
-    else if(retbuf[0]==0x2c && retbuf[1]==0x02)
-    {
-        printf("eiodpReadAddr return error code:0x%x\n",retbuf[2]);
-        ret = IODP_ERROR_PKT;
-        goto FAIL;
-    }
-    else{
-        printf("eiodpReadAddr noreturn\n");
-        ret = IODP_ERROR_NORET;
-        goto FAIL;
-    }
-
-
-
-FAIL:
-    MOONOS_FREE(retbuf);
-    return ret;
-}
-
-/************************************************************
-    @brief:
-        注册服务函数
-    @param:
-        eiodp_fd:eiodp句柄
-        funcode：API代码
-        callbackFunc:服务函数
-    @return:
-        <0 - 失败（error code）
-         0 - 成功
-*************************************************************/
-int eiodpRegister(eIODP_TYPE* eiodp_fd,uint16 funcode,
-                int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata))
-{
-    if(eiodp_fd == nullptr){
-        return IODP_ERROR_PARAM;
-    }
-    eIODP_FUNC_NODE* node = MOONOS_MALLOC(sizeof(eIODP_FUNC_NODE));
-    if(node == nullptr){
-        return IODP_ERROR_HEAPOVER;
-    }
-    node->funcode=funcode;
-    node->callbackFunc = callbackFunc;
-    node->pNext=nullptr;
-    if(eiodp_fd->pFuncHead == nullptr){
-        eiodp_fd->pFuncHead = node;
-        return IODP_OK;
-    }
-    int st = addFuncNode(eiodp_fd->pFuncHead,node);
-    if(st == IODP_ERROR_APINODE_REPEAT){
-        printf("error addFuncNode have repeat code\n");
-        return IODP_ERROR_REPEATCODE;
-    }
-    return IODP_OK;
-}
-/************************************************************
-    @brief:
-        打印已经注册的服务函数
-    @param:
-        eiodp_fd:eiodp句柄
-    @return:
-        <0 - 失败（error code）
-         0 - 成功
-*************************************************************/
-int eiodpShowRegFunc(eIODP_TYPE* eiodp_fd)
-{
-    if(eiodp_fd == nullptr){
-        return IODP_ERROR_PARAM;
-    }
-    if(eiodp_fd->pFuncHead == nullptr){
-        printf("no Register Function\n");
-        return IODP_OK;
-    }
-    eIODP_FUNC_NODE* p = eiodp_fd->pFuncHead;
-    while(p){
-        printf("function code: 0x%04x   function ptr: 0x%x\n",p->funcode,p->callbackFunc);
-        p=p->pNext;
-    }
-
-    return IODP_OK;
-}
-
-/************************************************************
-    @brief:
-        调用服务端的API接口，该接口由服务端的eiodpRegister注册的callbackFunc函数来提供
-    @param:
-        eiodp_fd:eiodp句柄
-        code：API代码
-        argsize：入参arg的长度
-        arg：API入参
-        retarg：用户需要提供返回参数的容器
-    @return:
-        <0 - 失败（error code）
-        >0 - 成功 返回参数长度
-*************************************************************/
-int eiodpFunction(eIODP_TYPE* eiodp_fd, uint16 code, 
-        uint16 argsize,void* arg, void* retarg)
-{
-    unsigned int devfd=eiodp_fd->iodevHandle;
-    int ret=0;
-
-    unsigned short pktsize=10+argsize;
-    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
-
-    sendbuf[0]=0xeb;sendbuf[1]=0x90;
-    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
-    sendbuf[3]=(unsigned char)(pktsize)&0xff;
-    sendbuf[4]=0xec;sendbuf[5]=0x03;
-    sendbuf[6]=(unsigned char)(code>>8)&0xff;
-    sendbuf[7]=(unsigned char)(code)&0xff;
-    sendbuf[8]=(unsigned char)(argsize>>8)&0xff;
-    sendbuf[9]=(unsigned char)(argsize)&0xff;
-    memcpy(&sendbuf[10],arg,argsize);
-    updatepktcrc(sendbuf,pktsize+4);
-
-    //IOWRITE(devfd,sendbuf,pktsize+4);
-    eiodp_fd->iodevWrite(devfd,sendbuf,pktsize+4);
-    MOONOS_FREE(sendbuf);
-
-    //等待返回
-#if (IODP_OS==IODP_OS_LINUX)
-    struct timespec tv;clock_gettime(CLOCK_REALTIME, &tv);tv.tv_sec += 3; // 这个是设置等待时长的。单位是秒
-    int timeres=0;timeres = sem_timedwait(&(eiodp_fd->func_retsem),&tv);
-    if(timeres == -1){IODP_LOGMSG("time out\n");return IODP_ERROR_TIMEOUT;}
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#elif (IODP_OS==IODP_OS_NULL)
-    long timeout=0;
-    while (eiodp_recvProcessTask_nos(eiodp_fd)==-1)
-    {
-        timeout++;
-        if(timeout>1000*10000){
-            IODP_LOGMSG("time out\n");
-            return IODP_ERROR_TIMEOUT;
-        }
-    } 
-#endif
-
-    unsigned char *retbuf=MOONOS_MALLOC(IODP_FUNCPKT_RET_LEN);
-    unsigned short recvlen=0;
-    recvlen = get_ring(eiodp_fd->retbuf_func,retbuf,IODP_FUNCPKT_RET_LEN);
-    if(recvlen<7){ret=IODP_ERROR_SMOLL_RECVLEN;goto FAIL;}
-    if(retbuf[0]==0x6c && retbuf[1]==0x03)
-    {
-        unsigned short retcode = ((unsigned short)retbuf[2] << 8) | ((unsigned short)retbuf[3]) ;
-        unsigned short retlen = ((unsigned short)retbuf[4] << 8) | ((unsigned short)retbuf[5]) ;
-        if(retcode!=code){ret=IODP_ERROR_RETCODE;goto FAIL;}
-        if(retlen!=recvlen-6){ret=IODP_ERROR_RECVLEN;goto FAIL;}
-        memcpy(retarg,&retbuf[6],retlen);
-        MOONOS_FREE(retbuf);
-        return retlen;
-    }
-    else if(retbuf[0]==0x2c && retbuf[1]==0x03)
-    {
-        printf("eiodpFunction return error code:0x%x\n",retbuf[2]);
-        ret = IODP_ERROR_PKT;
-        goto FAIL;
-    }
-    else{
-        printf("eiodpFunction noreturn\n");
-        ret = IODP_ERROR_NORET;
-        goto FAIL;
-    }
-
-
-
-FAIL:
-    MOONOS_FREE(retbuf);
-    return ret;
-
-}
-
-//-----------------------------------crc32----------------------
-static unsigned long table[256];
-//位逆转
-static unsigned long bitrev(unsigned long input, int bw)
-{
-    int i;
-    unsigned long var;
-    var = 0;
-    for(i=0;i<bw;i++)
-    {
-        if(input & 0x01)
-        {
-            var |= 1<<(bw-1-i);
-        }
-        input>>=1;
-    }
-    return var;
-}
-
-//码表生成
-//如:X32+X26+...X1+1,poly=(1<<26)|...|(1<<1)|(1<<0)
-void crc32_init()
-{
-    int i;
-    int j;
-    unsigned long c;
-    unsigned long poly = 0x4C11DB7;
-    poly=bitrev(poly,32);
-    for(i=0; i<256; i++)
-    {
-        c = i;
-        for (j=0; j<8; j++)
-        {
-            if(c&1)
-            {
-                c=poly^(c>>1);
-            }
-            else
-            {
-                c=c>>1;
-            }
-        }
-        table[i] = c;
-    }
-}
-
-unsigned long crc32(void* input, int len)
-{
-    int i;
-    unsigned char* pch;
-    unsigned long crc = 0xFFFFFFFF;
-    pch = (unsigned char*)input;
-    for(i=0;i<len;i++)
-    {
-        crc = (crc>>8)^table[(unsigned char)(crc^*pch)];
-        pch++;
-    }
-    crc ^= 0xFFFFFFFF;
-
-    return crc;
-}
-
-int checkpktcrc(unsigned char* data,unsigned int size)
-{
-    unsigned int crcdata = (unsigned int)crc32(data,size-4);
-    if(
-       (data[size-2]==((crcdata>>8)&0xff)) && (data[size-1]==((crcdata)&0xff)) &&
-       (data[size-4]==((crcdata>>24)&0xff)) && (data[size-3]==((crcdata>>16)&0xff))
-      )
-    {
-        return 1;
-    }
-    else{
-        return 0;
-    }
-
-}
-
-int updatepktcrc(unsigned char* data,unsigned int size)
-{
-    unsigned int crcdata = (unsigned int)crc32(data,size-4);
-
-    data[size-2]=((crcdata>>8)&0xff);
-    data[size-1]=((crcdata)&0xff);
-    data[size-4]=((crcdata>>24)&0xff);
-    data[size-3]=((crcdata>>16)&0xff);
-
-}
-
-//---------------------------------------------------------------------------------
-//                             eiodp ring buffer
-
-eIODP_RING* creat_ring(uint32 size)
-{
-    eIODP_RING* pRet=(eIODP_RING*)MOONOS_MALLOC(sizeof (eIODP_RING));
-    pRet->buf=(uint8*)MOONOS_MALLOC(size);
-    if(pRet->buf!=nullptr)
-    {
-        pRet->bufSize=size;
-        pRet->pIn=0;
-        pRet->pOut=0;
-
-    }
-    else {
-        MOONOS_FREE(pRet);
-        pRet=nullptr;
-    }
-
-    return pRet;
-}
-
-void delate_ring(eIODP_RING* p)
-{
-    MOONOS_FREE(p->buf);
-    MOONOS_FREE(p);
-}
-
-uint16 size_ring(eIODP_RING* p)
-{
-    if(p->pIn >= p->pOut){
-        return p->pIn-p->pOut;
-    }
-    else{
-        return p->bufSize-(p->pOut-p->pIn);
-    }
-}
-
-int put_ring(eIODP_RING* p,uint8* buf,uint32 size)
-{
-		int i;
-    //首先要判断是否会写满
-    if(size+size_ring(p) >= p->bufSize){
-        return -1;
-    }
-
-    
-    for(i=0;i<size;i++){
-        p->buf[p->pIn]=buf[i];
-
-        if((p->pIn+1) >= p->bufSize){
-            p->pIn=0;
-        }
-        else {
-            p->pIn++;
-        }
-    }
-    return i;
-
-}
-
-int get_ring(eIODP_RING* p,uint8* buf,uint32 size)
-{
-	int i;
-    if(p->pIn == p->pOut) return 0;
-
-    
-    for(i=0;i<size;i++){
-        buf[i]=p->buf[p->pOut];
-
-        if((p->pOut+1) >= p->bufSize){
-            p->pOut=0;
-        }
-        else {
-            p->pOut++;
-        }
-
-
-        if(p->pIn == p->pOut){
-            return i+1;
-        }
-    }
-    return i;
-}
-
-
+/*
+    文件名：eiodp.c
+    作者：zouzhiqiang
+
+    说明：
+                                《嵌入式通用io数据协议框架》
+    通过制定一套协议框架，让用户快速实现主从设备的交互，尤其是让从设备能够轻松构建服务响应（类似http）
+    框架适用于所有支持标准io（read write）的通讯类型。可以在eiodp_config.h中配置相关接口。
+
+    数据包协议通过一个头帧+包类型来确定一个数据包。头帧为2字节：0xeb90,包类型也占2字节。而数据包尾则占
+    4个字节。包尾根据不同的包类型来确定内容：固定尾帧、校验和、crc32。
+
+    框架会开启一个接收数据服务线程，该线程会根据接收的数据做响应的处理。（同一个硬件设备可以同时做主从，这
+    里的主从设备是虚拟的，io必须要是双工的）
+
+    接受线程会根据TYPE的不同来进行不同的操作、发送不同的信号量、压入不同的ringbuf
+
+    数据包格式与占用长度
+    +------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |      nB     |      4B     |
+    +------+------+------+-------------+------+------+
+    | eb90 | size | TYPE |     DATA    |     CHECK   |
+    +------+------+------+-------------+------+------+
+
+    根据type的不同 data与check也有所不同
+
+    type最高位代表是发送包还是返回包，1是发送包；0是返回包
+    type
+    ---------------------------------
+    | | 1b  | 1b  |
+    +-+-----+-----+
+    |1|发送包| OK  |
+    +-+-----+-----+
+    |0|返回包|ERROR|
+    +-+-----+-----|
+
+【设备空间读写操作】TYPE=0xEC01、0xEC02 
+    从设备一般会分配一些内存空间，用于记录配置与设备信息等等。主设备可以通过读写地址操作来操作从设备的空
+    间地址数据。
+
+    [写地址数据操作]将长度为len字节的数据，写入从设备地址为addr往后的len位上。
+    +------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
+    +------+------+------+------+------+-------------+------+------+
+    | eb90 | size | EC01 | addr |  len |     DATA    |     CRC32   |
+    +------+------+------+------+------+-------------+------+------+
+
+    [读地址数据操作]读取从设备从addr地址往后的len位数据，该操作有返回响应。
+    +------+------+------+------+------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |      4B     |
+    +------+------+------+------+------+------+------+
+    | eb90 | size | EC02 | addr |  len |     CRC32   |
+    +------+------+------+------+------+------+------+
+        返回正确
+        +------+------+------+------+------+-------------+------+------+
+        |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
+        +------+------+------+------+------+-------------+------+------+
+        | eb90 | size | 6C02 | addr |  len |     DATA    |     CRC32   |
+        +------+------+------+------+------+-------------+------+------+
+        返回错误，eCODE代表错误码:0x1地址非法
+        +------+------+------+-----+------+------+
+        |  2B  |  2B  |  2B  | 1B  |      4B     |
+        +------+------+------+-----+------+------+
+        | eb90 | size | 2C02 |eCODE|     CRC32   |
+        +------+------+------+-----+------+------+
+
+【function】TYPE=0xEC03
+    通用函数接口。有返回。
+    +------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
+    +------+------+------+------+------+-------------+------+------+
+    | eb90 | size | EC03 | func |  len |     arg     |     CRC32   |
+    +------+------+------+------+------+-------------+------+------+
+        返回正确
+        +------+------+------+------+------+-------------+------+------+
+        |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
+        +------+------+------+------+------+-------------+------+------+
+        | eb90 | size | 6C03 | func |  len | returnDATA  |     CRC32   |
+        +------+------+------+------+------+-------------+------+------+
+        返回错误，eCODE：0x01没有这个服务函数 0x02延迟返回的请求表已满
+        +------+------+------+-----+------+------+
+        |  2B  |  2B  |  2B  | 1B  |      4B     |
+        +------+------+------+-----+------+------+
+        | eb90 | size | 2C03 |eCODE|     CRC32   |
+        +------+------+------+-----+------+------+
+
+
+*/
+
+#include "eiodp.h"
+#include "eiodp_config.h"
+#include <stdio.h>
+#include <string.h>
+
+
+int eiodp_recvpushTask(eIODP_TYPE* eiodp_fd);
+int eiodp_recvProcessTask(eIODP_TYPE* eiodp_fd);
+
+#if (IODP_METRICS_ENABLE)
+#define IODP_METRIC_ADD(fd,field,v) IODP_ATOMIC_ADD(&(fd)->metrics.cnt.field,(v))
+#define IODP_METRIC_MAX(fd,field,v) IODP_ATOMIC_MAX(&(fd)->metrics.cnt.field,(v))
+#else
+#define IODP_METRIC_ADD(fd,field,v) ((void)0)
+#define IODP_METRIC_MAX(fd,field,v) ((void)0)
+#endif
+#define IODP_METRIC_INC(fd,field) IODP_METRIC_ADD(fd,field,1)
+
+/************************************************************
+    @brief:
+        初始化框架，准备缓存取、信号量、创建接受服务线程
+    @param:
+        fd：依赖的io设备句柄，eiodp协议需要作用于标准io设备。
+        readfunc：fd设备读数据函数
+        writefunc：fd设备写数据函数
+    @return:
+        创建的eIODP_TYPE指针，可以通过这个指针来操作iodp
+*************************************************************/
+eIODP_TYPE* eiodp_init(unsigned int fd, 
+                int (*readfunc)(int, char*, int),
+                int (*writefunc)(int, char*, int))
+{
+    crc32_init();
+    //入参检查
+    if(fd==NULL){
+        IODP_LOGE("error: eiodp_init fd = NULL\n");
+        return NULL;
+    }
+#if (IODP_OS!=IODP_OS_NULL)
+    if(readfunc == NULL || writefunc == NULL){
+        IODP_LOGE("error: eiodp_init func = NULL\n");
+        return NULL;
+    }
+#endif
+
+    eIODP_TYPE* pDev = MOONOS_MALLOC(sizeof(eIODP_TYPE));
+    if(pDev == NULL)return NULL;
+    pDev->recv_ringbuf=creat_ring(IODP_RECV_MAX_LEN);
+    if(pDev->recv_ringbuf == NULL){
+        MOONOS_FREE(pDev);
+        IODP_LOGE("recv_ringbuf melloc error\n");
+        return NULL;
+    }
+
+    pDev->retbuf_func=creat_ring(IODP_RETURN_BUFFER);
+    if(pDev->retbuf_func == NULL){
+        delate_ring(pDev->recv_ringbuf);
+        MOONOS_FREE(pDev);
+        IODP_LOGE("retbuf_func melloc error\n");
+        return NULL;
+    }
+
+    pDev->retbuf_readaddr=creat_ring(IODP_RETURN_BUFFER);
+    if(pDev->retbuf_readaddr == NULL){
+        delate_ring(pDev->retbuf_func);
+        delate_ring(pDev->recv_ringbuf);
+        MOONOS_FREE(pDev);
+        IODP_LOGE("retbuf_func melloc error\n");
+        return NULL;
+    }
+
+    pDev->configmemSize=IODP_CONFIGMEM_SIZE;
+    pDev->configmem=pDev->configmemBuf;
+    pDev->pPersist=nullptr;
+    pDev->iodevHandle=fd;
+    pDev->iodevRead = readfunc;
+    pDev->iodevWrite = writefunc;
+    pDev->iodevWritev = nullptr;
+    pDev->parser.have = 0;
+    pDev->parser.need = 0;
+    pDev->outbuf = nullptr;
+    pDev->outcap = 0;
+    pDev->outlen = 0;
+    pDev->flowMode = 0;
+    pDev->probeFail = 0;
+    pDev->probeToken = 0;
+    pDev->txOffset = 0;
+    pDev->peerAcked = 0;
+    pDev->peerWindow = 0;
+    pDev->probeEnd = 0;
+    pDev->probeTime = 0;
+    pDev->pFuncHead = nullptr;
+    pDev->deferOpen = 0;
+    pDev->funcTx = nullptr;
+    memset(pDev->streamSrv,0,sizeof(pDev->streamSrv));
+    pDev->streamTx = nullptr;
+    pDev->rwriteMode = 0;
+    pDev->pRwTx = nullptr;
+    pDev->pRwRx = nullptr;
+    pDev->tickFunc = nullptr;
+    pDev->pollCount = IODP_NOS_LOOPS_PER_MS; //从1ms开始，有效时间戳不为0
+#if (IODP_METRICS_ENABLE)
+    memset(&pDev->metrics,0,sizeof(pDev->metrics));
+#endif
+    memset(pDev->rtt,0,sizeof(pDev->rtt));
+    int i;
+    for(i=0;i<IODP_RTT_NUM;i++)pDev->rtt[i].rto = IODP_RTO_INIT;
+    for(i=0;i<IODP_DEFER_MAX;i++){
+        pDev->defer[i].state = 1<<1;    //代数从1开始
+        pDev->defer[i].funcode = 0;
+    }
+    //版本从2开始，调用者用0表示还没有读过
+    pDev->cfgSeq = 2;
+    for(i=0;i<IODP_CFG_NBLOCK;i++)pDev->blkver[i] = 2;
+    pDev->touchCnt = 0;
+    memset(pDev->watch,0,sizeof(pDev->watch));
+    memset(pDev->watchMask,0,sizeof(pDev->watchMask));
+    memset(pDev->vreg,0,sizeof(pDev->vreg));
+    pDev->vregUsed = 0;
+    memset(pDev->vregMask,0,sizeof(pDev->vregMask));
+    memset(pDev->subSrv,0,sizeof(pDev->subSrv));
+    pDev->subDirty = 0;
+    memset(pDev->sub,0,sizeof(pDev->sub));
+    pDev->subWait = 0;
+    memset(pDev->stream,0,sizeof(pDev->stream));
+    pDev->streamOpen = 0;
+    memset(pDev->xmemDir,0,sizeof(pDev->xmemDir));
+    pDev->xmemPages = 0;
+    pDev->mreadTag = 0;
+    memset(pDev->pending,0,sizeof(pDev->pending));
+    pDev->pendingOrder = 0;
+
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_init(&(pDev->mutex_rtt),NULL);
+    pthread_mutex_init(&(pDev->mutex_flow),NULL);
+    pthread_mutex_init(&(pDev->mutex_cfg),NULL);
+    pthread_mutex_init(&(pDev->mutex_sub),NULL);
+    pthread_mutex_init(&(pDev->mutex_stream),NULL);
+    pthread_mutex_init(&(pDev->mutex_persist),NULL);
+    sem_init(&pDev->flow_sem, 0, 0);
+    sem_init(&pDev->rwrite_sem, 0, 0);
+    pthread_mutex_init(&(pDev->mutex_rwrite),NULL);
+    sem_init(&pDev->readaddr_retsem, 0, 0);
+    sem_init(&pDev->func_retsem, 0, 0);
+    sem_init(&pDev->sem_recvSync, 0, 0);
+    pthread_mutex_init(&(pDev->mutex_recv),NULL);
+    pthread_mutex_init(&(pDev->mutex_pending),NULL);
+    pDev->stopping = 0;
+#elif (IODP_OS==IODP_OS_FREERTOS)
+#elif (IODP_OS==IODP_OS_NULL)
+    pDev->txPending = nullptr;
+    if(writefunc == NULL){
+        pDev->txPending = creat_ring(IODP_RETURN_BUFFER);
+        if(pDev->txPending == NULL){
+            delate_ring(pDev->retbuf_readaddr);
+            delate_ring(pDev->retbuf_func);
+            delate_ring(pDev->recv_ringbuf);
+            MOONOS_FREE(pDev);
+            IODP_LOGE("txPending melloc error\n");
+            return NULL;
+        }
+    }
+#endif
+
+
+    //开启服务
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_create(&pDev->ptRecvPushTask,NULL,eiodp_recvpushTask,pDev);
+    pthread_create(&pDev->ptRecvProcessTask,NULL,eiodp_recvProcessTask,pDev);
+#elif (IODP_OS==IODP_OS_FREERTOS)
+#endif
+
+    return pDev;
+}
+
+void eiodp_deinit(eIODP_TYPE* eiodp_fd)
+{
+    int i, j;
+    if(eiodp_fd == nullptr)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    //接收任务可能阻塞在设备读里，取消后等它退出；处理任务看到stopping后自己退出
+    eiodp_fd->stopping = 1;
+    pthread_cancel(eiodp_fd->ptRecvPushTask);
+    pthread_join(eiodp_fd->ptRecvPushTask,NULL);
+    pthread_join(eiodp_fd->ptRecvProcessTask,NULL);
+#endif
+    if(eiodp_fd->deferOpen != 0)IODP_LOGW("deinit with %d deferred requests\n",eiodp_fd->deferOpen);
+    //对方打开的流按取消结束，本端打开的流不再回调
+    for(i=0;i<IODP_STREAM_MAX;i++){
+        eIODP_STREAM_SRV* ss = &eiodp_fd->streamSrv[i];
+        if(ss->used && ss->ops->close != nullptr)ss->ops->close(ss->state,IODP_ERROR_CANCELED);
+        if(eiodp_fd->stream[i].openPkt != nullptr)MOONOS_FREE(eiodp_fd->stream[i].openPkt);
+    }
+    eiodpConfigPersistClose(eiodp_fd);
+
+    for(i=0;i<IODP_XMEM_L1;i++){
+        uint8** l2 = eiodp_fd->xmemDir[i];
+        if(l2 == nullptr)continue;
+        for(j=0;j<IODP_XMEM_L2;j++){
+            if(l2[j] != nullptr)MOONOS_FREE(l2[j]);
+        }
+        MOONOS_FREE(l2);
+    }
+    eIODP_FUNC_NODE* node = eiodp_fd->pFuncHead;
+    while(node != nullptr){
+        eIODP_FUNC_NODE* next = (eIODP_FUNC_NODE*)node->pNext;
+        MOONOS_FREE(node);
+        node = next;
+    }
+    if(eiodp_fd->funcTx != nullptr)MOONOS_FREE(eiodp_fd->funcTx);
+    if(eiodp_fd->streamTx != nullptr)MOONOS_FREE(eiodp_fd->streamTx);
+    if(eiodp_fd->pRwTx != nullptr)MOONOS_FREE(eiodp_fd->pRwTx);
+    if(eiodp_fd->pRwRx != nullptr)MOONOS_FREE(eiodp_fd->pRwRx);
+    delate_ring(eiodp_fd->retbuf_readaddr);
+    delate_ring(eiodp_fd->retbuf_func);
+    delate_ring(eiodp_fd->recv_ringbuf);
+
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_destroy(&eiodp_fd->mutex_rtt);
+    pthread_mutex_destroy(&eiodp_fd->mutex_flow);
+    pthread_mutex_destroy(&eiodp_fd->mutex_cfg);
+    pthread_mutex_destroy(&eiodp_fd->mutex_sub);
+    pthread_mutex_destroy(&eiodp_fd->mutex_stream);
+    pthread_mutex_destroy(&eiodp_fd->mutex_persist);
+    pthread_mutex_destroy(&eiodp_fd->mutex_rwrite);
+    pthread_mutex_destroy(&eiodp_fd->mutex_recv);
+    pthread_mutex_destroy(&eiodp_fd->mutex_pending);
+    sem_destroy(&eiodp_fd->flow_sem);
+    sem_destroy(&eiodp_fd->rwrite_sem);
+    sem_destroy(&eiodp_fd->readaddr_retsem);
+    sem_destroy(&eiodp_fd->func_retsem);
+    sem_destroy(&eiodp_fd->sem_recvSync);
+#elif (IODP_OS==IODP_OS_NULL)
+    if(eiodp_fd->txPending != nullptr)delate_ring(eiodp_fd->txPending);
+#endif
+    MOONOS_FREE(eiodp_fd);
+}
+
+//找到帧头
+static char* findhead(char* buf,int buflen)
+{
+    int i=0;
+    for(i=0;i<buflen-1;i++){
+        if(buf[i]==0xeb && buf[i+1]==0x90){
+            return &buf[i];
+        }
+    }
+    return NULL;
+}
+
+//通过code找到服务函数node
+static eIODP_FUNC_NODE* findFuncNode(eIODP_FUNC_NODE* pHead,uint16 code)
+{
+    eIODP_FUNC_NODE* p=pHead;
+    while(p){
+        if(p->funcode == code){
+            return p;
+        }
+        p=p->pNext;
+    }
+    return NULL;
+}
+//往服务函数链表中插入新函数节点
+static int addFuncNode(eIODP_FUNC_NODE* pHead,eIODP_FUNC_NODE* node)
+{
+    if(node == NULL){
+        return IODP_ERROR_PARAM;
+    }
+    if(node->pNext != NULL){
+        return IODP_ERROR_PARAM;//不是一个单独的节点
+    }
+    //find
+    eIODP_FUNC_NODE* p=pHead;
+    while(p){
+        if(p->funcode == node->funcode){
+            return IODP_ERROR_APINODE_REPEAT;//有重复code
+        }
+        if(p->pNext==NULL){
+            //add
+            p->pNext=node;
+            return 1;
+        }
+        p=p->pNext;
+    }
+
+    return -4;
+}
+
+
+//获取当前单调时间 单位us，用于超时与RTT计算
+static unsigned long long iodp_now(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd->tickFunc != nullptr){
+        //tick允许32位回绕，累计差值
+        uint32 tick = eiodp_fd->tickFunc();
+        eiodp_fd->tickTotal += (uint32)(tick - eiodp_fd->tickLast);
+        eiodp_fd->tickLast = tick;
+        return eiodp_fd->tickTotal*1000000ULL/eiodp_fd->tickHz;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (unsigned long long)tv.tv_sec*1000000ULL + tv.tv_nsec/1000;
+#else
+    //没有时钟源，按本实例的轮询次数估算
+    return eiodp_fd->pollCount*1000/IODP_NOS_LOOPS_PER_MS;
+#endif
+}
+
+//累计发送字节位置前进len，返回新的位置
+static uint32 flow_Advance(eIODP_TYPE* eiodp_fd, int len)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    return __atomic_add_fetch(&eiodp_fd->txOffset,(uint32)len,__ATOMIC_RELAXED);
+#else
+    eiodp_fd->txOffset += len;
+    return eiodp_fd->txOffset;
+#endif
+}
+
+//写数据包到io设备，所有发送都经过这里（eiodp_process期间写到调用者的输出缓存）
+//回复、确认、推送等不计入流量控制，直接用这个
+static int iodp_Write(eIODP_TYPE* eiodp_fd, unsigned char* buf, int len)
+{
+    if(eiodp_fd->outbuf != nullptr){
+        if(eiodp_fd->outlen + len > eiodp_fd->outcap){
+            IODP_LOGW("process outbuf full, drop %d bytes\n",len);
+            return -1;
+        }
+        memcpy(&eiodp_fd->outbuf[eiodp_fd->outlen],buf,len);
+        eiodp_fd->outlen += len;
+    }
+    else if(eiodp_fd->iodevWrite == nullptr){
+#if (IODP_OS==IODP_OS_NULL)
+        //没有io设备，暂存到下一次eiodp_process输出
+        if(eiodp_fd->txPending == nullptr || put_ring(eiodp_fd->txPending,buf,len) == -1)
+#endif
+        {
+            IODP_LOGW("no io device, drop %d bytes\n",len);
+            return -1;
+        }
+    }
+    else{
+        len = eiodp_fd->iodevWrite(eiodp_fd->iodevHandle,(char*)buf,len);
+    }
+    IODP_METRIC_INC(eiodp_fd,txFrames);
+    IODP_METRIC_ADD(eiodp_fd,txBytes,len);
+    return len;
+}
+
+/************************************************************
+    @brief:
+        写请求帧（经过flow_Acquire/flow_Check的首次发送），累计发送字节位置前进，
+        对方的返回据此确认；重传和回复等用iodp_Write，不计入
+    @param:
+        txEnd：不为NULL时返回这个包发出后的累计发送字节位置，用于流量控制
+*************************************************************/
+static int iodp_WriteEnd(eIODP_TYPE* eiodp_fd, unsigned char* buf, int len, uint32* txEnd)
+{
+    len = iodp_Write(eiodp_fd,buf,len);
+    uint32 end = flow_Advance(eiodp_fd,len>0?len:0);
+    if(txEnd)*txEnd = end;
+    return len;
+}
+
+//分段写出一帧，调用前检查iodevWritev，eiodp_process输出期间不使用
+static int iodp_WriteV(eIODP_TYPE* eiodp_fd, const void* const* bufs, const int* lens, int n)
+{
+    int len = eiodp_fd->iodevWritev(eiodp_fd->iodevHandle,bufs,lens,n);
+    IODP_METRIC_INC(eiodp_fd,txFrames);
+    IODP_METRIC_ADD(eiodp_fd,txBytes,len);
+    return len;
+}
+
+#if (IODP_METRICS_ENABLE)
+//时延对应的直方图桶：小于IODP_HIST_SUB的值线性，之后每个2的幂区间分IODP_HIST_SUB个子桶
+static int hist_Bucket(uint32 v)
+{
+    if(v < IODP_HIST_SUB)return v;
+    int msb = 31;
+    while(!(v & (1UL<<msb)))msb--;
+    int mag = msb - IODP_HIST_SUBBITS + 1;
+    if(mag >= IODP_HIST_MAG)return IODP_HIST_BUCKETS-1;
+    int sub = (v >> (msb - IODP_HIST_SUBBITS)) & (IODP_HIST_SUB-1);
+    return mag*IODP_HIST_SUB + sub;
+}
+
+//桶的上界（不含）
+static uint32 hist_BucketTop(int b)
+{
+    int mag = b / IODP_HIST_SUB;
+    int sub = b % IODP_HIST_SUB;
+    if(mag == 0)return sub+1;
+    return (uint32)(IODP_HIST_SUB + sub + 1) << (mag-1);
+}
+#endif
+
+//记录一次往返时延
+static void metrics_Latency(eIODP_TYPE* eiodp_fd, int op, unsigned long long us)
+{
+#if (IODP_METRICS_ENABLE)
+    uint32 v = us > 0xffffffffULL ? 0xffffffff : (uint32)us;
+    eIODP_HIST* h = &eiodp_fd->metrics.lat[op];
+    IODP_ATOMIC_ADD(&h->count[hist_Bucket(v)],1);
+    IODP_ATOMIC_ADD(&h->total,1);
+    IODP_ATOMIC_MAX(&h->max,v);
+#endif
+}
+
+//加入一个RTT样本，按RFC6298更新srtt/rttvar/rto
+static void rtt_Sample(eIODP_TYPE* eiodp_fd, int op, unsigned long long r)
+{
+    if(r > IODP_RTO_MAX)r = IODP_RTO_MAX;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rtt);
+#endif
+    eIODP_RTT* p = &eiodp_fd->rtt[op];
+    if(!p->valid){
+        p->srtt = (uint32)r;
+        p->rttvar = (uint32)r/2;
+        p->valid = 1;
+    }
+    else{
+        uint32 err = p->srtt > r ? p->srtt-(uint32)r : (uint32)r-p->srtt;
+        p->rttvar = p->rttvar - p->rttvar/4 + err/4;
+        p->srtt = p->srtt - p->srtt/8 + (uint32)r/8;
+    }
+    unsigned long long rto = (unsigned long long)p->srtt + 4ULL*p->rttvar;
+    if(rto < IODP_RTO_MIN)rto = IODP_RTO_MIN;
+    if(rto > IODP_RTO_MAX)rto = IODP_RTO_MAX;
+    p->rto = (uint32)rto;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rtt);
+#endif
+}
+
+//超时后退避，rto加倍，直到收到新的样本
+static void rtt_Backoff(eIODP_TYPE* eiodp_fd, int op)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rtt);
+#endif
+    eIODP_RTT* p = &eiodp_fd->rtt[op];
+    p->rto = (p->rto*2 > IODP_RTO_MAX) ? IODP_RTO_MAX : p->rto*2;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rtt);
+#endif
+}
+
+//---------------------------flow control----------------------------
+
+//对方返回了txEnd之前发出的请求，归还额度
+static void flow_Ack(eIODP_TYPE* eiodp_fd, uint32 txEnd)
+{
+    if(!eiodp_fd->flowMode)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    uint32 old = __atomic_load_n(&eiodp_fd->peerAcked,__ATOMIC_RELAXED);
+    while((int)(txEnd - old) > 0 &&
+          !__atomic_compare_exchange_n(&eiodp_fd->peerAcked,&old,txEnd,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED));
+    sem_post(&eiodp_fd->flow_sem);
+#else
+    if((int)(txEnd - eiodp_fd->peerAcked) > 0)eiodp_fd->peerAcked = txEnd;
+#endif
+}
+
+//额度是否足够发送len字节，窗口比包小时只要没有在途数据就放行
+//额度用完之后还要发探测包，预留一个探测包(12字节)的空间
+static int flow_HasCredit(eIODP_TYPE* eiodp_fd, int len)
+{
+    uint32 acked = IODP_ATOMIC_LOAD(&eiodp_fd->peerAcked);
+    uint32 win = IODP_ATOMIC_LOAD(&eiodp_fd->peerWindow);
+    uint32 inflight = IODP_ATOMIC_LOAD(&eiodp_fd->txOffset) - acked;
+    if(win == 0)return 0;
+    return (inflight + len + 12 <= win) || (inflight == 0);
+}
+
+/************************************************************
+    @brief:
+        发送额度探测，上一个探测超时则重发，连续IODP_FLOW_PROBE_MAX次没有回应时：
+        从来没有回应过说明对方不支持，关闭流量控制；否则认为对方缓存已经清空。
+    @return:
+        0 - 已有探测在途或已发出  1 - 放弃等待，可以直接发送
+*************************************************************/
+static int flow_Probe(eIODP_TYPE* eiodp_fd)
+{
+    unsigned long long now = iodp_now(eiodp_fd);
+    if(eiodp_fd->probeToken != 0){
+        if(now - eiodp_fd->probeTime < eiodp_fd->rtt[IODP_RTT_ADDR].rto)return 0;
+        if(++eiodp_fd->probeFail >= IODP_FLOW_PROBE_MAX){
+            eiodp_fd->probeToken = 0;
+            eiodp_fd->probeFail = 0;
+            if(eiodp_fd->peerWindow == 0){
+                IODP_LOGW("peer does not answer credit probe, flow control off\n");
+                eiodp_fd->flowMode = 0;
+            }
+            else{
+                IODP_LOGW("credit probe no answer, assume peer drained\n");
+                IODP_ATOMIC_STORE(&eiodp_fd->peerAcked,IODP_ATOMIC_LOAD(&eiodp_fd->txOffset));
+            }
+            return 1;
+        }
+    }
+    unsigned short token = eiodp_fd->probeToken + 1;
+    if(token == 0)token = 1;
+    unsigned char sendbuf[12];
+    unsigned short pktsize=8;
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_CREDIT;
+    sendbuf[6]=(unsigned char)(token>>8)&0xff;
+    sendbuf[7]=(unsigned char)(token)&0xff;
+    updatepktcrc(sendbuf,pktsize+4);
+    eiodp_fd->probeTime = now;
+    IODP_METRIC_INC(eiodp_fd,flowProbes);
+    //先登记再发送，返回可能在发送函数返回之前就到了；探测本身不计入发送位置
+    eiodp_fd->probeEnd = IODP_ATOMIC_LOAD(&eiodp_fd->txOffset);
+    IODP_ATOMIC_STORE(&eiodp_fd->probeToken,token);
+    iodp_Write(eiodp_fd,sendbuf,pktsize+4);
+    return 0;
+}
+
+//额度探测的返回 6C05 token window
+static void flow_onProbeAck(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktsize<8)return;
+    unsigned short token = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    uint32 win = ((uint32)pktbuf[4] << 24) | ((uint32)pktbuf[5] << 16) |
+                 ((uint32)pktbuf[6] << 8) | ((uint32)pktbuf[7]);
+    if(token == 0 || token != IODP_ATOMIC_LOAD(&eiodp_fd->probeToken))return;
+    IODP_ATOMIC_STORE(&eiodp_fd->peerWindow,win);
+    eiodp_fd->probeFail = 0;
+    flow_Ack(eiodp_fd,eiodp_fd->probeEnd);
+    IODP_ATOMIC_STORE(&eiodp_fd->probeToken,0);
+#if (IODP_OS==IODP_OS_LINUX)
+    sem_post(&eiodp_fd->flow_sem);
+#endif
+}
+
+//等待额度返回（linux下等信号量，无操作系统下处理一次接收）
+static void flow_Wait(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    struct timespec tv;
+    clock_gettime(CLOCK_REALTIME, &tv);
+    tv.tv_nsec += 10*1000*1000;
+    if(tv.tv_nsec >= 1000000000){tv.tv_sec++;tv.tv_nsec -= 1000000000;}
+    sem_timedwait(&eiodp_fd->flow_sem,&tv);
+#elif (IODP_OS==IODP_OS_NULL)
+    eiodp_recvProcessTask_nos(eiodp_fd);
+#endif
+}
+
+//发送请求前等待额度
+static void flow_Acquire(eIODP_TYPE* eiodp_fd, int len)
+{
+    int stalled = 0;
+    if(!eiodp_fd->flowMode)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_flow);
+#endif
+    while(eiodp_fd->flowMode && !flow_HasCredit(eiodp_fd,len)){
+        if(!stalled && eiodp_fd->peerWindow){
+            IODP_METRIC_INC(eiodp_fd,flowStalls);
+            stalled = 1;
+        }
+        if(flow_Probe(eiodp_fd))break;
+        flow_Wait(eiodp_fd);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_flow);
+#endif
+}
+
+#if (IODP_OS==IODP_OS_NULL || IODP_OS==IODP_OS_LINUX)
+//异步请求用：额度不够时发探测并返回0，不等待
+static int flow_Check(eIODP_TYPE* eiodp_fd, int len)
+{
+    int ret;
+    if(!eiodp_fd->flowMode || flow_HasCredit(eiodp_fd,len))return 1;
+    if(eiodp_fd->peerWindow)IODP_METRIC_INC(eiodp_fd,flowStalls);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_flow);
+#endif
+    ret = flow_Probe(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_flow);
+#endif
+    return ret;
+}
+#endif
+
+/************************************************************
+    @brief:
+        额度探测处理 type EC05，返回本端接收窗口
+*************************************************************/
+static int credit_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_CREDIT || pktsize<4)return IODP_ERROR_API_HEAD;
+#if (IODP_OS==IODP_OS_NULL)
+    uint32 win = IODP_NOS_RXWINDOW;
+#else
+    uint32 win = eiodp_fd->recv_ringbuf->bufSize-1;
+#endif
+    unsigned char retbuf[16];
+    unsigned short retpktsize=12;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=IODP_TYPE_CREDIT;
+    retbuf[6]=pktbuf[2];
+    retbuf[7]=pktbuf[3];
+    retbuf[8]=(unsigned char)(win>>24)&0xff;
+    retbuf[9]=(unsigned char)(win>>16)&0xff;
+    retbuf[10]=(unsigned char)(win>>8)&0xff;
+    retbuf[11]=(unsigned char)(win)&0xff;
+    updatepktcrc(retbuf,16);
+    iodp_Write(eiodp_fd,retbuf,16);
+    return IODP_OK;
+}
+
+void eiodpSetFlowControl(eIODP_TYPE* eiodp_fd,int enable)
+{
+    if(eiodp_fd == nullptr)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_flow);
+#endif
+    eiodp_fd->probeToken = 0;
+    eiodp_fd->probeFail = 0;
+    eiodp_fd->peerWindow = 0;
+    eiodp_fd->peerAcked = eiodp_fd->txOffset;
+    eiodp_fd->flowMode = enable ? 1 : 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_flow);
+#endif
+}
+
+//---------------------------configmem seqlock----------------------------
+
+//开始写配置空间，一个包的全部修改放在一次begin/end之间，对读者整体可见
+static void cfg_WriteBegin(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    eiodp_fd->touchCnt = 0;
+    IODP_ATOMIC_STORE(&eiodp_fd->cfgSeq,eiodp_fd->cfgSeq+1);
+    IODP_FENCE_REL();
+}
+
+//一个需要通知的监视
+typedef struct
+{
+    eIODP_WATCH_CB cb;
+    void* ctx;
+    uint16 addr;
+    uint16 len;
+}eIODP_WATCH_HIT;
+
+//用块位图找出与这次写入重叠的监视，每个监视合并成一个范围，在写锁内调用
+static int watch_Collect(eIODP_TYPE* eiodp_fd, eIODP_WATCH_HIT* hit)
+{
+    uint32 mask = 0;
+    int t, w, n = 0;
+    unsigned int b;
+    for(t=0;t<eiodp_fd->touchCnt;t++){
+        unsigned int a = eiodp_fd->touchAddr[t];
+        for(b=a/IODP_CFG_BLOCK;b<=(a+eiodp_fd->touchLen[t]-1)/IODP_CFG_BLOCK;b++){
+            mask |= eiodp_fd->watchMask[b];
+        }
+    }
+    for(w=0;mask && w<IODP_WATCH_MAX;w++){
+        if(!(mask & (1UL<<w)))continue;
+        mask &= ~(1UL<<w);
+        eIODP_WATCH* wt = &eiodp_fd->watch[w];
+        unsigned int lo = 0xffff, hi = 0;
+        for(t=0;t<eiodp_fd->touchCnt;t++){
+            unsigned int s = eiodp_fd->touchAddr[t];
+            unsigned int e = s + eiodp_fd->touchLen[t];
+            if(s < wt->addr)s = wt->addr;
+            if(e > (unsigned int)wt->addr+wt->len)e = wt->addr+wt->len;
+            if(s >= e)continue;
+            if(s < lo)lo = s;
+            if(e > hi)hi = e;
+        }
+        if(lo >= hi)continue;
+        hit[n].cb = wt->cb;
+        hit[n].ctx = wt->ctx;
+        hit[n].addr = lo;
+        hit[n].len = hi-lo;
+        n++;
+    }
+    return n;
+}
+
+#define SUB_ISDIRTY(ss,i) ((ss)->dirty[(i)>>3] & (1<<((i)&7)))
+
+//订阅范围内[lo,hi)标记为脏
+static void sub_SetDirty(eIODP_SUB_SRV* ss, unsigned int lo, unsigned int hi)
+{
+    unsigned int i;
+    if(lo < ss->addr)lo = ss->addr;
+    if(hi > (unsigned int)ss->addr+ss->len)hi = ss->addr+ss->len;
+    for(i=lo;i<hi;i++)ss->dirty[i>>3] |= 1<<(i&7);
+}
+
+//把这次写入的地址段标记到对方的订阅，在写锁内调用，本端写入同样标记
+static void sub_MarkDirty(eIODP_TYPE* eiodp_fd)
+{
+    uint32 dirty = 0;
+    int s, t;
+    for(s=0;s<IODP_SUB_MAX;s++){
+        eIODP_SUB_SRV* ss = &eiodp_fd->subSrv[s];
+        if(!ss->used)continue;
+        for(t=0;t<eiodp_fd->touchCnt;t++){
+            unsigned int lo = eiodp_fd->touchAddr[t];
+            unsigned int hi = lo + eiodp_fd->touchLen[t];
+            if(lo >= (unsigned int)ss->addr+ss->len || hi <= ss->addr)continue;
+            sub_SetDirty(ss,lo,hi);
+            dirty |= (1UL<<s);
+        }
+    }
+    if(dirty)IODP_ATOMIC_STORE(&eiodp_fd->subDirty,eiodp_fd->subDirty|dirty);
+}
+
+//结束写入；notify为1时写入可见之后调用重叠的监视（在写锁之外，回调中可以读写配置空间）
+static void cfg_WriteEnd(eIODP_TYPE* eiodp_fd, int notify)
+{
+    eIODP_WATCH_HIT hit[IODP_WATCH_MAX];
+    int i, n = 0;
+    IODP_FENCE_REL();
+    IODP_ATOMIC_STORE(&eiodp_fd->cfgSeq,eiodp_fd->cfgSeq+1);
+    if(notify)n = watch_Collect(eiodp_fd,hit);
+    sub_MarkDirty(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    for(i=0;i<n;i++)hit[i].cb(hit[i].ctx,hit[i].addr,hit[i].len);
+}
+
+//开始读，等到没有写入进行中，返回当时的序号
+static uint32 cfg_ReadBegin(eIODP_TYPE* eiodp_fd)
+{
+    uint32 seq;
+    while((seq = IODP_ATOMIC_LOAD(&eiodp_fd->cfgSeq)) & 1){
+#if (IODP_OS==IODP_OS_LINUX)
+        sched_yield();
+#endif
+    }
+    IODP_FENCE_ACQ();
+    return seq;
+}
+
+//读期间有写入发生，需要重读
+static int cfg_ReadRetry(eIODP_TYPE* eiodp_fd, uint32 seq)
+{
+    IODP_FENCE_ACQ();
+    return IODP_ATOMIC_LOAD(&eiodp_fd->cfgSeq) != seq;
+}
+
+//读配置空间的一致快照，调用前检查好范围
+static void configmem_Read(eIODP_TYPE* eiodp_fd, unsigned short addr, unsigned short len, unsigned char* buf)
+{
+    uint32 seq;
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        memcpy(buf,&eiodp_fd->configmem[addr],len);
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+}
+
+/************************************************************
+    @brief:
+        写配置空间，所有远程写操作都经过这里，必须在cfg_WriteBegin/cfg_WriteEnd之间调用
+    @param:
+        eiodp_fd：eiodp句柄
+        addr：配置空间地址
+        len：数据长度
+        data：数据
+    @return:
+        实际写入的长度，超出配置空间的部分被丢弃
+*************************************************************/
+static int configmem_Write(eIODP_TYPE* eiodp_fd, unsigned short addr, unsigned short len, unsigned char* data)
+{
+    if(addr>=eiodp_fd->configmemSize)return 0;
+    if(len>(eiodp_fd->configmemSize-addr))len = eiodp_fd->configmemSize-addr;
+    if(len==0)return 0;
+    memcpy(&eiodp_fd->configmem[addr],data,len);
+    //记录写过的地址段，放不下时并入最后一段
+    if(eiodp_fd->touchCnt < IODP_MRANGE_MAX){
+        eiodp_fd->touchAddr[eiodp_fd->touchCnt] = addr;
+        eiodp_fd->touchLen[eiodp_fd->touchCnt] = len;
+        eiodp_fd->touchCnt++;
+    }
+    else{
+        int t = IODP_MRANGE_MAX-1;
+        unsigned int s = eiodp_fd->touchAddr[t], e = s + eiodp_fd->touchLen[t];
+        if(addr < s)s = addr;
+        if((unsigned int)addr+len > e)e = addr+len;
+        eiodp_fd->touchAddr[t] = s;
+        eiodp_fd->touchLen[t] = e-s;
+    }
+    //块版本记为这次写入结束后的序号
+    unsigned int b;
+    for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++){
+        IODP_ATOMIC_STORE(&eiodp_fd->blkver[b],eiodp_fd->cfgSeq+1);
+    }
+    return len;
+}
+
+//---------------------------扩展地址空间----------------------------
+
+//取扩展空间第pg页，alloc为1时没有分配过就分配（在写锁内调用），为0时没有分配过返回NULL
+static uint8* xmem_Page(eIODP_TYPE* eiodp_fd, uint32 pg, int alloc)
+{
+    uint8** l2 = eiodp_fd->xmemDir[pg/IODP_XMEM_L2];
+    if(l2 == nullptr){
+        if(!alloc)return nullptr;
+        l2 = MOONOS_MALLOC(sizeof(uint8*)*IODP_XMEM_L2);
+        if(l2 == nullptr)return nullptr;
+        memset(l2,0,sizeof(uint8*)*IODP_XMEM_L2);
+        IODP_FENCE_REL();
+        eiodp_fd->xmemDir[pg/IODP_XMEM_L2] = l2;
+    }
+    uint8* page = l2[pg%IODP_XMEM_L2];
+    if(page == nullptr && alloc){
+        if(eiodp_fd->xmemPages >= IODP_XMEM_MAXPAGES)return nullptr;
+        page = MOONOS_MALLOC(IODP_XMEM_PAGE);
+        if(page == nullptr)return nullptr;
+        memset(page,0,IODP_XMEM_PAGE);
+        //页清零之后才对读者可见
+        IODP_FENCE_REL();
+        l2[pg%IODP_XMEM_L2] = page;
+        eiodp_fd->xmemPages++;
+    }
+    return page;
+}
+
+/************************************************************
+    @brief:
+        写扩展地址空间，必须在cfg_WriteBegin/cfg_WriteEnd之间调用。
+        [0,configmemSize)写到配置空间，其余写到页中，页在第一次写入时分配
+    @return:
+        实际写入的长度，超出空间或者页数达到IODP_XMEM_MAXPAGES时后面的部分被丢弃
+*************************************************************/
+static uint32 xmem_Write(eIODP_TYPE* eiodp_fd, uint32 addr, uint32 len, const uint8* data)
+{
+    uint32 done = 0;
+    if(addr >= IODP_XMEM_SIZE)return 0;
+    if(len > IODP_XMEM_SIZE-addr)len = IODP_XMEM_SIZE-addr;
+    if(addr < eiodp_fd->configmemSize){
+        uint32 n = eiodp_fd->configmemSize-addr;
+        if(n > len)n = len;
+        done = configmem_Write(eiodp_fd,addr,n,(unsigned char*)data);
+    }
+    while(done < len){
+        uint32 a = addr+done;
+        uint32 n = IODP_XMEM_PAGE - a%IODP_XMEM_PAGE;
+        if(n > len-done)n = len-done;
+        uint8* page = xmem_Page(eiodp_fd,a/IODP_XMEM_PAGE,1);
+        if(page == nullptr)break;
+        memcpy(&page[a%IODP_XMEM_PAGE],&data[done],n);
+        done += n;
+    }
+    return done;
+}
+
+//读扩展地址空间的一致快照，调用前检查好范围；没有分配的页读出为0，不分配
+static void xmem_Read(eIODP_TYPE* eiodp_fd, uint32 addr, uint32 len, uint8* buf)
+{
+    uint32 seq;
+    do{
+        uint32 done = 0;
+        seq = cfg_ReadBegin(eiodp_fd);
+        if(addr < eiodp_fd->configmemSize){
+            done = eiodp_fd->configmemSize-addr;
+            if(done > len)done = len;
+            memcpy(buf,&eiodp_fd->configmem[addr],done);
+        }
+        while(done < len){
+            uint32 a = addr+done;
+            uint32 n = IODP_XMEM_PAGE - a%IODP_XMEM_PAGE;
+            if(n > len-done)n = len-done;
+            uint8* page = xmem_Page(eiodp_fd,a/IODP_XMEM_PAGE,0);
+            if(page)memcpy(&buf[done],&page[a%IODP_XMEM_PAGE],n);
+            else memset(&buf[done],0,n);
+            done += n;
+        }
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+}
+
+//---------------------------配置空间持久化----------------------------
+
+#if (IODP_PERSIST_ENABLE)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PERSIST_HDR(ps,i) ((eIODP_PERSIST_HDR*)((ps)->map + (i)*IODP_PERSIST_ALIGN))
+#define PERSIST_LIVE(ps) ((ps)->map + 2*IODP_PERSIST_ALIGN)
+#define PERSIST_SLOT(ps,i) ((ps)->map + 2*IODP_PERSIST_ALIGN + (1+(i))*(ps)->area)
+
+//文件头的CRC，不包含hdrcrc本身
+static uint32 persist_HdrCrc(eIODP_PERSIST_HDR* h)
+{
+    return (uint32)crc32(h,sizeof(eIODP_PERSIST_HDR)-sizeof(uint32));
+}
+
+//把映射中的一段同步写回文件，起点向下对齐到页
+static int persist_Sync(eIODP_PERSIST* ps, uint8* p, uint32 len)
+{
+    unsigned long pg = (unsigned long)sysconf(_SC_PAGESIZE);
+    uint8* start = ps->map + ((unsigned long)(p - ps->map)/pg)*pg;
+    return msync(start,(p+len)-start,MS_SYNC);
+}
+
+//槽i是否是完整的检查点：文件头与数据的CRC都正确
+static int persist_Valid(eIODP_PERSIST* ps, int i, uint32 size)
+{
+    eIODP_PERSIST_HDR* h = PERSIST_HDR(ps,i);
+    if(h->magic != IODP_PERSIST_MAGIC || h->size != size || h->seq == 0)return 0;
+    if(h->hdrcrc != persist_HdrCrc(h))return 0;
+    return h->datacrc == (uint32)crc32(PERSIST_SLOT(ps,i),size);
+}
+
+/************************************************************
+    @brief:
+        写检查点，linux下在mutex_persist内调用。
+        快照写到较旧的槽并msync，之后才写这个槽的文件头，最新的检查点在整个过程中保持完整
+    @return:
+        IODP_ERROR_PKT - msync失败
+        0 - 从上一个检查点以来没有写入
+        1 - 已写入
+*************************************************************/
+static int persist_Checkpoint(eIODP_TYPE* eiodp_fd)
+{
+    eIODP_PERSIST* ps = eiodp_fd->pPersist;
+    uint32 size = eiodp_fd->configmemSize;
+    uint32 seq;
+    int t = (ps->slot == 0) ? 1 : 0;
+    uint8* slot = PERSIST_SLOT(ps,t);
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        if(seq == ps->savedCfgSeq)return 0;
+        memcpy(slot,eiodp_fd->configmem,size);
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+    if(persist_Sync(ps,slot,size) != 0)return IODP_ERROR_PKT;
+
+    eIODP_PERSIST_HDR* h = PERSIST_HDR(ps,t);
+    h->magic = IODP_PERSIST_MAGIC;
+    h->size = size;
+    h->seq = ps->seq+1;
+    h->datacrc = (uint32)crc32(slot,size);
+    h->hdrcrc = persist_HdrCrc(h);
+    if(persist_Sync(ps,(uint8*)h,sizeof(eIODP_PERSIST_HDR)) != 0)return IODP_ERROR_PKT;
+    ps->seq++;
+    ps->slot = t;
+    ps->savedCfgSeq = seq;
+    return 1;
+}
+
+//接收任务中调用：有写入并且距离上一次超过间隔时写检查点
+static void persist_Service(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd->pPersist == nullptr)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_persist);
+#endif
+    eIODP_PERSIST* ps = eiodp_fd->pPersist;
+    if(ps != nullptr && ps->interval_us != 0 &&
+       IODP_ATOMIC_LOAD(&eiodp_fd->cfgSeq) != ps->savedCfgSeq){
+        unsigned long long now = iodp_now(eiodp_fd);
+        if(now - ps->lastTime >= ps->interval_us){
+            ps->lastTime = now;
+            if(persist_Checkpoint(eiodp_fd) < 0)IODP_LOGW("configmem checkpoint fail\n");
+        }
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_persist);
+#endif
+}
+#else
+#define persist_Service(fd) ((void)0)
+#endif
+
+//---------------------------虚拟读范围----------------------------
+
+//找出与读请求重叠的虚拟读范围，返回范围编号的位图
+static uint32 vreg_Match(eIODP_TYPE* eiodp_fd, unsigned short addr, unsigned short len)
+{
+    uint32 mask = 0, hit = 0;
+    unsigned int b;
+    int v;
+    if(len == 0 || IODP_ATOMIC_LOAD(&eiodp_fd->vregUsed) == 0)return 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++){
+        mask |= eiodp_fd->vregMask[b];
+    }
+    for(v=0;mask && v<IODP_VREG_MAX;v++){
+        if(!(mask & (1UL<<v)))continue;
+        mask &= ~(1UL<<v);
+        eIODP_VREG* vr = &eiodp_fd->vreg[v];
+        if(vr->addr < (unsigned int)addr+len && addr < (unsigned int)vr->addr+vr->len)hit |= (1UL<<v);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return hit;
+}
+
+//一个需要填充的虚拟读范围
+typedef struct
+{
+    int id;
+    int ok;
+    eIODP_VREG v;
+}eIODP_VREG_HIT;
+
+/************************************************************
+    @brief:
+        填充ids中缓存过期的虚拟读范围，在读配置空间快照之前调用。
+        填充函数在锁外调用，结果在一次写入事务中写入配置空间，不触发写入监视
+    @param:
+        eiodp_fd：eiodp句柄
+        ids：vreg_Match返回的范围位图
+*************************************************************/
+static void vreg_Fill(eIODP_TYPE* eiodp_fd, uint32 ids)
+{
+    eIODP_VREG_HIT hit[IODP_VREG_MAX];
+    unsigned int total = 0, off;
+    int v, i, n = 0;
+    if(ids == 0)return;
+    unsigned long long now = iodp_now(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    for(v=0;v<IODP_VREG_MAX;v++){
+        if(!(ids & eiodp_fd->vregUsed & (1UL<<v)))continue;
+        eIODP_VREG* vr = &eiodp_fd->vreg[v];
+        if(vr->valid && vr->ttl_us && now - vr->fillTime < vr->ttl_us)continue;
+        hit[n].id = v;
+        hit[n].v = *vr;
+        total += vr->len;
+        n++;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    if(n == 0)return;
+    unsigned char* buf = MOONOS_MALLOC(total);
+    if(buf == nullptr)return;
+    for(i=0,off=0;i<n;i++){
+        hit[i].ok = (hit[i].v.cb(hit[i].v.ctx,hit[i].v.addr,hit[i].v.len,&buf[off]) == 0);
+        off += hit[i].v.len;
+    }
+    cfg_WriteBegin(eiodp_fd);
+    for(i=0,off=0;i<n;i++){
+        eIODP_VREG* vr = &eiodp_fd->vreg[hit[i].id];
+        //填充期间被取消或者重新映射的不写入
+        if(hit[i].ok && (eiodp_fd->vregUsed & (1UL<<hit[i].id)) && vr->cb == hit[i].v.cb &&
+           vr->addr == hit[i].v.addr && vr->len == hit[i].v.len){
+            configmem_Write(eiodp_fd,vr->addr,vr->len,&buf[off]);
+            vr->valid = 1;
+            vr->fillTime = now;
+        }
+        off += hit[i].v.len;
+    }
+    cfg_WriteEnd(eiodp_fd,0);
+    MOONOS_FREE(buf);
+}
+
+/************************************************************
+    @brief:
+        写地址处理函数 type EC01
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        -1为帧头错误 
+        0为地址溢出错误（会有返回iodp） 
+        1为正确
+*************************************************************/
+static int writeaddr_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize){
+    if(pktbuf[0]!=0xec || pktbuf[1]!=0x01)return IODP_ERROR_WADDR_HEAD;
+    unsigned short addr = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short len = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    cfg_WriteBegin(eiodp_fd);
+    int wlen = configmem_Write(eiodp_fd,addr,len,&pktbuf[6]);
+    cfg_WriteEnd(eiodp_fd,1);
+    if(wlen<len)return 0;
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        读地址处理函数 type EC02
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_RADDR_HEAD 为帧头错误 
+        0为地址溢出错误（会有返回iodp） 
+        1为正确
+*************************************************************/
+static int readaddr_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=0x02)return IODP_ERROR_RADDR_HEAD;
+    unsigned short addr = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short len = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+
+    if(addr>=eiodp_fd->configmemSize){
+        unsigned char retbuf[11];
+        unsigned short retpktsize=7;
+        retbuf[0]=0xeb;
+        retbuf[1]=0x90;
+        retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+        retbuf[3]=(unsigned char)(retpktsize)&0xff;
+        retbuf[4]=0x2c; //type error pkt
+        retbuf[5]=0x02;
+        retbuf[6]=0x01; //error code
+        updatepktcrc(retbuf,11);
+        //IOWRITE(devfd,retbuf,11);
+        iodp_Write(eiodp_fd,retbuf,11);
+        return 0;
+    }
+
+    unsigned char *retbuf = MOONOS_MALLOC(14+len);
+    unsigned short retlen = len;
+    if(len>(eiodp_fd->configmemSize-addr))retlen = (eiodp_fd->configmemSize-addr);
+    unsigned short retpktsize=10+retlen;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=0x02;
+    retbuf[6]=(unsigned char)(addr>>8)&0xff;
+    retbuf[7]=(unsigned char)(addr)&0xff;
+    retbuf[8]=(unsigned char)(retlen>>8)&0xff;
+    retbuf[9]=(unsigned char)(retlen)&0xff;
+    vreg_Fill(eiodp_fd,vreg_Match(eiodp_fd,addr,retlen));
+    configmem_Read(eiodp_fd,addr,retlen,&retbuf[10]);
+    updatepktcrc(retbuf,retpktsize+4);
+    //IOWRITE(devfd,retbuf,retpktsize+4);
+    iodp_Write(eiodp_fd,retbuf,retpktsize+4);
+    MOONOS_FREE(retbuf);
+    return 1;
+}
+
+//返回错误包 2Cxx eCODE
+static void errpkt_Send(eIODP_TYPE* eiodp_fd, unsigned char type, unsigned char ecode)
+{
+    unsigned char retbuf[11];
+    unsigned short retpktsize=7;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x2c;
+    retbuf[5]=type;
+    retbuf[6]=ecode;
+    updatepktcrc(retbuf,11);
+    iodp_Write(eiodp_fd,retbuf,11);
+}
+
+/************************************************************
+    @brief:
+        多段读处理函数 type EC06
+        请求：EC06 tag count {addr len}*count
+        返回：6C06 tag len DATA，各段数据按请求顺序首尾相接
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为地址溢出或格式错误（会有返回iodp）
+        1为正确
+*************************************************************/
+static int mread_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_MREAD || pktsize<6)return IODP_ERROR_API_HEAD;
+    unsigned short count = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    if(count==0 || count>IODP_MRANGE_MAX || pktsize!=6+4*count){
+        errpkt_Send(eiodp_fd,IODP_TYPE_MREAD,0x02);
+        return 0;
+    }
+    //先检查全部地址段，任何一段越界都不返回数据
+    unsigned int total=0;
+    int i;
+    for(i=0;i<count;i++){
+        unsigned char* r = &pktbuf[6+4*i];
+        unsigned short addr = ((unsigned short)r[0] << 8) | ((unsigned short)r[1]) ;
+        unsigned short len = ((unsigned short)r[2] << 8) | ((unsigned short)r[3]) ;
+        if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr)){
+            errpkt_Send(eiodp_fd,IODP_TYPE_MREAD,0x01);
+            return 0;
+        }
+        total += len;
+    }
+    //返回包必须能被对方的解析器接收
+    if(total+16>IODP_RECV_MAX_LEN){
+        errpkt_Send(eiodp_fd,IODP_TYPE_MREAD,0x03);
+        return 0;
+    }
+
+    unsigned char *retbuf = MOONOS_MALLOC(14+total);
+    if(retbuf == nullptr)return 0;
+    unsigned short retpktsize=10+total;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=IODP_TYPE_MREAD;
+    retbuf[6]=pktbuf[2];
+    retbuf[7]=pktbuf[3];
+    retbuf[8]=(unsigned char)(total>>8)&0xff;
+    retbuf[9]=(unsigned char)(total)&0xff;
+    //各段碰到的虚拟读范围一起填充，同一个范围只填充一次
+    uint32 ids = 0;
+    for(i=0;i<count;i++){
+        unsigned char* r = &pktbuf[6+4*i];
+        unsigned short addr = ((unsigned short)r[0] << 8) | ((unsigned short)r[1]) ;
+        unsigned short len = ((unsigned short)r[2] << 8) | ((unsigned short)r[3]) ;
+        ids |= vreg_Match(eiodp_fd,addr,len);
+    }
+    vreg_Fill(eiodp_fd,ids);
+    //全部地址段取同一个快照
+    uint32 seq;
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        unsigned int off=10;
+        for(i=0;i<count;i++){
+            unsigned char* r = &pktbuf[6+4*i];
+            unsigned short addr = ((unsigned short)r[0] << 8) | ((unsigned short)r[1]) ;
+            unsigned short len = ((unsigned short)r[2] << 8) | ((unsigned short)r[3]) ;
+            memcpy(&retbuf[off],&(eiodp_fd->configmem[addr]),len);
+            off += len;
+        }
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+    updatepktcrc(retbuf,retpktsize+4);
+    iodp_Write(eiodp_fd,retbuf,retpktsize+4);
+    MOONOS_FREE(retbuf);
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        多段写处理函数 type EC07
+        请求：EC07 count {addr len DATA}*count，无返回
+        先检查全部地址段，有一段越界或者长度不对整包丢弃，全部合法才写入
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为地址溢出或格式错误，没有写入
+        1为正确
+*************************************************************/
+static int mwrite_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_MWRITE || pktsize<4)return IODP_ERROR_API_HEAD;
+    unsigned short count = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    if(count==0 || count>IODP_MRANGE_MAX){
+        IODP_LOGW("mwrite count %u error\n",count);
+        return 0;
+    }
+    int i, off=4;
+    for(i=0;i<count;i++){
+        if(off+4>pktsize)break;
+        unsigned short addr = ((unsigned short)pktbuf[off] << 8) | ((unsigned short)pktbuf[off+1]) ;
+        unsigned short len = ((unsigned short)pktbuf[off+2] << 8) | ((unsigned short)pktbuf[off+3]) ;
+        if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr))break;
+        off += 4+len;
+    }
+    if(i<count || off!=pktsize){
+        IODP_LOGW("mwrite range %d error, dropped\n",i);
+        return 0;
+    }
+    off=4;
+    cfg_WriteBegin(eiodp_fd);
+    for(i=0;i<count;i++){
+        unsigned short addr = ((unsigned short)pktbuf[off] << 8) | ((unsigned short)pktbuf[off+1]) ;
+        unsigned short len = ((unsigned short)pktbuf[off+2] << 8) | ((unsigned short)pktbuf[off+3]) ;
+        configmem_Write(eiodp_fd,addr,len,&pktbuf[off+4]);
+        off += 4+len;
+    }
+    cfg_WriteEnd(eiodp_fd,1);
+    return 1;
+}
+
+//---------------------------条件读----------------------------
+
+//PackBits编码：控制字节n为0~127时后面跟n+1个原始字节，为129~255时后面一个字节重复257-n次。
+//输出超过cap时返回-1
+static int rle_Encode(const unsigned char* in, unsigned int n, unsigned char* out, int cap)
+{
+    unsigned int i = 0;
+    int o = 0;
+    while(i < n){
+        unsigned int run = 1;
+        while(i+run < n && run < 128 && in[i+run] == in[i])run++;
+        if(run >= 3){
+            if(o+2 > cap)return -1;
+            out[o++] = (unsigned char)(257-run);
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+        //原始字节延续到下一个至少3字节的重复之前
+        unsigned int st = i;
+        while(i < n && i-st < 128){
+            if(i+2 < n && in[i] == in[i+1] && in[i] == in[i+2])break;
+            i++;
+        }
+        if(o+1+(int)(i-st) > cap)return -1;
+        out[o++] = (unsigned char)(i-st-1);
+        memcpy(&out[o],&in[st],i-st);
+        o += i-st;
+    }
+    return o;
+}
+
+//PackBits解码，输出必须正好outlen字节
+static int rle_Decode(const unsigned char* in, unsigned int n, unsigned char* out, unsigned int outlen)
+{
+    unsigned int i = 0, o = 0, c;
+    while(i < n){
+        unsigned char h = in[i++];
+        if(h < 128){
+            c = h+1;
+            if(i+c > n || o+c > outlen)return -1;
+            memcpy(&out[o],&in[i],c);
+            i += c;
+        }
+        else if(h > 128){
+            c = 257-h;
+            if(i >= n || o+c > outlen)return -1;
+            memset(&out[o],in[i++],c);
+        }
+        else c = 0;
+        o += c;
+    }
+    return (o == outlen) ? 0 : -1;
+}
+
+/************************************************************
+    @brief:
+        条件读处理函数 type EC0C
+        请求：EC0C tag addr len ver
+        返回：6C0C tag ver count {off rawlen enclen DATA}*count
+            ver为这次读取的快照版本，只返回块版本比请求的ver新的块，相邻的块合并成一段，
+            off为相对addr的偏移；enclen小于rawlen时DATA为PackBits编码，否则为原始数据，
+            count为0表示没有变化。
+        只能返回数据本身，不能返回与对方旧数据的异或差分：对方的旧数据只有版本号，这里没有保存历史
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为地址溢出或者返回太长（会有返回iodp）
+        1为正确
+*************************************************************/
+static int cread_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_CREAD || pktsize!=12)return IODP_ERROR_API_HEAD;
+    unsigned short addr = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    unsigned short len = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    uint32 ver = ((uint32)pktbuf[8] << 24) | ((uint32)pktbuf[9] << 16) | ((uint32)pktbuf[10] << 8) | pktbuf[11];
+    if(len==0 || addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr)){
+        errpkt_Send(eiodp_fd,IODP_TYPE_CREAD,0x01);
+        return 0;
+    }
+    vreg_Fill(eiodp_fd,vreg_Match(eiodp_fd,addr,len));
+
+    unsigned char chg[IODP_CFG_NBLOCK];
+    unsigned char *raw = MOONOS_MALLOC(len);
+    unsigned char *retbuf = MOONOS_MALLOC(IODP_RECV_MAX_LEN);
+    if(raw == nullptr || retbuf == nullptr){
+        if(raw)MOONOS_FREE(raw);
+        if(retbuf)MOONOS_FREE(retbuf);
+        return 0;
+    }
+    unsigned int b, b0 = addr/IODP_CFG_BLOCK, b1 = (addr+len-1)/IODP_CFG_BLOCK;
+    uint32 seq;
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        for(b=b0;b<=b1;b++)chg[b] = (IODP_ATOMIC_LOAD(&eiodp_fd->blkver[b]) > ver);
+        memcpy(raw,&eiodp_fd->configmem[addr],len);
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+
+    unsigned int off = 14, count = 0;
+    int ret = 1;
+    b = b0;
+    while(b <= b1){
+        if(!chg[b]){b++;continue;}
+        unsigned int e = b;
+        while(e+1 <= b1 && chg[e+1])e++;
+        unsigned int lo = b*IODP_CFG_BLOCK, hi = (e+1)*IODP_CFG_BLOCK;
+        if(lo < addr)lo = addr;
+        if(hi > (unsigned int)addr+len)hi = addr+len;
+        unsigned int rawlen = hi-lo;
+        //返回包必须能被对方的解析器接收
+        int space = (int)(IODP_RECV_MAX_LEN-1-4) - (int)(off+6);
+        int cap = (int)rawlen-1 < space ? (int)rawlen-1 : space;
+        int enclen = rle_Encode(&raw[lo-addr],rawlen,&retbuf[off+6],cap);
+        if(enclen < 0){
+            if((int)rawlen > space){ret = 0;break;}
+            memcpy(&retbuf[off+6],&raw[lo-addr],rawlen);
+            enclen = rawlen;
+        }
+        retbuf[off]=(unsigned char)((lo-addr)>>8)&0xff;
+        retbuf[off+1]=(unsigned char)(lo-addr)&0xff;
+        retbuf[off+2]=(unsigned char)(rawlen>>8)&0xff;
+        retbuf[off+3]=(unsigned char)(rawlen)&0xff;
+        retbuf[off+4]=(unsigned char)(enclen>>8)&0xff;
+        retbuf[off+5]=(unsigned char)(enclen)&0xff;
+        off += 6+enclen;
+        count++;
+        b = e+1;
+    }
+    if(ret){
+        retbuf[0]=0xeb;
+        retbuf[1]=0x90;
+        retbuf[2]=(unsigned char)(off>>8)&0xff;
+        retbuf[3]=(unsigned char)(off)&0xff;
+        retbuf[4]=0x6c;
+        retbuf[5]=IODP_TYPE_CREAD;
+        retbuf[6]=pktbuf[2];
+        retbuf[7]=pktbuf[3];
+        retbuf[8]=(unsigned char)(seq>>24)&0xff;
+        retbuf[9]=(unsigned char)(seq>>16)&0xff;
+        retbuf[10]=(unsigned char)(seq>>8)&0xff;
+        retbuf[11]=(unsigned char)(seq)&0xff;
+        retbuf[12]=(unsigned char)(count>>8)&0xff;
+        retbuf[13]=(unsigned char)(count)&0xff;
+        updatepktcrc(retbuf,off+4);
+        iodp_Write(eiodp_fd,retbuf,off+4);
+    }
+    else errpkt_Send(eiodp_fd,IODP_TYPE_CREAD,0x03);
+    MOONOS_FREE(raw);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+//---------------------------32位地址读写----------------------------
+
+/************************************************************
+    @brief:
+        32位地址写处理函数 type EC0D
+        请求：EC0D addr(4) len DATA，无返回
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为地址溢出或者页数已满
+        1为正确
+*************************************************************/
+static int write32_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_WRITE32 || pktsize<8)return IODP_ERROR_API_HEAD;
+    uint32 addr = ((uint32)pktbuf[2]<<24)|((uint32)pktbuf[3]<<16)|((uint32)pktbuf[4]<<8)|pktbuf[5];
+    unsigned short len = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    if(len > pktsize-8)return IODP_ERROR_API_HEAD;
+    cfg_WriteBegin(eiodp_fd);
+    uint32 wlen = xmem_Write(eiodp_fd,addr,len,&pktbuf[8]);
+    cfg_WriteEnd(eiodp_fd,1);
+    if(wlen<len)return 0;
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        32位地址读处理函数 type EC0E
+        请求：EC0E addr(4) len
+        返回：6C0E addr(4) len DATA，超出空间的部分不返回
+        错误：2C0E 01 地址越界 03 返回数据超过最大包长
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为地址溢出错误（会有返回iodp）
+        1为正确
+*************************************************************/
+static int read32_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_READ32 || pktsize!=8)return IODP_ERROR_API_HEAD;
+    uint32 addr = ((uint32)pktbuf[2]<<24)|((uint32)pktbuf[3]<<16)|((uint32)pktbuf[4]<<8)|pktbuf[5];
+    unsigned short len = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    if(addr >= IODP_XMEM_SIZE){
+        errpkt_Send(eiodp_fd,IODP_TYPE_READ32,0x01);
+        return 0;
+    }
+    unsigned short retlen = len;
+    if(retlen > IODP_XMEM_SIZE-addr)retlen = IODP_XMEM_SIZE-addr;
+    if(retlen+16 > IODP_RECV_MAX_LEN){
+        errpkt_Send(eiodp_fd,IODP_TYPE_READ32,0x03);
+        return 0;
+    }
+    unsigned char *retbuf = MOONOS_MALLOC(16+retlen);
+    if(retbuf == nullptr)return 0;
+    unsigned short retpktsize=12+retlen;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=IODP_TYPE_READ32;
+    memcpy(&retbuf[6],&pktbuf[2],4);
+    retbuf[10]=(unsigned char)(retlen>>8)&0xff;
+    retbuf[11]=(unsigned char)(retlen)&0xff;
+    //与配置空间重合的部分同样先填充虚拟读范围
+    if(addr < eiodp_fd->configmemSize){
+        uint32 n = eiodp_fd->configmemSize-addr;
+        if(n > retlen)n = retlen;
+        if(n)vreg_Fill(eiodp_fd,vreg_Match(eiodp_fd,addr,n));
+    }
+    xmem_Read(eiodp_fd,addr,retlen,&retbuf[12]);
+    updatepktcrc(retbuf,retpktsize+4);
+    iodp_Write(eiodp_fd,retbuf,retpktsize+4);
+    MOONOS_FREE(retbuf);
+    return 1;
+}
+
+//---------------------------订阅----------------------------
+
+//推送包：6C09 sid seq flags count {addr len DATA}*count
+static void push_Reject(eIODP_TYPE* eiodp_fd, uint16 sid)
+{
+    unsigned char retbuf[16];
+    unsigned short retpktsize=12;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=IODP_TYPE_PUSH;
+    retbuf[6]=(unsigned char)(sid>>8)&0xff;
+    retbuf[7]=(unsigned char)(sid)&0xff;
+    retbuf[8]=0;
+    retbuf[9]=0;
+    retbuf[10]=IODP_PUSH_ERROR;
+    retbuf[11]=0;
+    updatepktcrc(retbuf,16);
+    iodp_Write(eiodp_fd,retbuf,16);
+}
+
+/************************************************************
+    @brief:
+        订阅处理函数 type EC08
+        请求：EC08 sid addr len interval(ms)，无直接返回，之后推送整个范围；
+        范围错误或者sid超出订阅表时推送IODP_PUSH_ERROR。同一个sid重复订阅时重新开始
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为参数错误（会有返回iodp）
+        1为正确
+*************************************************************/
+static int sub_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_SUB || pktsize!=10)return IODP_ERROR_API_HEAD;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short addr = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    unsigned short len = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    unsigned short interval = ((unsigned short)pktbuf[8] << 8) | ((unsigned short)pktbuf[9]) ;
+    if(sid>=IODP_SUB_MAX || len==0 || addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr)){
+        push_Reject(eiodp_fd,sid);
+        return 0;
+    }
+    eIODP_SUB_SRV* ss = &eiodp_fd->subSrv[sid];
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    memset(ss->dirty,0,sizeof(ss->dirty));
+    ss->used = 1;
+    ss->full = 1;
+    ss->addr = addr;
+    ss->len = len;
+    ss->seq = 0;
+    ss->interval_us = (uint32)interval*1000;
+    ss->lastPush = 0;
+    sub_SetDirty(ss,addr,addr+len);
+    IODP_ATOMIC_STORE(&eiodp_fd->subDirty,eiodp_fd->subDirty|(1UL<<sid));
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        重新同步 type EC0A 与取消订阅 type EC0B，请求：EC0A/EC0B sid，无返回。
+        重新同步的sid没有订阅时推送IODP_PUSH_ERROR，对方会重新订阅
+*************************************************************/
+static int resync_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || (pktbuf[1]!=IODP_TYPE_RESYNC && pktbuf[1]!=IODP_TYPE_UNSUB) || pktsize!=4)
+        return IODP_ERROR_API_HEAD;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    if(sid>=IODP_SUB_MAX)return 0;
+    eIODP_SUB_SRV* ss = &eiodp_fd->subSrv[sid];
+    int reject = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    if(pktbuf[1]==IODP_TYPE_UNSUB){
+        ss->used = 0;
+        IODP_ATOMIC_STORE(&eiodp_fd->subDirty,eiodp_fd->subDirty&~(1UL<<sid));
+    }
+    else if(ss->used){
+        ss->full = 1;
+        sub_SetDirty(ss,ss->addr,ss->addr+ss->len);
+        IODP_ATOMIC_STORE(&eiodp_fd->subDirty,eiodp_fd->subDirty|(1UL<<sid));
+    }
+    else reject = 1;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    if(reject)push_Reject(eiodp_fd,sid);
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        组一个推送包，在写锁内调用。脏字节之间的空隙小于一个段头（4字节）时合并成一段，
+        放进包里的字节清除脏标记
+    @param:
+        sid：订阅编号
+        buf：至少IODP_RECV_MAX_LEN字节
+        more：返回是否还有没放下的变化
+    @return:
+        包长
+*************************************************************/
+static int push_Build(eIODP_TYPE* eiodp_fd, int sid, unsigned char* buf, int* more)
+{
+    eIODP_SUB_SRV* ss = &eiodp_fd->subSrv[sid];
+    unsigned int i = ss->addr, j, end = ss->addr + ss->len;
+    unsigned int off = 12, count = 0;
+    //包长必须能被对方的解析器接收，留出crc
+    unsigned int cap = IODP_RECV_MAX_LEN-1-4;
+    while(i < end && count < 255){
+        if(!SUB_ISDIRTY(ss,i)){i++;continue;}
+        unsigned int last = i+1;
+        for(j=i+1;j<end && j<last+4;j++){
+            if(SUB_ISDIRTY(ss,j))last = j+1;
+        }
+        if(off+4 >= cap)break;
+        if(last-i > cap-off-4)last = i+(cap-off-4);
+        buf[off]=(unsigned char)(i>>8)&0xff;
+        buf[off+1]=(unsigned char)(i)&0xff;
+        buf[off+2]=(unsigned char)((last-i)>>8)&0xff;
+        buf[off+3]=(unsigned char)(last-i)&0xff;
+        memcpy(&buf[off+4],&eiodp_fd->configmem[i],last-i);
+        for(j=i;j<last;j++)ss->dirty[j>>3] &= ~(1<<(j&7));
+        off += 4+last-i;
+        count++;
+        i = last;
+    }
+    while(i < end && !SUB_ISDIRTY(ss,i))i++;
+    *more = (i < end);
+    buf[0]=0xeb;
+    buf[1]=0x90;
+    buf[2]=(unsigned char)(off>>8)&0xff;
+    buf[3]=(unsigned char)(off)&0xff;
+    buf[4]=0x6c;
+    buf[5]=IODP_TYPE_PUSH;
+    buf[6]=(unsigned char)(sid>>8)&0xff;
+    buf[7]=(unsigned char)(sid)&0xff;
+    buf[8]=(unsigned char)(ss->seq>>8)&0xff;
+    buf[9]=(unsigned char)(ss->seq)&0xff;
+    buf[10]=ss->full ? IODP_PUSH_FULL : 0;
+    buf[11]=count;
+    ss->seq++;
+    if(!*more){
+        ss->full = 0;
+        IODP_ATOMIC_STORE(&eiodp_fd->subDirty,eiodp_fd->subDirty&~(1UL<<sid));
+    }
+    updatepktcrc(buf,off+4);
+    return off+4;
+}
+
+//从设备：推送有变化并且到了推送间隔的订阅，整范围推送不受间隔限制
+static void push_Service(eIODP_TYPE* eiodp_fd)
+{
+    uint32 mask = IODP_ATOMIC_LOAD(&eiodp_fd->subDirty);
+    if(mask == 0)return;
+    unsigned long long now = iodp_now(eiodp_fd);
+    unsigned char* buf = MOONOS_MALLOC(IODP_RECV_MAX_LEN);
+    if(buf == nullptr)return;
+    int s;
+    for(s=0;s<IODP_SUB_MAX;s++){
+        if(!(mask & (1UL<<s)))continue;
+        eIODP_SUB_SRV* ss = &eiodp_fd->subSrv[s];
+        int more = 1;
+        while(more){
+            int len;
+#if (IODP_OS==IODP_OS_LINUX)
+            pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+            if(!(eiodp_fd->subDirty & (1UL<<s)) || (!ss->full && now - ss->lastPush < ss->interval_us)){
+#if (IODP_OS==IODP_OS_LINUX)
+                pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+                break;
+            }
+            len = push_Build(eiodp_fd,s,buf,&more);
+            ss->lastPush = now;
+#if (IODP_OS==IODP_OS_LINUX)
+            pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+            iodp_Write(eiodp_fd,buf,len);
+        }
+    }
+    MOONOS_FREE(buf);
+}
+
+//主设备：发送订阅请求，在mutex_sub内调用
+static void sub_SendSubscribe(eIODP_TYPE* eiodp_fd, uint16 sid)
+{
+    eIODP_SUB* sb = &eiodp_fd->sub[sid];
+    unsigned char sdbuf[18];
+    unsigned short pktsize=14;
+    sdbuf[0]=0xeb;
+    sdbuf[1]=0x90;
+    sdbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sdbuf[3]=(unsigned char)(pktsize)&0xff;
+    sdbuf[4]=0xec;
+    sdbuf[5]=IODP_TYPE_SUB;
+    sdbuf[6]=(unsigned char)(sid>>8)&0xff;
+    sdbuf[7]=(unsigned char)(sid)&0xff;
+    sdbuf[8]=(unsigned char)(sb->addr>>8)&0xff;
+    sdbuf[9]=(unsigned char)(sb->addr)&0xff;
+    sdbuf[10]=(unsigned char)(sb->len>>8)&0xff;
+    sdbuf[11]=(unsigned char)(sb->len)&0xff;
+    sdbuf[12]=(unsigned char)(sb->interval_ms>>8)&0xff;
+    sdbuf[13]=(unsigned char)(sb->interval_ms)&0xff;
+    updatepktcrc(sdbuf,18);
+    iodp_Write(eiodp_fd,sdbuf,18);
+}
+
+//主设备：发送EC0A重新同步或者EC0B取消订阅
+static void sub_SendCtl(eIODP_TYPE* eiodp_fd, unsigned char type, uint16 sid)
+{
+    unsigned char sdbuf[12];
+    unsigned short pktsize=8;
+    sdbuf[0]=0xeb;
+    sdbuf[1]=0x90;
+    sdbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sdbuf[3]=(unsigned char)(pktsize)&0xff;
+    sdbuf[4]=0xec;
+    sdbuf[5]=type;
+    sdbuf[6]=(unsigned char)(sid>>8)&0xff;
+    sdbuf[7]=(unsigned char)(sid)&0xff;
+    updatepktcrc(sdbuf,12);
+    iodp_Write(eiodp_fd,sdbuf,12);
+}
+
+/************************************************************
+    @brief:
+        主设备收到推送 type 6C09，检查序号，按地址段调用回调
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+*************************************************************/
+static void sub_onPush(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktsize<8)return;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    uint16 seq = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    int flags = pktbuf[6];
+    int count = pktbuf[7];
+    int i, off = 8;
+    for(i=0;i<count;i++){
+        if(off+4>pktsize)break;
+        off += 4 + (((unsigned short)pktbuf[off+2] << 8) | ((unsigned short)pktbuf[off+3]));
+    }
+    if(i<count || off!=pktsize){
+        IODP_LOGW("push pkt format error\n");
+        return;
+    }
+    if(sid>=IODP_SUB_MAX)return;
+
+    eIODP_SUB* sb = &eiodp_fd->sub[sid];
+    eIODP_PUSH_CB cb;
+    void* ctx;
+    int lost = 0;
+    unsigned long long now = iodp_now(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_sub);
+#endif
+    if(sb->state == IODP_SUB_FREE){
+        //已经取消的订阅，再通知一次对方
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_sub);
+#endif
+        sub_SendCtl(eiodp_fd,IODP_TYPE_UNSUB,sid);
+        return;
+    }
+    cb = sb->cb;
+    ctx = sb->ctx;
+    if(flags & IODP_PUSH_ERROR){
+        if(sb->state == IODP_SUB_WAIT){
+            //订阅被拒绝
+            sb->state = IODP_SUB_FREE;
+            IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait&~(1UL<<sid));
+        }
+        else{
+            //对方已经没有这个订阅（比如重启过），重新订阅
+            sb->state = IODP_SUB_WAIT;
+            sb->reqTime = now;
+            IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait|(1UL<<sid));
+            sub_SendSubscribe(eiodp_fd,sid);
+            cb = nullptr;
+        }
+    }
+    else if(flags & IODP_PUSH_FULL){
+        sb->state = IODP_SUB_ACTIVE;
+        IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait&~(1UL<<sid));
+    }
+    else if(sb->state == IODP_SUB_WAIT || (sb->state == IODP_SUB_ACTIVE && seq != sb->expectSeq)){
+        //整范围推送或者中间的推送丢失
+        sb->state = IODP_SUB_RESYNC;
+        sb->reqTime = now;
+        IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait|(1UL<<sid));
+        sub_SendCtl(eiodp_fd,IODP_TYPE_RESYNC,sid);
+        lost = 1;
+    }
+    sb->expectSeq = seq+1;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_sub);
+#endif
+    if(cb == nullptr)return;
+    if(flags & IODP_PUSH_ERROR){
+        cb(ctx,sid,IODP_PUSH_ERROR,0,0,nullptr);
+        return;
+    }
+    if(lost){
+        IODP_LOGD("push sid %u lost, resync\n",sid);
+        cb(ctx,sid,IODP_PUSH_LOST,0,0,nullptr);
+    }
+    for(i=0,off=8;i<count;i++){
+        unsigned short addr = ((unsigned short)pktbuf[off] << 8) | ((unsigned short)pktbuf[off+1]) ;
+        unsigned short len = ((unsigned short)pktbuf[off+2] << 8) | ((unsigned short)pktbuf[off+3]) ;
+        cb(ctx,sid,flags&IODP_PUSH_FULL,addr,len,&pktbuf[off+4]);
+        off += 4+len;
+    }
+}
+
+//主设备：订阅与重新同步没有回应时重发
+static void sub_Retry(eIODP_TYPE* eiodp_fd)
+{
+    uint32 mask = IODP_ATOMIC_LOAD(&eiodp_fd->subWait);
+    if(mask == 0)return;
+    unsigned long long now = iodp_now(eiodp_fd);
+    int s;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_sub);
+#endif
+    for(s=0;s<IODP_SUB_MAX;s++){
+        eIODP_SUB* sb = &eiodp_fd->sub[s];
+        if(!(mask & (1UL<<s)) || now - sb->reqTime < IODP_SUB_RETRY)continue;
+        sb->reqTime = now;
+        if(sb->state == IODP_SUB_WAIT)sub_SendSubscribe(eiodp_fd,s);
+        else if(sb->state == IODP_SUB_RESYNC)sub_SendCtl(eiodp_fd,IODP_TYPE_RESYNC,s);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_sub);
+#endif
+}
+
+//接收任务每次循环调用：推送本端的变化，重发订阅请求
+static void sub_Service(eIODP_TYPE* eiodp_fd)
+{
+    push_Service(eiodp_fd);
+    sub_Retry(eiodp_fd);
+}
+
+#if (IODP_METRICS_ENABLE && IODP_METRICS_REMOTE)
+//远程统计使用的保留服务节点，只用于识别，不会被调用
+static eIODP_FUNC_NODE metricsNode = {IODP_FUNCODE_METRICS,nullptr,nullptr,nullptr,nullptr,nullptr};
+
+//把统计摘要按大端序列化，所有字段都是uint32
+static void metrics_Serialize(eIODP_TYPE* eiodp_fd, unsigned short* retlen, unsigned char* retdata)
+{
+    eIODP_METRICS_SUMMARY sum;
+    uint32* p = (uint32*)&sum;
+    int i, n = sizeof(sum)/sizeof(uint32);
+    memset(&sum,0,sizeof(sum));
+    eiodpGetMetricsSummary(eiodp_fd,&sum);
+    for(i=0;i<n;i++){
+        retdata[i*4]=(unsigned char)(p[i]>>24)&0xff;
+        retdata[i*4+1]=(unsigned char)(p[i]>>16)&0xff;
+        retdata[i*4+2]=(unsigned char)(p[i]>>8)&0xff;
+        retdata[i*4+3]=(unsigned char)(p[i])&0xff;
+    }
+    *retlen = n*4;
+}
+#endif
+
+//延迟返回：取一个空闲表项生成token，只在接收处理任务中调用，表满返回-1
+static int defer_Open(eIODP_TYPE* eiodp_fd, uint16 fcode, eIODP_DEFER* token)
+{
+    int i;
+    for(i=0;i<IODP_DEFER_MAX;i++){
+        eIODP_DEFER_SLOT* ds = &eiodp_fd->defer[i];
+        uint32 st = IODP_ATOMIC_LOAD(&ds->state);
+        if(st & 1)continue;
+        ds->funcode = fcode;
+        token->fd = eiodp_fd;
+        token->funcode = fcode;
+        token->slot = (uint16)i;
+        token->gen = (uint16)(st>>1);
+        IODP_ATOMIC_ADD(&eiodp_fd->deferOpen,1);
+        IODP_ATOMIC_STORE(&ds->state,st|1);
+        return i;
+    }
+    return -1;
+}
+
+//延迟返回：token对上时关闭表项并换代，可以在任意线程调用，同一个token只有一次成功
+static int defer_Close(eIODP_TYPE* eiodp_fd, const eIODP_DEFER* token)
+{
+    eIODP_DEFER_SLOT* ds = &eiodp_fd->defer[token->slot];
+    uint32 open = ((uint32)token->gen<<1) | 1;
+    uint16 next = (uint16)(token->gen+1);
+    if(next == 0)next = 1;
+#if (IODP_OS==IODP_OS_LINUX)
+    if(!__atomic_compare_exchange_n(&ds->state,&open,(uint32)next<<1,0,__ATOMIC_ACQ_REL,__ATOMIC_RELAXED))return -1;
+#else
+    if(ds->state != open)return -1;
+    ds->state = (uint32)next<<1;
+#endif
+    IODP_ATOMIC_ADD(&eiodp_fd->deferOpen,(uint32)-1);
+    return 0;
+}
+
+//在retdata[10]开始的retlen字节返回数据前加上0x6C03头，算crc后发出
+static int function_Reply(eIODP_TYPE* eiodp_fd, uint16 fcode, unsigned char* retdata, uint16 retlen)
+{
+    unsigned short retpktsize = retlen+10;
+    retdata[0]=0xeb;
+    retdata[1]=0x90;
+    retdata[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retdata[3]=(unsigned char)(retpktsize)&0xff;
+    retdata[4]=0x6c;
+    retdata[5]=0x03;
+    retdata[6]=(unsigned char)(fcode>>8)&0xff;
+    retdata[7]=(unsigned char)(fcode)&0xff;
+    retdata[8]=(unsigned char)(retlen>>8)&0xff;
+    retdata[9]=(unsigned char)(retlen)&0xff;
+    updatepktcrc(retdata,retpktsize+4);
+    return iodp_Write(eiodp_fd,retdata,retpktsize+4);
+}
+
+//发出写入器中的帧，帧头frame[4..hdr)由调用者填好。有引用且设置了分段写时，
+//帧中的各部分与引用交替输出，crc逐段累加；否则把引用的数据复制到帧中对应位置，整帧输出
+static int writer_Flush(eIODP_TYPE* eiodp_fd, eIODP_WRITER* w)
+{
+    unsigned char* f = w->frame;
+    unsigned short pktsize = w->hdr+w->len;
+    int i;
+    f[0]=0xeb;
+    f[1]=0x90;
+    f[2]=(unsigned char)(pktsize>>8)&0xff;
+    f[3]=(unsigned char)(pktsize)&0xff;
+    if(w->nref == 0 || w->len == 0 || eiodp_fd->outbuf != nullptr || eiodp_fd->iodevWritev == nullptr){
+        for(i=0;i<w->nref;i++)memcpy(&f[w->hdr+w->refOff[i]],w->refPtr[i],w->refLen[i]);
+        updatepktcrc(f,pktsize+4);
+        return iodp_Write(eiodp_fd,f,pktsize+4);
+    }
+
+    const void* bufs[2*IODP_WRITER_MAXREF+2];
+    int lens[2*IODP_WRITER_MAXREF+2];
+    int n = 0, at = 0;  //at为帧中下一段的起点
+    unsigned long crc = 0xFFFFFFFF;
+    for(i=0;i<=w->nref;i++){
+        int end = (i<w->nref) ? w->hdr+w->refOff[i] : w->hdr+w->len;
+        if(end > at){
+            bufs[n] = &f[at];
+            lens[n] = end-at;
+            crc = crc32_update(crc,bufs[n],lens[n]);
+            n++;
+        }
+        if(i == w->nref)break;
+        bufs[n] = w->refPtr[i];
+        lens[n] = w->refLen[i];
+        crc = crc32_update(crc,bufs[n],lens[n]);
+        n++;
+        at = end+w->refLen[i];
+    }
+    crc ^= 0xFFFFFFFF;
+    //crc放在帧中数据之后，与updatepktcrc的字节序一致
+    unsigned char* tail = &f[w->hdr+w->len];
+    tail[0]=(unsigned char)((crc>>24)&0xff);
+    tail[1]=(unsigned char)((crc>>16)&0xff);
+    tail[2]=(unsigned char)((crc>>8)&0xff);
+    tail[3]=(unsigned char)((crc)&0xff);
+    bufs[n] = tail;
+    lens[n] = 4;
+    n++;
+    return iodp_WriteV(eiodp_fd,bufs,lens,n);
+}
+
+//发出写入器服务函数的返回，加上0x6C03头
+static int writer_Send(eIODP_TYPE* eiodp_fd, uint16 fcode, eIODP_WRITER* w)
+{
+    unsigned char* f = w->frame;
+    f[4]=0x6c;
+    f[5]=0x03;
+    f[6]=(unsigned char)(fcode>>8)&0xff;
+    f[7]=(unsigned char)(fcode)&0xff;
+    f[8]=(unsigned char)(w->len>>8)&0xff;
+    f[9]=(unsigned char)(w->len)&0xff;
+    return writer_Flush(eiodp_fd,w);
+}
+
+/************************************************************
+    @brief:
+    服务函数处理 type EC03
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        -1为帧头错误 
+        0为地址溢出错误（会有返回iodp） 
+        1为正确
+*************************************************************/
+static int function_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=0x03)return IODP_ERROR_API_HEAD;
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    unsigned short fcode = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short arglen = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    eIODP_FUNC_NODE* pnode = findFuncNode(eiodp_fd->pFuncHead,fcode);
+#if (IODP_METRICS_ENABLE && IODP_METRICS_REMOTE)
+    if(fcode==IODP_FUNCODE_METRICS)pnode=&metricsNode;
+#endif
+    //流式服务函数只能用EC10打开
+    if(pnode!=nullptr && pnode->streamOps!=nullptr)pnode=nullptr;
+    if(pnode!=nullptr && pnode->deferFunc!=nullptr)
+    {
+        //延迟返回：交给服务函数后立即返回，返回由eiodpComplete发出
+        eIODP_DEFER token;
+        if(defer_Open(eiodp_fd,fcode,&token) < 0){
+            IODP_LOGW("deferred table full, reject 0x%04x\n",fcode);
+            errpkt_Send(eiodp_fd,IODP_TYPE_FUNCTION,IODP_FERR_BUSY);
+        }
+        else if(pnode->deferFunc(token,arglen,&pktbuf[6]) < 0)eiodpComplete(token,0,nullptr);
+    }
+    else if(pnode!=nullptr && pnode->writerFunc!=nullptr)
+    {
+        //写入器：参数直接使用接收缓存，返回直接写在输出帧里
+        eIODP_WRITER w;
+        if(arglen > pktsize-6)arglen = pktsize-6;
+        memset(&w,0,sizeof(w));
+        w.frame = eiodp_fd->funcTx;
+        w.hdr = 10;
+        w.cap = IODP_FUNC_RESP_MAX;
+        if(pnode->writerFunc(&pktbuf[6],arglen,&w) < 0){
+            w.len = 0;
+            w.nref = 0;
+        }
+        writer_Send(eiodp_fd,fcode,&w);
+    }
+    else if(pnode!=nullptr)
+    {
+        unsigned char retdata[IODP_FUNCPKT_RET_LEN];
+        unsigned short retlen=0;
+#if (IODP_METRICS_ENABLE && IODP_METRICS_REMOTE)
+        if(pnode==&metricsNode)metrics_Serialize(eiodp_fd,&retlen,&retdata[10]);
+        else
+#endif
+        pnode->callbackFunc(arglen,&pktbuf[6],&retlen,&retdata[10]);
+        function_Reply(eiodp_fd,fcode,retdata,retlen);
+    }
+    else{
+        unsigned char retdata[11];
+        unsigned short retpktsize = 7;
+        //make return pkt
+        retdata[0]=0xeb;
+        retdata[1]=0x90;
+        retdata[2]=(unsigned char)(retpktsize>>8)&0xff;
+        retdata[3]=(unsigned char)(retpktsize)&0xff;
+        retdata[4]=0x2c; //type error pkt
+        retdata[5]=0x03;
+        retdata[6]=IODP_FERR_NOFUNC; //error code
+        updatepktcrc(retdata,11);
+        iodp_Write(eiodp_fd,retdata,11);
+    }
+    return IODP_OK;
+
+
+}
+
+//数据块的帧头（不含eb90与长度）
+static void stream_Header(unsigned char* f, uint16 sid, uint16 seq, uint8 flags, uint16 len)
+{
+    f[4]=0x6c;
+    f[5]=IODP_TYPE_SCHUNK;
+    f[6]=(unsigned char)(sid>>8)&0xff;
+    f[7]=(unsigned char)(sid)&0xff;
+    f[8]=(unsigned char)(seq>>8)&0xff;
+    f[9]=(unsigned char)(seq)&0xff;
+    f[10]=flags;
+    f[11]=(unsigned char)(len>>8)&0xff;
+    f[12]=(unsigned char)(len)&0xff;
+}
+
+//从设备：发出错误数据块，数据为1字节原因
+static void stream_Reject(eIODP_TYPE* eiodp_fd, uint16 sid, uint16 seq, uint8 reason)
+{
+    unsigned char retbuf[18];
+    unsigned short retpktsize=14;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    stream_Header(retbuf,sid,seq,IODP_SCHUNK_END|IODP_SCHUNK_ERROR,1);
+    retbuf[13]=reason;
+    updatepktcrc(retbuf,18);
+    iodp_Write(eiodp_fd,retbuf,18);
+}
+
+//从设备：结束流
+static void stream_Close(eIODP_STREAM_SRV* ss, int status)
+{
+    ss->used = 0;
+    if(ss->ops->close != nullptr)ss->ops->close(ss->state,status);
+}
+
+//从设备：在额度内反复调用next，每次的数据作为一个数据块发出
+static void stream_Pump(eIODP_TYPE* eiodp_fd, eIODP_STREAM_SRV* ss)
+{
+    while(ss->used && (short)(ss->seq - ss->limit) < 0){
+        //没有地方输出，或者eiodp_process的输出缓存放不下一个整块时，留到下一次
+        if(eiodp_fd->outbuf == nullptr && eiodp_fd->iodevWrite == nullptr)break;
+        if(eiodp_fd->outbuf != nullptr && eiodp_fd->outcap - eiodp_fd->outlen < IODP_STREAM_CHUNK+17)break;
+        eIODP_WRITER w;
+        memset(&w,0,sizeof(w));
+        w.frame = eiodp_fd->streamTx;
+        w.hdr = 13;
+        w.cap = IODP_STREAM_CHUNK;
+        int r = ss->ops->next(ss->state,&w);
+        if(r < 0){
+            stream_Reject(eiodp_fd,ss->sid,ss->seq,IODP_SERR_FAIL);
+            stream_Close(ss,r);
+            break;
+        }
+        stream_Header(w.frame,ss->sid,ss->seq,r==0 ? IODP_SCHUNK_END : 0,w.len);
+        writer_Flush(eiodp_fd,&w);
+        ss->seq++;
+        if(r == 0)stream_Close(ss,IODP_OK);
+    }
+}
+
+/************************************************************
+    @brief:
+    打开流 type EC10
+    +------+------+------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |  2B  |  2B  |   arglenB   |      4B     |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    | eb90 | size | EC10 |  sid | code |window|arglen|     ARG     |     CRC32   |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    之后按额度返回数据块，序号seq从0开始，对方可以发出seq<limit的数据块，打开时limit=window：
+    +------+------+------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |  1B  |  2B  |     lenB    |      4B     |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    | eb90 | size | 6C11 |  sid |  seq | flags|  len |     DATA    |     CRC32   |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    没有服务函数、流表已满或者open拒绝时返回一个错误数据块。
+    sid的低字节为对方流表的位置，同一位置的新流（旧流的取消丢失）替换旧流，重复的打开请求忽略
+    @return:
+        IODP_ERROR_API_HEAD 为帧头错误
+        0为拒绝（会有返回iodp）
+        1为正确
+*************************************************************/
+static int stream_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_STREAM || pktsize<10)return IODP_ERROR_API_HEAD;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    uint16 code = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    uint16 window = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    uint16 arglen = ((unsigned short)pktbuf[8] << 8) | ((unsigned short)pktbuf[9]) ;
+    if(arglen > pktsize-10)arglen = pktsize-10;
+    int i, slot = -1;
+    for(i=0;i<IODP_STREAM_MAX;i++){
+        eIODP_STREAM_SRV* ss = &eiodp_fd->streamSrv[i];
+        if(ss->used && ss->sid == sid)return 1;
+        if(ss->used && (ss->sid&0xff) == (sid&0xff))stream_Close(ss,IODP_ERROR_CANCELED);
+        if(!ss->used && slot < 0)slot = i;
+    }
+    eIODP_FUNC_NODE* pnode = findFuncNode(eiodp_fd->pFuncHead,code);
+    if(pnode == nullptr || pnode->streamOps == nullptr){
+        stream_Reject(eiodp_fd,sid,0,IODP_SERR_NOFUNC);
+        return 0;
+    }
+    if(slot < 0){
+        stream_Reject(eiodp_fd,sid,0,IODP_SERR_BUSY);
+        return 0;
+    }
+    eIODP_STREAM_SRV* ss = &eiodp_fd->streamSrv[slot];
+    void* state = nullptr;
+    if(pnode->streamOps->open(&pktbuf[10],arglen,&state) < 0){
+        stream_Reject(eiodp_fd,sid,0,IODP_SERR_REJECT);
+        return 0;
+    }
+    ss->used = 1;
+    ss->sid = sid;
+    ss->seq = 0;
+    ss->limit = window;
+    ss->lastCredit = iodp_now(eiodp_fd);
+    ss->ops = pnode->streamOps;
+    ss->state = state;
+    stream_Pump(eiodp_fd,ss);
+    return 1;
+}
+
+/************************************************************
+    @brief:
+        流的额度与取消 type EC12，请求：EC12 sid op(1) n(2)，无返回。
+        IODP_SCTL_CREDIT把额度提高到n（只增不减），IODP_SCTL_CANCEL结束流。
+        额度的sid没有对应的流时返回IODP_SERR_GONE错误数据块
+*************************************************************/
+static int sctl_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_SCTL || pktsize!=7)return IODP_ERROR_API_HEAD;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    uint8 op = pktbuf[4];
+    uint16 n = ((unsigned short)pktbuf[5] << 8) | ((unsigned short)pktbuf[6]) ;
+    int i;
+    for(i=0;i<IODP_STREAM_MAX;i++){
+        eIODP_STREAM_SRV* ss = &eiodp_fd->streamSrv[i];
+        if(!ss->used || ss->sid != sid)continue;
+        if(op == IODP_SCTL_CANCEL){
+            stream_Close(ss,IODP_ERROR_CANCELED);
+            return 1;
+        }
+        if((short)(n - ss->limit) > 0)ss->limit = n;
+        ss->lastCredit = iodp_now(eiodp_fd);
+        stream_Pump(eiodp_fd,ss);
+        return 1;
+    }
+    if(op == IODP_SCTL_CREDIT)stream_Reject(eiodp_fd,sid,n,IODP_SERR_GONE);
+    return 0;
+}
+
+//主设备：发送EC12额度或者取消
+static void stream_SendCtl(eIODP_TYPE* eiodp_fd, uint16 sid, uint8 op, uint16 n)
+{
+    unsigned char sdbuf[15];
+    unsigned short pktsize=11;
+    sdbuf[0]=0xeb;
+    sdbuf[1]=0x90;
+    sdbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sdbuf[3]=(unsigned char)(pktsize)&0xff;
+    sdbuf[4]=0xec;
+    sdbuf[5]=IODP_TYPE_SCTL;
+    sdbuf[6]=(unsigned char)(sid>>8)&0xff;
+    sdbuf[7]=(unsigned char)(sid)&0xff;
+    sdbuf[8]=op;
+    sdbuf[9]=(unsigned char)(n>>8)&0xff;
+    sdbuf[10]=(unsigned char)(n)&0xff;
+    updatepktcrc(sdbuf,15);
+    iodp_Write(eiodp_fd,sdbuf,15);
+}
+
+//主设备：释放流表的一项，在mutex_stream内调用
+static void stream_Free(eIODP_TYPE* eiodp_fd, int s)
+{
+    eIODP_STREAM* st = &eiodp_fd->stream[s];
+    if(st->openPkt != nullptr)MOONOS_FREE(st->openPkt);
+    st->openPkt = nullptr;
+    st->state = 0;
+    IODP_ATOMIC_STORE(&eiodp_fd->streamOpen,eiodp_fd->streamOpen&~(1UL<<s));
+}
+
+/************************************************************
+    @brief:
+        主设备收到数据块 type 6C11，检查序号，补充额度，回调
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+*************************************************************/
+static void stream_onChunk(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktsize<9)return;
+    uint16 sid = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    uint16 seq = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    uint8 flags = pktbuf[6];
+    int len = ((unsigned short)pktbuf[7] << 8) | ((unsigned short)pktbuf[8]) ;
+    if(len != pktsize-9){
+        IODP_LOGW("stream chunk format error\n");
+        return;
+    }
+    int s = sid&0xff;
+    int status = IODP_STREAM_DATA;
+    const unsigned char* data = &pktbuf[9];
+    eIODP_STREAM* st = &eiodp_fd->stream[s < IODP_STREAM_MAX ? s : 0];
+    eIODP_CHUNK_CB cb;
+    void* ctx;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_stream);
+#endif
+    if(s >= IODP_STREAM_MAX || !(eiodp_fd->streamOpen & (1UL<<s)) || st->epoch != (sid>>8)){
+        //已经结束或者取消的流，再通知一次对方
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+        if(!(flags & IODP_SCHUNK_END))stream_SendCtl(eiodp_fd,sid,IODP_SCTL_CANCEL,0);
+        return;
+    }
+    cb = st->cb;
+    ctx = st->ctx;
+    if(flags & IODP_SCHUNK_ERROR){
+        status = IODP_ERROR_PKT;
+        stream_Free(eiodp_fd,s);
+    }
+    else if(seq != st->expectSeq){
+        if((short)(seq - st->expectSeq) < 0){
+            //重复的数据块
+#if (IODP_OS==IODP_OS_LINUX)
+            pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+            return;
+        }
+        //中间的数据块丢失，数据块不重传，结束流
+        IODP_LOGD("stream sid 0x%04x lost %u..%u\n",sid,st->expectSeq,seq);
+        status = IODP_ERROR_LOST;
+        data = nullptr;
+        len = 0;
+        stream_Free(eiodp_fd,s);
+        stream_SendCtl(eiodp_fd,sid,IODP_SCTL_CANCEL,0);
+    }
+    else{
+        st->expectSeq++;
+        st->tries = 0;
+        st->lastTime = iodp_now(eiodp_fd);
+        if(st->openPkt != nullptr){
+            MOONOS_FREE(st->openPkt);
+            st->openPkt = nullptr;
+        }
+        if(flags & IODP_SCHUNK_END){
+            status = IODP_STREAM_END;
+            stream_Free(eiodp_fd,s);
+        }
+        else if((uint16)(st->limit - st->expectSeq) <= st->window/2){
+            //先补充额度再回调，回调期间对方继续发出
+            st->limit = st->expectSeq + st->window;
+            stream_SendCtl(eiodp_fd,sid,IODP_SCTL_CREDIT,st->limit);
+        }
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+    cb(ctx,sid,status,data,len);
+}
+
+//主设备：没有收到数据块时重发打开请求或额度，连续没有回应时结束流
+static void stream_Retry(eIODP_TYPE* eiodp_fd)
+{
+    uint32 mask = IODP_ATOMIC_LOAD(&eiodp_fd->streamOpen);
+    if(mask == 0)return;
+    unsigned long long now = iodp_now(eiodp_fd);
+    eIODP_CHUNK_CB cb[IODP_STREAM_MAX];
+    void* ctx[IODP_STREAM_MAX];
+    int sid[IODP_STREAM_MAX];
+    int s, nfail = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_stream);
+#endif
+    for(s=0;s<IODP_STREAM_MAX;s++){
+        eIODP_STREAM* st = &eiodp_fd->stream[s];
+        if(!(eiodp_fd->streamOpen & (1UL<<s)) || now - st->lastTime < IODP_STREAM_RETRY)continue;
+        uint16 id = ((uint16)st->epoch<<8)|s;
+        st->lastTime = now;
+        if(st->tries >= IODP_STREAM_TRIES){
+            cb[nfail] = st->cb;
+            ctx[nfail] = st->ctx;
+            sid[nfail] = id;
+            nfail++;
+            stream_Free(eiodp_fd,s);
+            stream_SendCtl(eiodp_fd,id,IODP_SCTL_CANCEL,0);
+            continue;
+        }
+        st->tries++;
+        if(st->openPkt != nullptr)iodp_Write(eiodp_fd,st->openPkt,st->openLen);
+        else stream_SendCtl(eiodp_fd,id,IODP_SCTL_CREDIT,st->limit);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+    for(s=0;s<nfail;s++){
+        IODP_LOGD("stream sid 0x%04x timeout\n",sid[s]);
+        cb[s](ctx[s],sid[s],IODP_ERROR_TIMEOUT,nullptr,0);
+    }
+}
+
+//接收任务每次循环调用：继续额度内没有发出的数据块，关闭额度超时的流，重发本端流的请求
+static void stream_Service(eIODP_TYPE* eiodp_fd)
+{
+    int i;
+    unsigned long long now = 0;
+    for(i=0;i<IODP_STREAM_MAX;i++){
+        eIODP_STREAM_SRV* ss = &eiodp_fd->streamSrv[i];
+        if(!ss->used)continue;
+        if(ss->seq == ss->limit){
+            if(now == 0)now = iodp_now(eiodp_fd);
+            if(now - ss->lastCredit >= IODP_STREAM_IDLE){
+                IODP_LOGD("stream sid 0x%04x credit timeout\n",ss->sid);
+                stream_Close(ss,IODP_ERROR_TIMEOUT);
+            }
+            continue;
+        }
+        stream_Pump(eiodp_fd,ss);
+    }
+    stream_Retry(eiodp_fd);
+}
+
+/************************************************************
+    @brief:
+    可靠写处理 type EC04
+    +------+------+------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |  2B  |  2B  |     lenB    |      4B     |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    | eb90 | size | EC04 | epoch|  seq | addr |  len |     DATA    |     CRC32   |
+    +------+------+------+------+------+------+------+-------------+------+------+
+    按seq顺序写入configmem，乱序到达的包缓存在窗口内，重复包直接丢弃。
+    epoch比当前会话旧的包（eiodpWriteDiscard之前的迟到重传）直接丢弃，不写入也不回ack，其余每个包都返回ack：
+    +------+------+------+------+------+-------------+------+------+
+    |  2B  |  2B  |  2B  |  2B  |  2B  |      4B     |      4B     |
+    +------+------+------+------+------+-------------+------+------+
+    | eb90 | size | 6C04 | epoch|cumack|     sack    |     CRC32   |
+    +------+------+------+------+------+-------------+------+------+
+    cumack为下一个期望的seq，sack的bit i表示seq=cumack+1+i已经收到
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：需要处理的数据包，这是已经解了eb90的数据包
+        pktsize：数据包长度
+    @return:
+        IODP_ERROR_WADDR_HEAD 为帧头错误
+        IODP_ERROR_RECVLEN 包长度不对
+        IODP_ERROR_HEAPOVER 接收窗口分配失败
+        IODP_OK 正确
+*************************************************************/
+static int rwrite_Process(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktbuf[0]!=0xec || pktbuf[1]!=IODP_TYPE_RWRITE)return IODP_ERROR_WADDR_HEAD;
+    unsigned short epoch = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short seq = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    unsigned short addr = ((unsigned short)pktbuf[6] << 8) | ((unsigned short)pktbuf[7]) ;
+    unsigned short len = ((unsigned short)pktbuf[8] << 8) | ((unsigned short)pktbuf[9]) ;
+    if(len>IODP_RWRITE_MAXDATA || len+10>pktsize)return IODP_ERROR_RECVLEN;
+
+    eIODP_RWRITE_RX* rx = eiodp_fd->pRwRx;
+    if(rx == nullptr){
+        rx = MOONOS_MALLOC(sizeof(eIODP_RWRITE_RX));
+        if(rx == nullptr)return IODP_ERROR_HEAPOVER;
+        //第一个包，不管哪个epoch都接受
+        rx->epoch = epoch;
+        rx->rcvNext = 0;
+        rx->rcvMask = 0;
+        eiodp_fd->pRwRx = rx;
+    }
+    //更新的会话（序号运算），发送端从seq 0开始
+    else if((short)(epoch - rx->epoch) > 0){
+        rx->epoch = epoch;
+        rx->rcvNext = 0;
+        rx->rcvMask = 0;
+    }
+    //旧会话迟到的包，不写入也不回ack
+    else if(epoch != rx->epoch){
+        IODP_METRIC_INC(eiodp_fd,rwDuplicates);
+        return IODP_OK;
+    }
+
+    unsigned short d = seq - rx->rcvNext;
+    if(d == 0){
+        //补齐空洞后连续写入的几个包一起可见
+        cfg_WriteBegin(eiodp_fd);
+        configmem_Write(eiodp_fd,addr,len,&pktbuf[10]);
+        rx->rcvNext++;
+        //把已经缓存的后续包依次写入
+        while(1){
+            int b = rx->rcvMask & 1;
+            rx->rcvMask >>= 1;
+            if(!b)break;
+            uint8* p = rx->slot[rx->rcvNext%IODP_RWIN_SIZE];
+            configmem_Write(eiodp_fd,((unsigned short)p[0]<<8)|p[1],
+                            ((unsigned short)p[2]<<8)|p[3],&p[4]);
+            rx->rcvNext++;
+        }
+        cfg_WriteEnd(eiodp_fd,1);
+    }
+    else if(d < IODP_RWIN_SIZE){
+        //乱序到达，缓存起来等待空洞补齐
+        if((rx->rcvMask & (1UL<<(d-1))) == 0){
+            uint8* p = rx->slot[seq%IODP_RWIN_SIZE];
+            memcpy(p,&pktbuf[6],4+len);
+            rx->rcvMask |= (1UL<<(d-1));
+        }
+    }
+    //其他情况为已经写入过的重复包或者超出窗口的包，只回ack
+    else IODP_METRIC_INC(eiodp_fd,rwDuplicates);
+
+    unsigned char retbuf[18];
+    unsigned short retpktsize=14;
+    retbuf[0]=0xeb;
+    retbuf[1]=0x90;
+    retbuf[2]=(unsigned char)(retpktsize>>8)&0xff;
+    retbuf[3]=(unsigned char)(retpktsize)&0xff;
+    retbuf[4]=0x6c;
+    retbuf[5]=IODP_TYPE_RWRITE;
+    retbuf[6]=(unsigned char)(rx->epoch>>8)&0xff;
+    retbuf[7]=(unsigned char)(rx->epoch)&0xff;
+    retbuf[8]=(unsigned char)(rx->rcvNext>>8)&0xff;
+    retbuf[9]=(unsigned char)(rx->rcvNext)&0xff;
+    retbuf[10]=(unsigned char)(rx->rcvMask>>24)&0xff;
+    retbuf[11]=(unsigned char)(rx->rcvMask>>16)&0xff;
+    retbuf[12]=(unsigned char)(rx->rcvMask>>8)&0xff;
+    retbuf[13]=(unsigned char)(rx->rcvMask)&0xff;
+    updatepktcrc(retbuf,18);
+    iodp_Write(eiodp_fd,retbuf,18);
+    return IODP_OK;
+}
+
+/************************************************************
+    @brief:
+        可靠写ack处理 type 6C04，释放已确认的包，标记需要快速重传的包
+    @param:
+        eiodp_fd：eiodp句柄
+        pktbuf：去掉头和crc的返回包
+        pktsize：数据包长度
+*************************************************************/
+static void rwrite_onAck(eIODP_TYPE* eiodp_fd, unsigned char* pktbuf, int pktsize)
+{
+    if(pktsize<10)return;
+    unsigned short epoch = ((unsigned short)pktbuf[2] << 8) | ((unsigned short)pktbuf[3]) ;
+    unsigned short cumack = ((unsigned short)pktbuf[4] << 8) | ((unsigned short)pktbuf[5]) ;
+    uint32 sack = ((uint32)pktbuf[6] << 24) | ((uint32)pktbuf[7] << 16) |
+                  ((uint32)pktbuf[8] << 8) | ((uint32)pktbuf[9]);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#endif
+    eIODP_RWRITE_TX* tx = eiodp_fd->pRwTx;
+    if(tx != nullptr && tx->epoch == epoch)
+    {
+        unsigned short inflight = tx->sndNext - tx->sndUna;
+        unsigned short d = cumack - tx->sndUna;
+        if(d <= inflight){
+            //累计确认，没有重传过的包可以作为RTT样本（Karn算法）
+            unsigned long long now = iodp_now(eiodp_fd);
+            while(tx->sndUna != cumack){
+                eIODP_RWRITE_SLOT* sl = &tx->slot[tx->sndUna%IODP_RWIN_SIZE];
+                if(sl->used == 1 && !sl->resent && cumack == (unsigned short)(tx->sndUna+1)){
+                    rtt_Sample(eiodp_fd,IODP_RTT_ADDR,now - sl->sendtime);
+                }
+                if(sl->used == 1)metrics_Latency(eiodp_fd,IODP_OP_RWRITE,now - sl->firstsend);
+                if(sl->used)flow_Ack(eiodp_fd,sl->txEnd);
+                sl->used = 0;
+                tx->sndUna++;
+            }
+            //选择确认，并统计空洞之前的包被跳过的次数
+            unsigned short top = cumack;
+            int i;
+            for(i=0;i<31 && sack;i++){
+                unsigned short seq = cumack+1+i;
+                if((sack & (1UL<<i)) && (unsigned short)(seq - tx->sndUna) < (unsigned short)(tx->sndNext - tx->sndUna)){
+                    if(tx->slot[seq%IODP_RWIN_SIZE].used == 1)flow_Ack(eiodp_fd,tx->slot[seq%IODP_RWIN_SIZE].txEnd);
+                    tx->slot[seq%IODP_RWIN_SIZE].used = 2;
+                    top = seq;
+                }
+            }
+            unsigned short seq;
+            for(seq=tx->sndUna;seq!=top;seq++){
+                eIODP_RWRITE_SLOT* sl = &tx->slot[seq%IODP_RWIN_SIZE];
+                if(sl->used == 1 && ++sl->dupcnt == IODP_RWRITE_DUPTHRESH){
+                    sl->fastRetx = 1;   //下一次检查时立即重传
+                }
+            }
+        }
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+    sem_post(&eiodp_fd->rwrite_sem);
+#endif
+}
+
+/************************************************************
+    @brief:
+        数据包分发处理，接收服务函数在收到完整数据包后调用
+    @param:
+        eiodp_fd:eiodp句柄
+        recvbuf：包含eb90头与crc的完整数据包
+        recvlen：数据包长度
+    @return:
+        -1 - 校验错误或者类型不匹配
+         0 - 已处理
+*************************************************************/
+//返回包放入返回缓存，记录溢出与水位
+static void ret_Put(eIODP_TYPE* eiodp_fd, eIODP_RING* ring, unsigned char* rec, int len)
+{
+    if(put_ring(ring,rec,len) == -1){
+        IODP_LOGW("ret put_ring out\n");
+        IODP_METRIC_INC(eiodp_fd,retRingOverflow);
+    }
+    IODP_METRIC_MAX(eiodp_fd,retRingHigh,size_ring(ring));
+}
+
+#if (IODP_OS==IODP_OS_NULL || IODP_OS==IODP_OS_LINUX)
+/************************************************************
+    @brief:
+        用返回包匹配在途的异步请求，匹配上就调用回调（linux下回调在接收处理任务中，不持有锁）
+    @param:
+        eiodp_fd:eiodp句柄
+        pkt：去掉头和crc的返回包
+        len：pkt长度
+    @return:
+        0 - 不属于异步请求
+        1 - 已处理
+*************************************************************/
+static int pending_Match(eIODP_TYPE* eiodp_fd, unsigned char* pkt, int len)
+{
+    int i, best=-1;
+    unsigned char type = pkt[1];
+    int ok = (pkt[0]==0x6c);
+    unsigned short key = 0, retlen = 0;
+    if(ok){
+        if(len<6)return 0;
+        key = ((unsigned short)pkt[2] << 8) | ((unsigned short)pkt[3]) ;
+        retlen = ((unsigned short)pkt[4] << 8) | ((unsigned short)pkt[5]) ;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    //错误包不带地址，交给最早发出的同类请求
+    for(i=0;i<IODP_PENDING_MAX;i++){
+        eIODP_PENDING* pd = &eiodp_fd->pending[i];
+        if(!pd->used || pd->type!=type)continue;
+        if(ok && (pd->key!=key || (type==IODP_TYPE_READADDR && pd->len!=retlen)))continue;
+        if(best<0 || (short)(pd->order - eiodp_fd->pending[best].order) < 0)best=i;
+    }
+    if(best<0){
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+        return 0;
+    }
+
+    eIODP_PENDING* pd = &eiodp_fd->pending[best];
+    flow_Ack(eiodp_fd,pd->txEnd);
+    if(pd->used==2){
+        //已经超时的请求的迟到返回，吃掉
+        pd->used = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+        return 1;
+    }
+    eIODP_DONE_CB cb = pd->cb;
+    void* ctx = pd->ctx;
+    int status, dlen=0;
+    unsigned char* data=nullptr;
+    if(ok){
+        if(retlen!=len-6){
+            status = IODP_ERROR_RECVLEN;
+        }
+        else{
+            int op = (type==IODP_TYPE_READADDR) ? IODP_RTT_ADDR : IODP_RTT_FUNC;
+            unsigned long long now = iodp_now(eiodp_fd);
+            if(pd->retry==0)rtt_Sample(eiodp_fd,op,now-pd->sendtime);
+            metrics_Latency(eiodp_fd,(type==IODP_TYPE_READADDR)?IODP_OP_READADDR:IODP_OP_FUNCTION,now-pd->firstsend);
+            status = retlen;
+            data = &pkt[6];
+            dlen = retlen;
+        }
+    }
+    else{
+        IODP_METRIC_INC(eiodp_fd,errorPkts);
+        status = IODP_ERROR_PKT;
+        data = &pkt[2];
+        dlen = len>2 ? 1 : 0;
+    }
+    //先释放表项，回调中可以发起新的请求；释放之后eiodpCancel找不到它，回调一定会来
+    pd->used = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    cb(ctx,status,data,dlen);
+    return 1;
+}
+
+//异步请求超时检查：读请求按RTO重发，超过次数或者function请求超时则回调超时
+static void pending_Service(eIODP_TYPE* eiodp_fd)
+{
+    int i, nexp=0;
+    eIODP_DONE_CB expcb[IODP_PENDING_MAX];
+    void* expctx[IODP_PENDING_MAX];
+    unsigned long long now = iodp_now(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    for(i=0;i<IODP_PENDING_MAX;i++){
+        eIODP_PENDING* pd = &eiodp_fd->pending[i];
+        if(!pd->used || now < pd->deadline)continue;
+        if(pd->used==2){
+            pd->used = 0;
+            continue;
+        }
+        int op = (pd->type==IODP_TYPE_READADDR) ? IODP_RTT_ADDR : IODP_RTT_FUNC;
+        int maxretry = (pd->type==IODP_TYPE_READADDR) ? IODP_READ_RETRY : IODP_FUNC_RETRY;
+        rtt_Backoff(eiodp_fd,op);
+        if(pd->type==IODP_TYPE_READADDR && pd->retry<maxretry){
+            pd->retry++;
+            pd->sendtime = now;
+            pd->deadline = now + eiodp_fd->rtt[op].rto;
+            IODP_METRIC_INC(eiodp_fd,retries);
+            iodp_Write(eiodp_fd,pd->frame,14);
+            continue;
+        }
+        //超时后再保留一个RTO，期间到达的迟到返回不会被当成下一个相同请求的结果
+        IODP_METRIC_INC(eiodp_fd,timeouts);
+        pd->used = 2;
+        pd->deadline = now + eiodp_fd->rtt[op].rto;
+        expcb[nexp] = pd->cb;
+        expctx[nexp] = pd->ctx;
+        nexp++;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    //回调放到最后，回调中可以发起新的请求
+    for(i=0;i<nexp;i++)expcb[i](expctx[i],IODP_ERROR_TIMEOUT,nullptr,0);
+}
+#endif
+
+static int pkt_Dispatch(eIODP_TYPE* eiodp_fd, unsigned char* recvbuf, int recvlen)
+{
+    IODP_METRIC_INC(eiodp_fd,rxFrames);
+    IODP_METRIC_ADD(eiodp_fd,rxBytes,recvlen);
+    //------------------确定包类型
+    if(((recvbuf[4])&IODP_TYPEBIT_SR_MASK)==0)//确定包为返回类型
+    {
+        //接受到返回类型的包，先校验，再根据返回类型确定不同的返回缓冲区，再给信号
+        if(checkpktcrc(recvbuf,recvlen)==0){
+            IODP_LOGW("retpkt crc error\n");
+            IODP_METRIC_INC(eiodp_fd,crcErrors);
+            return -1;
+        }
+#if (IODP_OS==IODP_OS_NULL || IODP_OS==IODP_OS_LINUX)
+        if((recvbuf[5]==IODP_TYPE_READADDR || recvbuf[5]==IODP_TYPE_FUNCTION) &&
+           pending_Match(eiodp_fd,&recvbuf[4],recvlen-8))return 0;
+#endif
+        //返回缓存区中按记录存放：2字节长度+去掉头和crc的包，长度覆盖在size字段上
+        recvbuf[2]=(unsigned char)((recvlen-8)>>8)&0xff;
+        recvbuf[3]=(unsigned char)(recvlen-8)&0xff;
+        //check pkt type code
+        if(recvbuf[5]==IODP_TYPE_READADDR || recvbuf[5]==IODP_TYPE_MREAD || recvbuf[5]==IODP_TYPE_CREAD ||
+           recvbuf[5]==IODP_TYPE_READ32)//readaddr，多段读、条件读、32位地址读共用读返回缓存
+        {
+            ret_Put(eiodp_fd,eiodp_fd->retbuf_readaddr,&recvbuf[2],recvlen-6);
+#if (IODP_OS==IODP_OS_LINUX)
+            sem_post(&(eiodp_fd->readaddr_retsem));
+#elif (IODP_OS==IODP_OS_FREERTOS)
+#endif
+        }
+        else if(recvbuf[5]==IODP_TYPE_FUNCTION)//function
+        {
+            ret_Put(eiodp_fd,eiodp_fd->retbuf_func,&recvbuf[2],recvlen-6);
+#if (IODP_OS==IODP_OS_LINUX)
+            sem_post(&(eiodp_fd->func_retsem));
+#elif (IODP_OS==IODP_OS_FREERTOS)
+#endif
+        }
+        else if(recvbuf[5]==IODP_TYPE_RWRITE)//reliable write ack
+        {
+            rwrite_onAck(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_CREDIT)//credit probe ack
+        {
+            flow_onProbeAck(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_PUSH)//subscription push
+        {
+            sub_onPush(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_SCHUNK)//stream chunk
+        {
+            stream_onChunk(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else {IODP_LOGW("retpkt type 0x%02x no match\n",recvbuf[5]);IODP_METRIC_INC(eiodp_fd,unknownType);return -1;}
+    }
+    else                                 //确定包为发送类型
+    {
+        //接受到发送类型的包需要 更具type代码分别转向不同的服务类型
+        if(recvbuf[5]==IODP_TYPE_WRITEADDR)//write addr
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("write addr pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            writeaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_READADDR)//readaddr
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("readaddr pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            readaddr_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_FUNCTION)//function
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("readaddr pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            function_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_RWRITE)//reliable write
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("rwrite pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            rwrite_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_MREAD)//multi read
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("mread pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            mread_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_MWRITE)//multi write
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("mwrite pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            mwrite_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_CREDIT)//credit probe
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("credit pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            credit_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_SUB)//subscribe
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("sub pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            sub_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_CREAD)//conditional read
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("cread pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            cread_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_WRITE32)//32-bit address write
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("write32 pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            write32_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_READ32)//32-bit address read
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("read32 pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            read32_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_RESYNC || recvbuf[5]==IODP_TYPE_UNSUB)//resync, unsubscribe
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("resync pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            resync_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else if(recvbuf[5]==IODP_TYPE_STREAM || recvbuf[5]==IODP_TYPE_SCTL)//stream open, credit/cancel
+        {
+            if(checkpktcrc(recvbuf,recvlen)==0){IODP_LOGW("stream pkt crc error\n");IODP_METRIC_INC(eiodp_fd,crcErrors);return -1;}
+            if(recvbuf[5]==IODP_TYPE_STREAM)stream_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+            else sctl_Process(eiodp_fd,&recvbuf[4],recvlen-8);
+        }
+        else {IODP_LOGW("pkt type 0x%02x no match\n",recvbuf[5]);IODP_METRIC_INC(eiodp_fd,unknownType);return -1;}
+    }
+    return 0;
+}
+
+/************************************************************
+    @brief:
+        增量解析：输入任意长度的数据，收齐的包交给pkt_Dispatch，没收齐的部分留在句柄中
+    @param:
+        eiodp_fd:eiodp句柄
+        in：收到的数据
+        len：数据长度
+    @return:
+        本次处理完成的数据包个数
+*************************************************************/
+static int parser_Feed(eIODP_TYPE* eiodp_fd, unsigned char* in, int len)
+{
+    eIODP_PARSER* ps = &eiodp_fd->parser;
+    int i=0, frames=0;
+    while(i<len)
+    {
+        //确定帧头
+        if(ps->have==0){
+            if(in[i]!=0xeb){IODP_LOGD("recvbuf[0]!=0xeb\n");IODP_METRIC_INC(eiodp_fd,resyncs);i++;continue;}
+            ps->buf[ps->have++]=in[i++];
+            continue;
+        }
+        if(ps->have==1){
+            //不消耗这个字节，它可能是下一个帧头的0xeb
+            if(in[i]!=0x90){IODP_LOGD("recvbuf[1]!=0x90\n");IODP_METRIC_INC(eiodp_fd,resyncs);ps->have=0;continue;}
+            ps->buf[ps->have++]=in[i++];
+            continue;
+        }
+        //包长度
+        if(ps->have<4){
+            ps->buf[ps->have++]=in[i++];
+            if(ps->have==4){
+                unsigned short pktlen = ((unsigned short)ps->buf[2] << 8) | ((unsigned short)ps->buf[3]) ;
+                //至少要有TYPE与CRC
+                if(pktlen>=IODP_RECV_MAX_LEN-4 || pktlen<6){
+                    IODP_LOGW("pktlen %u error\n",pktlen);
+                    IODP_METRIC_INC(eiodp_fd,resyncs);
+                    ps->have=0;
+                    continue;
+                }
+                ps->need=pktlen+4;
+            }
+            continue;
+        }
+        //包体整块拷贝
+        int n = ps->need - ps->have;
+        if(n > len-i)n = len-i;
+        memcpy(&ps->buf[ps->have],&in[i],n);
+        ps->have += n;
+        i += n;
+        if(ps->have == ps->need){
+            int pktlen = ps->need;
+            ps->have = 0;
+            ps->need = 0;
+            pkt_Dispatch(eiodp_fd,ps->buf,pktlen);
+            frames++;
+        }
+    }
+    return frames;
+}
+
+#if (IODP_OS!=IODP_OS_NULL)
+
+/************************************************************
+    @brief:
+        接受数据压入循环缓存-任务
+    @param:
+        eiodp_fd:eiodp句柄
+*************************************************************/
+int eiodp_recvpushTask(eIODP_TYPE* eiodp_fd)
+{
+    unsigned int devfd=eiodp_fd->iodevHandle;
+    unsigned char recvbuf[1024]={0};
+    int recvlen=0;
+    int off=0;
+    int stalled=0;
+    uint32 space=0;
+    while(!eiodp_fd->stopping){
+        //recvlen=IOREAD(devfd,recvbuf,1024);
+        recvlen = eiodp_fd->iodevRead(devfd,(char*)recvbuf,1024);
+        if(recvlen<=0) continue;
+        //接收缓存满时不再丢弃，等处理任务取走数据，压力反推到设备驱动或发送方的流量控制
+        off = 0;
+        stalled = 0;
+        while(off < recvlen){
+            space = eiodp_fd->recv_ringbuf->bufSize-1-size_ring(eiodp_fd->recv_ringbuf);
+            if(space == 0){
+                if(!stalled){
+                    //计为一次缓存满，数据没有丢
+                    IODP_METRIC_INC(eiodp_fd,recvRingOverflow);
+                    IODP_LOGD("recv ring full, wait\n");
+                    stalled = 1;
+                }
+                usleep(1000);
+                continue;
+            }
+            if(space > (uint32)(recvlen-off))space = recvlen-off;
+            put_ring(eiodp_fd->recv_ringbuf,&recvbuf[off],space);
+            off += space;
+        }
+        IODP_METRIC_MAX(eiodp_fd,recvRingHigh,size_ring(eiodp_fd->recv_ringbuf));
+    }
+    return 0;
+}
+
+/************************************************************
+    @brief:
+        接收服务函数-任务
+    @param:
+        eiodp_fd:eiodp句柄
+*************************************************************/
+int eiodp_recvProcessTask(eIODP_TYPE* eiodp_fd)
+{
+    unsigned char recvbuf[256];
+    int recvlen=0;
+    while(!eiodp_fd->stopping)
+    {
+        pending_Service(eiodp_fd);
+        sub_Service(eiodp_fd);
+        stream_Service(eiodp_fd);
+        persist_Service(eiodp_fd);
+        recvlen=get_ring(eiodp_fd->recv_ringbuf,recvbuf,sizeof(recvbuf));
+        if(recvlen<=0){continue;}
+        parser_Feed(eiodp_fd,recvbuf,recvlen);
+    }
+    return 0;
+}
+#endif
+
+#if (IODP_OS==IODP_OS_NULL)
+/************************************************************
+    @brief:
+        接收服务函数-任务(无操作系统) 在无操作系统的程序里 需要连续调用
+    @param:
+        eiodp_fd:eiodp句柄
+*************************************************************/
+int eiodp_recvProcessTask_nos(eIODP_TYPE* eiodp_fd)
+{
+    unsigned char recvbuf[IODP_NOS_READ_CHUNK];
+    int recvlen=0;
+    eiodp_fd->pollCount++;
+    pending_Service(eiodp_fd);
+    sub_Service(eiodp_fd);
+    stream_Service(eiodp_fd);
+    persist_Service(eiodp_fd);
+    if(eiodp_fd->iodevRead == nullptr)return -1;
+    recvlen=eiodp_fd->iodevRead(eiodp_fd->iodevHandle,(char*)recvbuf,IODP_NOS_READ_CHUNK);
+    if(recvlen<=0){return -1;}
+    return parser_Feed(eiodp_fd,recvbuf,recvlen);
+}
+
+/************************************************************
+    @brief:
+        无io接口时的数据处理，输入收到的数据，返回包写入outbuf
+*************************************************************/
+int eiodp_process(eIODP_TYPE* eiodp_fd, unsigned char* inbuf, int inlen,
+                    unsigned char* outbuf, int outcap)
+{
+    if(eiodp_fd == nullptr || inlen < 0 || outcap < 0)return IODP_ERROR_PARAM;
+    if((inlen > 0 && inbuf == nullptr) || (outcap > 0 && outbuf == nullptr))return IODP_ERROR_PARAM;
+    eiodp_fd->outbuf = outbuf;
+    eiodp_fd->outcap = outcap;
+    eiodp_fd->outlen = 0;
+    eiodp_fd->pollCount++;
+    //先输出两次调用之间发起的请求
+    if(eiodp_fd->txPending != nullptr && outcap > 0){
+        eiodp_fd->outlen = get_ring(eiodp_fd->txPending,outbuf,outcap);
+    }
+    pending_Service(eiodp_fd);
+    if(inlen > 0)parser_Feed(eiodp_fd,inbuf,inlen);
+    //这次输入引起的推送一起输出
+    sub_Service(eiodp_fd);
+    stream_Service(eiodp_fd);
+    persist_Service(eiodp_fd);
+    eiodp_fd->outbuf = nullptr;
+    return eiodp_fd->outlen;
+}
+#endif
+
+//---------------------------send cmd----------------------------
+
+/************************************************************
+    @brief:
+        写地址操作，将数据写到对方的配置空间上
+        此操作主要是在对方的iodp配置空间的addr偏移地址上写指定长度的数据。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：在对方的配置空间addr地址往后写数据
+        len：数据长度，在[addr,addr+len]上覆盖数据
+        sdbuf：数据头指针
+*************************************************************/
+void eiodpWriteAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf){
+
+    if(eiodp_fd->rwriteMode){
+        if(eiodpWriteAddrReliable(eiodp_fd,addr,len,sdbuf)!=IODP_OK){
+            IODP_LOGW("eiodpWriteAddr reliable write fail\n");
+        }
+        return;
+    }
+
+    unsigned short pktsize=10+len;
+    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
+
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=0x01;
+    sendbuf[6]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[7]=(unsigned char)(addr)&0xff;
+    sendbuf[8]=(unsigned char)(len>>8)&0xff;
+    sendbuf[9]=(unsigned char)(len)&0xff;
+    memcpy(&sendbuf[10],sdbuf,len);
+
+    updatepktcrc(sendbuf,pktsize+4);
+
+    flow_Acquire(eiodp_fd,pktsize+4);
+    //IOWRITE(devfd,sendbuf,pktsize+4);
+    iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,nullptr);
+    MOONOS_FREE(sendbuf);
+}
+
+int eiodpWriteAddr32(eIODP_TYPE* eiodp_fd,uint32 addr,unsigned short len,const unsigned char* sdbuf)
+{
+    if(eiodp_fd == nullptr || sdbuf == nullptr || len == 0)return IODP_ERROR_PARAM;
+    if(len+16 > IODP_RECV_MAX_LEN)return IODP_ERROR_PARAM;
+
+    unsigned short pktsize=12+len;
+    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
+    if(sendbuf == nullptr)return IODP_ERROR_HEAPOVER;
+
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_WRITE32;
+    sendbuf[6]=(unsigned char)(addr>>24)&0xff;
+    sendbuf[7]=(unsigned char)(addr>>16)&0xff;
+    sendbuf[8]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[9]=(unsigned char)(addr)&0xff;
+    sendbuf[10]=(unsigned char)(len>>8)&0xff;
+    sendbuf[11]=(unsigned char)(len)&0xff;
+    memcpy(&sendbuf[12],sdbuf,len);
+    updatepktcrc(sendbuf,pktsize+4);
+
+    flow_Acquire(eiodp_fd,pktsize+4);
+    iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,nullptr);
+    MOONOS_FREE(sendbuf);
+    return IODP_OK;
+}
+//可靠写：窗口复位，换一个会话号，接收端会丢弃旧会话的状态
+static void rwrite_Reset(eIODP_RWRITE_TX* tx)
+{
+    int i;
+    tx->epoch++;
+    tx->sndUna = 0;
+    tx->sndNext = 0;
+    for(i=0;i<IODP_RWIN_SIZE;i++)tx->slot[i].used = 0;
+}
+
+//可靠写：检查窗口中需要重传的包（调用时已持有锁）
+static int rwrite_Service(eIODP_TYPE* eiodp_fd)
+{
+    eIODP_RWRITE_TX* tx = eiodp_fd->pRwTx;
+    unsigned long long now = iodp_now(eiodp_fd);
+    unsigned short seq;
+    int backoff=0;
+    for(seq=tx->sndUna;seq!=tx->sndNext;seq++){
+        eIODP_RWRITE_SLOT* sl = &tx->slot[seq%IODP_RWIN_SIZE];
+        if(sl->used != 1)continue;
+        if(!sl->fastRetx && now - sl->sendtime < eiodp_fd->rtt[IODP_RTT_ADDR].rto)continue;
+        //超时重传计入重传次数并且需要退避，快速重传由对方的确认触发，都不需要
+        if(!sl->fastRetx){
+            if(sl->retry >= IODP_RWRITE_MAXRETRY){
+                //窗口保留，调用者可以再次flush或者放弃；重传次数清零，下一次重新计数
+                unsigned short s;
+                IODP_LOGW("rwrite retry out, seq %u addr 0x%02x%02x unacked\n",seq,sl->frame[10],sl->frame[11]);
+                for(s=tx->sndUna;s!=tx->sndNext;s++)tx->slot[s%IODP_RWIN_SIZE].retry = 0;
+                return IODP_ERROR_TIMEOUT;
+            }
+            if(!backoff){
+                rtt_Backoff(eiodp_fd,IODP_RTT_ADDR);
+                backoff=1;
+            }
+            sl->retry++;
+        }
+        sl->fastRetx = 0;
+        sl->resent = 1;
+        sl->dupcnt = 0;
+        IODP_METRIC_INC(eiodp_fd,rwRetrans);
+        sl->sendtime = now;
+        iodp_Write(eiodp_fd,sl->frame,sl->framelen);
+    }
+    return IODP_OK;
+}
+
+//可靠写：等待ack到来（linux下等信号量，无操作系统下处理一次接收）
+static void rwrite_Wait(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    struct timespec tv;
+    clock_gettime(CLOCK_REALTIME, &tv);
+    tv.tv_nsec += 10*1000*1000;
+    if(tv.tv_nsec >= 1000000000){tv.tv_sec++;tv.tv_nsec -= 1000000000;}
+    sem_timedwait(&eiodp_fd->rwrite_sem,&tv);
+#elif (IODP_OS==IODP_OS_NULL)
+    eiodp_recvProcessTask_nos(eiodp_fd);
+#endif
+}
+
+/************************************************************
+    @brief:
+        可靠写地址操作（EC04），数据全部进入发送窗口后返回
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：在对方的配置空间addr地址往后写数据
+        len：数据长度
+        sdbuf：数据头指针
+    @return:
+        IODP_ERROR_TIMEOUT - 有包超过最大重传次数，窗口保留（各包的重传次数清零），
+            本次数据中还没有进入窗口的部分没有发出，用eiodpWriteUnacked查询没有确认的范围
+        IODP_ERROR_HEAPOVER - 分配窗口失败
+        0 - 成功
+*************************************************************/
+int eiodpWriteAddrReliable(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf)
+{
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    int ret=IODP_OK;
+
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#endif
+    eIODP_RWRITE_TX* tx = eiodp_fd->pRwTx;
+    if(tx == nullptr){
+        tx = MOONOS_MALLOC(sizeof(eIODP_RWRITE_TX));
+        if(tx == nullptr){ret=IODP_ERROR_HEAPOVER;goto END;}
+        memset(tx,0,sizeof(eIODP_RWRITE_TX));
+        tx->epoch = (unsigned short)(iodp_now(eiodp_fd) ^ ((unsigned long)eiodp_fd >> 4));
+        eiodp_fd->pRwTx = tx;
+    }
+
+    unsigned short off=0;
+    while(off<len)
+    {
+        //先等对方接收缓存的额度，ack处理需要mutex_rwrite，等待时要放开
+        if(eiodp_fd->flowMode){
+            unsigned short flen = len-off;
+            if(flen > IODP_RWRITE_MAXDATA)flen = IODP_RWRITE_MAXDATA;
+#if (IODP_OS==IODP_OS_LINUX)
+            pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+            flow_Acquire(eiodp_fd,flen+18);
+            pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#else
+            flow_Acquire(eiodp_fd,flen+18);
+#endif
+        }
+        //窗口已满，等待ack
+        while((unsigned short)(tx->sndNext - tx->sndUna) >= IODP_RWIN_SIZE){
+            ret = rwrite_Service(eiodp_fd);
+            if(ret != IODP_OK)goto END;
+#if (IODP_OS==IODP_OS_LINUX)
+            pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+            rwrite_Wait(eiodp_fd);
+            pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#else
+            rwrite_Wait(eiodp_fd);
+#endif
+        }
+
+        unsigned short dlen = len-off;
+        if(dlen > IODP_RWRITE_MAXDATA)dlen = IODP_RWRITE_MAXDATA;
+        unsigned short daddr = addr+off;
+        unsigned short seq = tx->sndNext;
+        unsigned short pktsize=14+dlen;
+        eIODP_RWRITE_SLOT* sl = &tx->slot[seq%IODP_RWIN_SIZE];
+        unsigned char* sendbuf = sl->frame;
+
+        sendbuf[0]=0xeb;
+        sendbuf[1]=0x90;
+        sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+        sendbuf[3]=(unsigned char)(pktsize)&0xff;
+        sendbuf[4]=0xec;
+        sendbuf[5]=IODP_TYPE_RWRITE;
+        sendbuf[6]=(unsigned char)(tx->epoch>>8)&0xff;
+        sendbuf[7]=(unsigned char)(tx->epoch)&0xff;
+        sendbuf[8]=(unsigned char)(seq>>8)&0xff;
+        sendbuf[9]=(unsigned char)(seq)&0xff;
+        sendbuf[10]=(unsigned char)(daddr>>8)&0xff;
+        sendbuf[11]=(unsigned char)(daddr)&0xff;
+        sendbuf[12]=(unsigned char)(dlen>>8)&0xff;
+        sendbuf[13]=(unsigned char)(dlen)&0xff;
+        memcpy(&sendbuf[14],&sdbuf[off],dlen);
+        updatepktcrc(sendbuf,pktsize+4);
+
+        sl->framelen = pktsize+4;
+        sl->used = 1;
+        sl->retry = 0;
+        sl->dupcnt = 0;
+        sl->fastRetx = 0;
+        sl->resent = 0;
+        sl->sendtime = iodp_now(eiodp_fd);
+        sl->firstsend = sl->sendtime;
+        tx->sndNext++;
+        //持有mutex_rwrite，ack不会在txEnd记录之前被处理
+        iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&sl->txEnd);
+        off += dlen;
+    }
+
+END:
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+#endif
+    return ret;
+}
+
+/************************************************************
+    @brief:
+        等待可靠写窗口中的包全部被确认
+    @param:
+        eiodp_fd:eiodp句柄
+    @return:
+        IODP_ERROR_TIMEOUT - 有包超过最大重传次数，窗口保留，可以再次调用eiodpWriteFlush
+            或者用eiodpWriteDiscard放弃
+        0 - 全部送达
+*************************************************************/
+int eiodpWriteFlush(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    int ret=IODP_OK;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#endif
+    eIODP_RWRITE_TX* tx = eiodp_fd->pRwTx;
+    while(tx != nullptr && tx->sndUna != tx->sndNext){
+        ret = rwrite_Service(eiodp_fd);
+        if(ret != IODP_OK)break;
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+        rwrite_Wait(eiodp_fd);
+        pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#else
+        rwrite_Wait(eiodp_fd);
+#endif
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+#endif
+    return ret;
+}
+
+/************************************************************
+    @brief:
+        查询可靠写窗口中还没有确认的包
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：不为空时返回最早没有确认的包的起始地址
+        next：不为空时返回最后进入窗口的包的结束地址（其后的数据没有发出）
+    @return:
+        <0 - 失败（error code）
+        >=0 - 没有确认的包数，0时addr/next不变
+*************************************************************/
+int eiodpWriteUnacked(eIODP_TYPE* eiodp_fd,unsigned short* addr,unsigned short* next)
+{
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    int cnt=0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#endif
+    eIODP_RWRITE_TX* tx = eiodp_fd->pRwTx;
+    if(tx != nullptr && tx->sndUna != tx->sndNext){
+        eIODP_RWRITE_SLOT* first = &tx->slot[tx->sndUna%IODP_RWIN_SIZE];
+        eIODP_RWRITE_SLOT* last = &tx->slot[(unsigned short)(tx->sndNext-1)%IODP_RWIN_SIZE];
+        unsigned short seq;
+        for(seq=tx->sndUna;seq!=tx->sndNext;seq++){
+            if(tx->slot[seq%IODP_RWIN_SIZE].used == 1)cnt++;
+        }
+        if(addr != nullptr)*addr = (unsigned short)((first->frame[10]<<8)|first->frame[11]);
+        if(next != nullptr){
+            *next = (unsigned short)(((last->frame[10]<<8)|last->frame[11])+((last->frame[12]<<8)|last->frame[13]));
+        }
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+#endif
+    return cnt;
+}
+
+/************************************************************
+    @brief:
+        放弃可靠写窗口中没有确认的包，换一个会话号，对方丢弃旧会话的乱序缓存
+*************************************************************/
+void eiodpWriteDiscard(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_rwrite);
+#endif
+    if(eiodp_fd->pRwTx != nullptr)rwrite_Reset(eiodp_fd->pRwTx);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_rwrite);
+#endif
+}
+
+/************************************************************
+    @brief:
+        设置eiodpWriteAddr是否走可靠写
+    @param:
+        eiodp_fd:eiodp句柄
+        enable：1开启 0关闭
+*************************************************************/
+void eiodpSetReliableWrite(eIODP_TYPE* eiodp_fd,int enable)
+{
+    if(eiodp_fd == nullptr)return;
+    eiodp_fd->rwriteMode = enable ? 1 : 0;
+}
+
+//取出返回缓存区中的一条记录，超过cap的记录被丢弃
+static int ret_Get(eIODP_RING* ring, unsigned char* buf, int cap)
+{
+    unsigned char lenbuf[2];
+    if(size_ring(ring)<2)return 0;
+    get_ring(ring,lenbuf,2);
+    int len = ((int)lenbuf[0] << 8) | lenbuf[1];
+    if(len>cap){
+        while(len>0){
+            int n = get_ring(ring,buf,len>cap?cap:len);
+            if(n<=0)break;
+            len-=n;
+        }
+        return IODP_ERROR_RECVLEN;
+    }
+    return get_ring(ring,buf,len);
+}
+
+//清空某类返回包，发请求之前调用，避免之前超时请求的迟到返回被当成本次结果
+static void iodp_drainRet(eIODP_TYPE* eiodp_fd, unsigned char type)
+{
+    eIODP_RING* ring = (type==IODP_TYPE_READADDR) ? eiodp_fd->retbuf_readaddr : eiodp_fd->retbuf_func;
+    //pIn只在整条记录写完后发布，直接跳到这里不会落在记录中间
+    IODP_ATOMIC_STORE(&ring->pOut,IODP_ATOMIC_LOAD(&ring->pIn));
+#if (IODP_OS==IODP_OS_LINUX)
+    sem_t* sem = (type==IODP_TYPE_READADDR) ? &eiodp_fd->readaddr_retsem : &eiodp_fd->func_retsem;
+    while(sem_trywait(sem)==0);
+#endif
+}
+
+/************************************************************
+    @brief:
+        等待某类返回包进入返回缓存区
+    @param:
+        eiodp_fd:eiodp句柄
+        type：IODP_TYPE_READADDR 或 IODP_TYPE_FUNCTION
+        deadline：截止时间（iodp_now时间轴）
+    @return:
+        IODP_ERROR_TIMEOUT - 超时
+        IODP_OK - 有返回包
+*************************************************************/
+static int iodp_waitRet(eIODP_TYPE* eiodp_fd, unsigned char type, unsigned long long deadline)
+{
+#if (IODP_OS==IODP_OS_LINUX)
+    sem_t* sem = (type==IODP_TYPE_READADDR) ? &eiodp_fd->readaddr_retsem : &eiodp_fd->func_retsem;
+    while(1){
+        unsigned long long now = iodp_now(eiodp_fd);
+        if(now >= deadline){
+            return (sem_trywait(sem)==0) ? IODP_OK : IODP_ERROR_TIMEOUT;
+        }
+        //sem_timedwait只支持CLOCK_REALTIME，把单调时钟上的剩余时间换算过去
+        struct timespec tv;
+        clock_gettime(CLOCK_REALTIME, &tv);
+        unsigned long long ns = (unsigned long long)tv.tv_nsec + (deadline-now)*1000ULL;
+        tv.tv_sec += ns/1000000000ULL;
+        tv.tv_nsec = ns%1000000000ULL;
+        if(sem_timedwait(sem,&tv)==0)return IODP_OK;
+    }
+#elif (IODP_OS==IODP_OS_NULL)
+    eIODP_RING* ring = (type==IODP_TYPE_READADDR) ? eiodp_fd->retbuf_readaddr : eiodp_fd->retbuf_func;
+    while(size_ring(ring)==0){
+        if(iodp_now(eiodp_fd) >= deadline)return IODP_ERROR_TIMEOUT;
+        eiodp_recvProcessTask_nos(eiodp_fd);
+    }
+    return IODP_OK;
+#else
+    eIODP_RING* ring = (type==IODP_TYPE_READADDR) ? eiodp_fd->retbuf_readaddr : eiodp_fd->retbuf_func;
+    return (size_ring(ring)>0) ? IODP_OK : IODP_ERROR_TIMEOUT;
+#endif
+}
+
+/************************************************************
+    @brief:
+        读地址操作，读取对方的配置空间数据
+        此操作主要是将对方的addr地址往后len个数据都读取出来
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：读取地址
+        len：数据长度
+        recvbuf：将数据存入该数组
+        超时时间由RTT估计得出，超时后自动重发，最多重发IODP_READ_RETRY次
+    @return:
+        IODP_ERROR_TIMEOUT - time out
+        IODP_ERROR_SMOLL_RECVLEN - recvlen长度不对
+        IODP_ERROR_RECVLEN - 返回包包长度与实际不符
+        IODP_ERROR_PKT - 有返回包，但是返回了错误代码
+        IODP_ERROR_NORET - 返回type不对
+        >=0 - 成功 读到的数据长度
+*************************************************************/
+//读请求数据包编码，sendbuf 14字节
+static void readaddr_Encode(unsigned char* sendbuf,unsigned short addr,unsigned short len)
+{
+    unsigned short pktsize=10;
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=0x02;
+    sendbuf[6]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[7]=(unsigned char)(addr)&0xff;
+    sendbuf[8]=(unsigned char)(len>>8)&0xff;
+    sendbuf[9]=(unsigned char)(len)&0xff;
+    updatepktcrc(sendbuf,pktsize+4);
+}
+
+//32位地址读请求数据包编码，sendbuf 16字节
+static void read32_Encode(unsigned char* sendbuf,uint32 addr,unsigned short len)
+{
+    unsigned short pktsize=12;
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_READ32;
+    sendbuf[6]=(unsigned char)(addr>>24)&0xff;
+    sendbuf[7]=(unsigned char)(addr>>16)&0xff;
+    sendbuf[8]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[9]=(unsigned char)(addr)&0xff;
+    sendbuf[10]=(unsigned char)(len>>8)&0xff;
+    sendbuf[11]=(unsigned char)(len)&0xff;
+    updatepktcrc(sendbuf,pktsize+4);
+}
+
+//发出编码好的读请求（EC02或EC0E）并等待返回，retbuf至少len+14字节（EC0E为len+16）
+static int readaddr_Transact(eIODP_TYPE* eiodp_fd,unsigned char* sendbuf,unsigned char type,
+        uint32 addr,unsigned short len,unsigned char* recvbuf,unsigned char* retbuf)
+{
+    int ret=IODP_ERROR_TIMEOUT;
+    int attempt=0;
+    uint32 firstEnd=0;
+    //返回包地址字段的长度
+    int alen = (type==IODP_TYPE_READ32) ? 4 : 2;
+    unsigned short pktsize=8+alen;
+
+    iodp_drainRet(eiodp_fd,IODP_TYPE_READADDR);
+    unsigned long long starttime = iodp_now(eiodp_fd);
+
+    for(attempt=0;attempt<=IODP_READ_RETRY;attempt++)
+    {
+        unsigned long long sendtime = iodp_now(eiodp_fd);
+        unsigned long long deadline = sendtime + eiodp_fd->rtt[IODP_RTT_ADDR].rto;
+        if(attempt>0)IODP_METRIC_INC(eiodp_fd,retries);
+        //重发不再占用额度，返回时按第一次发送的位置归还
+        if(attempt==0){
+            flow_Acquire(eiodp_fd,pktsize+4);
+            iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&firstEnd);
+        }
+        //IOWRITE(devfd,sendbuf,pktsize+4);
+        else iodp_Write(eiodp_fd,sendbuf,pktsize+4);
+
+        //等待返回
+        while(1)
+        {
+            ret = iodp_waitRet(eiodp_fd,IODP_TYPE_READADDR,deadline);
+            if(ret != IODP_OK)break;
+            int recvlen = ret_Get(eiodp_fd->retbuf_readaddr,retbuf,len+12+alen);
+            if(recvlen == 0)continue;
+            if(recvlen<3){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+            if(retbuf[0]==0x6c && retbuf[1]==type)
+            {
+                if(recvlen<4+alen){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+                uint32 retaddr = 0;
+                int k;
+                for(k=0;k<alen;k++)retaddr = (retaddr<<8) | retbuf[2+k];
+                unsigned short retlen = ((unsigned short)retbuf[2+alen] << 8) | ((unsigned short)retbuf[3+alen]) ;
+                //地址对不上是之前请求的迟到返回，继续等
+                if(retaddr!=addr)continue;
+                if(retlen!=recvlen-4-alen){ret=IODP_ERROR_RECVLEN;goto END;}
+                memcpy(recvbuf,&retbuf[4+alen],retlen);
+                //重发过的请求分不清是哪一次的返回，不作为RTT样本
+                if(attempt==0)rtt_Sample(eiodp_fd,IODP_RTT_ADDR,iodp_now(eiodp_fd)-sendtime);
+                metrics_Latency(eiodp_fd,IODP_OP_READADDR,iodp_now(eiodp_fd)-starttime);
+                ret = retlen;
+                goto END;
+            }
+            else if(retbuf[0]==0x2c && retbuf[1]==type)
+            {
+                IODP_LOGW("eiodpReadAddr return error code:0x%x\n",retbuf[2]);
+                IODP_METRIC_INC(eiodp_fd,errorPkts);
+                ret = IODP_ERROR_PKT;
+                goto END;
+            }
+            else if(retbuf[1]==IODP_TYPE_READADDR || retbuf[1]==IODP_TYPE_READ32 ||
+                    retbuf[1]==IODP_TYPE_MREAD || retbuf[1]==IODP_TYPE_CREAD){
+                //之前另一种读请求的迟到返回
+                continue;
+            }
+            else{
+                IODP_LOGW("eiodpReadAddr noreturn\n");
+                ret = IODP_ERROR_NORET;
+                goto END;
+            }
+        }
+        rtt_Backoff(eiodp_fd,IODP_RTT_ADDR);
+        IODP_LOGI("time out\n");
+    }
+    if(ret==IODP_ERROR_TIMEOUT)IODP_METRIC_INC(eiodp_fd,timeouts);
+
+END:
+    //收到了返回，说明请求已经被对方取走
+    if(ret!=IODP_ERROR_TIMEOUT)flow_Ack(eiodp_fd,firstEnd);
+    return ret;
+}
+
+int eiodpReadAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* recvbuf)
+{
+    unsigned char sendbuf[14];
+    readaddr_Encode(sendbuf,addr,len);
+
+    unsigned char *retbuf=MOONOS_MALLOC(len+14);
+    if(retbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    int ret = readaddr_Transact(eiodp_fd,sendbuf,IODP_TYPE_READADDR,addr,len,recvbuf,retbuf);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+int eiodpReadAddr32(eIODP_TYPE* eiodp_fd,uint32 addr,unsigned short len,unsigned char* recvbuf)
+{
+    if(eiodp_fd == nullptr || recvbuf == nullptr || len == 0)return IODP_ERROR_PARAM;
+    //返回包要放得下返回缓存
+    if(len+10 > IODP_RETURN_BUFFER)return IODP_ERROR_PARAM;
+    unsigned char sendbuf[16];
+    read32_Encode(sendbuf,addr,len);
+
+    unsigned char *retbuf=MOONOS_MALLOC(len+16);
+    if(retbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    int ret = readaddr_Transact(eiodp_fd,sendbuf,IODP_TYPE_READ32,addr,len,recvbuf,retbuf);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+int eiodpReadMulti(eIODP_TYPE* eiodp_fd,const eIODP_RANGE* ranges,int count)
+{
+    if(eiodp_fd == nullptr || ranges == nullptr || count<=0 || count>IODP_MRANGE_MAX)return IODP_ERROR_PARAM;
+    int ret=IODP_ERROR_TIMEOUT;
+    int attempt=0;
+    uint32 firstEnd=0;
+    unsigned int total=0;
+    int i;
+    for(i=0;i<count;i++){
+        if(ranges[i].len>0 && ranges[i].buf == nullptr)return IODP_ERROR_PARAM;
+        total += ranges[i].len;
+    }
+    //返回包要整个放进读返回缓存
+    if(total+9>IODP_RETURN_BUFFER)return IODP_ERROR_PARAM;
+
+    unsigned short tag = ++eiodp_fd->mreadTag;
+    unsigned short pktsize=10+4*count;
+    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
+    if(sendbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    unsigned char *retbuf=MOONOS_MALLOC(total+8);
+    if(retbuf == nullptr){MOONOS_FREE(sendbuf);return IODP_ERROR_HEAPOVER;}
+
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_MREAD;
+    sendbuf[6]=(unsigned char)(tag>>8)&0xff;
+    sendbuf[7]=(unsigned char)(tag)&0xff;
+    sendbuf[8]=(unsigned char)(count>>8)&0xff;
+    sendbuf[9]=(unsigned char)(count)&0xff;
+    for(i=0;i<count;i++){
+        sendbuf[10+4*i]=(unsigned char)(ranges[i].addr>>8)&0xff;
+        sendbuf[11+4*i]=(unsigned char)(ranges[i].addr)&0xff;
+        sendbuf[12+4*i]=(unsigned char)(ranges[i].len>>8)&0xff;
+        sendbuf[13+4*i]=(unsigned char)(ranges[i].len)&0xff;
+    }
+    updatepktcrc(sendbuf,pktsize+4);
+
+    iodp_drainRet(eiodp_fd,IODP_TYPE_READADDR);
+    unsigned long long starttime = iodp_now(eiodp_fd);
+
+    for(attempt=0;attempt<=IODP_READ_RETRY;attempt++)
+    {
+        unsigned long long sendtime = iodp_now(eiodp_fd);
+        unsigned long long deadline = sendtime + eiodp_fd->rtt[IODP_RTT_ADDR].rto;
+        if(attempt>0)IODP_METRIC_INC(eiodp_fd,retries);
+        if(attempt==0){
+            flow_Acquire(eiodp_fd,pktsize+4);
+            iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&firstEnd);
+        }
+        else iodp_Write(eiodp_fd,sendbuf,pktsize+4);
+
+        //等待返回
+        while(1)
+        {
+            ret = iodp_waitRet(eiodp_fd,IODP_TYPE_READADDR,deadline);
+            if(ret != IODP_OK)break;
+            int recvlen = ret_Get(eiodp_fd->retbuf_readaddr,retbuf,total+8);
+            if(recvlen == 0 || recvlen == IODP_ERROR_RECVLEN)continue;
+            if(recvlen<3){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+            //读地址的迟到返回
+            if(retbuf[1]!=IODP_TYPE_MREAD)continue;
+            if(retbuf[0]==0x6c)
+            {
+                if(recvlen<6){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+                unsigned short rettag = ((unsigned short)retbuf[2] << 8) | ((unsigned short)retbuf[3]) ;
+                unsigned short retlen = ((unsigned short)retbuf[4] << 8) | ((unsigned short)retbuf[5]) ;
+                if(rettag!=tag)continue;
+                if(retlen!=total || retlen!=recvlen-6){ret=IODP_ERROR_RECVLEN;goto END;}
+                unsigned int off=6;
+                for(i=0;i<count;i++){
+                    memcpy(ranges[i].buf,&retbuf[off],ranges[i].len);
+                    off += ranges[i].len;
+                }
+                if(attempt==0)rtt_Sample(eiodp_fd,IODP_RTT_ADDR,iodp_now(eiodp_fd)-sendtime);
+                metrics_Latency(eiodp_fd,IODP_OP_READADDR,iodp_now(eiodp_fd)-starttime);
+                ret = total;
+                goto END;
+            }
+            else
+            {
+                IODP_LOGW("eiodpReadMulti return error code:0x%x\n",retbuf[2]);
+                IODP_METRIC_INC(eiodp_fd,errorPkts);
+                ret = IODP_ERROR_PKT;
+                goto END;
+            }
+        }
+        rtt_Backoff(eiodp_fd,IODP_RTT_ADDR);
+        IODP_LOGI("time out\n");
+    }
+    if(ret==IODP_ERROR_TIMEOUT)IODP_METRIC_INC(eiodp_fd,timeouts);
+
+END:
+    if(ret!=IODP_ERROR_TIMEOUT)flow_Ack(eiodp_fd,firstEnd);
+    MOONOS_FREE(sendbuf);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+int eiodpReadAddrIfChanged(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                unsigned char* buf,uint32* ver)
+{
+    if(eiodp_fd == nullptr || buf == nullptr || ver == nullptr || len == 0)return IODP_ERROR_PARAM;
+    //最坏情况：隔一块变化一块，全部不能压缩
+    unsigned int worst = 12 + 6*(len/IODP_CFG_BLOCK/2+2) + len;
+    if(worst+2 > IODP_RETURN_BUFFER-1)return IODP_ERROR_PARAM;
+    int ret=IODP_ERROR_TIMEOUT;
+    int attempt=0;
+    uint32 firstEnd=0;
+
+    unsigned short tag = ++eiodp_fd->mreadTag;
+    unsigned short pktsize=16;
+    unsigned char sendbuf[20];
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_CREAD;
+    sendbuf[6]=(unsigned char)(tag>>8)&0xff;
+    sendbuf[7]=(unsigned char)(tag)&0xff;
+    sendbuf[8]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[9]=(unsigned char)(addr)&0xff;
+    sendbuf[10]=(unsigned char)(len>>8)&0xff;
+    sendbuf[11]=(unsigned char)(len)&0xff;
+    sendbuf[12]=(unsigned char)(*ver>>24)&0xff;
+    sendbuf[13]=(unsigned char)(*ver>>16)&0xff;
+    sendbuf[14]=(unsigned char)(*ver>>8)&0xff;
+    sendbuf[15]=(unsigned char)(*ver)&0xff;
+    updatepktcrc(sendbuf,pktsize+4);
+
+    unsigned char *retbuf=MOONOS_MALLOC(IODP_RETURN_BUFFER);
+    if(retbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    iodp_drainRet(eiodp_fd,IODP_TYPE_READADDR);
+    unsigned long long starttime = iodp_now(eiodp_fd);
+
+    for(attempt=0;attempt<=IODP_READ_RETRY;attempt++)
+    {
+        unsigned long long sendtime = iodp_now(eiodp_fd);
+        unsigned long long deadline = sendtime + eiodp_fd->rtt[IODP_RTT_ADDR].rto;
+        if(attempt>0)IODP_METRIC_INC(eiodp_fd,retries);
+        if(attempt==0){
+            flow_Acquire(eiodp_fd,pktsize+4);
+            iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&firstEnd);
+        }
+        else iodp_Write(eiodp_fd,sendbuf,pktsize+4);
+
+        //等待返回
+        while(1)
+        {
+            ret = iodp_waitRet(eiodp_fd,IODP_TYPE_READADDR,deadline);
+            if(ret != IODP_OK)break;
+            int recvlen = ret_Get(eiodp_fd->retbuf_readaddr,retbuf,IODP_RETURN_BUFFER);
+            if(recvlen == 0 || recvlen == IODP_ERROR_RECVLEN)continue;
+            if(recvlen<3){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+            //读地址、多段读的迟到返回
+            if(retbuf[1]!=IODP_TYPE_CREAD)continue;
+            if(retbuf[0]==0x6c)
+            {
+                if(recvlen<10){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+                unsigned short rettag = ((unsigned short)retbuf[2] << 8) | ((unsigned short)retbuf[3]) ;
+                if(rettag!=tag)continue;
+                uint32 newver = ((uint32)retbuf[4] << 24) | ((uint32)retbuf[5] << 16) | ((uint32)retbuf[6] << 8) | retbuf[7];
+                unsigned short count = ((unsigned short)retbuf[8] << 8) | ((unsigned short)retbuf[9]) ;
+                int i, off = 10, total = 0;
+                //出错时ver不更新，已经写入buf的块下次还会返回
+                for(i=0;i<count;i++){
+                    if(off+6>recvlen)break;
+                    unsigned short boff = ((unsigned short)retbuf[off] << 8) | ((unsigned short)retbuf[off+1]) ;
+                    unsigned short rawlen = ((unsigned short)retbuf[off+2] << 8) | ((unsigned short)retbuf[off+3]) ;
+                    unsigned short enclen = ((unsigned short)retbuf[off+4] << 8) | ((unsigned short)retbuf[off+5]) ;
+                    if(off+6+enclen>recvlen || (unsigned int)boff+rawlen>len || enclen>rawlen)break;
+                    if(enclen==rawlen)memcpy(&buf[boff],&retbuf[off+6],rawlen);
+                    else if(rle_Decode(&retbuf[off+6],enclen,&buf[boff],rawlen)!=0)break;
+                    off += 6+enclen;
+                    total += rawlen;
+                }
+                if(i<count || off!=recvlen){ret=IODP_ERROR_RECVLEN;goto END;}
+                *ver = newver;
+                if(attempt==0)rtt_Sample(eiodp_fd,IODP_RTT_ADDR,iodp_now(eiodp_fd)-sendtime);
+                metrics_Latency(eiodp_fd,IODP_OP_READADDR,iodp_now(eiodp_fd)-starttime);
+                ret = total;
+                goto END;
+            }
+            else
+            {
+                IODP_LOGW("eiodpReadAddrIfChanged return error code:0x%x\n",retbuf[2]);
+                IODP_METRIC_INC(eiodp_fd,errorPkts);
+                ret = IODP_ERROR_PKT;
+                goto END;
+            }
+        }
+        rtt_Backoff(eiodp_fd,IODP_RTT_ADDR);
+        IODP_LOGI("time out\n");
+    }
+    if(ret==IODP_ERROR_TIMEOUT)IODP_METRIC_INC(eiodp_fd,timeouts);
+
+END:
+    if(ret!=IODP_ERROR_TIMEOUT)flow_Ack(eiodp_fd,firstEnd);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+int eiodpWriteMulti(eIODP_TYPE* eiodp_fd,const eIODP_RANGE* ranges,int count)
+{
+    if(eiodp_fd == nullptr || ranges == nullptr || count<=0 || count>IODP_MRANGE_MAX)return IODP_ERROR_PARAM;
+    unsigned int pktsize=8;
+    int i;
+    for(i=0;i<count;i++){
+        if(ranges[i].len>0 && ranges[i].buf == nullptr)return IODP_ERROR_PARAM;
+        pktsize += 4+ranges[i].len;
+    }
+    if(pktsize>=IODP_RECV_MAX_LEN-4)return IODP_ERROR_PARAM;
+
+    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
+    if(sendbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_MWRITE;
+    sendbuf[6]=(unsigned char)(count>>8)&0xff;
+    sendbuf[7]=(unsigned char)(count)&0xff;
+    unsigned int off=8;
+    for(i=0;i<count;i++){
+        sendbuf[off]=(unsigned char)(ranges[i].addr>>8)&0xff;
+        sendbuf[off+1]=(unsigned char)(ranges[i].addr)&0xff;
+        sendbuf[off+2]=(unsigned char)(ranges[i].len>>8)&0xff;
+        sendbuf[off+3]=(unsigned char)(ranges[i].len)&0xff;
+        memcpy(&sendbuf[off+4],ranges[i].buf,ranges[i].len);
+        off += 4+ranges[i].len;
+    }
+    updatepktcrc(sendbuf,pktsize+4);
+    flow_Acquire(eiodp_fd,pktsize+4);
+    iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,nullptr);
+    MOONOS_FREE(sendbuf);
+    return IODP_OK;
+}
+
+/************************************************************
+    @brief:
+        注册服务函数
+    @param:
+        eiodp_fd:eiodp句柄
+        funcode：API代码
+        callbackFunc:服务函数
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+static int func_Register(eIODP_TYPE* eiodp_fd,uint16 funcode,
+                int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata),
+                eIODP_DEFER_CB deferFunc,eIODP_WRITER_CB writerFunc,const eIODP_STREAM_OPS* streamOps)
+{
+    if(eiodp_fd == nullptr){
+        return IODP_ERROR_PARAM;
+    }
+    if(funcode == IODP_FUNCODE_METRICS){
+        IODP_LOGE("error function code 0x%04x is reserved\n",funcode);
+        return IODP_ERROR_REPEATCODE;
+    }
+    eIODP_FUNC_NODE* node = MOONOS_MALLOC(sizeof(eIODP_FUNC_NODE));
+    if(node == nullptr){
+        return IODP_ERROR_HEAPOVER;
+    }
+    node->funcode=funcode;
+    node->callbackFunc = callbackFunc;
+    node->deferFunc = deferFunc;
+    node->writerFunc = writerFunc;
+    node->streamOps = streamOps;
+    node->pNext=nullptr;
+    if(eiodp_fd->pFuncHead == nullptr){
+        eiodp_fd->pFuncHead = node;
+        return IODP_OK;
+    }
+    int st = addFuncNode(eiodp_fd->pFuncHead,node);
+    if(st == IODP_ERROR_APINODE_REPEAT){
+        IODP_LOGE("error addFuncNode have repeat code\n");
+        return IODP_ERROR_REPEATCODE;
+    }
+    return IODP_OK;
+}
+
+int eiodpRegister(eIODP_TYPE* eiodp_fd,uint16 funcode,
+                int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata))
+{
+    if(callbackFunc == nullptr)return IODP_ERROR_PARAM;
+    return func_Register(eiodp_fd,funcode,callbackFunc,nullptr,nullptr,nullptr);
+}
+
+int eiodpRegisterDeferred(eIODP_TYPE* eiodp_fd,uint16 funcode,eIODP_DEFER_CB deferFunc)
+{
+    if(deferFunc == nullptr)return IODP_ERROR_PARAM;
+    return func_Register(eiodp_fd,funcode,nullptr,deferFunc,nullptr,nullptr);
+}
+
+int eiodpComplete(eIODP_DEFER token,uint16 retlen,const void* retdata)
+{
+    eIODP_TYPE* eiodp_fd = (eIODP_TYPE*)token.fd;
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    if(retlen > IODP_FUNCPKT_RET_LEN-14 || (retlen > 0 && retdata == nullptr))return IODP_ERROR_PARAM;
+    if(token.slot >= IODP_DEFER_MAX || token.gen == 0)return IODP_ERROR_STALE;
+    //表项未完成期间不会被重新分配，先取code再关闭
+    uint16 fcode = eiodp_fd->defer[token.slot].funcode;
+    if(defer_Close(eiodp_fd,&token) < 0)return IODP_ERROR_STALE;
+    unsigned char buf[IODP_FUNCPKT_RET_LEN];
+    if(retlen > 0)memcpy(&buf[10],retdata,retlen);
+    int ret = function_Reply(eiodp_fd,fcode,buf,retlen);
+    return ret < 0 ? ret : IODP_OK;
+}
+
+int eiodpDeferredCount(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    return (int)IODP_ATOMIC_LOAD(&eiodp_fd->deferOpen);
+}
+
+int eiodpRegisterWriter(eIODP_TYPE* eiodp_fd,uint16 funcode,eIODP_WRITER_CB writerFunc)
+{
+    if(eiodp_fd == nullptr || writerFunc == nullptr)return IODP_ERROR_PARAM;
+    if(eiodp_fd->funcTx == nullptr){
+        //帧头10字节+返回数据+crc
+        eiodp_fd->funcTx = MOONOS_MALLOC(IODP_FUNC_RESP_MAX+14);
+        if(eiodp_fd->funcTx == nullptr)return IODP_ERROR_HEAPOVER;
+    }
+    return func_Register(eiodp_fd,funcode,nullptr,nullptr,writerFunc,nullptr);
+}
+
+unsigned char* eiodpWriterReserve(eIODP_WRITER* w,uint16 n)
+{
+    if(w == nullptr)return nullptr;
+    w->reserved = 0;
+    if((uint32)w->len+n > w->cap){
+        w->overflow = 1;
+        return nullptr;
+    }
+    w->reserved = n;
+    return &w->frame[w->hdr+w->len];
+}
+
+int eiodpWriterCommit(eIODP_WRITER* w,uint16 n)
+{
+    if(w == nullptr || n > w->reserved)return IODP_ERROR_PARAM;
+    w->len += n;
+    w->reserved = 0;
+    return IODP_OK;
+}
+
+int eiodpWriterAppend(eIODP_WRITER* w,const void* data,uint16 n)
+{
+    if(w == nullptr || (n > 0 && data == nullptr))return IODP_ERROR_PARAM;
+    unsigned char* p = eiodpWriterReserve(w,n);
+    if(p == nullptr)return IODP_ERROR_RETSIZE;
+    memcpy(p,data,n);
+    return eiodpWriterCommit(w,n);
+}
+
+int eiodpWriterRef(eIODP_WRITER* w,const void* data,uint16 n)
+{
+    if(w == nullptr || (n > 0 && data == nullptr))return IODP_ERROR_PARAM;
+    if(w->nref >= IODP_WRITER_MAXREF)return eiodpWriterAppend(w,data,n);
+    w->reserved = 0;
+    if((uint32)w->len+n > w->cap){
+        w->overflow = 1;
+        return IODP_ERROR_RETSIZE;
+    }
+    if(n == 0)return IODP_OK;
+    w->refPtr[w->nref] = (const unsigned char*)data;
+    w->refOff[w->nref] = w->len;
+    w->refLen[w->nref] = n;
+    w->nref++;
+    w->len += n;
+    return IODP_OK;
+}
+
+int eiodpWriterRemain(const eIODP_WRITER* w)
+{
+    if(w == nullptr)return IODP_ERROR_PARAM;
+    return w->cap-w->len;
+}
+
+void eiodpSetWritev(eIODP_TYPE* eiodp_fd,int (*writevfunc)(int, const void* const* bufs, const int* lens, int n))
+{
+    if(eiodp_fd == nullptr)return;
+    eiodp_fd->iodevWritev = writevfunc;
+}
+
+int eiodpRegisterStream(eIODP_TYPE* eiodp_fd,uint16 funcode,const eIODP_STREAM_OPS* ops)
+{
+    if(eiodp_fd == nullptr || ops == nullptr || ops->open == nullptr || ops->next == nullptr)return IODP_ERROR_PARAM;
+    if(eiodp_fd->streamTx == nullptr){
+        //帧头13字节+数据块+crc
+        eiodp_fd->streamTx = MOONOS_MALLOC(IODP_STREAM_CHUNK+17);
+        if(eiodp_fd->streamTx == nullptr)return IODP_ERROR_HEAPOVER;
+    }
+    return func_Register(eiodp_fd,funcode,nullptr,nullptr,nullptr,ops);
+}
+
+int eiodpStreamOpen(eIODP_TYPE* eiodp_fd,uint16 code,uint16 argsize,const void* arg,uint16 window,
+                eIODP_CHUNK_CB cb,void* ctx)
+{
+    if(eiodp_fd == nullptr || cb == nullptr || (argsize > 0 && arg == nullptr))return IODP_ERROR_PARAM;
+    //打开请求必须能被对方的解析器接收
+    if(argsize+18 >= IODP_RECV_MAX_LEN || window > 0x7fff)return IODP_ERROR_PARAM;
+    if(window == 0)window = IODP_STREAM_WINDOW;
+    unsigned short pktsize = 14+argsize;
+    unsigned char* pkt = MOONOS_MALLOC(pktsize+4);
+    if(pkt == nullptr)return IODP_ERROR_HEAPOVER;
+    int s;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_stream);
+#endif
+    for(s=0;s<IODP_STREAM_MAX;s++){
+        if(!(eiodp_fd->streamOpen & (1UL<<s)))break;
+    }
+    if(s == IODP_STREAM_MAX){
+#if (IODP_OS==IODP_OS_LINUX)
+        pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+        MOONOS_FREE(pkt);
+        return IODP_ERROR_BUSY;
+    }
+    eIODP_STREAM* st = &eiodp_fd->stream[s];
+    st->epoch++;
+    uint16 sid = ((uint16)st->epoch<<8)|s;
+    pkt[0]=0xeb;
+    pkt[1]=0x90;
+    pkt[2]=(unsigned char)(pktsize>>8)&0xff;
+    pkt[3]=(unsigned char)(pktsize)&0xff;
+    pkt[4]=0xec;
+    pkt[5]=IODP_TYPE_STREAM;
+    pkt[6]=(unsigned char)(sid>>8)&0xff;
+    pkt[7]=(unsigned char)(sid)&0xff;
+    pkt[8]=(unsigned char)(code>>8)&0xff;
+    pkt[9]=(unsigned char)(code)&0xff;
+    pkt[10]=(unsigned char)(window>>8)&0xff;
+    pkt[11]=(unsigned char)(window)&0xff;
+    pkt[12]=(unsigned char)(argsize>>8)&0xff;
+    pkt[13]=(unsigned char)(argsize)&0xff;
+    if(argsize > 0)memcpy(&pkt[14],arg,argsize);
+    updatepktcrc(pkt,pktsize+4);
+    st->state = 1;
+    st->tries = 0;
+    st->code = code;
+    st->window = window;
+    st->expectSeq = 0;
+    st->limit = window;
+    st->lastTime = iodp_now(eiodp_fd);
+    st->openPkt = pkt;
+    st->openLen = pktsize+4;
+    st->cb = cb;
+    st->ctx = ctx;
+    IODP_ATOMIC_STORE(&eiodp_fd->streamOpen,eiodp_fd->streamOpen|(1UL<<s));
+    iodp_Write(eiodp_fd,pkt,pktsize+4);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+    return sid;
+}
+
+int eiodpStreamCancel(eIODP_TYPE* eiodp_fd,int sid)
+{
+    if(eiodp_fd == nullptr || sid < 0 || sid > 0xffff || (sid&0xff) >= IODP_STREAM_MAX)return IODP_ERROR_PARAM;
+    int s = sid&0xff;
+    int ret = IODP_OK;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_stream);
+#endif
+    if(!(eiodp_fd->streamOpen & (1UL<<s)) || eiodp_fd->stream[s].epoch != (sid>>8))ret = IODP_ERROR_PARAM;
+    else{
+        stream_Free(eiodp_fd,s);
+        stream_SendCtl(eiodp_fd,(uint16)sid,IODP_SCTL_CANCEL,0);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_stream);
+#endif
+    return ret;
+}
+
+int eiodpStreamCount(eIODP_TYPE* eiodp_fd,int role)
+{
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    int i, n = 0;
+    if(role == 0){
+        uint32 mask = IODP_ATOMIC_LOAD(&eiodp_fd->streamOpen);
+        for(i=0;i<IODP_STREAM_MAX;i++)if(mask & (1UL<<i))n++;
+    }
+    else{
+        for(i=0;i<IODP_STREAM_MAX;i++)if(eiodp_fd->streamSrv[i].used)n++;
+    }
+    return n;
+}
+/************************************************************
+    @brief:
+        打印已经注册的服务函数
+    @param:
+        eiodp_fd:eiodp句柄
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpShowRegFunc(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr){
+        return IODP_ERROR_PARAM;
+    }
+    if(eiodp_fd->pFuncHead == nullptr){
+        printf("no Register Function\n");
+        return IODP_OK;
+    }
+    eIODP_FUNC_NODE* p = eiodp_fd->pFuncHead;
+    while(p){
+        if(p->deferFunc)printf("function code: 0x%04x   function ptr: %p (deferred)\n",p->funcode,(void*)p->deferFunc);
+        else if(p->writerFunc)printf("function code: 0x%04x   function ptr: %p (writer)\n",p->funcode,(void*)p->writerFunc);
+        else if(p->streamOps)printf("function code: 0x%04x   function ptr: %p (stream)\n",p->funcode,(void*)p->streamOps->next);
+        else printf("function code: 0x%04x   function ptr: 0x%x\n",p->funcode,p->callbackFunc);
+        p=p->pNext;
+    }
+
+    return IODP_OK;
+}
+
+/************************************************************
+    @brief:
+        调用服务端的API接口，该接口由服务端的eiodpRegister注册的callbackFunc函数来提供
+    @param:
+        eiodp_fd:eiodp句柄
+        code：API代码
+        argsize：入参arg的长度
+        arg：API入参
+        retarg：用户需要提供返回参数的容器
+    @return:
+        <0 - 失败（error code）
+        >0 - 成功 返回参数长度
+*************************************************************/
+//函数调用数据包编码，sendbuf argsize+14字节
+static void function_Encode(unsigned char* sendbuf,uint16 code,uint16 argsize,const void* arg)
+{
+    unsigned short pktsize=10+argsize;
+    sendbuf[0]=0xeb;sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;sendbuf[5]=0x03;
+    sendbuf[6]=(unsigned char)(code>>8)&0xff;
+    sendbuf[7]=(unsigned char)(code)&0xff;
+    sendbuf[8]=(unsigned char)(argsize>>8)&0xff;
+    sendbuf[9]=(unsigned char)(argsize)&0xff;
+    if(argsize && arg != &sendbuf[10])memcpy(&sendbuf[10],arg,argsize);
+    updatepktcrc(sendbuf,pktsize+4);
+}
+
+//发出编码好的函数调用并等待返回，retbuf至少IODP_FUNC_RESP_MAX+6字节，返回参数超过retcap时不复制
+static int function_Transact(eIODP_TYPE* eiodp_fd,unsigned char* sendbuf,uint16 code,
+        uint16 argsize,void* retarg,uint16 retcap,unsigned char* retbuf)
+{
+    int ret=IODP_ERROR_TIMEOUT;
+    int attempt=0;
+    uint32 firstEnd=0;
+    unsigned short pktsize=10+argsize;
+
+    iodp_drainRet(eiodp_fd,IODP_TYPE_FUNCTION);
+    unsigned long long starttime = iodp_now(eiodp_fd);
+
+    for(attempt=0;attempt<=IODP_FUNC_RETRY;attempt++)
+    {
+        unsigned long long sendtime = iodp_now(eiodp_fd);
+        unsigned long long deadline = sendtime + eiodp_fd->rtt[IODP_RTT_FUNC].rto;
+        if(attempt>0)IODP_METRIC_INC(eiodp_fd,retries);
+        //重发不再占用额度，返回时按第一次发送的位置归还
+        if(attempt==0){
+            flow_Acquire(eiodp_fd,pktsize+4);
+            iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&firstEnd);
+        }
+        //IOWRITE(devfd,sendbuf,pktsize+4);
+        else iodp_Write(eiodp_fd,sendbuf,pktsize+4);
+
+        //等待返回
+        while(1)
+        {
+            ret = iodp_waitRet(eiodp_fd,IODP_TYPE_FUNCTION,deadline);
+            if(ret != IODP_OK)break;
+            int recvlen = ret_Get(eiodp_fd->retbuf_func,retbuf,IODP_FUNC_RESP_MAX+6);
+            if(recvlen == 0)continue;
+            if(recvlen<3){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+            if(retbuf[0]==0x6c && retbuf[1]==0x03)
+            {
+                if(recvlen<6){ret=IODP_ERROR_SMOLL_RECVLEN;goto END;}
+                unsigned short retcode = ((unsigned short)retbuf[2] << 8) | ((unsigned short)retbuf[3]) ;
+                unsigned short retlen = ((unsigned short)retbuf[4] << 8) | ((unsigned short)retbuf[5]) ;
+                //code对不上是之前请求的迟到返回，继续等
+                if(retcode!=code)continue;
+                if(retlen!=recvlen-6){ret=IODP_ERROR_RECVLEN;goto END;}
+                if(retlen>retcap){ret=IODP_ERROR_RETSIZE;goto END;}
+                memcpy(retarg,&retbuf[6],retlen);
+                if(attempt==0)rtt_Sample(eiodp_fd,IODP_RTT_FUNC,iodp_now(eiodp_fd)-sendtime);
+                metrics_Latency(eiodp_fd,IODP_OP_FUNCTION,iodp_now(eiodp_fd)-starttime);
+                ret = retlen;
+                goto END;
+            }
+            else if(retbuf[0]==0x2c && retbuf[1]==0x03)
+            {
+                IODP_LOGW("eiodpFunction return error code:0x%x\n",retbuf[2]);
+                IODP_METRIC_INC(eiodp_fd,errorPkts);
+                ret = IODP_ERROR_PKT;
+                goto END;
+            }
+            else{
+                IODP_LOGW("eiodpFunction noreturn\n");
+                ret = IODP_ERROR_NORET;
+                goto END;
+            }
+        }
+        rtt_Backoff(eiodp_fd,IODP_RTT_FUNC);
+        IODP_LOGI("time out\n");
+    }
+    if(ret==IODP_ERROR_TIMEOUT)IODP_METRIC_INC(eiodp_fd,timeouts);
+
+END:
+    //收到了返回，说明请求已经被对方取走
+    if(ret!=IODP_ERROR_TIMEOUT)flow_Ack(eiodp_fd,firstEnd);
+    return ret;
+}
+
+int eiodpFunction(eIODP_TYPE* eiodp_fd, uint16 code, 
+        uint16 argsize,void* arg, void* retarg)
+{
+    unsigned short pktsize=10+argsize;
+    unsigned char *sendbuf=MOONOS_MALLOC(pktsize+4);
+    if(sendbuf == nullptr)return IODP_ERROR_HEAPOVER;
+    function_Encode(sendbuf,code,argsize,arg);
+
+    unsigned char *retbuf=MOONOS_MALLOC(IODP_FUNC_RESP_MAX+6);
+    if(retbuf == nullptr){MOONOS_FREE(sendbuf);return IODP_ERROR_HEAPOVER;}
+    int ret = function_Transact(eiodp_fd,sendbuf,code,argsize,retarg,IODP_FUNCPKT_RET_LEN,retbuf);
+    MOONOS_FREE(sendbuf);
+    MOONOS_FREE(retbuf);
+    return ret;
+}
+
+int eiodpFunctionEx(eIODP_TYPE* eiodp_fd, uint16 code, uint16 argsize, const void* arg,
+        void* retarg, uint16 retcap, unsigned char* frame)
+{
+    unsigned char retbuf[IODP_FUNC_RESP_MAX+6];
+    if(eiodp_fd == nullptr || frame == nullptr || (argsize && arg == nullptr) || (retcap && retarg == nullptr))
+        return IODP_ERROR_PARAM;
+    if(IODP_FUNC_FRAMELEN(argsize) > IODP_RECV_MAX_LEN)return IODP_ERROR_PARAM;
+    function_Encode(frame,code,argsize,arg);
+    return function_Transact(eiodp_fd,frame,code,argsize,retarg,retcap,retbuf);
+}
+
+//---------------------------预编码请求----------------------------
+
+eIODP_PREPARED* eiodpPrepareRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len)
+{
+    if(eiodp_fd == nullptr || len == 0)return nullptr;
+    eIODP_PREPARED* prep = MOONOS_MALLOC(sizeof(eIODP_PREPARED)+14+len+14);
+    if(prep == nullptr)return nullptr;
+    memset(prep,0,sizeof(eIODP_PREPARED));
+    prep->eiodp_fd = eiodp_fd;
+    prep->type = IODP_TYPE_READADDR;
+    prep->key = addr;
+    prep->len = len;
+    prep->framelen = 14;
+    prep->frame = (uint8*)(prep+1);
+    prep->retbuf = prep->frame+14;
+    readaddr_Encode(prep->frame,addr,len);
+    return prep;
+}
+
+eIODP_PREPARED* eiodpPrepareFunction(eIODP_TYPE* eiodp_fd,uint16 code,uint16 argsize,const void* arg)
+{
+    if(eiodp_fd == nullptr || (argsize && arg == nullptr))return nullptr;
+    if(argsize+14 > IODP_RECV_MAX_LEN)return nullptr;
+    eIODP_PREPARED* prep = MOONOS_MALLOC(sizeof(eIODP_PREPARED)+argsize+14+IODP_FUNC_RESP_MAX+6);
+    if(prep == nullptr)return nullptr;
+    memset(prep,0,sizeof(eIODP_PREPARED));
+    prep->eiodp_fd = eiodp_fd;
+    prep->type = IODP_TYPE_FUNCTION;
+    prep->key = code;
+    prep->len = argsize;
+    prep->framelen = argsize+14;
+    prep->frame = (uint8*)(prep+1);
+    prep->retbuf = prep->frame+prep->framelen;
+    function_Encode(prep->frame,code,argsize,arg);
+    return prep;
+}
+
+int eiodpPreparedSetArg(eIODP_PREPARED* prep,uint16 off,const void* data,uint16 n)
+{
+    if(prep == nullptr || prep->type != IODP_TYPE_FUNCTION)return IODP_ERROR_PARAM;
+    if(n == 0)return IODP_OK;
+    if(data == nullptr || (unsigned int)off+n > prep->len)return IODP_ERROR_PARAM;
+    uint8* f = prep->frame;
+    unsigned int total = prep->framelen-4;
+    uint32 crc = ((uint32)f[total]<<24)|((uint32)f[total+1]<<16)|((uint32)f[total+2]<<8)|f[total+3];
+    //只按改变的字节修正CRC，不重算整个数据包
+    crc = crc32_patch(crc,total,10+off,&f[10+off],(const uint8*)data,n);
+    memcpy(&f[10+off],data,n);
+    f[total]=(crc>>24)&0xff;
+    f[total+1]=(crc>>16)&0xff;
+    f[total+2]=(crc>>8)&0xff;
+    f[total+3]=crc&0xff;
+    return IODP_OK;
+}
+
+int eiodpPreparedRead(eIODP_PREPARED* prep,unsigned char* recvbuf)
+{
+    if(prep == nullptr || recvbuf == nullptr || prep->type != IODP_TYPE_READADDR)return IODP_ERROR_PARAM;
+    return readaddr_Transact(prep->eiodp_fd,prep->frame,IODP_TYPE_READADDR,prep->key,prep->len,recvbuf,prep->retbuf);
+}
+
+int eiodpPreparedCall(eIODP_PREPARED* prep,void* retarg)
+{
+    if(prep == nullptr || retarg == nullptr || prep->type != IODP_TYPE_FUNCTION)return IODP_ERROR_PARAM;
+    return function_Transact(prep->eiodp_fd,prep->frame,prep->key,prep->len,retarg,IODP_FUNCPKT_RET_LEN,prep->retbuf);
+}
+
+void eiodpPreparedFree(eIODP_PREPARED* prep)
+{
+    if(prep == nullptr)return;
+    MOONOS_FREE(prep);
+}
+
+#if (IODP_OS==IODP_OS_NULL || IODP_OS==IODP_OS_LINUX)
+//取一个空闲的异步请求表项（调用时已持有锁），返回包没有请求编号，相同的请求不能同时在途
+static eIODP_PENDING* pending_Alloc(eIODP_TYPE* eiodp_fd, unsigned char type, unsigned short key, unsigned short len)
+{
+    int i;
+    eIODP_PENDING* pfree = nullptr;
+    for(i=0;i<IODP_PENDING_MAX;i++){
+        eIODP_PENDING* pd = &eiodp_fd->pending[i];
+        if(!pd->used){
+            if(pfree == nullptr)pfree = pd;
+            continue;
+        }
+        if(pd->type==type && pd->key==key && (type!=IODP_TYPE_READADDR || pd->len==len))return nullptr;
+    }
+    return pfree;
+}
+
+static void pending_Start(eIODP_TYPE* eiodp_fd, eIODP_PENDING* pd, unsigned char type,
+                unsigned short key, eIODP_DONE_CB cb, void* ctx)
+{
+    int op = (type==IODP_TYPE_READADDR) ? IODP_RTT_ADDR : IODP_RTT_FUNC;
+    pd->type = type;
+    pd->key = key;
+    pd->retry = 0;
+    pd->cb = cb;
+    pd->ctx = ctx;
+    pd->order = eiodp_fd->pendingOrder++;
+    pd->sendtime = iodp_now(eiodp_fd);
+    pd->firstsend = pd->sendtime;
+    pd->deadline = pd->sendtime + eiodp_fd->rtt[op].rto;
+    pd->used = 1;
+}
+
+/************************************************************
+    @brief:
+        异步读地址
+*************************************************************/
+int eiodpReadAddrAsync(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                eIODP_DONE_CB cb,void* ctx)
+{
+    if(eiodp_fd == nullptr || cb == nullptr)return IODP_ERROR_PARAM;
+    int ret=IODP_ERROR_BUSY;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    eIODP_PENDING* pd = pending_Alloc(eiodp_fd,IODP_TYPE_READADDR,addr,len);
+    if(pd == nullptr || !flow_Check(eiodp_fd,14))goto END;
+
+    unsigned short pktsize=10;
+    unsigned char* sendbuf = pd->frame;
+    sendbuf[0]=0xeb;
+    sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;
+    sendbuf[5]=IODP_TYPE_READADDR;
+    sendbuf[6]=(unsigned char)(addr>>8)&0xff;
+    sendbuf[7]=(unsigned char)(addr)&0xff;
+    sendbuf[8]=(unsigned char)(len>>8)&0xff;
+    sendbuf[9]=(unsigned char)(len)&0xff;
+    updatepktcrc(sendbuf,pktsize+4);
+
+    pd->len = len;
+    pending_Start(eiodp_fd,pd,IODP_TYPE_READADDR,addr,cb,ctx);
+    iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&pd->txEnd);
+    ret = IODP_OK;
+END:
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    return ret;
+}
+
+/************************************************************
+    @brief:
+        异步调用服务函数
+*************************************************************/
+int eiodpFunctionAsync(eIODP_TYPE* eiodp_fd, uint16 code, uint16 argsize, void* arg,
+                eIODP_DONE_CB cb,void* ctx)
+{
+    if(eiodp_fd == nullptr || cb == nullptr || (argsize>0 && arg == nullptr))return IODP_ERROR_PARAM;
+    int ret=IODP_ERROR_BUSY;
+    unsigned short pktsize=10+argsize;
+    unsigned char *sendbuf=nullptr;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    eIODP_PENDING* pd = pending_Alloc(eiodp_fd,IODP_TYPE_FUNCTION,code,0);
+    if(pd == nullptr || !flow_Check(eiodp_fd,pktsize+4))goto END;
+    sendbuf=MOONOS_MALLOC(pktsize+4);
+    if(sendbuf == nullptr){ret=IODP_ERROR_HEAPOVER;goto END;}
+    sendbuf[0]=0xeb;sendbuf[1]=0x90;
+    sendbuf[2]=(unsigned char)(pktsize>>8)&0xff;
+    sendbuf[3]=(unsigned char)(pktsize)&0xff;
+    sendbuf[4]=0xec;sendbuf[5]=IODP_TYPE_FUNCTION;
+    sendbuf[6]=(unsigned char)(code>>8)&0xff;
+    sendbuf[7]=(unsigned char)(code)&0xff;
+    sendbuf[8]=(unsigned char)(argsize>>8)&0xff;
+    sendbuf[9]=(unsigned char)(argsize)&0xff;
+    memcpy(&sendbuf[10],arg,argsize);
+    updatepktcrc(sendbuf,pktsize+4);
+
+    pd->len = 0;
+    pending_Start(eiodp_fd,pd,IODP_TYPE_FUNCTION,code,cb,ctx);
+    iodp_WriteEnd(eiodp_fd,sendbuf,pktsize+4,&pd->txEnd);
+    MOONOS_FREE(sendbuf);
+    ret = IODP_OK;
+END:
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    return ret;
+}
+
+int eiodpPendingCount(eIODP_TYPE* eiodp_fd)
+{
+    int i, n=0;
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    for(i=0;i<IODP_PENDING_MAX;i++){
+        if(eiodp_fd->pending[i].used==1)n++;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    return n;
+}
+
+int eiodpCancel(eIODP_TYPE* eiodp_fd,eIODP_DONE_CB cb,void* ctx)
+{
+    int i, ret=IODP_ERROR_PARAM;
+    if(eiodp_fd == nullptr || cb == nullptr)return IODP_ERROR_PARAM;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_pending);
+#endif
+    for(i=0;i<IODP_PENDING_MAX;i++){
+        eIODP_PENDING* pd = &eiodp_fd->pending[i];
+        if(pd->used!=1 || pd->cb!=cb || pd->ctx!=ctx)continue;
+        //与超时相同，保留表项吃掉迟到的返回
+        int op = (pd->type==IODP_TYPE_READADDR) ? IODP_RTT_ADDR : IODP_RTT_FUNC;
+        pd->used = 2;
+        pd->deadline = iodp_now(eiodp_fd) + eiodp_fd->rtt[op].rto;
+        ret = IODP_OK;
+        break;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_pending);
+#endif
+    return ret;
+}
+#endif
+
+/************************************************************
+    @brief:
+        设置时钟源，设置后超时与RTT都按真实时间计算
+    @param:
+        eiodp_fd:eiodp句柄
+        tickfunc：返回当前tick计数，允许32位回绕，NULL取消
+        tickHz：每秒tick数
+*************************************************************/
+void eiodpSetTickSource(eIODP_TYPE* eiodp_fd,uint32 (*tickfunc)(void),uint32 tickHz)
+{
+    if(eiodp_fd == nullptr)return;
+    if(tickfunc == nullptr || tickHz == 0){
+        eiodp_fd->tickFunc = nullptr;
+        return;
+    }
+    eiodp_fd->tickHz = tickHz;
+    eiodp_fd->tickTotal = tickHz;   //从1秒开始，有效时间戳不为0
+    eiodp_fd->tickLast = tickfunc();
+    eiodp_fd->tickFunc = tickfunc;
+}
+
+int eiodpConfigRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* buf)
+{
+    if(eiodp_fd == nullptr || buf == nullptr)return IODP_ERROR_PARAM;
+    if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr))return IODP_ERROR_PARAM;
+    configmem_Read(eiodp_fd,addr,len,buf);
+    return len;
+}
+
+//范围内各块版本的最大值，在读锁内调用
+static uint32 cfg_Version(eIODP_TYPE* eiodp_fd, unsigned short addr, unsigned short len)
+{
+    uint32 ver = 0;
+    unsigned int b;
+    if(len==0)return 0;
+    for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++){
+        uint32 v = IODP_ATOMIC_LOAD(&eiodp_fd->blkver[b]);
+        if((int)(v-ver) > 0 || ver == 0)ver = v;
+    }
+    return ver;
+}
+
+int eiodpConfigReadIfChanged(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                unsigned char* buf,uint32* ver)
+{
+    if(eiodp_fd == nullptr || buf == nullptr || ver == nullptr)return IODP_ERROR_PARAM;
+    if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr) || len==0)return IODP_ERROR_PARAM;
+    uint32 seq, v;
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        v = cfg_Version(eiodp_fd,addr,len);
+        if(v == *ver && !cfg_ReadRetry(eiodp_fd,seq))return 0;
+        memcpy(buf,&eiodp_fd->configmem[addr],len);
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+    *ver = v;
+    return len;
+}
+
+int eiodpConfigWrite(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,const unsigned char* data)
+{
+    if(eiodp_fd == nullptr || data == nullptr)return IODP_ERROR_PARAM;
+    if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr))return IODP_ERROR_PARAM;
+    cfg_WriteBegin(eiodp_fd);
+    configmem_Write(eiodp_fd,addr,len,(unsigned char*)data);
+    cfg_WriteEnd(eiodp_fd,0);
+    return len;
+}
+
+int eiodpXmemWrite(eIODP_TYPE* eiodp_fd,uint32 addr,uint32 len,const unsigned char* data)
+{
+    if(eiodp_fd == nullptr || data == nullptr)return IODP_ERROR_PARAM;
+    if(addr>=IODP_XMEM_SIZE || len>IODP_XMEM_SIZE-addr)return IODP_ERROR_PARAM;
+    cfg_WriteBegin(eiodp_fd);
+    uint32 wlen = xmem_Write(eiodp_fd,addr,len,data);
+    cfg_WriteEnd(eiodp_fd,0);
+    if(wlen<len)return IODP_ERROR_HEAPOVER;
+    return len;
+}
+
+int eiodpXmemRead(eIODP_TYPE* eiodp_fd,uint32 addr,uint32 len,unsigned char* buf)
+{
+    if(eiodp_fd == nullptr || buf == nullptr)return IODP_ERROR_PARAM;
+    if(addr>=IODP_XMEM_SIZE || len>IODP_XMEM_SIZE-addr)return IODP_ERROR_PARAM;
+    xmem_Read(eiodp_fd,addr,len,buf);
+    return len;
+}
+
+uint32 eiodpXmemPages(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr)return 0;
+    return eiodp_fd->xmemPages;
+}
+
+int eiodpConfigPersist(eIODP_TYPE* eiodp_fd,const char* path,uint32 interval_ms)
+{
+#if (IODP_PERSIST_ENABLE)
+    if(eiodp_fd == nullptr || path == nullptr || eiodp_fd->pPersist != nullptr)return IODP_ERROR_PARAM;
+    uint32 size = eiodp_fd->configmemSize;
+    eIODP_PERSIST* ps = MOONOS_MALLOC(sizeof(eIODP_PERSIST));
+    if(ps == nullptr)return IODP_ERROR_HEAPOVER;
+    memset(ps,0,sizeof(eIODP_PERSIST));
+    ps->area = (size+IODP_PERSIST_ALIGN-1)/IODP_PERSIST_ALIGN*IODP_PERSIST_ALIGN;
+    ps->maplen = 2*IODP_PERSIST_ALIGN+3*ps->area;
+    ps->slot = -1;
+    ps->interval_us = interval_ms*1000;
+
+    ps->file = open(path,O_RDWR|O_CREAT,0644);
+    if(ps->file < 0){
+        IODP_LOGE("persist open fail\n");
+        MOONOS_FREE(ps);
+        return IODP_ERROR_PARAM;
+    }
+    struct stat st;
+    if(fstat(ps->file,&st) != 0 ||
+       ((unsigned long long)st.st_size < ps->maplen && ftruncate(ps->file,ps->maplen) != 0)){
+        IODP_LOGE("persist resize fail\n");
+        close(ps->file);
+        MOONOS_FREE(ps);
+        return IODP_ERROR_PARAM;
+    }
+    ps->map = mmap(NULL,ps->maplen,PROT_READ|PROT_WRITE,MAP_SHARED,ps->file,0);
+    if(ps->map == MAP_FAILED){
+        IODP_LOGE("persist mmap fail\n");
+        close(ps->file);
+        MOONOS_FREE(ps);
+        return IODP_ERROR_PARAM;
+    }
+
+    //工作区可能是崩溃时写了一半的，只从完整的检查点恢复
+    int i, best = -1;
+    for(i=0;i<2;i++){
+        if(!persist_Valid(ps,i,size))continue;
+        if(best < 0 || PERSIST_HDR(ps,i)->seq > PERSIST_HDR(ps,best)->seq)best = i;
+    }
+
+    //configmem改为指向工作区，恢复的数据（或者原来的内容）作为一次整体写入，
+    //块版本更新，监视与订阅收到通知
+    char* old = eiodp_fd->configmem;
+    cfg_WriteBegin(eiodp_fd);
+    eiodp_fd->configmem = (char*)PERSIST_LIVE(ps);
+    configmem_Write(eiodp_fd,0,size,(best >= 0) ? PERSIST_SLOT(ps,best) : (unsigned char*)old);
+    cfg_WriteEnd(eiodp_fd,1);
+
+    if(best >= 0){
+        ps->seq = PERSIST_HDR(ps,best)->seq;
+        ps->slot = best;
+        ps->savedCfgSeq = IODP_ATOMIC_LOAD(&eiodp_fd->cfgSeq);
+    }
+    ps->lastTime = iodp_now(eiodp_fd);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_persist);
+#endif
+    eiodp_fd->pPersist = ps;
+    //新文件立即写第一个检查点
+    if(best < 0 && persist_Checkpoint(eiodp_fd) < 0)IODP_LOGW("configmem checkpoint fail\n");
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_persist);
+#endif
+    return (best >= 0) ? 1 : 0;
+#else
+    return IODP_ERROR_PARAM;
+#endif
+}
+
+int eiodpConfigCheckpoint(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_PERSIST_ENABLE)
+    if(eiodp_fd == nullptr)return IODP_ERROR_PARAM;
+    int ret = IODP_ERROR_PARAM;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_persist);
+#endif
+    if(eiodp_fd->pPersist != nullptr){
+        ret = persist_Checkpoint(eiodp_fd);
+        eiodp_fd->pPersist->lastTime = iodp_now(eiodp_fd);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_persist);
+#endif
+    return ret;
+#else
+    return IODP_ERROR_PARAM;
+#endif
+}
+
+void eiodpConfigPersistClose(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_PERSIST_ENABLE)
+    if(eiodp_fd == nullptr)return;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_persist);
+#endif
+    eIODP_PERSIST* ps = eiodp_fd->pPersist;
+    if(ps != nullptr){
+        if(persist_Checkpoint(eiodp_fd) < 0)IODP_LOGW("configmem checkpoint fail\n");
+        eiodp_fd->pPersist = nullptr;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_persist);
+#endif
+    if(ps == nullptr)return;
+    //内容不变，不需要更新块版本
+    cfg_WriteBegin(eiodp_fd);
+    memcpy(eiodp_fd->configmemBuf,eiodp_fd->configmem,eiodp_fd->configmemSize);
+    eiodp_fd->configmem = eiodp_fd->configmemBuf;
+    cfg_WriteEnd(eiodp_fd,0);
+    munmap(ps->map,ps->maplen);
+    close(ps->file);
+    MOONOS_FREE(ps);
+#endif
+}
+
+uint32 eiodpConfigPersistSeq(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_PERSIST_ENABLE)
+    if(eiodp_fd == nullptr || eiodp_fd->pPersist == nullptr)return 0;
+    return eiodp_fd->pPersist->seq;
+#else
+    return 0;
+#endif
+}
+
+uint32 eiodpConfigVersion(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len)
+{
+    if(eiodp_fd == nullptr)return 0;
+    if(addr>=eiodp_fd->configmemSize)return 0;
+    if(len>(eiodp_fd->configmemSize-addr))len = eiodp_fd->configmemSize-addr;
+    uint32 seq, v;
+    do{
+        seq = cfg_ReadBegin(eiodp_fd);
+        v = cfg_Version(eiodp_fd,addr,len);
+    }while(cfg_ReadRetry(eiodp_fd,seq));
+    return v;
+}
+
+int eiodpWatch(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,eIODP_WATCH_CB cb,void* ctx)
+{
+    if(eiodp_fd == nullptr || cb == nullptr || len == 0)return IODP_ERROR_PARAM;
+    if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr))return IODP_ERROR_PARAM;
+    int w, ret = IODP_ERROR_BUSY;
+    unsigned int b;
+    //索引与写入回调查找在同一把锁下修改
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    for(w=0;w<IODP_WATCH_MAX;w++){
+        eIODP_WATCH* wt = &eiodp_fd->watch[w];
+        if(wt->used)continue;
+        wt->addr = addr;
+        wt->len = len;
+        wt->cb = cb;
+        wt->ctx = ctx;
+        wt->used = 1;
+        for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++){
+            eiodp_fd->watchMask[b] |= (1UL<<w);
+        }
+        ret = w;
+        break;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return ret;
+}
+
+int eiodpUnwatch(eIODP_TYPE* eiodp_fd,int id)
+{
+    if(eiodp_fd == nullptr || id<0 || id>=IODP_WATCH_MAX)return IODP_ERROR_PARAM;
+    unsigned int b;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    eiodp_fd->watch[id].used = 0;
+    for(b=0;b<IODP_CFG_NBLOCK;b++){
+        eiodp_fd->watchMask[b] &= ~(1UL<<id);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return IODP_OK;
+}
+
+int eiodpMapRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                eIODP_VREAD_CB cb,void* ctx,uint32 ttl_us)
+{
+    if(eiodp_fd == nullptr || cb == nullptr || len == 0)return IODP_ERROR_PARAM;
+    if(addr>=eiodp_fd->configmemSize || len>(eiodp_fd->configmemSize-addr))return IODP_ERROR_PARAM;
+    int v, ret = IODP_ERROR_BUSY;
+    unsigned int b;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    for(v=0;v<IODP_VREG_MAX;v++){
+        eIODP_VREG* vr = &eiodp_fd->vreg[v];
+        if((eiodp_fd->vregUsed & (1UL<<v)) &&
+           vr->addr < (unsigned int)addr+len && addr < (unsigned int)vr->addr+vr->len){
+            ret = IODP_ERROR_PARAM;
+            break;
+        }
+    }
+    for(v=0;ret==IODP_ERROR_BUSY && v<IODP_VREG_MAX;v++){
+        eIODP_VREG* vr = &eiodp_fd->vreg[v];
+        if(eiodp_fd->vregUsed & (1UL<<v))continue;
+        vr->addr = addr;
+        vr->len = len;
+        vr->cb = cb;
+        vr->ctx = ctx;
+        vr->ttl_us = ttl_us;
+        vr->valid = 0;
+        vr->fillTime = 0;
+        for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++){
+            eiodp_fd->vregMask[b] |= (1UL<<v);
+        }
+        IODP_ATOMIC_STORE(&eiodp_fd->vregUsed,eiodp_fd->vregUsed|(1UL<<v));
+        ret = v;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return ret;
+}
+
+int eiodpUnmapRead(eIODP_TYPE* eiodp_fd,int id)
+{
+    if(eiodp_fd == nullptr || id<0 || id>=IODP_VREG_MAX)return IODP_ERROR_PARAM;
+    unsigned int b;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    IODP_ATOMIC_STORE(&eiodp_fd->vregUsed,eiodp_fd->vregUsed&~(1UL<<id));
+    for(b=0;b<IODP_CFG_NBLOCK;b++){
+        eiodp_fd->vregMask[b] &= ~(1UL<<id);
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return IODP_OK;
+}
+
+int eiodpInvalidateRead(eIODP_TYPE* eiodp_fd,int id)
+{
+    if(eiodp_fd == nullptr || id<0 || id>=IODP_VREG_MAX)return IODP_ERROR_PARAM;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_cfg);
+#endif
+    eiodp_fd->vreg[id].valid = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_cfg);
+#endif
+    return IODP_OK;
+}
+
+int eiodpSubscribe(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,uint16 interval_ms,
+                eIODP_PUSH_CB cb,void* ctx)
+{
+    if(eiodp_fd == nullptr || cb == nullptr || len == 0 || (unsigned int)addr+len > 0x10000)return IODP_ERROR_PARAM;
+    int s, ret = IODP_ERROR_BUSY;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_sub);
+#endif
+    for(s=0;s<IODP_SUB_MAX;s++){
+        eIODP_SUB* sb = &eiodp_fd->sub[s];
+        if(sb->state != IODP_SUB_FREE)continue;
+        sb->state = IODP_SUB_WAIT;
+        sb->addr = addr;
+        sb->len = len;
+        sb->interval_ms = interval_ms;
+        sb->expectSeq = 0;
+        sb->cb = cb;
+        sb->ctx = ctx;
+        sb->reqTime = iodp_now(eiodp_fd);
+        IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait|(1UL<<s));
+        sub_SendSubscribe(eiodp_fd,s);
+        ret = s;
+        break;
+    }
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_sub);
+#endif
+    return ret;
+}
+
+int eiodpUnsubscribe(eIODP_TYPE* eiodp_fd,int sid)
+{
+    if(eiodp_fd == nullptr || sid<0 || sid>=IODP_SUB_MAX)return IODP_ERROR_PARAM;
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_lock(&eiodp_fd->mutex_sub);
+#endif
+    eiodp_fd->sub[sid].state = IODP_SUB_FREE;
+    IODP_ATOMIC_STORE(&eiodp_fd->subWait,eiodp_fd->subWait&~(1UL<<sid));
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_unlock(&eiodp_fd->mutex_sub);
+#endif
+    sub_SendCtl(eiodp_fd,IODP_TYPE_UNSUB,sid);
+    return IODP_OK;
+}
+
+unsigned long long eiodpNow(eIODP_TYPE* eiodp_fd)
+{
+    if(eiodp_fd == nullptr)return 0;
+    return iodp_now(eiodp_fd);
+}
+
+/************************************************************
+    @brief:
+        获取RTT估计值，单位us
+    @param:
+        eiodp_fd:eiodp句柄
+        op：IODP_RTT_ADDR 或 IODP_RTT_FUNC
+        srtt/rttvar/rto：输出，可以为NULL
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        0 - 成功
+*************************************************************/
+int eiodpGetRtt(eIODP_TYPE* eiodp_fd,int op,uint32* srtt,uint32* rttvar,uint32* rto)
+{
+    if(eiodp_fd == nullptr || op < 0 || op >= IODP_RTT_NUM)return IODP_ERROR_PARAM;
+    eIODP_RTT* p = &eiodp_fd->rtt[op];
+    if(srtt)*srtt = p->srtt;
+    if(rttvar)*rttvar = p->rttvar;
+    if(rto)*rto = p->rto;
+    return IODP_OK;
+}
+
+/************************************************************
+    @brief:
+        获取统计快照
+*************************************************************/
+int eiodpGetMetrics(eIODP_TYPE* eiodp_fd,eIODP_METRICS* out)
+{
+#if (IODP_METRICS_ENABLE)
+    if(eiodp_fd == nullptr || out == nullptr)return IODP_ERROR_PARAM;
+    uint32* src = (uint32*)&eiodp_fd->metrics;
+    uint32* dst = (uint32*)out;
+    int i, n = sizeof(eIODP_METRICS)/sizeof(uint32);
+    for(i=0;i<n;i++)dst[i] = IODP_ATOMIC_LOAD(&src[i]);
+    return IODP_OK;
+#else
+    return IODP_ERROR_PARAM;
+#endif
+}
+
+uint32 eiodpHistPercentile(const eIODP_HIST* h,uint32 permille)
+{
+#if (IODP_METRICS_ENABLE)
+    uint32 total=0, acc=0;
+    int b;
+    for(b=0;b<IODP_HIST_BUCKETS;b++)total += h->count[b];
+    if(total == 0)return 0;
+    //向上取整，保证p100落在最后一个有样本的桶
+    unsigned long long rank = ((unsigned long long)total*permille + 999)/1000;
+    if(rank == 0)rank = 1;
+    for(b=0;b<IODP_HIST_BUCKETS;b++){
+        acc += h->count[b];
+        if(acc >= rank){
+            uint32 top = hist_BucketTop(b);
+            return (h->max && top > h->max) ? h->max : top;
+        }
+    }
+    return h->max;
+#else
+    return 0;
+#endif
+}
+
+int eiodpGetMetricsSummary(eIODP_TYPE* eiodp_fd,eIODP_METRICS_SUMMARY* out)
+{
+#if (IODP_METRICS_ENABLE)
+    if(eiodp_fd == nullptr || out == nullptr)return IODP_ERROR_PARAM;
+    eIODP_METRICS* m = MOONOS_MALLOC(sizeof(eIODP_METRICS));
+    if(m == nullptr)return IODP_ERROR_HEAPOVER;
+    int op;
+    eiodpGetMetrics(eiodp_fd,m);
+    out->cnt = m->cnt;
+    for(op=0;op<IODP_OP_NUM;op++){
+        out->lat[op].count = m->lat[op].total;
+        out->lat[op].p50 = eiodpHistPercentile(&m->lat[op],500);
+        out->lat[op].p90 = eiodpHistPercentile(&m->lat[op],900);
+        out->lat[op].p99 = eiodpHistPercentile(&m->lat[op],990);
+        out->lat[op].max = m->lat[op].max;
+    }
+    MOONOS_FREE(m);
+    return IODP_OK;
+#else
+    return IODP_ERROR_PARAM;
+#endif
+}
+
+void eiodpResetMetrics(eIODP_TYPE* eiodp_fd)
+{
+#if (IODP_METRICS_ENABLE)
+    if(eiodp_fd == nullptr)return;
+    uint32* p = (uint32*)&eiodp_fd->metrics;
+    int i, n = sizeof(eIODP_METRICS)/sizeof(uint32);
+    for(i=0;i<n;i++)IODP_ATOMIC_STORE(&p[i],0);
+#endif
+}
+
+int eiodpGetRemoteMetrics(eIODP_TYPE* eiodp_fd,eIODP_METRICS_SUMMARY* out)
+{
+    if(eiodp_fd == nullptr || out == nullptr)return IODP_ERROR_PARAM;
+    unsigned char retdata[IODP_FUNCPKT_RET_LEN];
+    uint32* p = (uint32*)out;
+    int i, n = sizeof(eIODP_METRICS_SUMMARY)/sizeof(uint32);
+    int ret = eiodpFunction(eiodp_fd,IODP_FUNCODE_METRICS,0,retdata,retdata);
+    if(ret < 0)return ret;
+    if(ret != n*4)return IODP_ERROR_RECVLEN;
+    for(i=0;i<n;i++){
+        p[i] = ((uint32)retdata[i*4]<<24) | ((uint32)retdata[i*4+1]<<16) |
+               ((uint32)retdata[i*4+2]<<8) | ((uint32)retdata[i*4+3]);
+    }
+    return IODP_OK;
+}
+
+//-----------------------------------crc32----------------------
+static unsigned long table[256];
+//位逆转
+static unsigned long bitrev(unsigned long input, int bw)
+{
+    int i;
+    unsigned long var;
+    var = 0;
+    for(i=0;i<bw;i++)
+    {
+        if(input & 0x01)
+        {
+            var |= 1<<(bw-1-i);
+        }
+        input>>=1;
+    }
+    return var;
+}
+
+//码表生成
+//如:X32+X26+...X1+1,poly=(1<<26)|...|(1<<1)|(1<<0)
+void crc32_init()
+{
+    int i;
+    int j;
+    unsigned long c;
+    unsigned long poly = 0x4C11DB7;
+    poly=bitrev(poly,32);
+    for(i=0; i<256; i++)
+    {
+        c = i;
+        for (j=0; j<8; j++)
+        {
+            if(c&1)
+            {
+                c=poly^(c>>1);
+            }
+            else
+            {
+                c=c>>1;
+            }
+        }
+        table[i] = c;
+    }
+}
+
+unsigned long crc32_update(unsigned long crc, const void* input, int len)
+{
+    int i;
+    const unsigned char* pch = (const unsigned char*)input;
+    for(i=0;i<len;i++)
+    {
+        crc = (crc>>8)^table[(unsigned char)(crc^*pch)];
+        pch++;
+    }
+    return crc;
+}
+
+unsigned long crc32(void* input, int len)
+{
+    return crc32_update(0xFFFFFFFF,input,len)^0xFFFFFFFF;
+}
+
+//CRC寄存器为unsigned long，bitrev的1<<31会符号扩展，64位平台上寄存器的高位同样参与运算，
+//所以下面的矩阵按寄存器的实际位数计算，不能直接套用32位CRC的合并算法
+#define CRC_REGBITS (sizeof(unsigned long)*8)
+
+//GF(2)上矩阵乘向量，mat[i]为第i位对应的列
+static unsigned long gf2_times(const unsigned long* mat, unsigned long vec)
+{
+    unsigned long sum = 0;
+    while(vec){
+        if(vec&1)sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void gf2_square(unsigned long* square, const unsigned long* mat)
+{
+    unsigned int n;
+    for(n=0;n<CRC_REGBITS;n++)square[n] = gf2_times(mat,mat[n]);
+}
+
+//CRC寄存器经过nzero个0字节后的值。
+//短的直接查表，长的用矩阵平方，耗时与log(nzero)成正比
+static unsigned long crc32_zeros(unsigned long crc, uint32 nzero)
+{
+    unsigned long even[64], odd[64], row;
+    unsigned int n;
+    if(nzero <= 64){
+        while(nzero--)crc = (crc>>8)^table[crc&0xff];
+        return crc;
+    }
+    //odd为经过1个0位的算子，table[128]即多项式
+    odd[0] = table[128];
+    row = 1;
+    for(n=1;n<CRC_REGBITS;n++){
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2_square(even,odd);   //2位
+    gf2_square(odd,even);   //4位
+    do{
+        gf2_square(even,odd);
+        if(nzero&1)crc = gf2_times(even,crc);
+        nzero >>= 1;
+        if(nzero == 0)break;
+        gf2_square(odd,even);
+        if(nzero&1)crc = gf2_times(odd,crc);
+        nzero >>= 1;
+    }while(nzero);
+    return crc;
+}
+
+//CRC是线性的：长度不变时 crc(新) = crc(旧) ^ crc0(旧^新)，crc0为初值0、不取反的CRC。
+//差值只有[off,off+n)非0，前面的0不改变寄存器，只需从off算起再经过后面的0字节
+uint32 crc32_patch(uint32 crc, uint32 total, uint32 off, const uint8* olddata, const uint8* newdata, uint32 n)
+{
+    unsigned long d = 0;
+    uint32 i;
+    for(i=0;i<n;i++){
+        d = (d>>8)^table[(unsigned char)(d^olddata[i]^newdata[i])];
+    }
+    return crc^(uint32)crc32_zeros(d,total-off-n);
+}
+
+int checkpktcrc(unsigned char* data,unsigned int size)
+{
+    unsigned int crcdata = (unsigned int)crc32(data,size-4);
+    if(
+       (data[size-2]==((crcdata>>8)&0xff)) && (data[size-1]==((crcdata)&0xff)) &&
+       (data[size-4]==((crcdata>>24)&0xff)) && (data[size-3]==((crcdata>>16)&0xff))
+      )
+    {
+        return 1;
+    }
+    else{
+        return 0;
+    }
+
+}
+
+int updatepktcrc(unsigned char* data,unsigned int size)
+{
+    unsigned int crcdata = (unsigned int)crc32(data,size-4);
+
+    data[size-2]=((crcdata>>8)&0xff);
+    data[size-1]=((crcdata)&0xff);
+    data[size-4]=((crcdata>>24)&0xff);
+    data[size-3]=((crcdata>>16)&0xff);
+
+}
+
+//---------------------------------------------------------------------------------
+//                             eiodp ring buffer
+
+eIODP_RING* creat_ring(uint32 size)
+{
+    eIODP_RING* pRet=(eIODP_RING*)MOONOS_MALLOC(sizeof (eIODP_RING));
+    pRet->buf=(uint8*)MOONOS_MALLOC(size);
+    if(pRet->buf!=nullptr)
+    {
+        pRet->bufSize=size;
+        pRet->pIn=0;
+        pRet->pOut=0;
+
+    }
+    else {
+        MOONOS_FREE(pRet);
+        pRet=nullptr;
+    }
+
+    return pRet;
+}
+
+void delate_ring(eIODP_RING* p)
+{
+    MOONOS_FREE(p->buf);
+    MOONOS_FREE(p);
+}
+
+uint16 size_ring(eIODP_RING* p)
+{
+    uint32 in = IODP_ATOMIC_LOAD(&p->pIn);
+    uint32 out = IODP_ATOMIC_LOAD(&p->pOut);
+    IODP_FENCE_ACQ();
+    if(in >= out){
+        return in-out;
+    }
+    else{
+        return p->bufSize-(out-in);
+    }
+}
+
+//单生产者单消费者：数据全部拷贝完之后才一次性发布pIn/pOut，另一端不会看到半条记录
+int put_ring(eIODP_RING* p,uint8* buf,uint32 size)
+{
+		int i;
+    //首先要判断是否会写满
+    if(size+size_ring(p) >= p->bufSize){
+        return -1;
+    }
+
+    uint32 in = p->pIn;
+    for(i=0;i<size;i++){
+        p->buf[in]=buf[i];
+
+        if((in+1) >= p->bufSize){
+            in=0;
+        }
+        else {
+            in++;
+        }
+    }
+    IODP_FENCE_REL();
+    IODP_ATOMIC_STORE(&p->pIn,in);
+    return i;
+
+}
+
+int get_ring(eIODP_RING* p,uint8* buf,uint32 size)
+{
+	int i;
+    uint32 in = IODP_ATOMIC_LOAD(&p->pIn);
+    uint32 out = p->pOut;
+    IODP_FENCE_ACQ();
+    if(in == out) return 0;
+
+    
+    for(i=0;i<size;i++){
+        buf[i]=p->buf[out];
+
+        if((out+1) >= p->bufSize){
+            out=0;
+        }
+        else {
+            out++;
+        }
+
+
+        if(in == out){
+            i++;
+            break;
+        }
+    }
+    IODP_FENCE_REL();
+    IODP_ATOMIC_STORE(&p->pOut,out);
+    return i;
+}
+
+
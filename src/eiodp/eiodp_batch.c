@@ -0,0 +1,243 @@
+/*
+    文件名：eiodp_batch.c
+
+    说明：
+        eiodp客户端批量读写，接口说明见eiodp_batch.h。
+        写操作合并在影子空间shadow里，dirty位图记录哪些字节需要发出；
+        读操作按登记顺序存放，发出时排序合并。
+*/
+
+#include "eiodp.h"
+#include "eiodp_batch.h"
+
+#include <string.h>
+
+#define BATCH_ISDIRTY(b,i) ((b)->dirty[(i)>>3] & (1<<((i)&7)))
+
+eIODP_BATCH* eiodpBatchCreate(eIODP_TYPE* eiodp_fd,uint32 window_us,uint32 threshold)
+{
+    if(eiodp_fd == nullptr)return nullptr;
+    eIODP_BATCH* b = MOONOS_MALLOC(sizeof(eIODP_BATCH));
+    if(b == nullptr)return nullptr;
+    memset(b,0,sizeof(eIODP_BATCH));
+    b->eiodp_fd = eiodp_fd;
+    b->window_us = window_us;
+    b->threshold = threshold ? threshold : IODP_BATCH_MAXSPAN;
+    return b;
+}
+
+void eiodpBatchDestroy(eIODP_BATCH* b)
+{
+    if(b == nullptr)return;
+    eiodpBatchFlush(b);
+    MOONOS_FREE(b);
+}
+
+//发出全部脏区间，连续的脏字节为一段，段数或包长到上限时分包
+static int batch_FlushWrites(eIODP_BATCH* b)
+{
+    eIODP_RANGE ranges[IODP_MRANGE_MAX];
+    int count = 0;
+    int ret = IODP_OK;
+    unsigned int pktlen = 8;
+    unsigned int i = 0;
+    if(b->dirtyCnt == 0)return IODP_OK;
+    while(i < IODP_CONFIGMEM_SIZE){
+        if(!BATCH_ISDIRTY(b,i)){i++;continue;}
+        unsigned int start = i;
+        while(i < IODP_CONFIGMEM_SIZE && BATCH_ISDIRTY(b,i) && i-start < IODP_BATCH_MAXSPAN)i++;
+        unsigned int len = i-start;
+        //多段写整包不能超过对方的接收长度
+        if(count == IODP_MRANGE_MAX || pktlen+4+len+4 >= IODP_RECV_MAX_LEN-4){
+            int r = eiodpWriteMulti(b->eiodp_fd,ranges,count);
+            if(r < 0 && ret == IODP_OK)ret = r;
+            b->stat.wireWrites++;
+            count = 0;
+            pktlen = 8;
+        }
+        ranges[count].addr = start;
+        ranges[count].len = len;
+        ranges[count].buf = &b->shadow[start];
+        count++;
+        pktlen += 4+len;
+        b->stat.wireWriteBytes += len;
+    }
+    if(count > 0){
+        int r = eiodpWriteMulti(b->eiodp_fd,ranges,count);
+        if(r < 0 && ret == IODP_OK)ret = r;
+        b->stat.wireWrites++;
+    }
+    memset(b->dirty,0,sizeof(b->dirty));
+    b->dirtyCnt = 0;
+    return ret;
+}
+
+//发出一组合并后的读段，数据分发给每个读操作
+static int batch_ReadGroup(eIODP_BATCH* b, eIODP_RANGE* spans, int* first, int* last,
+                           int nspan, eIODP_BATCH_READ** sorted)
+{
+    int s, k;
+    int ret = eiodpReadMulti(b->eiodp_fd,spans,nspan);
+    b->stat.wireReads++;
+    for(s=0;s<nspan;s++){
+        for(k=first[s];k<=last[s];k++){
+            eIODP_BATCH_READ* rd = sorted[k];
+            if(ret >= 0){
+                memcpy(rd->buf,&spans[s].buf[rd->addr-spans[s].addr],rd->len);
+                if(rd->status)*rd->status = rd->len;
+            }
+            else if(rd->status)*rd->status = ret;
+        }
+    }
+    return ret < 0 ? ret : IODP_OK;
+}
+
+//按地址排序后合并，每一组不超过多段读的段数与返回缓存
+static int batch_FlushReads(eIODP_BATCH* b)
+{
+    eIODP_BATCH_READ* sorted[IODP_BATCH_MAXREAD];
+    eIODP_RANGE spans[IODP_MRANGE_MAX];
+    int first[IODP_MRANGE_MAX], last[IODP_MRANGE_MAX];
+    unsigned char tmp[IODP_RETURN_BUFFER];
+    int i, j, nspan = 0;
+    unsigned int used = 0;
+    int ret = IODP_OK;
+    if(b->readCnt == 0)return IODP_OK;
+
+    //插入排序，地址相同时保持登记顺序
+    for(i=0;i<b->readCnt;i++){
+        eIODP_BATCH_READ* rd = &b->read[i];
+        for(j=i;j>0 && sorted[j-1]->addr > rd->addr;j--)sorted[j] = sorted[j-1];
+        sorted[j] = rd;
+    }
+
+    for(i=0;i<b->readCnt;i++){
+        eIODP_BATCH_READ* rd = sorted[i];
+        unsigned int rend = (unsigned int)rd->addr + rd->len;
+        if(nspan > 0){
+            eIODP_RANGE* sp = &spans[nspan-1];
+            unsigned int send = (unsigned int)sp->addr + sp->len;
+            unsigned int nend = rend > send ? rend : send;
+            //与上一段相邻、重叠或空隙够小，并且合并后放得下
+            if(rd->addr <= send+IODP_BATCH_GAP && nend-sp->addr <= IODP_BATCH_MAXSPAN &&
+               used+(nend-send) <= sizeof(tmp)-9){
+                used += nend-send;
+                sp->len = nend-sp->addr;
+                last[nspan-1] = i;
+                continue;
+            }
+        }
+        //新开一段，当前组满了先发出
+        if(nspan == IODP_MRANGE_MAX || used+rd->len > sizeof(tmp)-9){
+            int r = batch_ReadGroup(b,spans,first,last,nspan,sorted);
+            if(r < 0 && ret == IODP_OK)ret = r;
+            nspan = 0;
+            used = 0;
+        }
+        spans[nspan].addr = rd->addr;
+        spans[nspan].len = rd->len;
+        spans[nspan].buf = &tmp[used];
+        first[nspan] = i;
+        last[nspan] = i;
+        used += rd->len;
+        nspan++;
+    }
+    if(nspan > 0){
+        int r = batch_ReadGroup(b,spans,first,last,nspan,sorted);
+        if(r < 0 && ret == IODP_OK)ret = r;
+    }
+    b->readCnt = 0;
+    return ret;
+}
+
+int eiodpBatchFlush(eIODP_BATCH* b)
+{
+    if(b == nullptr)return IODP_ERROR_PARAM;
+    if(b->dirtyCnt == 0 && b->readCnt == 0)return IODP_OK;
+    //先写后读，读能看到之前缓存的写
+    int ret = batch_FlushWrites(b);
+    int r = batch_FlushReads(b);
+    if(ret == IODP_OK)ret = r;
+    b->pendingBytes = 0;
+    b->stat.flushes++;
+    return ret;
+}
+
+int eiodpBatchPoll(eIODP_BATCH* b)
+{
+    if(b == nullptr)return IODP_ERROR_PARAM;
+    if(b->dirtyCnt == 0 && b->readCnt == 0)return IODP_OK;
+    if(eiodpNow(b->eiodp_fd) - b->firstTime >= b->window_us)return eiodpBatchFlush(b);
+    return IODP_OK;
+}
+
+//登记一个操作之后检查阈值与窗口
+static int batch_Added(eIODP_BATCH* b, int wasEmpty, uint16 len)
+{
+    if(wasEmpty)b->firstTime = eiodpNow(b->eiodp_fd);
+    b->pendingBytes += len;
+    if(b->pendingBytes >= b->threshold)return eiodpBatchFlush(b);
+    return eiodpBatchPoll(b);
+}
+
+int eiodpBatchWrite(eIODP_BATCH* b,uint16 addr,uint16 len,const unsigned char* data)
+{
+    int i;
+    if(b == nullptr || (len > 0 && data == nullptr))return IODP_ERROR_PARAM;
+    if(len == 0)return IODP_OK;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE){
+        int ret = eiodpBatchFlush(b);
+        eiodpWriteAddr(b->eiodp_fd,addr,len,(unsigned char*)data);
+        return ret;
+    }
+    //与还没发出的读重叠，先发出，保证读看到的是写之前的值
+    int flushRet = IODP_OK;
+    for(i=0;i<b->readCnt;i++){
+        if(b->read[i].addr < addr+len && addr < b->read[i].addr+b->read[i].len){
+            flushRet = eiodpBatchFlush(b);
+            break;
+        }
+    }
+    int wasEmpty = (b->dirtyCnt == 0 && b->readCnt == 0);
+    memcpy(&b->shadow[addr],data,len);
+    for(i=addr;i<addr+len;i++){
+        if(!BATCH_ISDIRTY(b,i)){
+            b->dirty[i>>3] |= 1<<(i&7);
+            b->dirtyCnt++;
+        }
+    }
+    b->stat.writes++;
+    b->stat.writeBytes += len;
+    int ret = batch_Added(b,wasEmpty,len);
+    return flushRet < 0 ? flushRet : ret;
+}
+
+int eiodpBatchRead(eIODP_BATCH* b,uint16 addr,uint16 len,unsigned char* buf,int* status)
+{
+    if(b == nullptr || buf == nullptr || len == 0 || len > IODP_BATCH_MAXSPAN)return IODP_ERROR_PARAM;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE){
+        //不参与合并，免得越界错误影响同一组的其他读
+        int ret = eiodpBatchFlush(b);
+        int r = eiodpReadAddr(b->eiodp_fd,addr,len,buf);
+        if(status)*status = r;
+        return ret;
+    }
+    int flushRet = IODP_OK;
+    if(b->readCnt == IODP_BATCH_MAXREAD)flushRet = eiodpBatchFlush(b);
+    int wasEmpty = (b->dirtyCnt == 0 && b->readCnt == 0);
+    eIODP_BATCH_READ* rd = &b->read[b->readCnt++];
+    rd->addr = addr;
+    rd->len = len;
+    rd->buf = buf;
+    rd->status = status;
+    if(status)*status = IODP_BATCH_PENDING;
+    b->stat.reads++;
+    int ret = batch_Added(b,wasEmpty,len);
+    return flushRet < 0 ? flushRet : ret;
+}
+
+void eiodpBatchGetStat(eIODP_BATCH* b,eIODP_BATCH_STAT* out)
+{
+    if(b == nullptr || out == nullptr)return;
+    *out = b->stat;
+}
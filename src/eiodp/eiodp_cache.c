@@ -0,0 +1,160 @@
+/*
+    文件名：eiodp_cache.c
+
+    说明：
+        eiodp客户端镜像缓存，接口说明见eiodp_cache.h。
+        mirror为对方配置空间的本地镜像，valid/fillTime按块记录有效性与填充时间。
+*/
+
+#include "eiodp.h"
+#include "eiodp_cache.h"
+
+#include <string.h>
+
+eIODP_CACHE* eiodpCacheCreate(eIODP_TYPE* eiodp_fd,uint32 maxAge_us,uint16 prefetch)
+{
+    if(eiodp_fd == nullptr)return nullptr;
+    eIODP_CACHE* c = MOONOS_MALLOC(sizeof(eIODP_CACHE));
+    if(c == nullptr)return nullptr;
+    memset(c,0,sizeof(eIODP_CACHE));
+    c->eiodp_fd = eiodp_fd;
+    c->maxAge_us = maxAge_us;
+    c->prefetch = prefetch;
+    c->lastEnd = 0xffffffff;
+    return c;
+}
+
+void eiodpCacheDestroy(eIODP_CACHE* c)
+{
+    if(c == nullptr)return;
+    MOONOS_FREE(c);
+}
+
+//块是否可以直接使用
+static int cache_Fresh(eIODP_CACHE* c, unsigned int b, unsigned long long now)
+{
+    if(!c->valid[b])return 0;
+    return c->maxAge_us == 0 || now - c->fillTime[b] < c->maxAge_us;
+}
+
+//读回[b0,b1]块，每次最多IODP_CACHE_MAXFETCH字节
+static int cache_Fetch(eIODP_CACHE* c, unsigned int b0, unsigned int b1)
+{
+    unsigned int lo = b0*IODP_CFG_BLOCK;
+    unsigned int hi = (b1+1)*IODP_CFG_BLOCK;
+    if(hi > IODP_CONFIGMEM_SIZE)hi = IODP_CONFIGMEM_SIZE;
+    while(lo < hi){
+        unsigned int n = hi-lo;
+        if(n > IODP_CACHE_MAXFETCH)n = IODP_CACHE_MAXFETCH;
+        int ret = eiodpReadAddr(c->eiodp_fd,lo,n,&c->mirror[lo]);
+        c->stat.wireReads++;
+        if(ret < 0)return ret;
+        //对方配置空间比本地小时只返回一部分，没有读全的块保持无效
+        if(ret < (int)n)n = ret;
+        if(n == 0)break;
+        c->stat.wireBytes += n;
+        unsigned long long now = eiodpNow(c->eiodp_fd);
+        unsigned int b;
+        for(b=lo/IODP_CFG_BLOCK;b*IODP_CFG_BLOCK<lo+n;b++){
+            unsigned int bend = (b+1)*IODP_CFG_BLOCK;
+            if(bend > IODP_CONFIGMEM_SIZE)bend = IODP_CONFIGMEM_SIZE;
+            if(bend > lo+n)break;
+            c->valid[b] = 1;
+            c->fillTime[b] = now;
+        }
+        lo += n;
+    }
+    return IODP_OK;
+}
+
+int eiodpCacheRead(eIODP_CACHE* c,uint16 addr,uint16 len,unsigned char* buf)
+{
+    if(c == nullptr || buf == nullptr || len == 0)return IODP_ERROR_PARAM;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE)return eiodpReadAddr(c->eiodp_fd,addr,len,buf);
+    c->stat.reads++;
+    unsigned long long now = eiodpNow(c->eiodp_fd);
+    unsigned int b, b0 = addr/IODP_CFG_BLOCK, b1 = (addr+len-1)/IODP_CFG_BLOCK;
+    unsigned int s0 = IODP_CFG_NBLOCK, s1 = 0;
+    for(b=b0;b<=b1;b++){
+        if(cache_Fresh(c,b,now))continue;
+        if(s0 == IODP_CFG_NBLOCK)s0 = b;
+        s1 = b;
+    }
+    if(s0 == IODP_CFG_NBLOCK){
+        c->stat.hits++;
+    }
+    else{
+        //顺序读，后面的块很快也会被读到，一起读回
+        if(addr == c->lastEnd && c->prefetch > 0){
+            unsigned int p = 0;
+            while(p < c->prefetch && s1+1 < IODP_CFG_NBLOCK && !cache_Fresh(c,s1+1,now)){
+                s1++;
+                p++;
+            }
+            c->stat.prefetchBlocks += p;
+        }
+        int ret = cache_Fetch(c,s0,s1);
+        if(ret < 0)return ret;
+        for(b=b0;b<=b1;b++){
+            if(!c->valid[b])return IODP_ERROR_RECVLEN;
+        }
+    }
+    memcpy(buf,&c->mirror[addr],len);
+    c->lastEnd = (unsigned int)addr+len;
+    return len;
+}
+
+int eiodpCacheWrite(eIODP_CACHE* c,uint16 addr,uint16 len,const unsigned char* data)
+{
+    if(c == nullptr || data == nullptr || len == 0)return IODP_ERROR_PARAM;
+    eiodpWriteAddr(c->eiodp_fd,addr,len,(unsigned char*)data);
+    c->stat.writes++;
+    if(addr >= IODP_CONFIGMEM_SIZE)return IODP_OK;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE)len = IODP_CONFIGMEM_SIZE-addr;
+    unsigned long long now = eiodpNow(c->eiodp_fd);
+    unsigned int b, b0 = addr/IODP_CFG_BLOCK, b1 = (addr+len-1)/IODP_CFG_BLOCK;
+    memcpy(&c->mirror[addr],data,len);
+    for(b=b0;b<=b1;b++){
+        unsigned int lo = b*IODP_CFG_BLOCK, hi = lo+IODP_CFG_BLOCK;
+        if(hi > IODP_CONFIGMEM_SIZE)hi = IODP_CONFIGMEM_SIZE;
+        //整块都是刚写的值，重新计时；部分覆盖的块保持原来的有效性与时间
+        if(addr <= lo && (unsigned int)addr+len >= hi){
+            c->valid[b] = 1;
+            c->fillTime[b] = now;
+        }
+    }
+    return IODP_OK;
+}
+
+void eiodpCacheInvalidate(eIODP_CACHE* c,uint16 addr,uint16 len)
+{
+    if(c == nullptr)return;
+    if(len == 0){
+        memset(c->valid,0,sizeof(c->valid));
+        return;
+    }
+    if(addr >= IODP_CONFIGMEM_SIZE)return;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE)len = IODP_CONFIGMEM_SIZE-addr;
+    unsigned int b;
+    for(b=addr/IODP_CFG_BLOCK;b<=(unsigned int)(addr+len-1)/IODP_CFG_BLOCK;b++)c->valid[b] = 0;
+}
+
+int eiodpCacheRefresh(eIODP_CACHE* c,uint16 addr,uint16 len,unsigned char* buf)
+{
+    if(c == nullptr || len == 0)return IODP_ERROR_PARAM;
+    if((unsigned int)addr+len > IODP_CONFIGMEM_SIZE){
+        if(buf == nullptr)return IODP_ERROR_PARAM;
+        return eiodpReadAddr(c->eiodp_fd,addr,len,buf);
+    }
+    eiodpCacheInvalidate(c,addr,len);
+    int ret = cache_Fetch(c,addr/IODP_CFG_BLOCK,(addr+len-1)/IODP_CFG_BLOCK);
+    if(ret < 0)return ret;
+    if(buf)memcpy(buf,&c->mirror[addr],len);
+    return len;
+}
+
+void eiodpCacheGetStat(eIODP_CACHE* c,eIODP_CACHE_STAT* out)
+{
+    if(c == nullptr || out == nullptr)return;
+    *out = c->stat;
+}
@@ -0,0 +1,366 @@
+/*
+    文件名：eiodp_log.c
+
+    说明：
+        eiodp日志，接口说明见eiodp_log.h。
+        linux下：
+            每个线程第一次写日志时从池中取一个环形缓存，线程退出后缓存回到池中，剩余记录照常输出。
+            生产者只写head，消费者只写tail，用acquire/release保证记录内容先于下标可见。
+            后台线程每1ms把所有缓存格式化输出一次，eiodp_logFlush在调用线程里做同样的事情，
+            两者用同一把锁互斥（锁只在消费端，生产端没有锁）。
+        其他平台：
+            提交时直接格式化输出。
+*/
+
+#include "eiodp.h"
+#include "eiodp_log.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if (IODP_OS==IODP_OS_LINUX)
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+static void (*log_sink)(int level,const char* line) = nullptr;
+static uint32 (*log_clock)(void) = nullptr;
+
+static const char log_lvchar[] = {'-','E','W','I','D'};
+
+#if (IODP_OS==IODP_OS_LINUX)
+#define LOG_FETCH_ADD(p,v) __atomic_fetch_add((p),(v),__ATOMIC_RELAXED)
+#define LOG_EXCHANGE(p,v) __atomic_exchange_n((p),(v),__ATOMIC_RELAXED)
+#else
+static uint32 log_FetchAdd(uint32* p,uint32 v){uint32 o=*p;*p=o+v;return o;}
+static uint32 log_Exchange(uint32* p,uint32 v){uint32 o=*p;*p=v;return o;}
+#define LOG_FETCH_ADD(p,v) log_FetchAdd((p),(v))
+#define LOG_EXCHANGE(p,v) log_Exchange((p),(v))
+#endif
+
+//一条二进制日志记录
+typedef struct
+{
+    eIODP_LOGSITE* site;
+    uint32 ts;          //时间戳ms
+    uint32 suppressed;  //在此之前被抑制的条数
+    int nargs;
+    long arg[IODP_LOG_MAXARGS];
+}eIODP_LOGREC;
+
+static uint32 log_nowms(void)
+{
+    if(log_clock)return log_clock();
+#if (IODP_OS==IODP_OS_LINUX)
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC,&tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+#else
+    return 0;
+#endif
+}
+
+static void log_Output(int level,const char* line)
+{
+    if(log_sink)log_sink(level,line);
+    else fputs(line,stdout);
+}
+
+/************************************************************
+    @brief:
+        按格式串格式化一条记录。参数都是long，所以每个整数转换都改写成带l的形式
+    @return:
+        写入的字符数
+*************************************************************/
+static int log_Format(char* out,int cap,const char* fmt,int nargs,const long* args)
+{
+    int n=0, ai=0;
+    const char* p=fmt;
+    char spec[16];
+    while(*p && n<cap-1)
+    {
+        if(*p!='%'){out[n++]=*p++;continue;}
+        if(p[1]=='%'){out[n++]='%';p+=2;continue;}
+        //复制标志、宽度、精度，丢掉原有的长度修饰
+        int sl=0;
+        spec[sl++]=*p++;
+        while(*p && strchr("-+ #0123456789.",*p) && sl<(int)sizeof(spec)-3)spec[sl++]=*p++;
+        while(*p && strchr("hlLqjzt",*p))p++;
+        char c=*p;
+        if(c==0)break;
+        p++;
+        long a = ai<nargs ? args[ai] : 0;
+        ai++;
+        int w;
+        if(strchr("diuxXoc",c)){
+            if(c!='c')spec[sl++]='l';
+            spec[sl++]=c;
+            spec[sl]=0;
+            if(c=='c')w=snprintf(&out[n],cap-n,spec,(int)a);
+            else w=snprintf(&out[n],cap-n,spec,a);
+        }
+        else if(c=='s'){
+            spec[sl++]='s';spec[sl]=0;
+            w=snprintf(&out[n],cap-n,spec,a?(const char*)a:"(null)");
+        }
+        else if(c=='p'){
+            spec[sl++]='p';spec[sl]=0;
+            w=snprintf(&out[n],cap-n,spec,(void*)a);
+        }
+        else{
+            //浮点等不支持的转换
+            w=snprintf(&out[n],cap-n,"?");
+        }
+        if(w<0)break;
+        n += w;
+        if(n>cap-1)n=cap-1;
+    }
+    out[n]=0;
+    return n;
+}
+
+static void log_Emit(eIODP_LOGREC* rec)
+{
+    char line[IODP_LOG_LINE_LEN];
+    int level = rec->site->level;
+    int n;
+    if(rec->suppressed){
+        snprintf(line,sizeof(line),"[%c %u.%03u] last message suppressed %u times: %s",
+                log_lvchar[level],rec->ts/1000,rec->ts%1000,rec->suppressed,rec->site->fmt);
+        n=strlen(line);
+        if(n==0 || line[n-1]!='\n'){
+            if(n>=(int)sizeof(line)-1)n=sizeof(line)-2;
+            line[n]='\n';line[n+1]=0;
+        }
+        log_Output(level,line);
+    }
+    n=snprintf(line,sizeof(line),"[%c %u.%03u] ",log_lvchar[level],rec->ts/1000,rec->ts%1000);
+    log_Format(&line[n],sizeof(line)-n,rec->site->fmt,rec->nargs,rec->arg);
+    log_Output(level,line);
+}
+
+/************************************************************
+    @brief:
+        调用点限速
+    @return:
+        0 - 丢弃
+        1 - 输出，*supp返回之前被抑制的条数
+*************************************************************/
+static int log_RateCheck(eIODP_LOGSITE* site,uint32 now,uint32* supp)
+{
+    *supp=0;
+#if (IODP_OS!=IODP_OS_LINUX)
+    if(log_clock==nullptr)return 1;
+#endif
+    //多线程下窗口切换存在竞争，最多多放过几条，不影响正确性
+    if(now - site->winStart >= IODP_LOG_RATE_MS){
+        site->winStart = now;
+        LOG_EXCHANGE(&site->winCount,0);
+    }
+    if(LOG_FETCH_ADD(&site->winCount,1) >= IODP_LOG_RATE){
+        LOG_FETCH_ADD(&site->suppressed,1);
+        return 0;
+    }
+    if(site->suppressed)*supp = LOG_EXCHANGE(&site->suppressed,0);
+    return 1;
+}
+
+void eiodp_logSetSink(void (*sink)(int level,const char* line))
+{
+    log_sink = sink;
+}
+
+void eiodp_logSetClock(uint32 (*msfunc)(void))
+{
+    log_clock = msfunc;
+}
+
+#if (IODP_OS==IODP_OS_LINUX)
+
+//单生产者单消费者环形缓存
+typedef struct
+{
+    uint32 head;        //生产者写
+    uint32 tail;        //消费者写
+    uint32 dropped;     //缓存满丢弃的条数
+    uint32 reported;    //已经报告过的丢弃条数
+    int owner;          //1 有线程在使用
+    eIODP_LOGREC rec[IODP_LOG_RINGSIZE];
+}eIODP_LOGRING;
+
+static eIODP_LOGRING* log_rings[IODP_LOG_MAXTHREAD];
+static int log_ringnum = 0;
+static __thread eIODP_LOGRING* log_myring = nullptr;
+static __thread int log_noring = 0;
+static pthread_mutex_t log_poolmutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_consmutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_key;
+
+//格式化一个缓存中的全部记录（调用时持有log_consmutex）
+static int log_DrainRing(eIODP_LOGRING* r)
+{
+    int n=0;
+    uint32 tail = r->tail;
+    uint32 head = __atomic_load_n(&r->head,__ATOMIC_ACQUIRE);
+    while(tail != head){
+        log_Emit(&r->rec[tail & (IODP_LOG_RINGSIZE-1)]);
+        tail++;
+        n++;
+    }
+    __atomic_store_n(&r->tail,tail,__ATOMIC_RELEASE);
+
+    uint32 dropped = __atomic_load_n(&r->dropped,__ATOMIC_RELAXED);
+    if(dropped != r->reported){
+        char line[64];
+        snprintf(line,sizeof(line),"[W] log ring full, %u records dropped\n",dropped - r->reported);
+        r->reported = dropped;
+        log_Output(IODP_LOGLV_WARN,line);
+    }
+    return n;
+}
+
+static int log_DrainAll(void)
+{
+    int i, n=0, num;
+    pthread_mutex_lock(&log_consmutex);
+    num = __atomic_load_n(&log_ringnum,__ATOMIC_ACQUIRE);
+    for(i=0;i<num;i++)n += log_DrainRing(log_rings[i]);
+    pthread_mutex_unlock(&log_consmutex);
+    if(n)fflush(stdout);
+    return n;
+}
+
+static void* log_Task(void* arg)
+{
+    (void)arg;
+    while(1){
+        if(log_DrainAll()==0)usleep(1000);
+    }
+    return nullptr;
+}
+
+//线程退出，缓存交还给池，剩下的记录由后台线程继续输出
+static void log_ThreadExit(void* p)
+{
+    __atomic_store_n(&((eIODP_LOGRING*)p)->owner,0,__ATOMIC_RELEASE);
+}
+
+static void log_Init(void)
+{
+    pthread_t t;
+    pthread_key_create(&log_key,log_ThreadExit);
+    pthread_create(&t,nullptr,log_Task,nullptr);
+    pthread_detach(t);
+    atexit(eiodp_logFlush);
+}
+
+//为当前线程取一个缓存，池用尽返回NULL
+static eIODP_LOGRING* log_GetRing(void)
+{
+    int i;
+    eIODP_LOGRING* r = nullptr;
+    pthread_once(&log_once,log_Init);
+    pthread_mutex_lock(&log_poolmutex);
+    for(i=0;i<log_ringnum;i++){
+        eIODP_LOGRING* p = log_rings[i];
+        if(__atomic_load_n(&p->owner,__ATOMIC_ACQUIRE)==0){
+            r = p;
+            break;
+        }
+    }
+    if(r == nullptr && log_ringnum < IODP_LOG_MAXTHREAD){
+        r = MOONOS_MALLOC(sizeof(eIODP_LOGRING));
+        if(r){
+            memset(r,0,sizeof(eIODP_LOGRING));
+            log_rings[log_ringnum] = r;
+            __atomic_store_n(&log_ringnum,log_ringnum+1,__ATOMIC_RELEASE);
+        }
+    }
+    if(r){
+        //旧主人留下的记录属于同一个生产者序列，head/tail不需要复位
+        r->owner = 1;
+        pthread_setspecific(log_key,r);
+    }
+    pthread_mutex_unlock(&log_poolmutex);
+    return r;
+}
+
+void eiodp_logPost(eIODP_LOGSITE* site,int nargs,const long* args)
+{
+    uint32 now = log_nowms();
+    uint32 supp;
+    int i;
+    if(!log_RateCheck(site,now,&supp))return;
+    if(nargs>IODP_LOG_MAXARGS)nargs=IODP_LOG_MAXARGS;
+
+    eIODP_LOGRING* r = log_myring;
+    if(r == nullptr && !log_noring){
+        r = log_myring = log_GetRing();
+        if(r == nullptr)log_noring = 1;
+    }
+    if(r == nullptr){
+        //线程太多，退化为同步输出
+        eIODP_LOGREC rec;
+        rec.site=site;rec.ts=now;rec.suppressed=supp;rec.nargs=nargs;
+        for(i=0;i<nargs;i++)rec.arg[i]=args[i];
+        pthread_mutex_lock(&log_consmutex);
+        log_Emit(&rec);
+        pthread_mutex_unlock(&log_consmutex);
+        return;
+    }
+
+    uint32 head = r->head;
+    if(head - __atomic_load_n(&r->tail,__ATOMIC_ACQUIRE) >= IODP_LOG_RINGSIZE){
+        __atomic_fetch_add(&r->dropped,1,__ATOMIC_RELAXED);
+        return;
+    }
+    eIODP_LOGREC* rec = &r->rec[head & (IODP_LOG_RINGSIZE-1)];
+    rec->site=site;
+    rec->ts=now;
+    rec->suppressed=supp;
+    rec->nargs=nargs;
+    for(i=0;i<nargs;i++)rec->arg[i]=args[i];
+    __atomic_store_n(&r->head,head+1,__ATOMIC_RELEASE);
+}
+
+void eiodp_logFlush(void)
+{
+    log_DrainAll();
+}
+
+uint32 eiodp_logDropped(void)
+{
+    uint32 sum=0;
+    int i, num = __atomic_load_n(&log_ringnum,__ATOMIC_ACQUIRE);
+    for(i=0;i<num;i++)sum += __atomic_load_n(&log_rings[i]->dropped,__ATOMIC_RELAXED);
+    return sum;
+}
+
+#else
+
+void eiodp_logPost(eIODP_LOGSITE* site,int nargs,const long* args)
+{
+    eIODP_LOGREC rec;
+    int i;
+    rec.ts = log_nowms();
+    if(!log_RateCheck(site,rec.ts,&rec.suppressed))return;
+    if(nargs>IODP_LOG_MAXARGS)nargs=IODP_LOG_MAXARGS;
+    rec.site=site;
+    rec.nargs=nargs;
+    for(i=0;i<nargs;i++)rec.arg[i]=args[i];
+    log_Emit(&rec);
+}
+
+void eiodp_logFlush(void)
+{
+    fflush(stdout);
+}
+
+uint32 eiodp_logDropped(void)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+    文件名：eiodp_schema.c
+
+    说明：
+        eiodp寄存器表的读计划与写回，接口说明见eiodp_schema.h。
+        字段表按偏移排列，生成计划时不需要排序。
+*/
+
+#include "eiodp.h"
+#include "eiodp_schema.h"
+
+#include <string.h>
+
+//把字段集合合并成地址段，间隔不超过gap的字段合并，返回段数
+static int schema_Ranges(const eIODP_SCHEMA* s, unsigned long long mask, unsigned int gap,
+                         uint16* off, uint16* len)
+{
+    int i, n = 0;
+    for(i=0;i<s->nfield;i++){
+        const eIODP_FIELD* f = &s->field[i];
+        if(!(mask & (1ULL<<i)) || f->size == 0)continue;
+        if(n > 0 && (unsigned int)f->off <= (unsigned int)off[n-1]+len[n-1]+gap){
+            len[n-1] = f->off+f->size-off[n-1];
+            continue;
+        }
+        off[n] = f->off;
+        len[n] = f->size;
+        n++;
+    }
+    return n;
+}
+
+//把地址段装进请求，每个请求不超过多段读的段数与返回缓存，装不下的段拆开
+static int schema_Group(eIODP_SCHEMA_PLAN* p, const uint16* off, const uint16* len, int n)
+{
+    unsigned int used = 0;
+    int cnt = 0, i;
+    p->nrange = 0;
+    p->ngroup = 0;
+    p->wireBytes = 0;
+    for(i=0;i<n;i++){
+        unsigned int o = off[i], l = len[i];
+        while(l > 0){
+            if(cnt == IODP_MRANGE_MAX || used == IODP_SCHEMA_MAXFETCH){
+                p->groupEnd[p->ngroup++] = p->nrange;
+                used = 0;
+                cnt = 0;
+            }
+            if(p->nrange == IODP_SCHEMA_MAXRANGE)return IODP_ERROR_PARAM;
+            unsigned int take = IODP_SCHEMA_MAXFETCH-used;
+            if(take > l)take = l;
+            p->addr[p->nrange] = p->schema->base+o;
+            p->len[p->nrange] = take;
+            p->nrange++;
+            cnt++;
+            used += take;
+            p->wireBytes += take;
+            o += take;
+            l -= take;
+        }
+    }
+    if(cnt > 0)p->groupEnd[p->ngroup++] = p->nrange;
+    return p->ngroup;
+}
+
+int eiodpSchemaPlan(eIODP_SCHEMA_PLAN* plan,const eIODP_SCHEMA* schema,unsigned long long mask)
+{
+    uint16 off[IODP_SCHEMA_MAXFIELD], len[IODP_SCHEMA_MAXFIELD];
+    eIODP_SCHEMA_PLAN tmp;
+    if(plan == nullptr || schema == nullptr || schema->nfield > IODP_SCHEMA_MAXFIELD)return IODP_ERROR_PARAM;
+    if(schema->nfield < IODP_SCHEMA_MAXFIELD)mask &= (1ULL<<schema->nfield)-1;
+    if(mask == 0)return IODP_ERROR_PARAM;
+
+    //只合并相邻的字段
+    tmp.schema = schema;
+    tmp.mask = mask;
+    int n = schema_Ranges(schema,mask,0,off,len);
+    int r0 = schema_Group(&tmp,off,len,n);
+
+    //合并小空隙：段少、请求包短，但是多读空隙，可能多出一个请求
+    plan->schema = schema;
+    plan->mask = mask;
+    n = schema_Ranges(schema,mask,IODP_SCHEMA_GAP,off,len);
+    int r1 = schema_Group(plan,off,len,n);
+
+    if(r1 < 0 || (r0 > 0 && r0 < r1)){
+        if(r0 < 0)return r0;
+        memcpy(plan,&tmp,sizeof(tmp));
+        return r0;
+    }
+    return r1;
+}
+
+int eiodpSchemaFetch(eIODP_TYPE* eiodp_fd,const eIODP_SCHEMA_PLAN* plan,uint8* img)
+{
+    eIODP_RANGE ranges[IODP_MRANGE_MAX];
+    int g, i, first = 0, total = 0;
+    if(eiodp_fd == nullptr || plan == nullptr || plan->schema == nullptr || img == nullptr)return IODP_ERROR_PARAM;
+    uint16 base = plan->schema->base;
+    for(g=0;g<plan->ngroup;g++){
+        int count = plan->groupEnd[g]-first;
+        int ret;
+        if(count == 1){
+            //只有一段时用普通读，请求包更短
+            ret = eiodpReadAddr(eiodp_fd,plan->addr[first],plan->len[first],&img[plan->addr[first]-base]);
+        }
+        else{
+            for(i=0;i<count;i++){
+                ranges[i].addr = plan->addr[first+i];
+                ranges[i].len = plan->len[first+i];
+                ranges[i].buf = &img[plan->addr[first+i]-base];
+            }
+            ret = eiodpReadMulti(eiodp_fd,ranges,count);
+        }
+        if(ret < 0)return ret;
+        total += ret;
+        first = plan->groupEnd[g];
+    }
+    return total;
+}
+
+int eiodpSchemaStore(eIODP_TYPE* eiodp_fd,const eIODP_SCHEMA* schema,unsigned long long mask,const uint8* img)
+{
+    uint16 off[IODP_SCHEMA_MAXFIELD], len[IODP_SCHEMA_MAXFIELD];
+    eIODP_RANGE ranges[IODP_MRANGE_MAX];
+    int count = 0, i;
+    unsigned int pktlen = 8;
+    if(eiodp_fd == nullptr || schema == nullptr || img == nullptr || schema->nfield > IODP_SCHEMA_MAXFIELD)
+        return IODP_ERROR_PARAM;
+    if(schema->nfield < IODP_SCHEMA_MAXFIELD)mask &= (1ULL<<schema->nfield)-1;
+    if(mask == 0)return IODP_ERROR_PARAM;
+
+    //不跨过空隙，空隙里是本地映像的旧值，不能写到对方
+    int n = schema_Ranges(schema,mask,0,off,len);
+    for(i=0;i<n;i++){
+        unsigned int o = off[i], l = len[i];
+        while(l > 0){
+            //多段写整包不能超过对方的接收长度
+            if(count == IODP_MRANGE_MAX || pktlen+4+4 >= IODP_RECV_MAX_LEN-4){
+                int r = eiodpWriteMulti(eiodp_fd,ranges,count);
+                if(r < 0)return r;
+                count = 0;
+                pktlen = 8;
+            }
+            unsigned int take = IODP_RECV_MAX_LEN-4-1-pktlen-4;
+            if(take > l)take = l;
+            ranges[count].addr = schema->base+o;
+            ranges[count].len = take;
+            ranges[count].buf = (unsigned char*)&img[o];
+            count++;
+            pktlen += 4+take;
+            o += take;
+            l -= take;
+        }
+    }
+    if(count > 0){
+        int r = eiodpWriteMulti(eiodp_fd,ranges,count);
+        if(r < 0)return r;
+    }
+    return IODP_OK;
+}
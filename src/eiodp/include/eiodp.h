@@ -1,217 +1,1610 @@
-#ifndef _EIODP_H_
-#define _EIODP_H_
-
-#include "type.h"
-#include "eiodp_config.h"
-#include "stdlib.h"
-
-//操作系统
-#define IODP_OS_NULL 0
-#define IODP_OS_LINUX 1
-#define IODP_OS_FREERTOS 2
-
-//定义接受包缓存大小
-#define IODP_RECV_MAX_LEN 1024
-//定义返回接受包缓存大小
-#define IODP_RETURN_BUFFER 512
-//定义iodp配置空间大小
-#define IODP_CONFIGMEM_SIZE 512
-//function数据包 最大返回参数数据
-#define IODP_FUNCPKT_RET_LEN 256
-
-#define IODP_LOG(str,a,b,c,d,e) printf(str,a,b,c,d,e)
-#define IODP_LOGMSG(str) printf(str)
-
-//type mask
-#define IODP_TYPEBIT_SR_MASK 0x80  //判断包为发送还是返回 typebit&IODP_TYPEBIT_SR_MASK==0 为返回包
-
-//malloc
-#define MOONOS_MALLOC(size) malloc(size)
-#define MOONOS_FREE(P) free(P)
-
-
-
-//--------------error code 
-#define IODP_OK 0
-#define IODP_ERROR_PARAM -10
-#define IODP_ERROR_HEAPOVER -11
-#define IODP_ERROR_REPEATCODE -12 
-#define IODP_ERROR_TIMEOUT -13
-#define IODP_ERROR_SMOLL_RECVLEN -14
-#define IODP_ERROR_RECVLEN -15
-#define IODP_ERROR_RETCODE -16
-#define IODP_ERROR_PKT -17      //返回了一个error数据包
-#define IODP_ERROR_NORET -18
-#define IODP_ERROR_API_HEAD -19 
-#define IODP_ERROR_RADDR_HEAD -20 
-#define IODP_ERROR_WADDR_HEAD -21
-
-#define IODP_ERROR_APINODE_REPEAT -22
-
-
-
-//eiodp服务函数链表结构
-typedef struct
-{
-    uint16 funcode;
-    int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata); 
-    void* pNext;
-}eIODP_FUNC_NODE;
-
-//eiodp循环缓冲buffer
-typedef struct
-{
-    uint32 bufSize;
-
-    uint8 *buf;
-    uint32 pIn; //环形缓冲的头指针
-    uint32 pOut; //环形缓冲的尾指针
-
-}eIODP_RING;
-
-//
-typedef struct
-{
-    unsigned int iodevHandle;   //IO设备的句柄fd
-    eIODP_RING*  recv_ringbuf;
-
-    eIODP_RING*  retbuf_readaddr;     //readaddr 类型包的返回包缓存区
-    eIODP_RING*  retbuf_func;         //function 类型包的返回包缓存区
-
-    unsigned int configmemSize;
-    char configmem[IODP_CONFIGMEM_SIZE];
-
-    //注册的服务函数链表
-    eIODP_FUNC_NODE* pFuncHead;
-
-    //iodevHandle设备的收发函数
-    int (*iodevRead)(int, char*, int);
-    int (*iodevWrite)(int, char*, int);
-
-#if (IODP_OS==IODP_OS_LINUX)
-    sem_t readaddr_retsem;
-    sem_t func_retsem;
-    pthread_t ptRecvPushTask;
-    pthread_t ptRecvProcessTask;
-    pthread_mutex_t mutex_recv;
-    sem_t sem_recvSync;
-#elif (IODP_OS==IODP_OS_FREERTOS)
-#endif
-
-
-}eIODP_TYPE;
-
-/************************************************************
-    @brief:
-        初始化框架，准备缓存取、信号量、创建接受服务线程
-    @param:
-        fd：依赖的io设备句柄，eiodp协议需要作用于标准io设备。
-        readfunc：fd设备读数据函数
-        writefunc：fd设备写数据函数
-    @return:
-        创建的eIODP_TYPE指针，可以通过这个指针来操作iodp
-*************************************************************/
-eIODP_TYPE* eiodp_init(unsigned int fd, int (*readfunc)(int, char*, int),
-                int (*writefunc)(int, char*, int));
-
-/************************************************************
-    @brief:
-        写地址操作，将数据写到对方的配置空间上
-        此操作主要是在对方的iodp配置空间的addr偏移地址上写指定长度的数据。
-    @param:
-        eiodp_fd:eiodp句柄
-        addr：在对方的配置空间addr地址往后写数据
-        len：数据长度，在[addr,addr+len]上覆盖数据
-        sdbuf：数据头指针
-*************************************************************/
-void eiodpWriteAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf);
-/************************************************************
-    @brief:
-        读地址操作，读取对方的配置空间数据
-        此操作主要是将对方的addr地址往后len个数据都读取出来
-    @param:
-        eiodp_fd:eiodp句柄
-        addr：读取地址
-        len：数据长度
-        recvbuf：将数据存入该数组
-    @return:
-        -6 - time out
-        -1 - recvlen长度不对
-        -4 - 返回包中地址对不上
-        -5 - 返回包包长度与实际不符
-        -3 - 有返回包，但是返回了错误代码
-        -2 - 返回type不对
-         0 - 成功
-*************************************************************/
-int eiodpReadAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* recvbuf);
-
-/************************************************************
-    @brief:
-        注册服务函数
-    @param:
-        eiodp_fd:eiodp句柄
-        funcode：服务函数代码
-        callbackFunc:服务函数
-    @return:
-        <0 - 失败（error code）
-         0 - 成功
-*************************************************************/
-int eiodpRegister(eIODP_TYPE* eiodp_fd,uint16 funcode,
-                int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata));
-
-/************************************************************
-    @brief:
-        打印已经注册的服务函数
-    @param:
-        eiodp_fd:eiodp句柄
-    @return:
-        <0 - 失败（error code）
-         0 - 成功
-*************************************************************/
-int eiodpShowRegFunc(eIODP_TYPE* eiodp_fd);
-/************************************************************
-    @brief:
-        调用服务端的API接口，该接口由服务端的eiodpRegister注册的callbackFunc函数来提供
-    @param:
-        eiodp_fd:eiodp句柄
-        code：API代码
-        argsize：入参arg的长度
-        arg：API入参
-        retarg：用户需要提供返回参数的容器
-    @return:
-        <0 - 失败（error code）
-        >0 - 成功 返回参数长度
-*************************************************************/
-int eiodpFunction(eIODP_TYPE* eiodp_fd, uint16 code, 
-        uint16 argsize,void* arg, void* retarg);
-
-
-/************************************************************
-    @brief:
-        接收服务函数-任务(无操作系统，连续字符read) 在无操作系统的程序里 需要连续调用
-    @param:
-        eiodp_fd:eiodp句柄
-*************************************************************/
-int eiodp_recvProcessTask_nos(eIODP_TYPE* eiodp_fd);
-
-
-int checkpktcrc(unsigned char* data,unsigned int size);
-int updatepktcrc(unsigned char* data,unsigned int size);
-
-void crc32_init();
-
-
-
-//-----------------------------------------------------------------------------------
-//                               eiodp ring buffer
-//
-
-eIODP_RING* creat_ring(uint32 size);
-
-void delate_ring(eIODP_RING* p);
-
-int put_ring(eIODP_RING* p,uint8* buf,uint32 size);
-int get_ring(eIODP_RING* p,uint8* buf,uint32 size);
-uint16 size_ring(eIODP_RING* p);
-
-#endif
+#ifndef _EIODP_H_
+#define _EIODP_H_
+
+#include "type.h"
+#include "eiodp_config.h"
+#include "stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//操作系统
+#define IODP_OS_NULL 0
+#define IODP_OS_LINUX 1
+#define IODP_OS_FREERTOS 2
+
+//定义接受包缓存大小
+#define IODP_RECV_MAX_LEN 1024
+//定义返回接受包缓存大小
+#define IODP_RETURN_BUFFER 512
+//定义iodp配置空间大小
+#define IODP_CONFIGMEM_SIZE 512
+//无操作系统且没有设置时钟源(eiodpSetTickSource)时，按轮询次数估算时间：每ms的eiodp_recvProcessTask_nos调用次数
+#define IODP_NOS_LOOPS_PER_MS 3333
+//无操作系统下eiodp_recvProcessTask_nos每次最多读取的字节数
+#define IODP_NOS_READ_CHUNK 64
+//无操作系统下异步请求最多同时在途的个数
+#define IODP_PENDING_MAX 8
+//延迟返回的服务函数最多同时未完成的请求数，表满时对方收到错误包（IODP_FERR_BUSY）
+#define IODP_DEFER_MAX 16
+//流量控制：无操作系统的从设备对外声明的接收窗口（字节），按串口接收FIFO/DMA缓存大小设置
+#define IODP_NOS_RXWINDOW 256
+//流量控制：额度探测连续多少次没有回应后放弃等待
+#define IODP_FLOW_PROBE_MAX 3
+//多段读写（EC06/EC07）单次最多的地址段数
+#define IODP_MRANGE_MAX 64
+//配置空间版本号的块大小（字节），每块记录最后一次被写入时的版本
+#define IODP_CFG_BLOCK 32
+#define IODP_CFG_NBLOCK ((IODP_CONFIGMEM_SIZE+IODP_CFG_BLOCK-1)/IODP_CFG_BLOCK)
+//配置空间写入监视最多个数，按块建立位图索引，不能超过32
+#define IODP_WATCH_MAX 32
+//虚拟读范围最多个数，索引方式同监视，不能超过32
+#define IODP_VREG_MAX 16
+//订阅（EC08）：每个句柄最多的订阅个数（主、从各自一张表），订阅或重新同步没有回应时的重发间隔(us)
+#define IODP_SUB_MAX 8
+#define IODP_SUB_RETRY 300000
+//扩展地址空间（EC0D/EC0E，32位地址）：[0,configmemSize)就是配置空间，其余按页稀疏存放，
+//页在第一次写入时分配，没有写过的页读出为0。两级页表，每IODP_XMEM_L2页一张二级表
+#define IODP_XMEM_SIZE (16UL<<20)
+#define IODP_XMEM_PAGE 4096
+#define IODP_XMEM_L2 64
+#define IODP_XMEM_L1 ((IODP_XMEM_SIZE/IODP_XMEM_PAGE+IODP_XMEM_L2-1)/IODP_XMEM_L2)
+//扩展地址空间最多分配的页数，达到后再写新的页被丢弃
+#define IODP_XMEM_MAXPAGES 1024
+//配置空间持久化文件：文件头、工作区、检查点槽都按IODP_PERSIST_ALIGN对齐，不能小于页大小
+#define IODP_PERSIST_ALIGN 4096
+#define IODP_PERSIST_MAGIC 0x4549504D
+
+//RTT估计(RFC6298)，单位us：没有样本时的超时、超时下限、超时上限
+#define IODP_RTO_INIT 1000000
+#define IODP_RTO_MIN 20000
+#define IODP_RTO_MAX 3000000
+//读地址超时后自动重发次数（读是幂等操作）
+#define IODP_READ_RETRY 2
+//function超时后自动重发次数，服务函数不一定幂等，默认不重发
+#define IODP_FUNC_RETRY 0
+//function数据包 最大返回参数数据
+#define IODP_FUNCPKT_RET_LEN 256
+//参数为argsize字节的函数调用数据包长度（eiodpFunctionEx的frame）
+#define IODP_FUNC_FRAMELEN(argsize) ((argsize)+14)
+//写入器服务函数最多的返回数据，受对方返回缓存限制：一条记录为2字节长度+6字节头+数据，
+//环形缓存最多存放IODP_RETURN_BUFFER-1字节
+#define IODP_FUNC_RESP_MAX (IODP_RETURN_BUFFER-9)
+//写入器最多的引用段数，超过后的引用按复制写入
+#define IODP_WRITER_MAXREF 8
+//流式函数调用（EC10）：每个句柄最多同时进行的流（主、从各自一张表），不能超过32
+#define IODP_STREAM_MAX 4
+//默认额度：对方最多领先本端已经收到的数据块数
+#define IODP_STREAM_WINDOW 8
+//一个数据块最多的数据，受接收包长限制：帧头13字节+数据，不超过IODP_RECV_MAX_LEN-5
+#define IODP_STREAM_CHUNK (IODP_RECV_MAX_LEN-1-4-13)
+//没有收到数据块时重发打开请求或额度的间隔(us)，连续IODP_STREAM_TRIES次没有回应时流失败
+#define IODP_STREAM_RETRY 300000
+#define IODP_STREAM_TRIES 5
+//从设备：额度用完后超过这个时间(us)没有新的额度时关闭流（对方的取消丢失或者对方重启过）
+#define IODP_STREAM_IDLE 3000000
+
+//统计直方图：HDR风格对数分桶，每个2的幂区间再分成2^IODP_HIST_SUBBITS个子桶，单位us
+#define IODP_HIST_SUBBITS 2
+#define IODP_HIST_SUB (1<<IODP_HIST_SUBBITS)
+#define IODP_HIST_MAG 24
+#define IODP_HIST_BUCKETS (IODP_HIST_MAG*IODP_HIST_SUB)
+//远程获取统计的保留function code，用户不能注册
+#define IODP_FUNCODE_METRICS 0xFFF0
+
+//可靠写（EC04）发送窗口大小，不能超过32
+#define IODP_RWIN_SIZE 8
+//可靠写单包最大数据长度，超出部分拆成多个包
+#define IODP_RWRITE_MAXDATA 256
+//可靠写单包最大重传次数，超过后放弃整个窗口
+#define IODP_RWRITE_MAXRETRY 10
+//收到多少次指示后续包已到达的ack后立即重传空洞处的包
+#define IODP_RWRITE_DUPTHRESH 3
+
+//日志接口见eiodp_log.h（IODP_LOGE/W/I/D），IODP_LOG与IODP_LOGMSG保留兼容
+#include "eiodp_log.h"
+
+//type mask
+#define IODP_TYPEBIT_SR_MASK 0x80  //判断包为发送还是返回 typebit&IODP_TYPEBIT_SR_MASK==0 为返回包
+
+//type code（TYPE的低字节）
+#define IODP_TYPE_WRITEADDR 0x01
+#define IODP_TYPE_READADDR 0x02
+#define IODP_TYPE_FUNCTION 0x03
+#define IODP_TYPE_RWRITE 0x04    //可靠写，返回ack
+#define IODP_TYPE_CREDIT 0x05    //流量控制额度探测
+#define IODP_TYPE_MREAD 0x06     //多段读
+#define IODP_TYPE_MWRITE 0x07    //多段写
+#define IODP_TYPE_SUB 0x08       //订阅
+#define IODP_TYPE_PUSH 0x09      //从设备推送变化（只有返回类型6C09）
+#define IODP_TYPE_RESYNC 0x0A    //请求重新同步整个订阅范围
+#define IODP_TYPE_UNSUB 0x0B     //取消订阅
+#define IODP_TYPE_CREAD 0x0C     //条件读，只返回版本变化的块
+#define IODP_TYPE_WRITE32 0x0D   //32位地址写扩展地址空间
+#define IODP_TYPE_READ32 0x0E    //32位地址读扩展地址空间
+#define IODP_TYPE_STREAM 0x10    //流式函数调用，对方按额度分块返回
+#define IODP_TYPE_SCHUNK 0x11    //流的数据块（只有返回类型6C11）
+#define IODP_TYPE_SCTL 0x12      //流的额度与取消
+
+//function错误包（2C03）的eCODE
+#define IODP_FERR_NOFUNC 0x01   //没有注册这个服务函数
+#define IODP_FERR_BUSY 0x02     //延迟返回的请求表已满，稍后重试
+
+//malloc
+#define MOONOS_MALLOC(size) malloc(size)
+#define MOONOS_FREE(P) free(P)
+
+
+
+//--------------error code 
+#define IODP_OK 0
+#define IODP_ERROR_PARAM -10
+#define IODP_ERROR_HEAPOVER -11
+#define IODP_ERROR_REPEATCODE -12 
+#define IODP_ERROR_TIMEOUT -13
+#define IODP_ERROR_SMOLL_RECVLEN -14
+#define IODP_ERROR_RECVLEN -15
+#define IODP_ERROR_RETCODE -16
+#define IODP_ERROR_PKT -17      //返回了一个error数据包
+#define IODP_ERROR_NORET -18
+#define IODP_ERROR_API_HEAD -19 
+#define IODP_ERROR_RADDR_HEAD -20 
+#define IODP_ERROR_WADDR_HEAD -21
+
+#define IODP_ERROR_APINODE_REPEAT -22
+#define IODP_ERROR_BUSY -23     //异步请求表已满，或者对方接收缓存额度不足
+#define IODP_ERROR_RETSIZE -24  //返回数据超过调用者提供的缓存
+#define IODP_ERROR_CANCELED -25 //请求被取消
+#define IODP_ERROR_LOST -26     //流的数据块丢失
+#define IODP_ERROR_STALE -27    //延迟返回的token已经完成过，或者不是deferFunc收到的
+
+
+
+//统计的操作类型
+#define IODP_OP_READADDR 0
+#define IODP_OP_FUNCTION 1
+#define IODP_OP_RWRITE 2
+#define IODP_OP_NUM 3
+
+//统计计数器，全部为uint32，方便原子操作与序列化
+typedef struct
+{
+    uint32 rxBytes;         //从io读到的字节
+    uint32 rxFrames;        //收到的完整数据包
+    uint32 txBytes;         //写到io的字节
+    uint32 txFrames;        //发出的数据包
+    uint32 crcErrors;       //crc校验失败
+    uint32 resyncs;         //帧头或长度不对，重新找帧头
+    uint32 unknownType;     //type不能识别
+    uint32 recvRingOverflow;//接收缓存区满（接收任务等待）
+    uint32 retRingOverflow; //返回缓存区满丢弃
+    uint32 recvRingHigh;    //接收缓存区最高水位
+    uint32 retRingHigh;     //返回缓存区最高水位
+    uint32 timeouts;        //请求超时
+    uint32 retries;         //请求重发
+    uint32 errorPkts;       //收到错误返回包
+    uint32 rwRetrans;       //可靠写重传
+    uint32 rwDuplicates;    //可靠写收到的重复包
+    uint32 flowStalls;      //发送时额度不足而等待
+    uint32 flowProbes;      //发出的额度探测
+}eIODP_COUNTERS;
+
+//时延直方图
+typedef struct
+{
+    uint32 count[IODP_HIST_BUCKETS];
+    uint32 total;
+    uint32 max;
+}eIODP_HIST;
+
+typedef struct
+{
+    eIODP_COUNTERS cnt;
+    eIODP_HIST lat[IODP_OP_NUM];    //各操作类型的往返时延
+}eIODP_METRICS;
+
+//时延摘要
+typedef struct
+{
+    uint32 count;
+    uint32 p50;
+    uint32 p90;
+    uint32 p99;
+    uint32 max;
+}eIODP_LATSUM;
+
+//统计摘要，远程获取时使用
+typedef struct
+{
+    eIODP_COUNTERS cnt;
+    eIODP_LATSUM lat[IODP_OP_NUM];
+}eIODP_METRICS_SUMMARY;
+
+/************************************************************
+    @brief:
+        配置空间写入监视回调，每个远程写包调用一次
+    @param:
+        ctx：注册时的用户参数
+        addr,len：这个包写入的数据与监视范围重叠的部分（多段写时为覆盖所有重叠部分的最小范围）
+*************************************************************/
+typedef void (*eIODP_WATCH_CB)(void* ctx, unsigned short addr, unsigned short len);
+
+typedef struct
+{
+    uint8 used;
+    uint16 addr;
+    uint16 len;
+    eIODP_WATCH_CB cb;
+    void* ctx;
+}eIODP_WATCH;
+
+/************************************************************
+    @brief:
+        虚拟读范围的填充函数，对方的读请求（EC02/EC06）碰到这个范围并且缓存已经过期时调用
+    @param:
+        ctx：注册时的用户参数
+        addr,len：注册的整个范围
+        buf：填充的数据，len字节
+    @return:
+        0 - 成功，buf写入配置空间
+        <0 - 失败，配置空间保持原来的值，下次读取时再调用
+*************************************************************/
+typedef int (*eIODP_VREAD_CB)(void* ctx, unsigned short addr, unsigned short len, unsigned char* buf);
+
+typedef struct
+{
+    uint8 valid;            //缓存有效（至少填充成功过一次）
+    uint16 addr;
+    uint16 len;
+    uint32 ttl_us;          //缓存有效期，0为每次读都重新填充
+    unsigned long long fillTime;    //最后一次填充成功的时间
+    eIODP_VREAD_CB cb;
+    void* ctx;
+}eIODP_VREG;
+
+//推送回调的flags
+#define IODP_PUSH_FULL 0x01     //整个范围的数据（订阅或重新同步后），否则只包含变化的部分
+#define IODP_PUSH_ERROR 0x02    //对方拒绝订阅（范围错误或者订阅表满），订阅已经取消，addr/len/data无效
+#define IODP_PUSH_LOST 0x04     //发现推送丢失，已经请求重新同步，addr/len/data无效
+
+/************************************************************
+    @brief:
+        订阅推送回调，一个推送包中的每个地址段调用一次
+    @param:
+        ctx：订阅时的用户参数
+        sid：订阅编号
+        flags：IODP_PUSH_FULL/IODP_PUSH_ERROR/IODP_PUSH_LOST
+        addr,len,data：变化的地址段与新值
+*************************************************************/
+typedef void (*eIODP_PUSH_CB)(void* ctx, int sid, int flags,
+                unsigned short addr, unsigned short len, const unsigned char* data);
+
+//订阅状态（主设备）
+#define IODP_SUB_FREE 0
+#define IODP_SUB_WAIT 1         //已发出订阅，等待第一个整范围推送
+#define IODP_SUB_ACTIVE 2
+#define IODP_SUB_RESYNC 3       //发现丢包，等待整范围推送
+
+//主设备的订阅
+typedef struct
+{
+    uint8 state;
+    uint16 addr;
+    uint16 len;
+    uint16 interval_ms;
+    uint16 expectSeq;       //下一个推送序号
+    unsigned long long reqTime;     //最后一次发出订阅或重新同步的时间
+    eIODP_PUSH_CB cb;
+    void* ctx;
+}eIODP_SUB;
+
+//从设备的订阅，dirty为配置空间的字节脏位图
+typedef struct
+{
+    uint8 used;
+    uint8 full;             //下一次推送整个范围
+    uint16 addr;
+    uint16 len;
+    uint16 seq;
+    uint32 interval_us;
+    unsigned long long lastPush;
+    uint8 dirty[(IODP_CONFIGMEM_SIZE+7)/8];
+}eIODP_SUB_SRV;
+
+//延迟返回的服务函数请求，由eiodpComplete完成。
+//slot与gen要和句柄中的延迟请求表对上，完成后表项的代数加1，同一个token不能再完成
+typedef struct
+{
+    void* fd;           //收到请求的eiodp句柄（eIODP_TYPE*）
+    uint16 funcode;
+    uint16 slot;        //延迟请求表的位置
+    uint16 gen;         //表项的代数，0无效
+}eIODP_DEFER;
+
+//延迟请求表项，state低位为1时未完成，其余位为代数
+typedef struct
+{
+    uint32 state;
+    uint16 funcode;
+}eIODP_DEFER_SLOT;
+
+typedef int (*eIODP_DEFER_CB)(eIODP_DEFER token, uint16 len, void* data);
+
+//服务函数的返回写入器，返回数据直接写在输出帧里
+typedef struct
+{
+    unsigned char* frame;   //输出帧，返回数据从frame[hdr]开始
+    uint16 hdr;             //帧头长度，服务函数返回为10，流的数据块为13
+    uint16 cap;             //最多的返回数据
+    uint16 len;             //已经写入的返回数据（包括引用）
+    uint16 reserved;        //reserve之后还没有commit的长度
+    uint16 nref;
+    int overflow;           //有写入因为超过cap被拒绝
+    //引用的外部数据，在返回数据中的位置为refOff，发出时分段输出，不复制到帧里
+    const unsigned char* refPtr[IODP_WRITER_MAXREF];
+    uint16 refOff[IODP_WRITER_MAXREF];
+    uint16 refLen[IODP_WRITER_MAXREF];
+}eIODP_WRITER;
+
+//arg直接指向接收缓存中的参数，只在服务函数内有效
+typedef int (*eIODP_WRITER_CB)(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w);
+
+//流式服务函数（EC10），在接收处理任务中调用
+typedef struct
+{
+    //打开流：arg直接指向接收缓存，只在open内有效，*state保存流的状态。返回<0时拒绝
+    int (*open)(const unsigned char* arg, uint16 arglen, void** state);
+    //产生下一个数据块，最多IODP_STREAM_CHUNK字节，写入方式同写入器服务函数。
+    //返回1为还有数据块，0为最后一个数据块，<0为出错（丢弃已经写入的数据，对方收到错误）
+    int (*next)(void* state, eIODP_WRITER* w);
+    //流结束：status为IODP_OK（最后一个数据块已发出）、next的错误、IODP_ERROR_CANCELED（对方取消）
+    //或者IODP_ERROR_TIMEOUT（额度长时间没有更新），可以为空
+    void (*close)(void* state, int status);
+}eIODP_STREAM_OPS;
+
+//eiodp服务函数链表结构
+typedef struct
+{
+    uint16 funcode;
+    int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata); 
+    void* pNext;
+    eIODP_DEFER_CB deferFunc;   //不为空时为延迟返回的服务函数
+    eIODP_WRITER_CB writerFunc; //不为空时为使用写入器的服务函数
+    const eIODP_STREAM_OPS* streamOps;  //不为空时为流式服务函数
+}eIODP_FUNC_NODE;
+
+//数据块回调的status
+#define IODP_STREAM_DATA 0      //数据块，之后还有
+#define IODP_STREAM_END 1       //最后一个数据块（可以没有数据），之后不再回调
+//数据块的flags（线上）
+#define IODP_SCHUNK_END 0x01
+#define IODP_SCHUNK_ERROR 0x02  //对方拒绝或者出错，数据为1字节原因
+//错误数据块的原因
+#define IODP_SERR_NOFUNC 0x01   //没有注册这个流式服务函数
+#define IODP_SERR_BUSY 0x02     //对方的流表已满
+#define IODP_SERR_REJECT 0x03   //open拒绝
+#define IODP_SERR_FAIL 0x04     //next出错
+#define IODP_SERR_GONE 0x05     //对方没有这个流（额度超时关闭或者重启过）
+//EC12的操作
+#define IODP_SCTL_CREDIT 0      //额度：对方可以发出序号小于n的数据块
+#define IODP_SCTL_CANCEL 1
+
+/************************************************************
+    @brief:
+        流的数据块回调，在接收线程（无操作系统为eiodp_recvProcessTask_nos/eiodp_process）中按序号顺序执行
+    @param:
+        ctx：打开流时的用户参数
+        sid：流编号
+        status：IODP_STREAM_DATA、IODP_STREAM_END，或者流失败：
+            IODP_ERROR_PKT（对方拒绝或出错，data[0]为IODP_SERR_*）、IODP_ERROR_LOST、IODP_ERROR_TIMEOUT，
+            END与失败之后不再回调
+        data,len：数据块，只在回调内有效
+*************************************************************/
+typedef void (*eIODP_CHUNK_CB)(void* ctx, int sid, int status, const unsigned char* data, int len);
+
+//主设备的流
+typedef struct
+{
+    uint8 state;            //0为空闲
+    uint8 epoch;            //流编号的高字节，区分先后使用同一项的流
+    uint8 tries;            //连续没有回应的重发次数
+    uint16 code;
+    uint16 window;
+    uint16 expectSeq;       //下一个数据块序号
+    uint16 limit;           //已经给对方的额度：对方可以发出序号小于limit的数据块
+    unsigned long long lastTime;    //最后一次收到数据块或者重发的时间
+    unsigned char* openPkt; //打开请求，收到第一个数据块前用于重发
+    uint16 openLen;
+    eIODP_CHUNK_CB cb;
+    void* ctx;
+}eIODP_STREAM;
+
+//从设备的流
+typedef struct
+{
+    uint8 used;
+    uint16 sid;
+    uint16 seq;             //下一个数据块序号
+    uint16 limit;
+    unsigned long long lastCredit;  //最后一次收到额度的时间
+    const eIODP_STREAM_OPS* ops;
+    void* state;
+}eIODP_STREAM_SRV;
+
+//eiodp循环缓冲buffer
+typedef struct
+{
+    uint32 bufSize;
+
+    uint8 *buf;
+    uint32 pIn; //环形缓冲的头指针
+    uint32 pOut; //环形缓冲的尾指针
+
+}eIODP_RING;
+
+//RTT估计器，地址类操作与function分开估计（function包含服务函数执行时间）
+#define IODP_RTT_ADDR 0
+#define IODP_RTT_FUNC 1
+#define IODP_RTT_NUM 2
+typedef struct
+{
+    uint32 srtt;        //平滑RTT
+    uint32 rttvar;      //RTT偏差
+    uint32 rto;         //当前超时
+    uint8 valid;        //是否已有样本
+}eIODP_RTT;
+
+//可靠写发送窗口中的一个包
+typedef struct
+{
+    uint8 used;         //0空闲 1等待确认 2已被选择确认(sack)
+    uint8 retry;        //超时重传次数，快速重传不计入
+    uint8 dupcnt;       //后续包被确认的次数，用于快速重传
+    uint8 fastRetx;     //1:dupcnt到达IODP_RWRITE_DUPTHRESH，下一次检查时立即重传
+    uint8 resent;       //重传过（超时或快速重传），确认时不作为RTT样本
+    uint16 framelen;
+    unsigned long long sendtime;
+    unsigned long long firstsend;   //第一次发送时间，用于统计端到端时延
+    uint32 txEnd;       //第一次发送后的发送字节位置，确认后用于归还流量控制额度
+    uint8 frame[18+IODP_RWRITE_MAXDATA];
+}eIODP_RWRITE_SLOT;
+
+//可靠写发送端状态
+typedef struct
+{
+    uint16 epoch;       //会话号，窗口复位后更换，接收端据此清空状态
+    uint16 sndUna;      //最早未确认的seq
+    uint16 sndNext;     //下一个要发送的seq
+    eIODP_RWRITE_SLOT slot[IODP_RWIN_SIZE];
+}eIODP_RWRITE_TX;
+
+//可靠写接收端状态：重复包抑制与乱序缓存
+typedef struct
+{
+    uint16 epoch;
+    uint16 rcvNext;     //下一个期望的seq，之前的包都已经写入configmem
+    uint32 rcvMask;     //bit i 表示seq=rcvNext+1+i已经缓存
+    uint8 slot[IODP_RWIN_SIZE][4+IODP_RWRITE_MAXDATA]; //addr len data
+}eIODP_RWRITE_RX;
+
+/************************************************************
+    @brief:
+        异步请求完成回调，在eiodp_recvProcessTask_nos或eiodp_process中调用
+    @param:
+        ctx：发起请求时传入的用户参数
+        status：>=0 成功，为返回数据长度
+                IODP_ERROR_TIMEOUT - 超时（已经按配置重发过）
+                IODP_ERROR_PKT - 对方返回错误包，data[0]为错误码
+                IODP_ERROR_RECVLEN - 返回包长度不对
+        data：返回数据，只在回调期间有效
+        len：返回数据长度
+*************************************************************/
+typedef void (*eIODP_DONE_CB)(void* ctx, int status, unsigned char* data, int len);
+
+//一个在途的异步请求
+typedef struct
+{
+    uint8 used;         //0空闲 1在途 2已超时，等待可能的迟到返回
+    uint8 type;         //IODP_TYPE_READADDR 或 IODP_TYPE_FUNCTION
+    uint8 retry;        //已重发次数
+    uint16 key;         //读地址或者function code，用于匹配返回包
+    uint16 len;         //读长度，读返回包的地址与长度都要对上
+    uint16 order;       //发出顺序，错误包不带地址，交给最早发出的同类请求
+    unsigned long long sendtime;
+    unsigned long long firstsend;
+    unsigned long long deadline;
+    uint32 txEnd;       //发送字节位置，返回后归还流量控制额度
+    eIODP_DONE_CB cb;
+    void* ctx;
+    uint8 frame[14];    //读请求的数据包，用于重发
+}eIODP_PENDING;
+
+/*
+    配置空间持久化文件布局（偏移按IODP_PERSIST_ALIGN对齐，area为配置空间大小向上对齐）：
+        0               文件头0，描述槽0
+        ALIGN           文件头1，描述槽1
+        2*ALIGN         工作区，configmem直接指向这里，远程写直接落在映射上
+        2*ALIGN+area    槽0
+        2*ALIGN+2*area  槽1
+    检查点把工作区的一致快照写到较旧的槽，msync后再写这个槽的文件头并msync。
+    任何时候崩溃，至少有一个文件头与槽完整；启动时取CRC都正确的最新的槽复制到工作区，
+    工作区本身可能被内核写回了一半，不作为恢复依据。
+*/
+typedef struct
+{
+    uint32 magic;       //IODP_PERSIST_MAGIC
+    uint32 size;        //配置空间大小
+    uint32 seq;         //检查点序号，越大越新，0为空
+    uint32 datacrc;     //槽中数据的CRC
+    uint32 hdrcrc;      //以上字段的CRC
+}eIODP_PERSIST_HDR;
+
+//持久化状态
+typedef struct
+{
+    int file;
+    uint8* map;
+    uint32 maplen;
+    uint32 area;                //工作区与每个槽的长度
+    uint32 seq;                 //最新检查点序号
+    int slot;                   //最新检查点所在的槽，-1为还没有
+    uint32 savedCfgSeq;         //最新检查点对应的cfgSeq，没有变化时不再写
+    uint32 interval_us;         //周期检查点间隔，0为只在eiodpConfigCheckpoint时写
+    unsigned long long lastTime;
+}eIODP_PERSIST;
+
+//增量解析状态，一个数据包可以分多次输入
+typedef struct
+{
+    uint16 have;        //当前包已经收到的字节
+    uint16 need;        //完整包长度，包头收齐之前为0
+    uint8 buf[IODP_RECV_MAX_LEN];
+}eIODP_PARSER;
+
+//
+typedef struct
+{
+    unsigned int iodevHandle;   //IO设备的句柄fd
+    eIODP_RING*  recv_ringbuf;
+
+    eIODP_RING*  retbuf_readaddr;     //readaddr 类型包的返回包缓存区
+    eIODP_RING*  retbuf_func;         //function 类型包的返回包缓存区
+
+    unsigned int configmemSize;
+    //接收线程写入，其他线程读取时使用eiodpConfigRead，直接读可能看到写了一半的数据
+    //平时指向configmemBuf，开启持久化后指向映射文件的工作区
+    char* configmem;
+    char configmemBuf[IODP_CONFIGMEM_SIZE];
+    eIODP_PERSIST* pPersist;
+    //configmem的顺序锁：写入期间为奇数，读前后看到同一个偶数值说明读到的是一致的快照
+    uint32 cfgSeq;
+    //每IODP_CFG_BLOCK字节一个版本号，为最后一次写入该块完成后的cfgSeq
+    uint32 blkver[IODP_CFG_NBLOCK];
+    //当前写入事务写过的地址段，事务结束后用于查找监视
+    uint16 touchCnt;
+    uint16 touchAddr[IODP_MRANGE_MAX];
+    uint16 touchLen[IODP_MRANGE_MAX];
+    //写入监视，watchMask[b]的第i位表示第i个监视与第b块重叠
+    eIODP_WATCH watch[IODP_WATCH_MAX];
+    uint32 watchMask[IODP_CFG_NBLOCK];
+    //虚拟读范围，vregMask[b]的第i位表示第i个范围与第b块重叠
+    //vregUsed的第i位表示第i个范围已经映射，读请求先检查它，没有映射时不加锁
+    eIODP_VREG vreg[IODP_VREG_MAX];
+    uint32 vregUsed;
+    uint32 vregMask[IODP_CFG_NBLOCK];
+    //对方的订阅，subDirty的第i位表示第i个订阅有没推送的变化
+    eIODP_SUB_SRV subSrv[IODP_SUB_MAX];
+    uint32 subDirty;
+    //扩展地址空间的两级页表，在configmem写锁内分配，句柄存在期间不释放
+    uint8** xmemDir[IODP_XMEM_L1];
+    uint32 xmemPages;
+
+    //注册的服务函数链表
+    eIODP_FUNC_NODE* pFuncHead;
+    //已经交给延迟服务函数、还没有完成的请求数
+    uint32 deferOpen;
+    eIODP_DEFER_SLOT defer[IODP_DEFER_MAX];
+    //写入器服务函数的输出帧，注册第一个写入器服务函数时申请，只在接收处理任务中使用
+    unsigned char* funcTx;
+    //对方打开的流与数据块的输出帧（注册第一个流式服务函数时申请），只在接收处理任务中使用
+    eIODP_STREAM_SRV streamSrv[IODP_STREAM_MAX];
+    unsigned char* streamTx;
+
+    //iodevHandle设备的收发函数
+    int (*iodevRead)(int, char*, int);
+    int (*iodevWrite)(int, char*, int);
+    //可选的分段写，n段数据作为一次写入，没有时分段数据先合并再用iodevWrite
+    int (*iodevWritev)(int, const void* const* bufs, const int* lens, int n);
+
+    //接收解析状态
+    eIODP_PARSER parser;
+    //eiodp_process调用期间，发出的数据写到调用者的缓存
+    uint8* outbuf;
+    int outcap;
+    int outlen;
+
+    //RTT估计与超时
+    eIODP_RTT rtt[IODP_RTT_NUM];
+#if (IODP_METRICS_ENABLE)
+    eIODP_METRICS metrics;
+#endif
+    //用户时钟源，设置后用它计时
+    uint32 (*tickFunc)(void);
+    uint32 tickHz;
+    uint32 tickLast;
+    unsigned long long tickTotal;
+    //无操作系统且没有时钟源时的轮询计数，每次eiodp_recvProcessTask_nos/eiodp_process加1
+    unsigned long long pollCount;
+
+    //流量控制（发送端）：对方每返回一个包，说明它已经取走了对应请求之前的所有数据，
+    //在途字节(txOffset-peerAcked)不超过对方声明的接收窗口peerWindow
+    uint8 flowMode;             //1:开启
+    uint8 probeFail;            //探测连续没有回应的次数
+    uint16 probeToken;          //在途探测编号，0为没有
+    uint32 txOffset;            //累计发出的请求字节（只计请求帧的首次发送）
+    uint32 peerAcked;           //对方已经取走的字节位置
+    uint32 peerWindow;          //对方接收窗口，0为未知
+    uint32 probeEnd;            //发出探测时的请求字节位置
+    unsigned long long probeTime;
+
+    //多段读的请求编号，用于识别迟到的返回包
+    uint16 mreadTag;
+
+    //本端发出的订阅，subWait的第i位表示第i个订阅在等待整范围推送
+    eIODP_SUB sub[IODP_SUB_MAX];
+    uint32 subWait;
+
+    //本端打开的流，streamOpen的第i位表示第i个流在使用
+    eIODP_STREAM stream[IODP_STREAM_MAX];
+    uint32 streamOpen;
+
+    //可靠写，第一次使用时分配
+    uint8 rwriteMode;           //1:eiodpWriteAddr走可靠写
+    eIODP_RWRITE_TX* pRwTx;
+    eIODP_RWRITE_RX* pRwRx;
+
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_mutex_t mutex_rtt;
+    pthread_mutex_t mutex_flow;
+    sem_t flow_sem;
+    pthread_mutex_t mutex_cfg;  //configmem写入互斥（接收线程与eiodpConfigWrite）
+    pthread_mutex_t mutex_sub;  //本端订阅表
+    pthread_mutex_t mutex_stream;   //本端流表
+    pthread_mutex_t mutex_persist;  //检查点（接收线程的周期检查点与eiodpConfigCheckpoint）
+    sem_t rwrite_sem;
+    pthread_mutex_t mutex_rwrite;
+    sem_t readaddr_retsem;
+    sem_t func_retsem;
+    pthread_t ptRecvPushTask;
+    pthread_t ptRecvProcessTask;
+    volatile int stopping;      //eiodp_deinit时置1，接收任务退出
+    pthread_mutex_t mutex_recv;
+    sem_t sem_recvSync;
+    pthread_mutex_t mutex_pending;  //异步请求表（调用线程与接收处理任务）
+#elif (IODP_OS==IODP_OS_FREERTOS)
+#elif (IODP_OS==IODP_OS_NULL)
+    //没有io写函数时，eiodp_process之外发出的请求暂存在这里，下次eiodp_process时输出
+    eIODP_RING* txPending;
+#endif
+    //异步请求表
+    eIODP_PENDING pending[IODP_PENDING_MAX];
+    uint16 pendingOrder;
+
+}eIODP_TYPE;
+
+/************************************************************
+    @brief:
+        初始化框架，准备缓存取、信号量、创建接受服务线程
+    @param:
+        fd：依赖的io设备句柄，eiodp协议需要作用于标准io设备。
+        readfunc：fd设备读数据函数
+        writefunc：fd设备写数据函数
+    @return:
+        创建的eIODP_TYPE指针，可以通过这个指针来操作iodp
+*************************************************************/
+eIODP_TYPE* eiodp_init(unsigned int fd, int (*readfunc)(int, char*, int),
+                int (*writefunc)(int, char*, int));
+
+/************************************************************
+    @brief:
+        释放eiodp_init创建的句柄：停止接收任务，关闭配置空间持久化（写最后一次检查点），
+        释放扩展地址空间、注册的服务函数与全部缓存。
+        调用前其他线程不能再使用这个句柄，在途的请求要先返回；
+        无操作系统下调用者要先停止调用eiodp_recvProcessTask_nos/eiodp_process
+    @param:
+        eiodp_fd:eiodp句柄，可以为NULL
+*************************************************************/
+void eiodp_deinit(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        写地址操作，将数据写到对方的配置空间上
+        此操作主要是在对方的iodp配置空间的addr偏移地址上写指定长度的数据。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：在对方的配置空间addr地址往后写数据
+        len：数据长度，在[addr,addr+len]上覆盖数据
+        sdbuf：数据头指针
+*************************************************************/
+void eiodpWriteAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf);
+
+/************************************************************
+    @brief:
+        32位地址写（EC0D），写对方的扩展地址空间，无返回。
+        低于对方配置空间大小的地址就是配置空间，与eiodpWriteAddr写的是同一块数据
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：扩展地址空间地址，不超过IODP_XMEM_SIZE
+        len：数据长度，数据包不能超过IODP_RECV_MAX_LEN
+        sdbuf：数据头指针
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        IODP_ERROR_HEAPOVER - 内存不足
+        0 - 已发出
+*************************************************************/
+int eiodpWriteAddr32(eIODP_TYPE* eiodp_fd,uint32 addr,unsigned short len,const unsigned char* sdbuf);
+/************************************************************
+    @brief:
+        读地址操作，读取对方的配置空间数据
+        此操作主要是将对方的addr地址往后len个数据都读取出来
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：读取地址
+        len：数据长度
+        recvbuf：将数据存入该数组
+        超时时间由RTT估计得出，超时后自动重发，最多重发IODP_READ_RETRY次
+    @return:
+        IODP_ERROR_TIMEOUT - time out
+        IODP_ERROR_SMOLL_RECVLEN - recvlen长度不对
+        IODP_ERROR_RECVLEN - 返回包包长度与实际不符
+        IODP_ERROR_PKT - 有返回包，但是返回了错误代码
+        IODP_ERROR_NORET - 返回type不对
+        >=0 - 成功 读到的数据长度
+*************************************************************/
+int eiodpReadAddr(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* recvbuf);
+
+/************************************************************
+    @brief:
+        32位地址读（EC0E），读对方的扩展地址空间，没有写过的页读出为0。
+        超时与重发与eiodpReadAddr相同
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：扩展地址空间地址
+        len：数据长度，返回包要放得下返回缓存（len最多IODP_RETURN_BUFFER-10）
+        recvbuf：将数据存入该数组
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者len太大
+        IODP_ERROR_PKT - 有返回包，但是返回了错误代码（地址越界）
+        其他同eiodpReadAddr
+        >=0 - 成功 读到的数据长度
+*************************************************************/
+int eiodpReadAddr32(eIODP_TYPE* eiodp_fd,uint32 addr,unsigned short len,unsigned char* recvbuf);
+
+//多段读写的一个地址段
+typedef struct
+{
+    uint16 addr;
+    uint16 len;
+    unsigned char* buf;     //读：数据存入这里 写：要写的数据
+}eIODP_RANGE;
+
+/************************************************************
+    @brief:
+        多段读（EC06），一个请求读取多个不连续的地址段，对方用一个返回包返回全部数据，
+        各段数据在对方同一次处理中读出。超时与重发与eiodpReadAddr相同
+    @param:
+        eiodp_fd:eiodp句柄
+        ranges：地址段，数据按段分别存入ranges[i].buf
+        count：段数，不超过IODP_MRANGE_MAX
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者总长度超过返回缓存
+        IODP_ERROR_TIMEOUT - time out
+        IODP_ERROR_RECVLEN - 返回包包长度与实际不符
+        IODP_ERROR_PKT - 有返回包，但是返回了错误代码（有地址段越界）
+        >=0 - 成功 读到的数据总长度
+*************************************************************/
+int eiodpReadMulti(eIODP_TYPE* eiodp_fd,const eIODP_RANGE* ranges,int count);
+
+/************************************************************
+    @brief:
+        条件读（EC0C）：buf为调用者缓存的对方数据，ver为缓存的版本。
+        对方只返回版本比ver新的块（每IODP_CFG_BLOCK字节一块），能压缩时用PackBits编码，
+        没有变化时只返回一个很短的包，本函数把变化的块写入buf并更新ver。
+        用于轮询变化很慢的大段数据。同一个buf/ver只能用于同一个addr/len。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr,len：读取范围，最坏情况（全部变化并且不能压缩）的返回包要放得下返回缓存，
+                  len最多约IODP_RETURN_BUFFER-64
+        buf：缓存，len字节
+        ver：输入缓存的版本，第一次调用传入0（返回全部数据）；成功后更新为新的版本
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者len太大
+        IODP_ERROR_TIMEOUT - time out
+        IODP_ERROR_RECVLEN - 返回包格式错误，ver没有更新
+        IODP_ERROR_PKT - 有返回包，但是返回了错误代码（地址越界）
+        0 - 没有变化
+        >0 - 更新的字节数
+*************************************************************/
+int eiodpReadAddrIfChanged(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                unsigned char* buf,uint32* ver);
+
+/************************************************************
+    @brief:
+        多段写（EC07），一个包写多个不连续的地址段，无返回。
+        对方先检查全部地址段，有任何一段越界则整包不写；
+        全部合法时在同一次处理中写完，对方的读请求不会看到只写了一部分的结果
+    @param:
+        eiodp_fd:eiodp句柄
+        ranges：地址段与数据
+        count：段数，不超过IODP_MRANGE_MAX
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者数据包超过IODP_RECV_MAX_LEN
+        IODP_ERROR_HEAPOVER - 内存不足
+        0 - 已发出
+*************************************************************/
+int eiodpWriteMulti(eIODP_TYPE* eiodp_fd,const eIODP_RANGE* ranges,int count);
+
+/************************************************************
+    @brief:
+        读本端配置空间的一致快照（顺序锁，读者不加锁也不阻塞写入）。
+        一个远程写包（EC01/EC04/EC07）的全部修改要么都能看到，要么都看不到
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：配置空间地址
+        len：长度
+        buf：数据存入这里
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出配置空间
+        >=0 - 读到的长度
+*************************************************************/
+int eiodpConfigRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* buf);
+
+/************************************************************
+    @brief:
+        只有范围内的数据在上次读取之后被写过才复制，用于轮询配置变化
+    @param:
+        ver：输入上次读取时得到的版本，第一次调用传入0；复制后更新为新的版本
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出配置空间
+        0 - 没有变化，buf没有修改
+        >0 - 有变化，已复制的长度
+*************************************************************/
+int eiodpConfigReadIfChanged(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                unsigned char* buf,uint32* ver);
+
+/************************************************************
+    @brief:
+        本端写配置空间，与远程写一样整体可见，并更新块版本
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出配置空间
+        >=0 - 写入的长度
+*************************************************************/
+int eiodpConfigWrite(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,const unsigned char* data);
+
+/************************************************************
+    @brief:
+        本端写扩展地址空间，与配置空间重合的部分同eiodpConfigWrite
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出IODP_XMEM_SIZE
+        IODP_ERROR_HEAPOVER - 页数达到IODP_XMEM_MAXPAGES或者内存不足，只写入了一部分
+        >=0 - 写入的长度
+*************************************************************/
+int eiodpXmemWrite(eIODP_TYPE* eiodp_fd,uint32 addr,uint32 len,const unsigned char* data);
+
+/************************************************************
+    @brief:
+        本端读扩展地址空间的一致快照，没有写过的页读出为0，读不会分配页
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出IODP_XMEM_SIZE
+        >=0 - 读到的长度
+*************************************************************/
+int eiodpXmemRead(eIODP_TYPE* eiodp_fd,uint32 addr,uint32 len,unsigned char* buf);
+
+/************************************************************
+    @brief:
+        获取扩展地址空间已经分配的页数
+*************************************************************/
+uint32 eiodpXmemPages(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        用映射文件保存配置空间（需要IODP_PERSIST_ENABLE）。
+        文件中有完整的检查点时恢复到配置空间（只需要一次mmap与复制，不需要主设备重新写入），
+        否则保留当前配置空间的内容并立即写第一个检查点。
+        之后configmem直接指向映射，远程写直接落在文件上，按interval_ms或者
+        eiodpConfigCheckpoint写检查点。恢复时会通知全部监视与订阅。
+    @param:
+        eiodp_fd:eiodp句柄
+        path：文件路径，不存在时创建
+        interval_ms：周期检查点间隔（在接收任务中检查，只在有写入时写），0为只手动
+    @return:
+        IODP_ERROR_PARAM - 参数错误、已经开启、没有开启IODP_PERSIST_ENABLE或者文件操作失败
+        IODP_ERROR_HEAPOVER - 内存不足
+        0 - 新文件，没有可以恢复的检查点
+        1 - 已从检查点恢复
+*************************************************************/
+int eiodpConfigPersist(eIODP_TYPE* eiodp_fd,const char* path,uint32 interval_ms);
+
+/************************************************************
+    @brief:
+        写一个检查点，配置空间从上一个检查点以来没有变化时不写
+    @return:
+        IODP_ERROR_PARAM - 没有开启持久化
+        IODP_ERROR_PKT - msync失败，原来的检查点仍然有效
+        0 - 没有变化
+        1 - 已写入
+*************************************************************/
+int eiodpConfigCheckpoint(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        写最后一个检查点并关闭文件，配置空间复制回句柄内部，之后的写入不再保存
+*************************************************************/
+void eiodpConfigPersistClose(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        获取最新检查点的序号，没有开启持久化时为0
+*************************************************************/
+uint32 eiodpConfigPersistSeq(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        获取范围内配置空间的版本（范围内各块版本的最大值），写入后变大
+*************************************************************/
+uint32 eiodpConfigVersion(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len);
+
+/************************************************************
+    @brief:
+        监视配置空间的一个地址范围，对方的写包（EC01/EC04/EC07）写到这个范围时调用cb。
+        一个包只调用一次，在写入全部可见之后调用，回调中可以用eiodpConfigRead读取新值。
+        linux下回调在接收线程中执行，不要在回调中等待本端发出的请求的返回。
+        本端eiodpConfigWrite不会触发回调。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr,len：监视范围
+        cb：回调
+        ctx：回调的用户参数
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者超出配置空间
+        IODP_ERROR_BUSY - 已经有IODP_WATCH_MAX个监视
+        >=0 - 监视编号，用于eiodpUnwatch
+*************************************************************/
+int eiodpWatch(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,eIODP_WATCH_CB cb,void* ctx);
+
+/************************************************************
+    @brief:
+        取消监视。接收线程中正在执行的回调不会被打断
+*************************************************************/
+int eiodpUnwatch(eIODP_TYPE* eiodp_fd,int id);
+
+/************************************************************
+    @brief:
+        把配置空间的一个地址范围映射为虚拟读范围：对方的读请求（EC02/EC06）碰到这个范围时，
+        先调用cb填充整个范围再返回数据，不用周期性地把实时值刷新到配置空间。
+        填充后ttl_us之内的读直接返回缓存的值。
+        linux下cb在接收线程中执行；本端eiodpConfigRead与对方的写不会触发填充，
+        对方写入的值会保留到下一次填充。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr,len：范围，不能与已有的虚拟读范围重叠
+        cb：填充函数
+        ctx：cb的用户参数
+        ttl_us：缓存有效期，0为每次读都填充
+    @return:
+        IODP_ERROR_PARAM - 参数错误、超出配置空间或者与已有范围重叠
+        IODP_ERROR_BUSY - 已经有IODP_VREG_MAX个范围
+        >=0 - 范围编号，用于eiodpUnmapRead/eiodpInvalidateRead
+*************************************************************/
+int eiodpMapRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                eIODP_VREAD_CB cb,void* ctx,uint32 ttl_us);
+
+/************************************************************
+    @brief:
+        取消虚拟读范围，配置空间保留最后一次填充的值
+*************************************************************/
+int eiodpUnmapRead(eIODP_TYPE* eiodp_fd,int id);
+
+/************************************************************
+    @brief:
+        使虚拟读范围的缓存失效，下一次读取时重新填充
+*************************************************************/
+int eiodpInvalidateRead(eIODP_TYPE* eiodp_fd,int id);
+
+/************************************************************
+    @brief:
+        订阅对方配置空间的一个地址范围（EC08），对方的数据变化时主动推送，不用轮询。
+        订阅后对方先推送一次整个范围，之后只推送变化的字节，相邻的变化合并成一段，
+        同一个订阅两次推送至少间隔interval_ms，间隔内的多次变化合并到一次推送。
+        发现推送丢失（序号不连续）时回调IODP_PUSH_LOST并请求重新同步（EC0A），
+        之后会收到一次整个范围的推送。订阅与重新同步没有回应时每IODP_SUB_RETRY重发。
+        回调在接收线程（无操作系统为eiodp_recvProcessTask_nos/eiodp_process）中执行，
+        不要在回调中等待本端发出的请求的返回。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr,len：订阅范围
+        interval_ms：最小推送间隔，0为有变化就推送
+        cb：推送回调
+        ctx：回调的用户参数
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        IODP_ERROR_BUSY - 已经有IODP_SUB_MAX个订阅
+        >=0 - 订阅编号
+*************************************************************/
+int eiodpSubscribe(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,uint16 interval_ms,
+                eIODP_PUSH_CB cb,void* ctx);
+
+/************************************************************
+    @brief:
+        取消订阅（EC0B），之后收到的推送不再回调（接收线程中正在执行的回调不会被打断），
+        再收到这个编号的推送时会再次通知对方取消
+*************************************************************/
+int eiodpUnsubscribe(eIODP_TYPE* eiodp_fd,int sid);
+
+/************************************************************
+    @brief:
+        可靠写地址操作（EC04），数据按序号发送，对方写入后返回确认(ack)。
+        数据超过IODP_RWRITE_MAXDATA时拆成多个包，最多IODP_RWIN_SIZE个包同时在途，
+        丢失的包通过超时或选择确认(sack)重传，对方会丢弃重复包。
+        该函数在数据全部进入发送窗口后返回，需要确认全部送达时调用eiodpWriteFlush。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：在对方的配置空间addr地址往后写数据
+        len：数据长度
+        sdbuf：数据头指针
+    @return:
+        IODP_ERROR_TIMEOUT - 有包超过最大重传次数，窗口保留（各包的重传次数清零），
+            本次数据中还没有进入窗口的部分没有发出，用eiodpWriteUnacked查询没有确认的范围
+        IODP_ERROR_HEAPOVER - 分配窗口失败
+        0 - 成功
+*************************************************************/
+int eiodpWriteAddrReliable(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,unsigned char* sdbuf);
+
+/************************************************************
+    @brief:
+        等待可靠写窗口中的包全部被确认
+    @param:
+        eiodp_fd:eiodp句柄
+    @return:
+        IODP_ERROR_TIMEOUT - 有包超过最大重传次数，窗口保留，可以再次调用eiodpWriteFlush
+            或者用eiodpWriteDiscard放弃
+        0 - 全部送达
+*************************************************************/
+int eiodpWriteFlush(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        查询可靠写窗口中还没有确认的包
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：不为空时返回最早没有确认的包的起始地址
+        next：不为空时返回最后进入窗口的包的结束地址（其后的数据没有发出）
+    @return:
+        <0 - 失败（error code）
+        >=0 - 没有确认的包数，0时addr/next不变
+*************************************************************/
+int eiodpWriteUnacked(eIODP_TYPE* eiodp_fd,unsigned short* addr,unsigned short* next);
+
+/************************************************************
+    @brief:
+        放弃可靠写窗口中没有确认的包，换一个会话号，对方丢弃旧会话的乱序缓存
+*************************************************************/
+void eiodpWriteDiscard(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        设置eiodpWriteAddr是否走可靠写
+    @param:
+        eiodp_fd:eiodp句柄
+        enable：1开启 0关闭
+*************************************************************/
+void eiodpSetReliableWrite(eIODP_TYPE* eiodp_fd,int enable);
+
+/************************************************************
+    @brief:
+        注册服务函数
+    @param:
+        eiodp_fd:eiodp句柄
+        funcode：服务函数代码
+        callbackFunc:服务函数
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpRegister(eIODP_TYPE* eiodp_fd,uint16 funcode,
+                int (*callbackFunc)(uint16 len, void* data,uint16* retlen,void* retdata));
+
+/************************************************************
+    @brief:
+        注册延迟返回的服务函数。接收任务收到请求后调用deferFunc(token,len,data)，
+        deferFunc保存token后立即返回，不等待结果，接收任务继续处理后面的请求；
+        结果准备好后（可以在任意线程）调用eiodpComplete(token,...)发出0x6C03返回。
+        data只在deferFunc内有效，需要时自己复制。deferFunc返回<0时立即返回0字节，token作废。
+        每个token必须完成一次，eiodp_deinit之前要完成全部token。
+        同时未完成的请求最多IODP_DEFER_MAX个，表满时不调用deferFunc，对方收到错误包（IODP_FERR_BUSY）
+    @param:
+        eiodp_fd:eiodp句柄
+        funcode：服务函数代码
+        deferFunc:服务函数
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpRegisterDeferred(eIODP_TYPE* eiodp_fd,uint16 funcode,eIODP_DEFER_CB deferFunc);
+
+/************************************************************
+    @brief:
+        完成延迟返回的请求，编码0x6C03返回并发出。
+        linux下可以在任意线程调用；无操作系统时在主循环中调用，
+        没有io写函数时返回暂存，下次eiodp_process时输出
+    @param:
+        token：deferFunc收到的token
+        retlen：返回长度，不超过IODP_FUNCPKT_RET_LEN-14
+        retdata：返回数据
+    @return:
+        IODP_ERROR_PARAM - 参数错误，返回过长（token仍然有效）
+        IODP_ERROR_STALE - token已经完成过，或者不是deferFunc收到的，没有发出
+        <0 - 发送失败
+         0 - 已发出
+*************************************************************/
+int eiodpComplete(eIODP_DEFER token,uint16 retlen,const void* retdata);
+
+/************************************************************
+    @brief:
+        获取还没有完成的延迟返回请求数
+*************************************************************/
+int eiodpDeferredCount(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        注册使用写入器的服务函数。writerFunc(arg,arglen,w)的arg直接指向接收缓存，
+        返回数据通过w写入输出帧，最多IODP_FUNC_RESP_MAX字节（比eiodpRegister的
+        IODP_FUNCPKT_RET_LEN-10大，对方用eiodpFunctionEx接收）。
+        writerFunc返回<0时丢弃已经写入的数据，返回0字节
+    @param:
+        eiodp_fd:eiodp句柄
+        funcode：服务函数代码
+        writerFunc:服务函数
+    @return:
+        IODP_ERROR_HEAPOVER - 输出帧申请失败
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpRegisterWriter(eIODP_TYPE* eiodp_fd,uint16 funcode,eIODP_WRITER_CB writerFunc);
+
+/************************************************************
+    @brief:
+        在输出帧中预留n字节，写入后用eiodpWriterCommit提交，
+        下一次reserve、append或ref之前没有提交的部分作废
+    @param:
+        w：写入器
+        n：预留长度
+    @return:
+        nullptr - 剩余空间不足，w->overflow置1
+        其他 - 写入位置
+*************************************************************/
+unsigned char* eiodpWriterReserve(eIODP_WRITER* w,uint16 n);
+
+/************************************************************
+    @brief:
+        提交预留空间中的前n字节
+    @return:
+        IODP_ERROR_PARAM - n超过预留长度
+        0 - 成功
+*************************************************************/
+int eiodpWriterCommit(eIODP_WRITER* w,uint16 n);
+
+/************************************************************
+    @brief:
+        把n字节复制到输出帧
+    @return:
+        IODP_ERROR_RETSIZE - 剩余空间不足，没有写入，w->overflow置1
+        0 - 成功
+*************************************************************/
+int eiodpWriterAppend(eIODP_WRITER* w,const void* data,uint16 n);
+
+/************************************************************
+    @brief:
+        引用已有的n字节数据，不复制到输出帧，发出时与帧中的其他部分一起分段写出
+        （设置了eiodpSetWritev时），data在服务函数返回前必须有效。
+        引用超过IODP_WRITER_MAXREF段时按复制写入
+    @return:
+        IODP_ERROR_RETSIZE - 剩余空间不足，没有写入，w->overflow置1
+        0 - 成功
+*************************************************************/
+int eiodpWriterRef(eIODP_WRITER* w,const void* data,uint16 n);
+
+/************************************************************
+    @brief:
+        获取写入器的剩余空间
+*************************************************************/
+int eiodpWriterRemain(const eIODP_WRITER* w);
+
+/************************************************************
+    @brief:
+        设置io设备的分段写函数，writevfunc把bufs[0..n-1]作为一次写入发出，返回写入的总字节数。
+        写入器服务函数的返回带引用时用它发出，帧头、帧中的数据、引用的数据与crc分段输出，
+        crc逐段累加，引用的数据不复制。没有设置时引用的数据先复制到输出帧
+    @param:
+        eiodp_fd:eiodp句柄
+        writevfunc：分段写函数，nullptr取消
+*************************************************************/
+void eiodpSetWritev(eIODP_TYPE* eiodp_fd,int (*writevfunc)(int, const void* const* bufs, const int* lens, int n));
+
+/************************************************************
+    @brief:
+        注册流式服务函数。对方打开流（EC10）时调用ops->open，之后在对方给的额度内
+        反复调用ops->next，每次产生的数据作为一个数据块（6C11）发出，额度用完时暂停，
+        收到新的额度（EC12）后继续。next返回0、出错或者对方取消后调用ops->close。
+        function code与eiodpRegister共用，不能重复
+    @param:
+        eiodp_fd:eiodp句柄
+        funcode：服务函数代码
+        ops：流式服务函数，注册期间必须有效
+    @return:
+        IODP_ERROR_HEAPOVER - 输出帧申请失败
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpRegisterStream(eIODP_TYPE* eiodp_fd,uint16 funcode,const eIODP_STREAM_OPS* ops);
+
+/************************************************************
+    @brief:
+        打开对方的流式服务函数（EC10），不等待。数据块到达后按序号顺序回调cb，
+        最后一个数据块回调IODP_STREAM_END。对方最多领先window个数据块，
+        本端收到一半额度的数据块后补充额度，回调在接收线程中执行，回调处理慢时
+        接收线程跟着变慢，对方因额度用完而暂停。
+        没有收到数据块时每IODP_STREAM_RETRY重发打开请求或额度，连续IODP_STREAM_TRIES次
+        没有回应时回调IODP_ERROR_TIMEOUT；发现数据块丢失（序号不连续）时回调IODP_ERROR_LOST
+        并取消流，数据块不重传，需要时由调用者从断点重新打开
+    @param:
+        eiodp_fd:eiodp句柄
+        code：服务函数代码
+        argsize,arg：参数，交给对方的ops->open
+        window：额度，0为IODP_STREAM_WINDOW
+        cb：数据块回调
+        ctx：回调的用户参数
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        IODP_ERROR_BUSY - 已经有IODP_STREAM_MAX个流
+        IODP_ERROR_HEAPOVER - 申请内存失败
+        >=0 - 流编号
+*************************************************************/
+int eiodpStreamOpen(eIODP_TYPE* eiodp_fd,uint16 code,uint16 argsize,const void* arg,uint16 window,
+                eIODP_CHUNK_CB cb,void* ctx);
+
+/************************************************************
+    @brief:
+        取消流（EC12），之后收到的数据块不再回调（接收线程中正在执行的回调不会被打断），
+        对方调用ops->close(state,IODP_ERROR_CANCELED)。可以在数据块回调中调用
+    @return:
+        IODP_ERROR_PARAM - 没有这个流（已经结束或者取消）
+        0 - 成功
+*************************************************************/
+int eiodpStreamCancel(eIODP_TYPE* eiodp_fd,int sid);
+
+/************************************************************
+    @brief:
+        获取本端没有结束的流个数，role为0时为本端打开的流，为1时为对方打开、本端服务中的流
+*************************************************************/
+int eiodpStreamCount(eIODP_TYPE* eiodp_fd,int role);
+
+/************************************************************
+    @brief:
+        打印已经注册的服务函数
+    @param:
+        eiodp_fd:eiodp句柄
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpShowRegFunc(eIODP_TYPE* eiodp_fd);
+/************************************************************
+    @brief:
+        调用服务端的API接口，该接口由服务端的eiodpRegister注册的callbackFunc函数来提供
+    @param:
+        eiodp_fd:eiodp句柄
+        code：API代码
+        argsize：入参arg的长度
+        arg：API入参
+        retarg：用户需要提供返回参数的容器
+    @return:
+        <0 - 失败（error code）
+        >0 - 成功 返回参数长度
+*************************************************************/
+int eiodpFunction(eIODP_TYPE* eiodp_fd, uint16 code, 
+        uint16 argsize,void* arg, void* retarg);
+
+/************************************************************
+    @brief:
+        函数调用，检查返回参数长度，不申请内存。数据包在调用者提供的frame里编码，
+        返回包使用栈上的IODP_FUNC_RESP_MAX+6字节，可以接收写入器服务函数的长返回
+    @param:
+        eiodp_fd:eiodp句柄
+        code,argsize,arg：与eiodpFunction相同；arg可以直接指向frame+10，省去一次复制
+        retarg：返回参数的容器，retcap字节
+        retcap：retarg的大小
+        frame：编码缓存，IODP_FUNC_FRAMELEN(argsize)字节
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者数据包超过IODP_RECV_MAX_LEN
+        IODP_ERROR_RETSIZE - 返回参数超过retcap，retarg没有修改
+        其他同eiodpFunction
+*************************************************************/
+int eiodpFunctionEx(eIODP_TYPE* eiodp_fd, uint16 code, uint16 argsize, const void* arg,
+        void* retarg, uint16 retcap, unsigned char* frame);
+
+//预编码的请求：数据包与CRC只在创建时计算一次，发送时不再申请内存与编码
+typedef struct
+{
+    eIODP_TYPE* eiodp_fd;
+    uint8 type;         //IODP_TYPE_READADDR 或 IODP_TYPE_FUNCTION
+    uint16 key;         //读地址或者function code
+    uint16 len;         //读长度或者参数长度
+    uint16 framelen;    //整个数据包长度（包头到CRC）
+    uint8* frame;       //编码好的数据包
+    uint8* retbuf;      //返回包缓存
+}eIODP_PREPARED;
+
+/************************************************************
+    @brief:
+        预编码读请求，之后用eiodpPreparedRead反复发送，用于周期轮询同一段地址。
+        句柄不是线程安全的，同一个句柄同时只能有一个线程使用
+    @param:
+        eiodp_fd:eiodp句柄
+        addr,len：与eiodpReadAddr相同
+    @return:
+        句柄，参数错误或者内存不足返回NULL
+*************************************************************/
+eIODP_PREPARED* eiodpPrepareRead(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len);
+
+/************************************************************
+    @brief:
+        预编码函数调用，之后用eiodpPreparedCall反复调用；
+        参数只有少数字节变化时用eiodpPreparedSetArg修改，CRC按变化的字节增量修正
+    @param:
+        eiodp_fd:eiodp句柄
+        code,argsize,arg：与eiodpFunction相同，arg在创建时复制
+    @return:
+        句柄，参数错误、数据包超过IODP_RECV_MAX_LEN或者内存不足返回NULL
+*************************************************************/
+eIODP_PREPARED* eiodpPrepareFunction(eIODP_TYPE* eiodp_fd,uint16 code,uint16 argsize,const void* arg);
+
+/************************************************************
+    @brief:
+        修改预编码函数调用的参数arg[off..off+n)，CRC只按这n个字节增量修正
+    @return:
+        IODP_ERROR_PARAM - 不是函数调用或者超出参数范围
+        0 - 成功
+*************************************************************/
+int eiodpPreparedSetArg(eIODP_PREPARED* prep,uint16 off,const void* data,uint16 n);
+
+/************************************************************
+    @brief:
+        发送预编码的读请求并等待返回，超时、重发与返回值与eiodpReadAddr相同
+*************************************************************/
+int eiodpPreparedRead(eIODP_PREPARED* prep,unsigned char* recvbuf);
+
+/************************************************************
+    @brief:
+        发送预编码的函数调用并等待返回，返回值与eiodpFunction相同
+*************************************************************/
+int eiodpPreparedCall(eIODP_PREPARED* prep,void* retarg);
+
+/************************************************************
+    @brief:
+        释放预编码请求
+*************************************************************/
+void eiodpPreparedFree(eIODP_PREPARED* prep);
+
+
+/************************************************************
+    @brief:
+        设置时钟源。无操作系统下没有时钟源时超时只能按轮询次数估算，
+        设置后超时与RTT都按真实时间计算。linux下设置后同样优先使用。
+    @param:
+        eiodp_fd:eiodp句柄
+        tickfunc：返回当前tick计数，允许32位回绕，NULL取消
+        tickHz：每秒tick数
+*************************************************************/
+void eiodpSetTickSource(eIODP_TYPE* eiodp_fd,uint32 (*tickfunc)(void),uint32 tickHz);
+
+/************************************************************
+    @brief:
+        获取eiodp使用的单调时间，单位us（时钟源同超时与RTT计算）
+*************************************************************/
+unsigned long long eiodpNow(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        获取RTT估计值，单位us
+    @param:
+        eiodp_fd:eiodp句柄
+        op：IODP_RTT_ADDR 或 IODP_RTT_FUNC
+        srtt/rttvar/rto：输出，可以为NULL
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        0 - 成功
+*************************************************************/
+int eiodpGetRtt(eIODP_TYPE* eiodp_fd,int op,uint32* srtt,uint32* rttvar,uint32* rto);
+
+/************************************************************
+    @brief:
+        开启/关闭流量控制（EC05）。
+        开启后发请求前先确认对方接收缓存还有空间：第一次发送时用探测包获取对方的接收窗口，
+        之后对方的每个返回包都会归还对应请求之前占用的额度，只有写操作时额度用完才会再次探测。
+        额度不够时同步接口等待，异步接口返回IODP_ERROR_BUSY。
+        对方不支持EC05（探测IODP_FLOW_PROBE_MAX次没有回应）时自动关闭。
+        对方发给本端的返回包不受限制。
+    @param:
+        eiodp_fd:eiodp句柄
+        enable：1开启 0关闭
+*************************************************************/
+void eiodpSetFlowControl(eIODP_TYPE* eiodp_fd,int enable);
+
+/************************************************************
+    @brief:
+        获取统计快照，统计在各线程中用relaxed原子操作更新，快照中各字段单独一致
+    @param:
+        eiodp_fd:eiodp句柄
+        out：快照
+    @return:
+        IODP_ERROR_PARAM - 参数错误或者没有开启统计
+        0 - 成功
+*************************************************************/
+int eiodpGetMetrics(eIODP_TYPE* eiodp_fd,eIODP_METRICS* out);
+
+/************************************************************
+    @brief:
+        获取统计摘要（直方图压缩为分位数）
+*************************************************************/
+int eiodpGetMetricsSummary(eIODP_TYPE* eiodp_fd,eIODP_METRICS_SUMMARY* out);
+
+/************************************************************
+    @brief:
+        统计清零
+*************************************************************/
+void eiodpResetMetrics(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        通过保留function code获取对方的统计摘要
+    @param:
+        eiodp_fd:eiodp句柄
+        out：对方的统计摘要
+    @return:
+        <0 - 失败（error code）
+         0 - 成功
+*************************************************************/
+int eiodpGetRemoteMetrics(eIODP_TYPE* eiodp_fd,eIODP_METRICS_SUMMARY* out);
+
+/************************************************************
+    @brief:
+        计算直方图分位数
+    @param:
+        h：直方图
+        permille：千分位，如500为中位数，990为p99
+    @return:
+        分位数所在桶的上界，单位us，没有样本返回0
+*************************************************************/
+uint32 eiodpHistPercentile(const eIODP_HIST* h,uint32 permille);
+
+/************************************************************
+    @brief:
+        接收服务函数-任务(无操作系统) 在无操作系统的程序里 需要连续调用
+        每次只读取已经到达的数据（最多IODP_NOS_READ_CHUNK字节）交给解析器，不会等待一个完整的包，
+        没收齐的包保存在句柄中，下次调用继续。
+    @param:
+        eiodp_fd:eiodp句柄
+    @return:
+        -1 - 没有读到数据
+        >=0 - 本次处理完成的数据包个数
+*************************************************************/
+int eiodp_recvProcessTask_nos(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        无操作系统、没有io接口时使用：输入收到的数据，输出需要发送的数据。
+        inbuf可以是任意切分的字节流，不完整的包保存在句柄中，下次调用继续解析。
+        处理过程中产生的返回包写入outbuf，由调用者发送。函数不阻塞，不分配内存。
+        eiodp_init的读写函数可以为NULL。
+        注意：服务函数中不能再调用eiodpReadAddr等同步请求。
+    @param:
+        eiodp_fd:eiodp句柄
+        inbuf：收到的数据
+        inlen：数据长度，可以为0
+        outbuf：输出缓存
+        outcap：输出缓存大小，放不下的返回包会被丢弃，建议不小于IODP_RECV_MAX_LEN
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        >=0 - 写入outbuf的字节数
+*************************************************************/
+int eiodp_process(eIODP_TYPE* eiodp_fd, unsigned char* inbuf, int inlen,
+                    unsigned char* outbuf, int outcap);
+
+/************************************************************
+    @brief:
+        异步读地址。发出请求后立即返回，结果通过回调给出。
+        无操作系统下回调与超时重发都在eiodp_recvProcessTask_nos/eiodp_process中处理；
+        linux下在接收处理任务中处理，回调运行在接收处理任务的线程里，不能阻塞。
+        多个请求可以同时在途，返回包按地址与长度匹配。协议中没有请求编号，
+        所以同一地址同一长度的读请求同时只能有一个在途。
+    @param:
+        eiodp_fd:eiodp句柄
+        addr：读取地址
+        len：数据长度
+        cb：完成回调
+        ctx：回调的用户参数
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        IODP_ERROR_BUSY - 同时在途的请求已达IODP_PENDING_MAX，或者相同的读请求还没完成，或者流量控制额度不足
+        0 - 已发出
+*************************************************************/
+int eiodpReadAddrAsync(eIODP_TYPE* eiodp_fd,unsigned short addr,unsigned short len,
+                eIODP_DONE_CB cb,void* ctx);
+
+/************************************************************
+    @brief:
+        异步调用服务函数，回调的线程同eiodpReadAddrAsync。返回包按function code匹配，
+        同一个function code同时只能有一个在途。与eiodpFunction一致，超时不重发。
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        IODP_ERROR_BUSY - 同时在途的请求已达IODP_PENDING_MAX，或者同一个code的请求还没完成，或者流量控制额度不足
+        IODP_ERROR_HEAPOVER - 内存不足
+        0 - 已发出
+*************************************************************/
+int eiodpFunctionAsync(eIODP_TYPE* eiodp_fd, uint16 code, uint16 argsize, void* arg,
+                eIODP_DONE_CB cb,void* ctx);
+
+/************************************************************
+    @brief:
+        获取在途的异步请求个数
+*************************************************************/
+int eiodpPendingCount(eIODP_TYPE* eiodp_fd);
+
+/************************************************************
+    @brief:
+        取消在途的异步请求，按发起时的cb与ctx查找，取消后不再调用回调。
+        linux下返回没有找到时，回调已经调用或者正在接收处理任务中调用。
+        表项再保留一个RTO，期间到达的迟到返回被丢弃，不会当成下一个相同请求的结果，
+        所以取消后立即发起相同的请求仍然可能返回IODP_ERROR_BUSY
+    @param:
+        eiodp_fd:eiodp句柄
+        cb,ctx：发起请求时的回调与用户参数
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者没有找到（已经完成或者已经超时）
+        0 - 已取消
+*************************************************************/
+int eiodpCancel(eIODP_TYPE* eiodp_fd,eIODP_DONE_CB cb,void* ctx);
+
+
+int checkpktcrc(unsigned char* data,unsigned int size);
+int updatepktcrc(unsigned char* data,unsigned int size);
+
+void crc32_init();
+unsigned long crc32(void* input, int len);
+//分段计算crc32：crc从0xFFFFFFFF开始，逐段累加，最后异或0xFFFFFFFF
+unsigned long crc32_update(unsigned long crc, const void* input, int len);
+
+//total字节数据的CRC为crc，其中[off,off+n)从olddata改为newdata后的CRC
+uint32 crc32_patch(uint32 crc, uint32 total, uint32 off, const uint8* olddata, const uint8* newdata, uint32 n);
+
+
+
+//-----------------------------------------------------------------------------------
+//                               eiodp ring buffer
+//
+
+eIODP_RING* creat_ring(uint32 size);
+
+void delate_ring(eIODP_RING* p);
+
+int put_ring(eIODP_RING* p,uint8* buf,uint32 size);
+int get_ring(eIODP_RING* p,uint8* buf,uint32 size);
+uint16 size_ring(eIODP_RING* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef _EIODP_HPP_
+#define _EIODP_HPP_
+
+/*
+    eiodp的C++17封装，只有头文件。
+        eiodp::Device：句柄的RAII封装，析构时调用eiodp_deinit
+        eiodp::Codec<T>：类型的线上编码，长度在编译期确定，整数与浮点按大端，与协议字节序一致
+        eiodp::Function<code,Arg,Res>：把function code与参数、返回类型绑定
+        eiodp::call<F>(dev,arg,res)：参数在栈上编码，用eiodpFunctionEx发出，不申请内存，
+            返回比Res的编码长时返回IODP_ERROR_RETSIZE，短时返回IODP_ERROR_RECVLEN
+        eiodp::serve<F,handler>(dev)：把int handler(const Arg&,Res&)注册为F::code的服务函数，
+            参数长度不对或者handler返回<0时返回0字节，调用方得到IODP_ERROR_RECVLEN
+    支持的类型：整数、枚举、bool、float、double、std::array、std::pair、std::tuple、eiodp::None（没有数据），
+    以及用eiodp_fields列出成员的结构体，成员按列出的顺序紧密排列，没有对齐填充：
+        struct Cmd
+        {
+            uint16 speed;
+            int8_t dir;
+            static constexpr auto eiodp_fields = std::make_tuple(&Cmd::speed,&Cmd::dir);
+        };
+    参数与返回的长度在编译期检查，超过数据包或者IODP_FUNCPKT_RET_LEN时编译出错。
+*/
+
+#include "eiodp.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace eiodp {
+
+//没有参数或者没有返回
+struct None {};
+
+template<class T, class = void>
+struct Codec;
+
+namespace detail {
+
+template<class T, bool = std::is_enum<T>::value>
+struct Unsigned { using type = std::make_unsigned_t<T>; };
+template<class T>
+struct Unsigned<T,true> { using type = std::make_unsigned_t<std::underlying_type_t<T>>; };
+
+template<class U>
+inline void putBE(unsigned char* p, U v)
+{
+    for(std::size_t i=sizeof(U);i>0;i--){
+        p[i-1] = (unsigned char)v;
+        v = (U)(v>>8);
+    }
+}
+
+template<class U>
+inline U getBE(const unsigned char* p)
+{
+    U v = 0;
+    for(std::size_t i=0;i<sizeof(U);i++)v = (U)((v<<8)|p[i]);
+    return v;
+}
+
+template<class P> struct MemberOf;
+template<class C, class M> struct MemberOf<M C::*> { using type = M; };
+
+template<class Tup> struct FieldsSize;
+template<class... P>
+struct FieldsSize<std::tuple<P...>>
+{
+    static constexpr std::size_t value = (std::size_t(0) + ... + Codec<typename MemberOf<P>::type>::size);
+};
+
+template<class... T>
+struct TupleSize { static constexpr std::size_t value = (std::size_t(0) + ... + Codec<T>::size); };
+
+} // namespace detail
+
+//整数与枚举
+template<class T>
+struct Codec<T, std::enable_if_t<(std::is_integral<T>::value || std::is_enum<T>::value) &&
+                                 !std::is_same<T,bool>::value>>
+{
+    using U = typename detail::Unsigned<T>::type;
+    static constexpr std::size_t size = sizeof(T);
+    static void encode(unsigned char* p, const T& v) { detail::putBE<U>(p,(U)v); }
+    static void decode(const unsigned char* p, T& v) { v = (T)detail::getBE<U>(p); }
+};
+
+template<>
+struct Codec<bool>
+{
+    static constexpr std::size_t size = 1;
+    static void encode(unsigned char* p, const bool& v) { p[0] = v ? 1 : 0; }
+    static void decode(const unsigned char* p, bool& v) { v = p[0] != 0; }
+};
+
+//浮点按位模式编码
+template<class T>
+struct Codec<T, std::enable_if_t<std::is_floating_point<T>::value>>
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "只支持32/64位浮点");
+    using U = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    static constexpr std::size_t size = sizeof(T);
+    static void encode(unsigned char* p, const T& v)
+    {
+        U u;
+        std::memcpy(&u,&v,sizeof(u));
+        detail::putBE<U>(p,u);
+    }
+    static void decode(const unsigned char* p, T& v)
+    {
+        U u = detail::getBE<U>(p);
+        std::memcpy(&v,&u,sizeof(v));
+    }
+};
+
+template<>
+struct Codec<None>
+{
+    static constexpr std::size_t size = 0;
+    static void encode(unsigned char*, const None&) {}
+    static void decode(const unsigned char*, None&) {}
+};
+
+template<class T, std::size_t N>
+struct Codec<std::array<T,N>>
+{
+    static constexpr std::size_t size = N*Codec<T>::size;
+    static void encode(unsigned char* p, const std::array<T,N>& v)
+    {
+        for(std::size_t i=0;i<N;i++)Codec<T>::encode(p+i*Codec<T>::size,v[i]);
+    }
+    static void decode(const unsigned char* p, std::array<T,N>& v)
+    {
+        for(std::size_t i=0;i<N;i++)Codec<T>::decode(p+i*Codec<T>::size,v[i]);
+    }
+};
+
+template<class... T>
+struct Codec<std::tuple<T...>>
+{
+    static constexpr std::size_t size = detail::TupleSize<T...>::value;
+    static void encode(unsigned char* p, const std::tuple<T...>& v)
+    {
+        std::apply([p](const T&... e){
+            std::size_t off = 0;
+            ((Codec<T>::encode(p+off,e), off += Codec<T>::size), ...);
+        },v);
+    }
+    static void decode(const unsigned char* p, std::tuple<T...>& v)
+    {
+        std::apply([p](T&... e){
+            std::size_t off = 0;
+            ((Codec<T>::decode(p+off,e), off += Codec<T>::size), ...);
+        },v);
+    }
+};
+
+template<class A, class B>
+struct Codec<std::pair<A,B>>
+{
+    static constexpr std::size_t size = Codec<A>::size+Codec<B>::size;
+    static void encode(unsigned char* p, const std::pair<A,B>& v)
+    {
+        Codec<A>::encode(p,v.first);
+        Codec<B>::encode(p+Codec<A>::size,v.second);
+    }
+    static void decode(const unsigned char* p, std::pair<A,B>& v)
+    {
+        Codec<A>::decode(p,v.first);
+        Codec<B>::decode(p+Codec<A>::size,v.second);
+    }
+};
+
+//用eiodp_fields列出成员的结构体
+template<class T>
+struct Codec<T, std::void_t<decltype(T::eiodp_fields)>>
+{
+    static constexpr std::size_t size = detail::FieldsSize<std::remove_cv_t<decltype(T::eiodp_fields)>>::value;
+    static void encode(unsigned char* p, const T& v)
+    {
+        std::apply([p,&v](auto... mp){
+            std::size_t off = 0;
+            ((Codec<std::decay_t<decltype(v.*mp)>>::encode(p+off,v.*mp),
+              off += Codec<std::decay_t<decltype(v.*mp)>>::size), ...);
+        },T::eiodp_fields);
+    }
+    static void decode(const unsigned char* p, T& v)
+    {
+        std::apply([p,&v](auto... mp){
+            std::size_t off = 0;
+            ((Codec<std::decay_t<decltype(v.*mp)>>::decode(p+off,v.*mp),
+              off += Codec<std::decay_t<decltype(v.*mp)>>::size), ...);
+        },T::eiodp_fields);
+    }
+};
+
+//function code与参数、返回类型
+template<uint16 Code, class Arg = None, class Res = None>
+struct Function
+{
+    using arg_type = Arg;
+    using result_type = Res;
+    static constexpr uint16 code = Code;
+    static constexpr std::size_t argSize = Codec<Arg>::size;
+    static constexpr std::size_t resSize = Codec<Res>::size;
+    static_assert(IODP_FUNC_FRAMELEN(argSize) <= IODP_RECV_MAX_LEN, "参数超过IODP_RECV_MAX_LEN");
+    static_assert(resSize+14 <= IODP_FUNCPKT_RET_LEN, "返回超过IODP_FUNCPKT_RET_LEN");
+};
+
+//eiodp句柄，只能移动
+class Device
+{
+public:
+    Device() = default;
+    Device(unsigned int fd, int (*readfunc)(int, char*, int), int (*writefunc)(int, char*, int))
+        : h_(eiodp_init(fd,readfunc,writefunc)) {}
+    explicit Device(eIODP_TYPE* h) : h_(h) {}
+    ~Device() { eiodp_deinit(h_); }
+
+    Device(const Device&) = delete;
+    Device& operator=(const Device&) = delete;
+    Device(Device&& o) noexcept : h_(o.h_) { o.h_ = nullptr; }
+    Device& operator=(Device&& o) noexcept
+    {
+        if(this != &o){
+            eiodp_deinit(h_);
+            h_ = o.h_;
+            o.h_ = nullptr;
+        }
+        return *this;
+    }
+
+    eIODP_TYPE* get() const { return h_; }
+    operator eIODP_TYPE*() const { return h_; }
+    //放弃所有权，返回的句柄由调用者释放
+    eIODP_TYPE* release()
+    {
+        eIODP_TYPE* h = h_;
+        h_ = nullptr;
+        return h;
+    }
+
+private:
+    eIODP_TYPE* h_ = nullptr;
+};
+
+//调用F，成功返回IODP_OK并解码到res，其他同eiodpFunctionEx
+template<class F>
+int call(eIODP_TYPE* dev, const typename F::arg_type& arg, typename F::result_type& res)
+{
+    unsigned char frame[IODP_FUNC_FRAMELEN(F::argSize)];
+    unsigned char ret[F::resSize ? F::resSize : 1];
+    Codec<typename F::arg_type>::encode(&frame[10],arg);
+    int r = eiodpFunctionEx(dev,F::code,(uint16)F::argSize,&frame[10],ret,(uint16)F::resSize,frame);
+    if(r < 0)return r;
+    if((std::size_t)r != F::resSize)return IODP_ERROR_RECVLEN;
+    Codec<typename F::result_type>::decode(ret,res);
+    return IODP_OK;
+}
+
+//没有返回的F
+template<class F>
+int call(eIODP_TYPE* dev, const typename F::arg_type& arg = typename F::arg_type())
+{
+    static_assert(F::resSize == 0, "F有返回，使用call(dev,arg,res)");
+    None none;
+    return call<F>(dev,arg,none);
+}
+
+namespace detail {
+
+template<class F, auto Handler>
+int trampoline(uint16 len, void* data, uint16* retlen, void* retdata)
+{
+    typename F::arg_type arg{};
+    typename F::result_type res{};
+    *retlen = 0;
+    if(len != F::argSize)return IODP_ERROR_RECVLEN;
+    Codec<typename F::arg_type>::decode((const unsigned char*)data,arg);
+    int r = Handler(arg,res);
+    if(r < 0)return r;
+    Codec<typename F::result_type>::encode((unsigned char*)retdata,res);
+    *retlen = (uint16)F::resSize;
+    return IODP_OK;
+}
+
+} // namespace detail
+
+//注册F的服务函数，Handler为int(const Arg&,Res&)，返回值同eiodpRegister
+template<class F, auto Handler>
+int serve(eIODP_TYPE* dev)
+{
+    static_assert(std::is_invocable_r<int,decltype(Handler),const typename F::arg_type&,
+                                      typename F::result_type&>::value,
+                  "Handler应为int(const Arg&,Res&)");
+    return eiodpRegister(dev,F::code,&detail::trampoline<F,Handler>);
+}
+
+} // namespace eiodp
+
+#endif
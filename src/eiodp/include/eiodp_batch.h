@@ -0,0 +1,141 @@
+#ifndef _EIODPBATCH_H_
+#define _EIODPBATCH_H_
+
+/*
+    eiodp客户端批量读写。
+    应用对相邻或重叠的小地址段频繁读写时，先把操作缓存一段时间再一起发出：
+        写：写到本地影子空间，同一字节多次写入只保留最后一次，发出时按连续的脏区间用多段写(EC07)
+        读：先登记，发出时按地址排序，相邻、重叠或间隔不超过IODP_BATCH_GAP的读合并成一段，
+            再用多段读(EC06)一起读回，分发到各自的缓存
+    以下情况发出缓存的操作：
+        缓存字节数达到阈值
+        第一个缓存的操作已经等待超过窗口时间（在每次调用批量接口或者eiodpBatchPoll时检查）
+        调用eiodpBatchFlush（屏障）
+    顺序：发出时先写后读，读总能看到之前的写；写入与还没发出的读重叠时先把缓存发出，
+    读不会看到程序顺序在它之后的写。
+    缓存的读在发出之前buf与status都不可用。
+    批量句柄不是线程安全的，每个线程使用自己的句柄；与直接调用eiodpReadAddr等接口混用时，
+    先调用eiodpBatchFlush。
+*/
+
+#include "eiodp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//单个批量句柄最多缓存的读操作个数，超出时先发出
+#define IODP_BATCH_MAXREAD 64
+//合并读时允许跨过的空隙字节数，空隙部分会被多读回来
+#define IODP_BATCH_GAP 8
+//合并后单段最大长度（受返回缓存限制）
+#define IODP_BATCH_MAXSPAN (IODP_RETURN_BUFFER-16)
+//读操作还没有发出时的status
+#define IODP_BATCH_PENDING 0x10000
+
+//批量统计
+typedef struct
+{
+    uint32 reads;           //缓存的读操作
+    uint32 writes;          //缓存的写操作
+    uint32 wireReads;       //实际发出的多段读请求
+    uint32 wireWrites;      //实际发出的多段写请求
+    uint32 writeBytes;      //应用写入的字节
+    uint32 wireWriteBytes;  //合并后实际写出的字节
+    uint32 flushes;         //发出次数
+}eIODP_BATCH_STAT;
+
+typedef struct
+{
+    uint16 addr;
+    uint16 len;
+    unsigned char* buf;
+    int* status;
+}eIODP_BATCH_READ;
+
+typedef struct
+{
+    eIODP_TYPE* eiodp_fd;
+    uint32 window_us;       //缓存窗口
+    uint32 threshold;       //缓存字节阈值
+    unsigned long long firstTime;   //第一个缓存操作的时间
+    uint32 pendingBytes;    //缓存的读写字节
+    uint32 dirtyCnt;        //脏字节数
+    uint8 shadow[IODP_CONFIGMEM_SIZE];
+    uint8 dirty[(IODP_CONFIGMEM_SIZE+7)/8];
+    int readCnt;
+    eIODP_BATCH_READ read[IODP_BATCH_MAXREAD];
+    eIODP_BATCH_STAT stat;
+}eIODP_BATCH;
+
+/************************************************************
+    @brief:
+        创建批量读写句柄
+    @param:
+        eiodp_fd:eiodp句柄
+        window_us：缓存窗口，第一个操作缓存超过这个时间后发出，0为每次调用都立即发出
+        threshold：缓存的读写字节达到这个值后发出，0按IODP_BATCH_MAXSPAN
+    @return:
+        句柄，内存不足返回NULL
+*************************************************************/
+eIODP_BATCH* eiodpBatchCreate(eIODP_TYPE* eiodp_fd,uint32 window_us,uint32 threshold);
+
+/************************************************************
+    @brief:
+        发出缓存的操作并释放句柄
+*************************************************************/
+void eiodpBatchDestroy(eIODP_BATCH* b);
+
+/************************************************************
+    @brief:
+        缓存一个写操作。超出配置空间的写先发出缓存，再直接用eiodpWriteAddr发送
+        发出出错时缓存同样被清空，本次的写照常登记
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        <0 - 这次调用触发了发出，发出时出错
+        0 - 成功
+*************************************************************/
+int eiodpBatchWrite(eIODP_BATCH* b,uint16 addr,uint16 len,const unsigned char* data);
+
+/************************************************************
+    @brief:
+        缓存一个读操作，发出后数据写入buf，结果写入status
+    @param:
+        buf：数据缓存，发出之前必须保持有效
+        status：可以为NULL，缓存期间为IODP_BATCH_PENDING，
+                完成后为读到的长度或者错误码（同eiodpReadMulti）
+        超出配置空间的读先发出缓存，再直接用eiodpReadAddr同步读取
+        发出出错时缓存同样被清空，本次的读照常登记
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者len超过IODP_BATCH_MAXSPAN
+        <0 - 这次调用触发了发出，发出时出错
+        0 - 成功
+*************************************************************/
+int eiodpBatchRead(eIODP_BATCH* b,uint16 addr,uint16 len,unsigned char* buf,int* status);
+
+/************************************************************
+    @brief:
+        屏障：发出全部缓存的操作，返回时所有缓存的读都已经完成
+    @return:
+        0 - 全部成功
+        <0 - 第一个失败的错误码
+*************************************************************/
+int eiodpBatchFlush(eIODP_BATCH* b);
+
+/************************************************************
+    @brief:
+        检查缓存窗口，超时则发出，应用空闲时周期调用
+*************************************************************/
+int eiodpBatchPoll(eIODP_BATCH* b);
+
+/************************************************************
+    @brief:
+        获取批量统计
+*************************************************************/
+void eiodpBatchGetStat(eIODP_BATCH* b,eIODP_BATCH_STAT* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef _EIODPCACHE_H_
+#define _EIODPCACHE_H_
+
+/*
+    eiodp客户端镜像缓存。
+    在本地按块（IODP_CFG_BLOCK字节，与对方的块版本一致）镜像对方的配置空间，每块记录是否有效与填充时间：
+        读：范围内的块都有效并且没有超过有效期时直接从本地返回；否则用eiodpReadAddr
+            按整块读回过期的块，顺序读（本次从上次读的结尾开始）时再多读prefetch块
+        写：写穿，先用eiodpWriteAddr发出，再更新本地镜像；完全覆盖的块变为有效，
+            部分覆盖的块只有原来有效时才更新
+    对方自己或者其他主设备修改的数据在有效期内看不到，需要时调用eiodpCacheInvalidate/eiodpCacheRefresh。
+    eiodpWriteAddr没有确认，写丢失时镜像与对方不一致，直到有效期过去或者调用刷新；
+    需要确认时对句柄开启可靠写（eiodpSetReliableWrite）。
+    缓存句柄不是线程安全的，每个线程使用自己的句柄。
+*/
+
+#include "eiodp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//一次读回的最大长度（受返回缓存限制），过期的块多于这个长度时分多次读
+#define IODP_CACHE_MAXFETCH (IODP_RETURN_BUFFER/2)
+
+//缓存统计
+typedef struct
+{
+    uint32 reads;           //eiodpCacheRead调用次数
+    uint32 hits;            //全部从本地返回的读
+    uint32 wireReads;       //实际发出的读请求
+    uint32 wireBytes;       //读回的字节
+    uint32 prefetchBlocks;  //因为顺序读多读的块
+    uint32 writes;          //写穿次数
+}eIODP_CACHE_STAT;
+
+typedef struct
+{
+    eIODP_TYPE* eiodp_fd;
+    uint32 maxAge_us;       //块有效期，0为一直有效（只能手动失效）
+    uint16 prefetch;        //顺序读时多读的块数
+    uint32 lastEnd;         //上一次读的结尾地址，用于识别顺序读
+    uint8 mirror[IODP_CONFIGMEM_SIZE];
+    uint8 valid[IODP_CFG_NBLOCK];
+    unsigned long long fillTime[IODP_CFG_NBLOCK];
+    eIODP_CACHE_STAT stat;
+}eIODP_CACHE;
+
+/************************************************************
+    @brief:
+        创建镜像缓存，创建时全部块无效
+    @param:
+        eiodp_fd:eiodp句柄
+        maxAge_us：块有效期，0为一直有效
+        prefetch：顺序读时多读的块数，0为不预读
+    @return:
+        句柄，内存不足返回NULL
+*************************************************************/
+eIODP_CACHE* eiodpCacheCreate(eIODP_TYPE* eiodp_fd,uint32 maxAge_us,uint16 prefetch);
+
+/************************************************************
+    @brief:
+        释放缓存句柄
+*************************************************************/
+void eiodpCacheDestroy(eIODP_CACHE* c);
+
+/************************************************************
+    @brief:
+        读取，块都有效时从本地返回，否则读回过期的块。超出配置空间的读直接用eiodpReadAddr
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        <0 - 读回时出错（同eiodpReadAddr），buf没有修改
+        >=0 - 读到的长度
+*************************************************************/
+int eiodpCacheRead(eIODP_CACHE* c,uint16 addr,uint16 len,unsigned char* buf);
+
+/************************************************************
+    @brief:
+        写穿：eiodpWriteAddr发出后更新本地镜像
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        0 - 成功
+*************************************************************/
+int eiodpCacheWrite(eIODP_CACHE* c,uint16 addr,uint16 len,const unsigned char* data);
+
+/************************************************************
+    @brief:
+        使范围内的块失效，下一次读取时从对方读回
+    @param:
+        addr,len：范围，len为0时全部失效
+*************************************************************/
+void eiodpCacheInvalidate(eIODP_CACHE* c,uint16 addr,uint16 len);
+
+/************************************************************
+    @brief:
+        立即从对方读回范围内的块，不管是否有效
+    @param:
+        buf：可以为NULL，不为NULL时返回范围内的数据
+    @return:
+        <0 - 读回时出错
+        >=0 - 范围长度
+*************************************************************/
+int eiodpCacheRefresh(eIODP_CACHE* c,uint16 addr,uint16 len,unsigned char* buf);
+
+/************************************************************
+    @brief:
+        获取缓存统计
+*************************************************************/
+void eiodpCacheGetStat(eIODP_CACHE* c,eIODP_CACHE_STAT* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
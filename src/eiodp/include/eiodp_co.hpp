@@ -0,0 +1,640 @@
+#ifndef _EIODP_CO_HPP_
+#define _EIODP_CO_HPP_
+
+/*
+    eiodp的C++20协程封装，只有头文件，在无操作系统（IODP_OS_NULL）与linux构建中提供。
+    建立在异步请求接口（eiodpReadAddrAsync/eiodpFunctionAsync）之上，一个线程可以同时进行
+    大量设备会话，不需要每个会话一个线程：
+        eiodp::co::Task<T>：协程的返回类型，可以co_await另一个Task
+        eiodp::co::Executor：执行器，spawn启动顶层协程，run运行到全部结束。
+            无操作系统下attach的句柄由poll调用eiodp_recvProcessTask_nos驱动，返回包在接收路径中完成请求，
+            协程在poll返回前恢复；linux下句柄由自己的接收处理任务驱动（attach不需要），返回包在接收处理任务中
+            完成请求，结果放进执行器的完成队列并用信号量唤醒执行器，poll在没有就绪的协程时等信号量或者最近的期限
+        co_await eiodp::co::read(dev,addr,len,buf,opt)：异步读，结果同eiodpReadAddr
+        co_await eiodp::co::function(dev,code,argsize,arg,ret,retcap,opt)：异步调用，结果同eiodpFunctionEx
+        co_await eiodp::co::call<F>(dev,arg,res,opt)：类型化调用，结果同eiodp::call<F>
+        co_await eiodp::co::sleep(us,opt)：等待一段时间
+    每次等待可以设置选项AwaitOpt：
+        timeout_us：本次等待的期限，到期返回IODP_ERROR_TIMEOUT并取消请求（eiodpCancel）。
+            库本身按RTO的超时仍然有效，先到的一个生效
+        cancel：CancelSource，调用cancel()后登记在上面的等待都返回IODP_ERROR_CANCELED，
+            之后开始的等待立即返回IODP_ERROR_CANCELED
+    异步请求表满、或者相同的请求（同地址同长度的读，同一个function code）在途时，请求在执行器中排队，
+    每次poll按顺序重新发出，不返回IODP_ERROR_BUSY。
+    执行器与协程只能在一个线程中使用；销毁执行器之前要run到全部协程结束，CancelSource要活到登记的等待结束。
+*/
+
+#include "eiodp.hpp"
+
+#if (IODP_OS==IODP_OS_NULL || IODP_OS==IODP_OS_LINUX)
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+#if (IODP_OS==IODP_OS_LINUX)
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <semaphore.h>
+#include <time.h>
+#endif
+
+namespace eiodp {
+namespace co {
+
+class Executor;
+class CancelSource;
+template<class T = void> class Task;
+
+//一次等待的选项
+struct AwaitOpt
+{
+    uint32 timeout_us = 0;          //0为不设期限
+    CancelSource* cancel = nullptr;
+};
+
+namespace detail {
+
+//等待中的请求，存放在协程帧里（等待对象在挂起期间一直有效）
+struct Op
+{
+    enum State { Idle, Queued, InFlight, Done };
+    eIODP_TYPE* dev = nullptr;
+    uint8 type = 0;                 //IODP_TYPE_READADDR、IODP_TYPE_FUNCTION，0为只等待时间
+    uint16 key = 0;                 //读地址或者function code
+    uint16 len = 0;                 //读长度或者参数长度
+    const void* arg = nullptr;
+    unsigned char* out = nullptr;
+    uint16 cap = 0;
+    AwaitOpt opt;
+    int status = 0;
+    State state = Idle;
+    Executor* ex = nullptr;
+    std::coroutine_handle<> h;
+    bool hasTimer = false;
+    std::multimap<unsigned long long,Op*>::iterator timer;
+    std::list<Op*>::iterator qpos;  //排队位置
+    std::list<Op*>::iterator cpos;  //在CancelSource中的位置
+#if (IODP_OS==IODP_OS_LINUX)
+    std::uintptr_t token = 0;       //在途请求的编号，作为回调的ctx
+#endif
+
+    static void onDone(void* ctx, int status, unsigned char* data, int len);
+};
+
+#if (IODP_OS==IODP_OS_LINUX)
+//在途请求登记表：回调在接收处理任务中执行，ctx用编号而不是Op地址，
+//等待被期限或者取消结束后Op所在的协程帧可能已经释放，迟到的回调查不到编号就什么都不做
+struct Registry
+{
+    std::mutex mu;
+    std::unordered_map<std::uintptr_t,Op*> ops;
+    std::uintptr_t next = 1;
+
+    static Registry& get()
+    {
+        static Registry r;
+        return r;
+    }
+};
+#endif
+
+struct PromiseBase
+{
+    std::coroutine_handle<> cont;   //co_await这个Task的协程
+    Executor* root = nullptr;       //顶层协程所属的执行器
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept { return false; }
+        template<class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept;
+        void await_resume() noexcept {}
+    };
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+
+template<class T>
+struct Promise : PromiseBase
+{
+    T value{};
+    Task<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+};
+
+template<>
+struct Promise<void> : PromiseBase
+{
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+//read/function/sleep的等待对象
+class OpAwaiter
+{
+public:
+    OpAwaiter() = default;
+    OpAwaiter(const OpAwaiter&) = delete;
+    OpAwaiter& operator=(const OpAwaiter&) = delete;
+
+    bool await_ready() const noexcept { return op.state == Op::Done; }
+    bool await_suspend(std::coroutine_handle<> h);
+    int await_resume() const noexcept { return op.status; }
+
+protected:
+    Op op;
+};
+
+} // namespace detail
+
+//协程返回类型，创建后不立即运行，co_await或者Executor::spawn时开始
+template<class T>
+class Task
+{
+public:
+    using promise_type = detail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    Task(Task&& o) noexcept : h_(std::exchange(o.h_,{})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if(h_)h_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) noexcept
+    {
+        h_.promise().cont = cont;
+        return h_;
+    }
+    T await_resume()
+    {
+        if constexpr(!std::is_void<T>::value)return std::move(h_.promise().value);
+    }
+
+    std::coroutine_handle<promise_type> release() { return std::exchange(h_,{}); }
+
+private:
+    std::coroutine_handle<promise_type> h_;
+};
+
+template<class T>
+inline Task<T> detail::Promise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+//取消：cancel()之后登记在上面的等待返回IODP_ERROR_CANCELED
+class CancelSource
+{
+public:
+    CancelSource() = default;
+    CancelSource(const CancelSource&) = delete;
+    CancelSource& operator=(const CancelSource&) = delete;
+
+    void cancel();
+    bool cancelled() const { return cancelled_; }
+
+private:
+    friend class Executor;
+    bool cancelled_ = false;
+    std::list<detail::Op*> ops_;
+};
+
+class Executor
+{
+public:
+#if (IODP_OS==IODP_OS_LINUX)
+    Executor() { sem_init(&wake_,0,0); }
+    ~Executor() { sem_destroy(&wake_); }
+#else
+    Executor() = default;
+#endif
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    //由poll驱动接收的句柄，linux下句柄有自己的接收处理任务，只是登记
+    void attach(eIODP_TYPE* dev) { devs_.push_back(dev); }
+
+    //启动顶层协程，在下一次poll中开始运行，结束后自动释放
+    template<class T>
+    void spawn(Task<T> t)
+    {
+        auto h = t.release();
+        h.promise().root = this;
+        live_++;
+        ready_.push_back(h);
+    }
+
+    /************************************************************
+        @brief:
+            处理一轮：驱动各句柄的接收，重新发出排队的请求，处理到期的等待，恢复就绪的协程。
+            linux下没有就绪的协程时先等完成队列的信号量，最长到最近的期限，
+            不超过10ms，有排队的请求时不超过1ms
+        @return:
+            本轮恢复的协程个数
+    *************************************************************/
+    int poll()
+    {
+        Executor*& cur = current();
+        Executor* prev = cur;
+        cur = this;
+#if (IODP_OS==IODP_OS_LINUX)
+        if(ready_.empty())wait();
+        drain();
+#else
+        for(eIODP_TYPE* dev : devs_)eiodp_recvProcessTask_nos(dev);
+#endif
+        for(auto it = busy_.begin(); it != busy_.end();){
+            detail::Op* op = *it;
+            int r = issue(op);
+            if(r == IODP_ERROR_BUSY){++it;continue;}
+            it = busy_.erase(it);
+            op->state = detail::Op::InFlight;
+            if(r < 0)complete(op,r);
+        }
+        unsigned long long t = now();
+        while(!timers_.empty() && timers_.begin()->first <= t){
+            detail::Op* op = timers_.begin()->second;
+            abort(op,op->type ? IODP_ERROR_TIMEOUT : IODP_OK);
+        }
+        int n = 0;
+        while(!ready_.empty()){
+            std::coroutine_handle<> h = ready_.front();
+            ready_.pop_front();
+            h.resume();
+            n++;
+        }
+        cur = prev;
+        return n;
+    }
+
+    //运行到全部顶层协程结束
+    void run() { while(live_ > 0)poll(); }
+
+    //还没有结束的顶层协程个数
+    int live() const { return live_; }
+    //排队等待发出的请求个数
+    int queued() const { return (int)busy_.size(); }
+
+    //等待期限使用的时钟，单位us
+    static unsigned long long now()
+    {
+        return (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //正在poll的执行器
+    static Executor*& current()
+    {
+        thread_local Executor* ex = nullptr;
+        return ex;
+    }
+
+private:
+    friend class CancelSource;
+    friend struct detail::Op;
+    friend class detail::OpAwaiter;
+    friend struct detail::PromiseBase::FinalAwaiter;
+
+#if (IODP_OS==IODP_OS_LINUX)
+    //先登记再发出，返回可能在发出函数返回之前就到了
+    static int issue(detail::Op* op)
+    {
+        detail::Registry& reg = detail::Registry::get();
+        {
+            std::lock_guard<std::mutex> lk(reg.mu);
+            op->token = reg.next++;
+            reg.ops[op->token] = op;
+        }
+        void* ctx = (void*)op->token;
+        int r;
+        if(op->type == IODP_TYPE_READADDR)
+            r = eiodpReadAddrAsync(op->dev,op->key,op->len,&detail::Op::onDone,ctx);
+        else r = eiodpFunctionAsync(op->dev,op->key,op->len,(void*)op->arg,&detail::Op::onDone,ctx);
+        if(r < 0){
+            std::lock_guard<std::mutex> lk(reg.mu);
+            reg.ops.erase(op->token);
+        }
+        return r;
+    }
+
+    //没有就绪的协程时等完成队列，最长到最近的期限
+    void wait()
+    {
+        unsigned long long us = busy_.empty() ? 10000 : 1000;
+        if(!timers_.empty()){
+            unsigned long long t = now();
+            unsigned long long left = (timers_.begin()->first > t) ? timers_.begin()->first - t : 0;
+            if(left < us)us = left;
+        }
+        if(us == 0)return;
+        struct timespec tv;
+        clock_gettime(CLOCK_REALTIME,&tv);
+        unsigned long long ns = (unsigned long long)tv.tv_nsec + us*1000ULL;
+        tv.tv_sec += ns/1000000000ULL;
+        tv.tv_nsec = ns%1000000000ULL;
+        sem_timedwait(&wake_,&tv);
+    }
+
+    //取出接收处理任务完成的请求
+    void drain()
+    {
+        std::vector<std::pair<detail::Op*,int>> done;
+        {
+            std::lock_guard<std::mutex> lk(detail::Registry::get().mu);
+            done.swap(done_);
+        }
+        for(auto& d : done)complete(d.first,d.second);
+    }
+#else
+    static int issue(detail::Op* op)
+    {
+        if(op->type == IODP_TYPE_READADDR)
+            return eiodpReadAddrAsync(op->dev,op->key,op->len,&detail::Op::onDone,op);
+        return eiodpFunctionAsync(op->dev,op->key,op->len,(void*)op->arg,&detail::Op::onDone,op);
+    }
+#endif
+
+    //开始等待，返回false时已经完成，不挂起
+    bool start(detail::Op* op)
+    {
+        if(op->opt.cancel && op->opt.cancel->cancelled()){
+            op->status = IODP_ERROR_CANCELED;
+            op->state = detail::Op::Done;
+            return false;
+        }
+        if(op->type == 0){
+            op->state = detail::Op::InFlight;
+        }
+        else{
+            int r = issue(op);
+            if(r == IODP_ERROR_BUSY){
+                op->state = detail::Op::Queued;
+                op->qpos = busy_.insert(busy_.end(),op);
+            }
+            else if(r < 0){
+                op->status = r;
+                op->state = detail::Op::Done;
+                return false;
+            }
+            else op->state = detail::Op::InFlight;
+        }
+        if(op->opt.timeout_us || op->type == 0){
+            op->timer = timers_.emplace(now()+op->opt.timeout_us,op);
+            op->hasTimer = true;
+        }
+        if(op->opt.cancel)op->cpos = op->opt.cancel->ops_.insert(op->opt.cancel->ops_.end(),op);
+        return true;
+    }
+
+    //完成等待，协程在本轮poll中恢复
+    void complete(detail::Op* op, int status)
+    {
+        if(op->state == detail::Op::Done)return;
+        if(op->hasTimer){
+            timers_.erase(op->timer);
+            op->hasTimer = false;
+        }
+        if(op->state == detail::Op::Queued)busy_.erase(op->qpos);
+        if(op->opt.cancel)op->opt.cancel->ops_.erase(op->cpos);
+        op->status = status;
+        op->state = detail::Op::Done;
+        ready_.push_back(op->h);
+    }
+
+    //期限到或者被取消，在途的请求从异步请求表中取消
+    void abort(detail::Op* op, int status)
+    {
+#if (IODP_OS==IODP_OS_LINUX)
+        if(op->state == detail::Op::InFlight && op->type != 0){
+            detail::Registry& reg = detail::Registry::get();
+            std::unique_lock<std::mutex> lk(reg.mu);
+            if(reg.ops.erase(op->token) == 0){
+                //回调已经把结果放进完成队列，按实际结果完成
+                for(auto it = done_.begin(); it != done_.end(); ++it){
+                    if(it->first != op)continue;
+                    status = it->second;
+                    done_.erase(it);
+                    break;
+                }
+            }
+            else{
+                lk.unlock();
+                eiodpCancel(op->dev,&detail::Op::onDone,(void*)op->token);
+            }
+        }
+#else
+        if(op->state == detail::Op::InFlight && op->type != 0)eiodpCancel(op->dev,&detail::Op::onDone,op);
+#endif
+        complete(op,status);
+    }
+
+    std::vector<eIODP_TYPE*> devs_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::list<detail::Op*> busy_;
+    std::multimap<unsigned long long,detail::Op*> timers_;
+    int live_ = 0;
+#if (IODP_OS==IODP_OS_LINUX)
+    std::vector<std::pair<detail::Op*,int>> done_;  //接收处理任务完成的请求，由Registry::mu保护
+    sem_t wake_;
+#endif
+};
+
+inline void CancelSource::cancel()
+{
+    cancelled_ = true;
+    while(!ops_.empty()){
+        detail::Op* op = ops_.front();
+        op->ex->abort(op,IODP_ERROR_CANCELED);
+    }
+}
+
+#if (IODP_OS==IODP_OS_LINUX)
+//在接收处理任务中执行：数据在登记表的锁内复制，之后执行器才能结束这个等待
+inline void detail::Op::onDone(void* ctx, int status, unsigned char* data, int len)
+{
+    Registry& reg = Registry::get();
+    Executor* ex;
+    {
+        std::lock_guard<std::mutex> lk(reg.mu);
+        auto it = reg.ops.find((std::uintptr_t)ctx);
+        if(it == reg.ops.end())return;
+        Op* op = it->second;
+        reg.ops.erase(it);
+        if(status >= 0){
+            if(len > op->cap)status = IODP_ERROR_RETSIZE;
+            else if(len > 0)std::memcpy(op->out,data,len);
+        }
+        ex = op->ex;
+        ex->done_.emplace_back(op,status);
+    }
+    sem_post(&ex->wake_);
+}
+#else
+inline void detail::Op::onDone(void* ctx, int status, unsigned char* data, int len)
+{
+    Op* op = (Op*)ctx;
+    if(status >= 0){
+        if(len > op->cap)status = IODP_ERROR_RETSIZE;
+        else if(len > 0)std::memcpy(op->out,data,len);
+    }
+    op->ex->complete(op,status);
+}
+#endif
+
+template<class P>
+inline std::coroutine_handle<> detail::PromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<P> h) noexcept
+{
+    PromiseBase& p = h.promise();
+    if(p.cont)return p.cont;
+    //顶层协程结束，释放协程帧
+    if(p.root != nullptr){
+        p.root->live_--;
+        h.destroy();
+    }
+    return std::noop_coroutine();
+}
+
+inline bool detail::OpAwaiter::await_suspend(std::coroutine_handle<> h)
+{
+    op.h = h;
+    op.ex = Executor::current();
+    if(op.ex == nullptr){
+        //不在执行器中
+        op.status = IODP_ERROR_PARAM;
+        op.state = Op::Done;
+        return false;
+    }
+    return op.ex->start(&op);
+}
+
+namespace detail {
+
+class ReadAwaiter : public OpAwaiter
+{
+public:
+    ReadAwaiter(eIODP_TYPE* dev, uint16 addr, uint16 len, unsigned char* buf, AwaitOpt opt)
+    {
+        op.dev = dev;
+        op.type = IODP_TYPE_READADDR;
+        op.key = addr;
+        op.len = len;
+        op.out = buf;
+        op.cap = len;
+        op.opt = opt;
+        if(dev == nullptr || buf == nullptr){
+            op.status = IODP_ERROR_PARAM;
+            op.state = Op::Done;
+        }
+    }
+};
+
+class FunctionAwaiter : public OpAwaiter
+{
+public:
+    FunctionAwaiter(eIODP_TYPE* dev, uint16 code, uint16 argsize, const void* arg,
+                    void* ret, uint16 retcap, AwaitOpt opt)
+    {
+        op.dev = dev;
+        op.type = IODP_TYPE_FUNCTION;
+        op.key = code;
+        op.len = argsize;
+        op.arg = arg;
+        op.out = (unsigned char*)ret;
+        op.cap = retcap;
+        op.opt = opt;
+        if(dev == nullptr || (argsize && arg == nullptr) || (retcap && ret == nullptr)){
+            op.status = IODP_ERROR_PARAM;
+            op.state = Op::Done;
+        }
+    }
+};
+
+class SleepAwaiter : public OpAwaiter
+{
+public:
+    SleepAwaiter(uint32 us, AwaitOpt opt)
+    {
+        op.opt = opt;
+        op.opt.timeout_us = us;
+    }
+};
+
+template<class F>
+class CallAwaiter : public OpAwaiter
+{
+public:
+    CallAwaiter(eIODP_TYPE* dev, const typename F::arg_type& arg, typename F::result_type& res, AwaitOpt opt)
+        : res_(res)
+    {
+        Codec<typename F::arg_type>::encode(argbuf_,arg);
+        op.dev = dev;
+        op.type = IODP_TYPE_FUNCTION;
+        op.key = F::code;
+        op.len = (uint16)F::argSize;
+        op.arg = argbuf_;
+        op.out = resbuf_;
+        op.cap = (uint16)F::resSize;
+        op.opt = opt;
+        if(dev == nullptr){
+            op.status = IODP_ERROR_PARAM;
+            op.state = Op::Done;
+        }
+    }
+    int await_resume()
+    {
+        if(op.status < 0)return op.status;
+        if((std::size_t)op.status != F::resSize)return IODP_ERROR_RECVLEN;
+        Codec<typename F::result_type>::decode(resbuf_,res_);
+        return IODP_OK;
+    }
+
+private:
+    typename F::result_type& res_;
+    unsigned char argbuf_[F::argSize ? F::argSize : 1];
+    unsigned char resbuf_[F::resSize ? F::resSize : 1];
+};
+
+} // namespace detail
+
+inline detail::ReadAwaiter read(eIODP_TYPE* dev, uint16 addr, uint16 len, unsigned char* buf, AwaitOpt opt = {})
+{
+    return detail::ReadAwaiter(dev,addr,len,buf,opt);
+}
+
+inline detail::FunctionAwaiter function(eIODP_TYPE* dev, uint16 code, uint16 argsize, const void* arg,
+                                        void* ret, uint16 retcap, AwaitOpt opt = {})
+{
+    return detail::FunctionAwaiter(dev,code,argsize,arg,ret,retcap,opt);
+}
+
+template<class F>
+inline detail::CallAwaiter<F> call(eIODP_TYPE* dev, const typename F::arg_type& arg,
+                                   typename F::result_type& res, AwaitOpt opt = {})
+{
+    return detail::CallAwaiter<F>(dev,arg,res,opt);
+}
+
+inline detail::SleepAwaiter sleep(uint32 us, AwaitOpt opt = {})
+{
+    return detail::SleepAwaiter(us,opt);
+}
+
+} // namespace co
+} // namespace eiodp
+
+#endif
+
+#endif
@@ -1,27 +1,63 @@
-#ifndef _EIODPCONFIG_H_
-#define _EIODPCONFIG_H_
-
-#include "eiodp.h"
-
-//#define IOREAD(fd,buf,len) udpread(fd,buf,len)
-//#define IOWRITE(fd,buf,len) udpsend(fd,buf,len)
-#define IODP_OS IODP_OS_NULL     //"FreeRTos" "vxWorks" 
-
-
-
-
-#if (IODP_OS==IODP_OS_LINUX)
-    #include <pthread.h>
-    #include <semaphore.h>
-    #include <unistd.h>
-    #include <sys/time.h>
-    #define IODP_SEM_TAKE(sem) sem_wait(sem)
-    #define IODP_SEM_GIVE(sem) sem_post(sem)
-#elif (IODP_OS==IODP_OS_FREERTOS)
-    #include "FreeRTOS.h"
-    #define IODP_SEM_TAKE(sem) xSemaphoreTake(sem,(TickType_t)xMaxBlockTime)
-    #define IODP_SEM_GIVE(sem) xSemaphoreGive(sem)
-#elif (IODP_OS==IODP_OS_NULL)
-#endif
-
-#endif
+#ifndef _EIODPCONFIG_H_
+#define _EIODPCONFIG_H_
+
+#include "eiodp.h"
+
+//#define IOREAD(fd,buf,len) udpread(fd,buf,len)
+//#define IOWRITE(fd,buf,len) udpsend(fd,buf,len)
+#define IODP_OS IODP_OS_NULL     //"FreeRTos" "vxWorks" 
+
+//运行统计（计数器与时延直方图），关闭后统计代码不参与编译
+#define IODP_METRICS_ENABLE 1
+//是否通过保留的function code(IODP_FUNCODE_METRICS)对外提供统计
+#define IODP_METRICS_REMOTE 1
+
+//日志等级，低于此等级的日志不参与编译 IODP_LOGLV_NONE/ERROR/WARN/INFO/DEBUG
+#define IODP_LOG_LEVEL IODP_LOGLV_WARN
+
+//配置空间持久化到mmap文件（eiodpConfigPersist），需要POSIX文件接口与mmap，没有文件系统时设为0
+#define IODP_PERSIST_ENABLE 1
+
+
+
+
+#if (IODP_OS==IODP_OS_LINUX)
+    #include <pthread.h>
+    #include <semaphore.h>
+    #include <unistd.h>
+    #include <sys/time.h>
+    #include <sched.h>
+    #define IODP_SEM_TAKE(sem) sem_wait(sem)
+    #define IODP_SEM_GIVE(sem) sem_post(sem)
+    //统计计数用的relaxed原子操作
+    #define IODP_ATOMIC_ADD(p,v) __atomic_fetch_add((p),(v),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_LOAD(p) __atomic_load_n((p),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_STORE(p,v) __atomic_store_n((p),(v),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_MAX(p,v) do{ uint32 _o=__atomic_load_n((p),__ATOMIC_RELAXED); \
+            while((uint32)(v)>_o && !__atomic_compare_exchange_n((p),&_o,(uint32)(v),1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)); }while(0)
+    //配置空间顺序锁使用的内存屏障
+    #define IODP_FENCE_ACQ() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+    #define IODP_FENCE_REL() __atomic_thread_fence(__ATOMIC_RELEASE)
+#elif (IODP_OS==IODP_OS_FREERTOS)
+    #include "FreeRTOS.h"
+    #define IODP_SEM_TAKE(sem) xSemaphoreTake(sem,(TickType_t)xMaxBlockTime)
+    #define IODP_SEM_GIVE(sem) xSemaphoreGive(sem)
+    #define IODP_ATOMIC_ADD(p,v) __atomic_fetch_add((p),(v),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_LOAD(p) __atomic_load_n((p),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_STORE(p,v) __atomic_store_n((p),(v),__ATOMIC_RELAXED)
+    #define IODP_ATOMIC_MAX(p,v) do{ uint32 _o=__atomic_load_n((p),__ATOMIC_RELAXED); \
+            while((uint32)(v)>_o && !__atomic_compare_exchange_n((p),&_o,(uint32)(v),1,__ATOMIC_RELAXED,__ATOMIC_RELAXED)); }while(0)
+    #define IODP_FENCE_ACQ() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+    #define IODP_FENCE_REL() __atomic_thread_fence(__ATOMIC_RELEASE)
+#elif (IODP_OS==IODP_OS_NULL)
+    //单线程轮询，普通读写即可（32位对齐访问在MCU上本身是原子的）
+    #define IODP_ATOMIC_ADD(p,v) (*(p) += (v))
+    #define IODP_ATOMIC_LOAD(p) (*(volatile uint32*)(p))
+    #define IODP_ATOMIC_STORE(p,v) (*(volatile uint32*)(p) = (v))
+    #define IODP_ATOMIC_MAX(p,v) do{ if((uint32)(v)>*(p)) *(p)=(uint32)(v); }while(0)
+    //单核上只需要阻止编译器重排（中断里读配置空间时）
+    #define IODP_FENCE_ACQ() __asm__ volatile("" ::: "memory")
+    #define IODP_FENCE_REL() __asm__ volatile("" ::: "memory")
+#endif
+
+#endif
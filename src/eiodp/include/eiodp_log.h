@@ -0,0 +1,124 @@
+#ifndef _EIODPLOG_H_
+#define _EIODPLOG_H_
+
+/*
+    eiodp日志。
+    日志按等级在编译期过滤，低于IODP_LOG_LEVEL的调用连同参数一起编译为空。
+    linux下每个线程有一个无锁的单生产者环形缓存，调用处只写入二进制记录（格式串指针+参数），
+    由后台线程统一格式化输出，收包线程不会被stdout拖慢。
+    无操作系统/FreeRTOS下直接格式化输出。
+    每个调用点单独限速，每IODP_LOG_RATE_MS内最多输出IODP_LOG_RATE条，多出的只计数，
+    窗口结束后的下一条日志会带上被抑制的条数。
+
+    参数统一按long保存，格式串只支持整数(d i u x X o c)、%s、%p。
+    %s只能传字符串常量（格式化时原字符串必须仍然有效），指针参数需要强转为long。
+*/
+
+#include "eiodp.h"
+
+//日志等级
+#define IODP_LOGLV_NONE 0
+#define IODP_LOGLV_ERROR 1
+#define IODP_LOGLV_WARN 2
+#define IODP_LOGLV_INFO 3
+#define IODP_LOGLV_DEBUG 4
+
+//编译期日志等级，可以在eiodp_config.h中配置
+#ifndef IODP_LOG_LEVEL
+#define IODP_LOG_LEVEL IODP_LOGLV_WARN
+#endif
+
+//单条日志最多参数个数
+#define IODP_LOG_MAXARGS 6
+//每个线程的日志缓存条数，必须是2的幂
+#define IODP_LOG_RINGSIZE 256
+//最多同时有多少个线程使用独立缓存，超出的线程退化为加锁直接输出
+#define IODP_LOG_MAXTHREAD 16
+//单个调用点限速：IODP_LOG_RATE_MS毫秒内最多IODP_LOG_RATE条
+#define IODP_LOG_RATE 20
+#define IODP_LOG_RATE_MS 1000
+//格式化后单行最大长度
+#define IODP_LOG_LINE_LEN 256
+
+//日志调用点，每个调用处一个静态实例，用于限速
+typedef struct
+{
+    const char* fmt;
+    uint8 level;
+    uint32 winStart;    //当前限速窗口开始时间ms
+    uint32 winCount;    //当前窗口内的条数
+    uint32 suppressed;  //被抑制还没报告的条数
+}eIODP_LOGSITE;
+
+/************************************************************
+    @brief:
+        提交一条日志（由IODP_LOGx宏调用）
+    @param:
+        site：调用点
+        nargs：参数个数
+        args：参数
+*************************************************************/
+void eiodp_logPost(eIODP_LOGSITE* site,int nargs,const long* args);
+
+/************************************************************
+    @brief:
+        把所有线程缓存中的日志立即输出，进程退出时会自动调用
+*************************************************************/
+void eiodp_logFlush(void);
+
+/************************************************************
+    @brief:
+        设置日志输出函数，NULL恢复为输出到stdout
+    @param:
+        sink：level为日志等级，line为已经格式化好的一行
+*************************************************************/
+void eiodp_logSetSink(void (*sink)(int level,const char* line));
+
+/************************************************************
+    @brief:
+        设置日志时钟（毫秒），用于时间戳与限速。
+        linux下默认使用CLOCK_MONOTONIC，其他平台没有设置时钟时不限速
+*************************************************************/
+void eiodp_logSetClock(uint32 (*msfunc)(void));
+
+/************************************************************
+    @brief:
+        获取因为缓存满而丢弃的日志条数
+*************************************************************/
+uint32 eiodp_logDropped(void);
+
+#define IODP_LOG_AT(lv,fmt,...) do{ \
+        static eIODP_LOGSITE _iodp_site_ = {fmt,lv,0,0,0}; \
+        long _iodp_arg_[] = {0, ##__VA_ARGS__}; \
+        eiodp_logPost(&_iodp_site_,(int)(sizeof(_iodp_arg_)/sizeof(long))-1,&_iodp_arg_[1]); \
+    }while(0)
+
+#if (IODP_LOG_LEVEL >= IODP_LOGLV_ERROR)
+#define IODP_LOGE(fmt,...) IODP_LOG_AT(IODP_LOGLV_ERROR,fmt,##__VA_ARGS__)
+#else
+#define IODP_LOGE(fmt,...) ((void)0)
+#endif
+
+#if (IODP_LOG_LEVEL >= IODP_LOGLV_WARN)
+#define IODP_LOGW(fmt,...) IODP_LOG_AT(IODP_LOGLV_WARN,fmt,##__VA_ARGS__)
+#else
+#define IODP_LOGW(fmt,...) ((void)0)
+#endif
+
+#if (IODP_LOG_LEVEL >= IODP_LOGLV_INFO)
+#define IODP_LOGI(fmt,...) IODP_LOG_AT(IODP_LOGLV_INFO,fmt,##__VA_ARGS__)
+#else
+#define IODP_LOGI(fmt,...) ((void)0)
+#endif
+
+#if (IODP_LOG_LEVEL >= IODP_LOGLV_DEBUG)
+#define IODP_LOGD(fmt,...) IODP_LOG_AT(IODP_LOGLV_DEBUG,fmt,##__VA_ARGS__)
+#else
+#define IODP_LOGD(fmt,...) ((void)0)
+#endif
+
+//兼容旧接口
+#define IODP_LOG(str,a,b,c,d,e) IODP_LOGI(str,(long)(a),(long)(b),(long)(c),(long)(d),(long)(e))
+#define IODP_LOGMSG(str) IODP_LOGD(str)
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef _EIODPSCHEMA_H_
+#define _EIODPSCHEMA_H_
+
+/*
+    eiodp寄存器表。
+    用X宏把配置空间里的一段布局声明一次，生成字段偏移、带大端转换的取值/赋值函数与字段表，
+    不再手写地址与长度：
+        #define MYREGS_FIELDS(X,S) \
+            X(S,speed,U16,1) \
+            X(S,temp,I16,1) \
+            X(S,gain,F32,4)
+        IODP_SCHEMA_DEFINE(MYREGS,0x100)
+    每个字段为X(S,名字,类型,个数)，类型为U8/I8/U16/I16/U32/I32/F32，个数大于1时为数组。
+    字段按声明顺序紧密排列（没有对齐填充），需要保留的空隙声明成U8数组。生成：
+        MYREGS_layout：布局结构体（全部为uint8数组），MYREGS_SIZE为总长度，MYREGS_BASE为起始地址
+        MYREGS_F_speed：字段序号，IODP_FBIT(MYREGS,speed)为字段在字段集合中的位
+        IODP_FADDR(MYREGS,speed)/IODP_FSIZE(MYREGS,speed)：字段的地址与长度
+        MYREGS_get_speed(img)/MYREGS_set_speed(img,v)：在本地映像img（MYREGS_SIZE字节，
+            对应从MYREGS_BASE开始的数据）上按大端取值/赋值，数组用MYREGS_geti_gain(img,i)等
+        MYREGS_Schema()：字段表，用于生成读计划与写回
+    读计划：对一组字段预先算好读取方式（eiodpSchemaPlan），之后每次eiodpSchemaFetch按计划读回。
+    计划在空隙较小时合并相邻字段，再把各段装进尽量少的多段读（EC06），只有一段时用普通读（EC02）。
+    同一次多段读的各段在对方同一次处理中读出；字段集合超过返回缓存时分成多次读，各次之间不保证一致。
+*/
+
+#include "eiodp.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//一个寄存器表最多的字段数（字段集合用64位掩码表示）
+#define IODP_SCHEMA_MAXFIELD 64
+//读计划合并字段时允许跨过的空隙字节数，空隙比多一个地址段的开销（4字节）小时合并才划算
+#define IODP_SCHEMA_GAP 4
+//一个读计划最多的地址段数
+#define IODP_SCHEMA_MAXRANGE (2*IODP_MRANGE_MAX)
+//一次读回的最大长度（受返回缓存限制）
+#define IODP_SCHEMA_MAXFETCH (IODP_RETURN_BUFFER-10)
+
+//字段类型：长度与C类型
+#define IODP_SZ_U8 1
+#define IODP_SZ_I8 1
+#define IODP_SZ_U16 2
+#define IODP_SZ_I16 2
+#define IODP_SZ_U32 4
+#define IODP_SZ_I32 4
+#define IODP_SZ_F32 4
+#define IODP_CT_U8 uint8
+#define IODP_CT_I8 signed char
+#define IODP_CT_U16 uint16
+#define IODP_CT_I16 short
+#define IODP_CT_U32 uint32
+#define IODP_CT_I32 int
+#define IODP_CT_F32 float
+
+//大端取值/赋值，与协议的字节序一致
+static inline uint8 iodp_getU8(const uint8* p){return p[0];}
+static inline void iodp_setU8(uint8* p,uint8 v){p[0]=v;}
+static inline signed char iodp_getI8(const uint8* p){return (signed char)p[0];}
+static inline void iodp_setI8(uint8* p,signed char v){p[0]=(uint8)v;}
+static inline uint16 iodp_getU16(const uint8* p){return (uint16)((p[0]<<8)|p[1]);}
+static inline void iodp_setU16(uint8* p,uint16 v){p[0]=(uint8)(v>>8);p[1]=(uint8)v;}
+static inline short iodp_getI16(const uint8* p){return (short)iodp_getU16(p);}
+static inline void iodp_setI16(uint8* p,short v){iodp_setU16(p,(uint16)v);}
+static inline uint32 iodp_getU32(const uint8* p)
+{
+    return ((uint32)p[0]<<24)|((uint32)p[1]<<16)|((uint32)p[2]<<8)|p[3];
+}
+static inline void iodp_setU32(uint8* p,uint32 v)
+{
+    p[0]=(uint8)(v>>24);p[1]=(uint8)(v>>16);p[2]=(uint8)(v>>8);p[3]=(uint8)v;
+}
+static inline int iodp_getI32(const uint8* p){return (int)iodp_getU32(p);}
+static inline void iodp_setI32(uint8* p,int v){iodp_setU32(p,(uint32)v);}
+static inline float iodp_getF32(const uint8* p)
+{
+    union{uint32 u;float f;}x;
+    x.u = iodp_getU32(p);
+    return x.f;
+}
+static inline void iodp_setF32(uint8* p,float v)
+{
+    union{uint32 u;float f;}x;
+    x.f = v;
+    iodp_setU32(p,x.u);
+}
+
+//字段表的一项
+typedef struct
+{
+    const char* name;
+    uint16 off;         //相对寄存器表起始地址的偏移
+    uint16 size;        //字段总长度（元素长度*个数）
+}eIODP_FIELD;
+
+//寄存器表描述
+typedef struct
+{
+    const char* name;
+    uint16 base;        //起始地址
+    uint16 size;        //总长度
+    int nfield;
+    const eIODP_FIELD* field;   //按偏移从小到大排列
+}eIODP_SCHEMA;
+
+//X宏的展开方式
+#define IODP_SF_LAYOUT(S,name,type,n) uint8 name[IODP_SZ_##type*(n)];
+#define IODP_SF_ID(S,name,type,n) S##_F_##name,
+#define IODP_SF_TABLE(S,name,type,n) {#name,(uint16)offsetof(S##_layout,name),(uint16)(IODP_SZ_##type*(n))},
+#define IODP_SF_ACCESS(S,name,type,n) \
+    static inline IODP_CT_##type S##_geti_##name(const uint8* img,int i) \
+    {return iodp_get##type(img+offsetof(S##_layout,name)+IODP_SZ_##type*i);} \
+    static inline void S##_seti_##name(uint8* img,int i,IODP_CT_##type v) \
+    {iodp_set##type(img+offsetof(S##_layout,name)+IODP_SZ_##type*i,v);} \
+    static inline IODP_CT_##type S##_get_##name(const uint8* img){return S##_geti_##name(img,0);} \
+    static inline void S##_set_##name(uint8* img,IODP_CT_##type v){S##_seti_##name(img,0,v);}
+
+//由S##_FIELDS(X,S)生成寄存器表，base为起始地址
+#define IODP_SCHEMA_DEFINE(S,base) \
+    typedef struct{ S##_FIELDS(IODP_SF_LAYOUT,S) }S##_layout; \
+    enum{ S##_FIELDS(IODP_SF_ID,S) S##_NFIELD }; \
+    enum{ S##_BASE = (base), S##_SIZE = sizeof(S##_layout) }; \
+    typedef char S##_fieldcheck[(S##_NFIELD <= IODP_SCHEMA_MAXFIELD && (base)+sizeof(S##_layout) <= 0x10000) ? 1 : -1]; \
+    static inline const eIODP_SCHEMA* S##_Schema(void) \
+    { \
+        static const eIODP_FIELD field[] = { S##_FIELDS(IODP_SF_TABLE,S) }; \
+        static const eIODP_SCHEMA schema = {#S,(uint16)(base),(uint16)sizeof(S##_layout),S##_NFIELD,field}; \
+        return &schema; \
+    } \
+    S##_FIELDS(IODP_SF_ACCESS,S)
+
+//字段的地址、长度与字段集合
+#define IODP_FADDR(S,name) ((uint16)(S##_BASE+offsetof(S##_layout,name)))
+#define IODP_FSIZE(S,name) ((uint16)sizeof(((S##_layout*)0)->name))
+#define IODP_FBIT(S,name) (1ULL<<S##_F_##name)
+#define IODP_FALL(S) (S##_NFIELD >= 64 ? ~0ULL : (1ULL<<S##_NFIELD)-1)
+
+//读计划
+typedef struct
+{
+    const eIODP_SCHEMA* schema;
+    unsigned long long mask;    //字段集合
+    uint16 nrange;              //地址段数
+    uint16 ngroup;              //每次读取发出的请求数
+    uint32 wireBytes;           //每次读回的字节（包括合并时跨过的空隙）
+    uint16 addr[IODP_SCHEMA_MAXRANGE];
+    uint16 len[IODP_SCHEMA_MAXRANGE];
+    uint16 groupEnd[IODP_SCHEMA_MAXRANGE];  //第i个请求读取的地址段为[groupEnd[i-1],groupEnd[i])
+}eIODP_SCHEMA_PLAN;
+
+/************************************************************
+    @brief:
+        生成字段集合的读计划，分别按只合并相邻字段与合并小空隙计算，取请求数少的，
+        请求数相同时取地址段少的。计划生成一次，之后可以反复使用
+    @param:
+        plan：输出的读计划
+        schema：寄存器表，如MYREGS_Schema()
+        mask：字段集合，IODP_FBIT的组合
+    @return:
+        IODP_ERROR_PARAM - 参数错误，或者地址段超过IODP_SCHEMA_MAXRANGE
+        >0 - 每次读取发出的请求数
+*************************************************************/
+int eiodpSchemaPlan(eIODP_SCHEMA_PLAN* plan,const eIODP_SCHEMA* schema,unsigned long long mask);
+
+/************************************************************
+    @brief:
+        按读计划从对方读回字段集合
+    @param:
+        eiodp_fd:eiodp句柄
+        plan：读计划
+        img：本地映像，schema->size字节，读回的字段（以及跨过的空隙）存入对应偏移
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        <0 - 读取时出错（同eiodpReadMulti），出错之前的请求已经写入img
+        >=0 - 读回的字节数
+*************************************************************/
+int eiodpSchemaFetch(eIODP_TYPE* eiodp_fd,const eIODP_SCHEMA_PLAN* plan,uint8* img);
+
+/************************************************************
+    @brief:
+        把本地映像中的字段集合写到对方，只写字段本身，相邻的字段合并成一段，
+        用多段写（EC07）发出，一包放不下时分成多包
+    @param:
+        eiodp_fd:eiodp句柄
+        schema：寄存器表
+        mask：字段集合
+        img：本地映像
+    @return:
+        IODP_ERROR_PARAM - 参数错误
+        <0 - 发出时出错（同eiodpWriteMulti）
+        0 - 已发出
+*************************************************************/
+int eiodpSchemaStore(eIODP_TYPE* eiodp_fd,const eIODP_SCHEMA* schema,unsigned long long mask,const uint8* img);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
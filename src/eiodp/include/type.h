@@ -1,19 +1,22 @@
-//本文件主要是为了兼容不同的硬件与编译器平台，属于硬件层
-
-
-#ifndef _TYPE_H_
-#define _TYPE_H_
-
-#define nullptr 0
-#define NULL 0
-
-
-typedef unsigned char uint8;
-typedef unsigned short uint16;
-typedef unsigned int uint32;
-
-
-
-
-
-#endif
+//本文件主要是为了兼容不同的硬件与编译器平台，属于硬件层
+
+
+#ifndef _TYPE_H_
+#define _TYPE_H_
+
+//C++有自己的nullptr与NULL
+#ifndef __cplusplus
+#define nullptr 0
+#define NULL 0
+#endif
+
+
+typedef unsigned char uint8;
+typedef unsigned short uint16;
+typedef unsigned int uint32;
+
+
+
+
+
+#endif
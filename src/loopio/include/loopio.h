@@ -0,0 +1,109 @@
+#ifndef _LOOPIO_H_
+#define _LOOPIO_H_
+
+/*
+    进程内回环传输（loopback），用于在一台机器上模拟真实链路。
+    一对端点通过loopopen创建，A端写入的数据经过模拟链路后可以在B端读出，反之亦然。
+    loopsend/loopread的签名与eiodp_init要求的读写函数一致，可以直接替换udpsend/udpread。
+
+    每个方向的链路可以单独配置：
+        带宽（波特率，按每字节bitsPerByte位计算串行化时间）
+        固定时延与随机抖动
+        误码率（按位翻转）、整包丢弃率、乱序率
+        链路缓存上限（超出即尾部丢弃，模拟UART FIFO溢出）
+    所有随机行为由seed决定，相同seed与相同调用序列会得到相同结果。
+    时钟默认使用CLOCK_MONOTONIC，也可以通过loopio_setclock注入虚拟时钟。
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//最大端点数量
+#define LOOPIO_MAXNUM 30
+
+//单方向链路配置
+typedef struct
+{
+    unsigned int baudrate;      //bit/s，0表示带宽不受限
+    unsigned int bitsPerByte;   //每字节占用位数，串口8N1为10，0按10计算
+    unsigned int latency_us;    //固定传输时延
+    unsigned int jitter_us;     //随机抖动上限[0,jitter_us)
+    double ber;                 //误码率（每bit翻转概率）
+    double droprate;            //每次写入整包丢弃概率
+    double reorderrate;         //每次写入被额外延迟而乱序的概率
+    unsigned int reorder_us;    //乱序包的额外延迟，0则取latency_us+jitter_us+1000
+    unsigned int queueLimit;    //链路上在途字节上限，0表示不限
+    unsigned int seed;          //随机种子，0使用默认种子
+    unsigned int readTimeout_us;//读无数据时最长阻塞时间，0为非阻塞
+    int dgram;                  //1：一次read只返回一个写入块（类似udp） 0：字节流（类似串口）
+}LOOPIO_LINKCFG;
+
+//单方向链路统计
+typedef struct
+{
+    unsigned long long txBytes;     //写入字节
+    unsigned long long txChunks;    //写入次数
+    unsigned long long rxBytes;     //被读出的字节
+    unsigned long long dropChunks;  //按droprate丢弃的写入块
+    unsigned long long overflowChunks;//超出queueLimit丢弃的写入块
+    unsigned long long errBytes;    //发生误码的字节
+    unsigned long long reorderChunks;//被乱序的写入块
+}LOOPIO_STAT;
+
+/************************************************************
+    @brief:
+        填充一个理想链路配置，再按需修改
+    @param:
+        cfg：配置
+        baudrate：波特率，0为不限速
+*************************************************************/
+void loopio_defcfg(LOOPIO_LINKCFG* cfg, unsigned int baudrate);
+
+/************************************************************
+    @brief:
+        创建一对回环端点
+    @param:
+        a2b：A写B读方向的链路配置，NULL为理想链路
+        b2a：B写A读方向的链路配置，NULL为理想链路
+        fda：返回A端句柄
+        fdb：返回B端句柄
+    @return:
+        0 - 成功
+       -1 - 端点用尽或内存不足
+*************************************************************/
+int loopopen(const LOOPIO_LINKCFG* a2b, const LOOPIO_LINKCFG* b2a, int* fda, int* fdb);
+
+/************************************************************
+    @brief:
+        关闭端点，一对端点都关闭后释放链路
+*************************************************************/
+void loopclose(int fd);
+
+//写数据到对端，返回len（被丢弃的数据同样返回len，与真实链路一致）
+int loopsend(int fd, char* buf, int len);
+//分段写：bufs[0..n-1]作为一次写入（同一个数据块），返回总长度，可以用于eiodpSetWritev
+int loopsendv(int fd, const void* const* bufs, const int* lens, int n);
+//读取已经到达的数据，无数据时按readTimeout_us阻塞，超时返回0
+int loopread(int fd, char* buf, int len);
+
+/************************************************************
+    @brief:
+        获取fd写出方向的链路统计
+    @return:
+        0 - 成功  -1 - fd非法
+*************************************************************/
+int loopstat(int fd, LOOPIO_STAT* stat);
+
+/************************************************************
+    @brief:
+        替换链路时钟，NULL恢复为CLOCK_MONOTONIC。
+        注入虚拟时钟后读操作不再阻塞等待，由调用者推进时钟。
+*************************************************************/
+void loopio_setclock(unsigned long long (*nowus)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/*
+    文件名：loopio.c
+
+    说明：
+        进程内回环传输与链路模拟，接口说明见loopio.h。
+        每个方向维护一个按送达时间排序的数据块队列，写入时计算串行化与传输时延，
+        读取时只返回送达时间已到的数据。
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "loopio.h"
+
+//在途数据块
+typedef struct LOOPIO_CHUNK
+{
+    struct LOOPIO_CHUNK* pNext;
+    unsigned long long deliver_us;  //送达时间
+    int len;
+    int off;                        //已经被读出的字节
+    unsigned char data[1];
+}LOOPIO_CHUNK;
+
+//单方向链路
+typedef struct
+{
+    LOOPIO_LINKCFG cfg;
+    LOOPIO_STAT stat;
+    unsigned int rng;
+    unsigned int pByteErr;          //单字节出错概率（按2^32定标）
+    unsigned long long busy_until;  //链路串行化占用结束时间
+    unsigned long long last_deliver;//保序送达的最晚时间
+    unsigned int queued;            //在途字节
+    LOOPIO_CHUNK* pHead;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+}LOOPIO_DIR;
+
+struct loopfdtype{
+    int used;
+    LOOPIO_DIR* tx;
+    LOOPIO_DIR* rx;
+};
+
+static struct loopfdtype loopfd_list[LOOPIO_MAXNUM];
+static pthread_mutex_t loopfd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long (*loopclock)(void) = NULL;
+
+static unsigned long long mono_nowus(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (unsigned long long)tv.tv_sec*1000000ULL + tv.tv_nsec/1000;
+}
+
+static unsigned long long loop_nowus(void)
+{
+    return loopclock ? loopclock() : mono_nowus();
+}
+
+//xorshift32
+static unsigned int loop_rand(LOOPIO_DIR* d)
+{
+    unsigned int x = d->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    d->rng = x;
+    return x;
+}
+
+//概率p换算为32位阈值
+static unsigned int prob_threshold(double p)
+{
+    if(p <= 0.0) return 0;
+    if(p >= 1.0) return 0xffffffff;
+    return (unsigned int)(p*4294967295.0);
+}
+
+void loopio_defcfg(LOOPIO_LINKCFG* cfg, unsigned int baudrate)
+{
+    memset(cfg, 0, sizeof(LOOPIO_LINKCFG));
+    cfg->baudrate = baudrate;
+    cfg->bitsPerByte = 10;
+    cfg->readTimeout_us = 1000;
+}
+
+static LOOPIO_DIR* creat_dir(const LOOPIO_LINKCFG* cfg)
+{
+    LOOPIO_DIR* d = (LOOPIO_DIR*)malloc(sizeof(LOOPIO_DIR));
+    if(d == NULL) return NULL;
+    memset(d, 0, sizeof(LOOPIO_DIR));
+    if(cfg) d->cfg = *cfg;
+    else loopio_defcfg(&d->cfg, 0);
+    if(d->cfg.bitsPerByte == 0) d->cfg.bitsPerByte = 10;
+    d->rng = d->cfg.seed ? d->cfg.seed : 0x9e3779b9;
+
+    //单字节出错概率 1-(1-ber)^8
+    if(d->cfg.ber > 0.0){
+        double q = 1.0-d->cfg.ber;
+        double q8 = q*q; q8 = q8*q8; q8 = q8*q8;
+        d->pByteErr = prob_threshold(1.0-q8);
+    }
+    pthread_mutex_init(&d->mutex, NULL);
+    pthread_cond_init(&d->cond, NULL);
+    return d;
+}
+
+static void delate_dir(LOOPIO_DIR* d)
+{
+    LOOPIO_CHUNK* p = d->pHead;
+    while(p){
+        LOOPIO_CHUNK* n = p->pNext;
+        free(p);
+        p = n;
+    }
+    pthread_mutex_destroy(&d->mutex);
+    pthread_cond_destroy(&d->cond);
+    free(d);
+}
+
+int loopopen(const LOOPIO_LINKCFG* a2b, const LOOPIO_LINKCFG* b2a, int* fda, int* fdb)
+{
+    int i, a = 0, b = 0;
+    pthread_mutex_lock(&loopfd_mutex);
+    //句柄从1开始，eiodp_init不接受fd=0
+    for(i=1;i<LOOPIO_MAXNUM;i++){
+        if(loopfd_list[i].used) continue;
+        if(a == 0) a = i;
+        else { b = i; break; }
+    }
+    if(b == 0){
+        pthread_mutex_unlock(&loopfd_mutex);
+        printf("loopopen no free fd\n");
+        return -1;
+    }
+    LOOPIO_DIR* dab = creat_dir(a2b);
+    LOOPIO_DIR* dba = creat_dir(b2a);
+    if(dab == NULL || dba == NULL){
+        if(dab) delate_dir(dab);
+        if(dba) delate_dir(dba);
+        pthread_mutex_unlock(&loopfd_mutex);
+        return -1;
+    }
+    loopfd_list[a].used = 1; loopfd_list[a].tx = dab; loopfd_list[a].rx = dba;
+    loopfd_list[b].used = 1; loopfd_list[b].tx = dba; loopfd_list[b].rx = dab;
+    pthread_mutex_unlock(&loopfd_mutex);
+    *fda = a;
+    *fdb = b;
+    return 0;
+}
+
+void loopclose(int fd)
+{
+    int i;
+    if(fd <= 0 || fd >= LOOPIO_MAXNUM) return;
+    pthread_mutex_lock(&loopfd_mutex);
+    if(loopfd_list[fd].used){
+        LOOPIO_DIR* tx = loopfd_list[fd].tx;
+        LOOPIO_DIR* rx = loopfd_list[fd].rx;
+        int peer = 0;
+        loopfd_list[fd].used = 0;
+        for(i=1;i<LOOPIO_MAXNUM;i++){
+            if(loopfd_list[i].used && loopfd_list[i].tx == rx) peer = i;
+        }
+        if(peer == 0){
+            delate_dir(tx);
+            delate_dir(rx);
+        }
+    }
+    pthread_mutex_unlock(&loopfd_mutex);
+}
+
+//n段数据作为一次写入
+static int loop_send(int fd, const void* const* bufs, const int* lens, int n, int len)
+{
+    if(fd <= 0 || fd >= LOOPIO_MAXNUM || !loopfd_list[fd].used || len <= 0) return -1;
+    LOOPIO_DIR* d = loopfd_list[fd].tx;
+    LOOPIO_LINKCFG* cfg = &d->cfg;
+    int i;
+
+    pthread_mutex_lock(&d->mutex);
+    unsigned long long now = loop_nowus();
+    d->stat.txBytes += len;
+    d->stat.txChunks++;
+
+    //串行化：链路忙时排队，占用时间按带宽计算
+    unsigned long long start = d->busy_until > now ? d->busy_until : now;
+    if(cfg->baudrate){
+        d->busy_until = start + (unsigned long long)len*cfg->bitsPerByte*1000000ULL/cfg->baudrate;
+    }
+    else{
+        d->busy_until = start;
+    }
+
+    if(cfg->queueLimit && d->queued + len > cfg->queueLimit){
+        d->stat.overflowChunks++;
+        pthread_mutex_unlock(&d->mutex);
+        return len;
+    }
+    if(cfg->droprate > 0.0 && loop_rand(d) < prob_threshold(cfg->droprate)){
+        d->stat.dropChunks++;
+        pthread_mutex_unlock(&d->mutex);
+        return len;
+    }
+
+    LOOPIO_CHUNK* c = (LOOPIO_CHUNK*)malloc(sizeof(LOOPIO_CHUNK)+len);
+    if(c == NULL){
+        pthread_mutex_unlock(&d->mutex);
+        return -1;
+    }
+    for(i=0,len=0;i<n;i++){
+        memcpy(c->data+len, bufs[i], lens[i]);
+        len += lens[i];
+    }
+    c->len = len;
+    c->off = 0;
+
+    //误码：按字节概率挑出出错字节，再随机翻转其中一位
+    if(d->pByteErr){
+        for(i=0;i<len;i++){
+            if(loop_rand(d) < d->pByteErr){
+                c->data[i] ^= (unsigned char)(1 << (loop_rand(d)&7));
+                d->stat.errBytes++;
+            }
+        }
+    }
+
+    unsigned long long deliver = d->busy_until + cfg->latency_us;
+    if(cfg->jitter_us) deliver += loop_rand(d)%cfg->jitter_us;
+    if(cfg->reorderrate > 0.0 && loop_rand(d) < prob_threshold(cfg->reorderrate)){
+        //乱序包额外延迟，不推进last_deliver，后续数据可以超过它
+        deliver += cfg->reorder_us ? cfg->reorder_us : cfg->latency_us+cfg->jitter_us+1000;
+        d->stat.reorderChunks++;
+    }
+    else{
+        //抖动不应该打乱串行链路上的顺序
+        if(deliver < d->last_deliver) deliver = d->last_deliver;
+        d->last_deliver = deliver;
+    }
+    c->deliver_us = deliver;
+
+    //按送达时间插入，时间相同保持写入顺序
+    LOOPIO_CHUNK** pp = &d->pHead;
+    while(*pp && (*pp)->deliver_us <= deliver) pp = &(*pp)->pNext;
+    c->pNext = *pp;
+    *pp = c;
+    d->queued += len;
+
+    pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->mutex);
+    return len;
+}
+
+int loopsend(int fd, char* buf, int len)
+{
+    const void* bufs[1] = {buf};
+    return loop_send(fd,bufs,&len,1,len);
+}
+
+int loopsendv(int fd, const void* const* bufs, const int* lens, int n)
+{
+    int i, len = 0;
+    if(bufs == NULL || lens == NULL || n <= 0) return -1;
+    for(i=0;i<n;i++){
+        if(lens[i] < 0 || (lens[i] > 0 && bufs[i] == NULL)) return -1;
+        len += lens[i];
+    }
+    return loop_send(fd,bufs,lens,n,len);
+}
+
+//取出已经送达的数据，返回字节数
+static int take_ready(LOOPIO_DIR* d, char* buf, int len, unsigned long long now)
+{
+    int n = 0;
+    while(n < len && d->pHead && d->pHead->deliver_us <= now){
+        LOOPIO_CHUNK* c = d->pHead;
+        int cp = c->len - c->off;
+        if(cp > len-n) cp = len-n;
+        memcpy(&buf[n], &c->data[c->off], cp);
+        n += cp;
+        c->off += cp;
+        if(d->cfg.dgram || c->off >= c->len){
+            //数据报模式下未读完的部分被截断，与udp一致
+            d->queued -= c->len;
+            d->pHead = c->pNext;
+            free(c);
+            if(d->cfg.dgram) break;
+        }
+    }
+    d->stat.rxBytes += n;
+    return n;
+}
+
+int loopread(int fd, char* buf, int len)
+{
+    if(fd <= 0 || fd >= LOOPIO_MAXNUM || !loopfd_list[fd].used || len <= 0) return -1;
+    LOOPIO_DIR* d = loopfd_list[fd].rx;
+    int n;
+
+    pthread_mutex_lock(&d->mutex);
+    unsigned long long now = loop_nowus();
+    unsigned long long end = now + d->cfg.readTimeout_us;
+    while(1){
+        n = take_ready(d, buf, len, now);
+        if(n > 0 || now >= end || loopclock) break;
+
+        //等到下一个数据块送达或者超时
+        unsigned long long wake = end;
+        if(d->pHead && d->pHead->deliver_us < wake) wake = d->pHead->deliver_us;
+        struct timespec tv;
+        clock_gettime(CLOCK_REALTIME, &tv);
+        unsigned long long ns = (unsigned long long)tv.tv_nsec + (wake-now)*1000ULL;
+        tv.tv_sec += ns/1000000000ULL;
+        tv.tv_nsec = ns%1000000000ULL;
+        pthread_cond_timedwait(&d->cond, &d->mutex, &tv);
+        now = loop_nowus();
+    }
+    pthread_mutex_unlock(&d->mutex);
+    return n;
+}
+
+int loopstat(int fd, LOOPIO_STAT* stat)
+{
+    if(fd <= 0 || fd >= LOOPIO_MAXNUM || !loopfd_list[fd].used || stat == NULL) return -1;
+    LOOPIO_DIR* d = loopfd_list[fd].tx;
+    pthread_mutex_lock(&d->mutex);
+    *stat = d->stat;
+    pthread_mutex_unlock(&d->mutex);
+    return 0;
+}
+
+void loopio_setclock(unsigned long long (*nowus)(void))
+{
+    loopclock = nowus;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//单线程主循环：两端互为主从，各自保持多个异步请求在途，同时响应对方的请求
+
+#if (IODP_OS==IODP_OS_NULL)
+
+int func_sum(uint16 len, void* data,uint16* retlen,void* retdata){
+    int sum = 0;
+    unsigned char *ptr = (unsigned char *)data;
+    for(int i=0; i<len; i++)
+    {
+        sum+=ptr[i];
+    }
+
+    *retlen=4;
+    *(int*)retdata=sum;
+    return 0;
+}
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+typedef struct
+{
+    eIODP_TYPE* peer;       //对方，用于校验读回的数据
+    int issued;
+    int done;
+    int ok;
+    int timeout;
+    int bad;
+}SIDE;
+
+typedef struct
+{
+    SIDE* side;
+    int isfunc;
+    unsigned short addr;
+    int expect;
+}REQ;
+
+static void on_done(void* ctx, int status, unsigned char* data, int len)
+{
+    REQ* rq = (REQ*)ctx;
+    SIDE* sd = rq->side;
+    sd->done++;
+    if(status == IODP_ERROR_TIMEOUT)sd->timeout++;
+    else if(status < 0)sd->bad++;
+    else if(rq->isfunc){
+        if(len==4 && *(int*)data==rq->expect)sd->ok++;
+        else sd->bad++;
+    }
+    else{
+        if(len==rq->expect && memcmp(data,&sd->peer->configmem[rq->addr],len)==0)sd->ok++;
+        else sd->bad++;
+    }
+    free(rq);
+}
+
+//尽量把请求表填满
+static void issue(eIODP_TYPE* pdev, SIDE* sd, int total)
+{
+    static unsigned char arg[32];
+    while(sd->issued < total){
+        REQ* rq = malloc(sizeof(REQ));
+        rq->side = sd;
+        rq->isfunc = sd->issued & 1;
+        int ret;
+        if(rq->isfunc){
+            int n = rand()%32+1, sum=0;
+            for(int i=0;i<n;i++){arg[i]=rand();sum+=arg[i];}
+            rq->expect = sum;
+            ret = eiodpFunctionAsync(pdev,0x660+rand()%4,n,arg,on_done,rq);
+        }
+        else{
+            rq->addr = rand()%256;
+            rq->expect = rand()%64+1;
+            ret = eiodpReadAddrAsync(pdev,rq->addr,rq->expect,on_done,rq);
+        }
+        //请求表满或者相同请求在途，下一轮再发
+        if(ret == IODP_ERROR_BUSY){free(rq);break;}
+        sd->issued++;
+    }
+}
+
+#define testcnt 400
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 115200);
+    cfg.latency_us = 2000;
+    cfg.droprate = 0.01;
+    cfg.seed = 5;
+    cfg.readTimeout_us = 0;
+
+    int fdA=0, fdB=0;
+    if(loopopen(&cfg, &cfg, &fdA, &fdB) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pA = eiodp_init(fdA,loopread,loopsend);
+    eIODP_TYPE* pB = eiodp_init(fdB,loopread,loopsend);
+    for(int i=0;i<4;i++){
+        eiodpRegister(pA,0x660+i,func_sum);
+        eiodpRegister(pB,0x660+i,func_sum);
+    }
+    eiodpSetTickSource(pA,tick_ms,1000);
+    eiodpSetTickSource(pB,tick_ms,1000);
+    for(int i=0;i<IODP_CONFIGMEM_SIZE;i++){
+        pA->configmem[i] = i*7;
+        pB->configmem[i] = i*13;
+    }
+
+    SIDE sa = {pB}, sb = {pA};
+    int maxinflight = 0;
+    srand(1);
+    uint32 start = tick_ms();
+    while(sa.done < testcnt || sb.done < testcnt){
+        issue(pA,&sa,testcnt);
+        issue(pB,&sb,testcnt);
+        int n = eiodpPendingCount(pA);
+        if(n > maxinflight)maxinflight = n;
+        eiodp_recvProcessTask_nos(pA);
+        eiodp_recvProcessTask_nos(pB);
+        if(tick_ms()-start > 60000){printf("test time out\n");break;}
+    }
+    uint32 cost = tick_ms()-start;
+
+    printf("A: done=%d ok=%d timeout=%d bad=%d\n",sa.done,sa.ok,sa.timeout,sa.bad);
+    printf("B: done=%d ok=%d timeout=%d bad=%d\n",sb.done,sb.ok,sb.timeout,sb.bad);
+    printf("time=%ums maxinflight=%d (%.2fms/req)\n",cost,maxinflight,(double)cost/(2*testcnt));
+    return (sa.done!=testcnt || sb.done!=testcnt || sa.bad || sb.bad);
+}
+
+#else
+//这里测试无操作系统下的单线程主循环，linux下的异步请求由test_coro覆盖
+int main()
+{
+    printf("single-thread async loop test is for IODP_OS_NULL\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,125 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <eiodp_batch.h>
+#include <loopio.h>
+
+//批量读写：随机的小范围读写交错进行，本地按程序顺序维护期望值，
+//检查合并后每个读看到的值与程序顺序一致，并统计实际发出的请求数
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+#define AREA 128
+#define testcnt 400
+#define maxlen 8
+
+typedef struct
+{
+    unsigned char buf[maxlen];
+    unsigned char expect[maxlen];
+    int len;
+    int status;
+}READREC;
+
+static READREC rec[testcnt];
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 1000;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pdev,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int errorcnt=0;
+    int i, nread=0;
+    unsigned char model[AREA];
+    if(eiodpReadAddr(pdev,0,AREA,model)!=AREA){
+        printf("initial read fail\n");
+        return 1;
+    }
+
+    eIODP_BATCH* b = eiodpBatchCreate(pdev,5000,0);
+    srand(9);
+    for(i=0;i<testcnt;i++){
+        int len = rand()%maxlen+1;
+        int addr = rand()%(AREA-len+1);
+        if(rand()%2){
+            unsigned char data[maxlen];
+            for(int j=0;j<len;j++)data[j]=rand();
+            eiodpBatchWrite(b,addr,len,data);
+            memcpy(&model[addr],data,len);
+        }
+        else{
+            READREC* r = &rec[nread++];
+            r->len = len;
+            memcpy(r->expect,&model[addr],len);
+            eiodpBatchRead(b,addr,len,r->buf,&r->status);
+        }
+    }
+    if(eiodpBatchFlush(b)!=IODP_OK){
+        printf("flush fail\n");
+        errorcnt++;
+    }
+    for(i=0;i<nread;i++){
+        if(rec[i].status!=rec[i].len || memcmp(rec[i].buf,rec[i].expect,rec[i].len)!=0){
+            printf("read %d mismatch status=%d\n",i,rec[i].status);
+            errorcnt++;
+        }
+    }
+    //全部发出后对方的配置空间与本地期望一致
+    unsigned char check[AREA];
+    if(eiodpReadAddr(pdev,0,AREA,check)!=AREA || memcmp(check,model,AREA)!=0){
+        printf("final content mismatch\n");
+        errorcnt++;
+    }
+
+    eIODP_BATCH_STAT st;
+    eiodpBatchGetStat(b,&st);
+    printf("ops=%u (reads %u writes %u) -> wire reads %u writes %u, flushes %u, write bytes %u -> %u\n",
+            st.reads+st.writes,st.reads,st.writes,st.wireReads,st.wireWrites,st.flushes,
+            st.writeBytes,st.wireWriteBytes);
+    if(st.wireReads+st.wireWrites >= st.reads+st.writes)errorcnt++;
+    eiodpBatchDestroy(b);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
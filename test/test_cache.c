@@ -0,0 +1,145 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <eiodp_cache.h>
+#include <loopio.h>
+
+//镜像缓存：检查命中、写穿、失效、过期与顺序预读，并统计实际发出的读请求数
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 500;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pdev,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int i;
+    unsigned char init[IODP_CONFIGMEM_SIZE];
+    for(i=0;i<IODP_CONFIGMEM_SIZE;i++)init[i]=i*7;
+    eiodpConfigWrite(pServer,0,IODP_CONFIGMEM_SIZE,init);
+
+    eIODP_CACHE* c = eiodpCacheCreate(pdev,200000,2);
+    eIODP_CACHE_STAT st;
+    unsigned char buf[64], truth[64];
+
+    //同一块内的寄存器只读一次
+    eiodpCacheRead(c,10,2,buf);
+    eiodpCacheRead(c,12,2,buf);
+    eiodpCacheRead(c,20,4,buf);
+    eiodpCacheGetStat(c,&st);
+    expect("block fill",st.wireReads==1 && st.hits==2 && buf[0]==init[20]);
+
+    //写穿后读回本地的值，对方也写入了
+    unsigned char v[2] = {0x55,0x66};
+    eiodpCacheWrite(c,12,2,v);
+    eiodpCacheRead(c,12,2,buf);
+    eiodpCacheGetStat(c,&st);
+    expect("write through local",st.wireReads==1 && buf[0]==0x55 && buf[1]==0x66);
+    eiodpReadAddr(pdev,12,2,truth);
+    expect("write through remote",truth[0]==0x55 && truth[1]==0x66);
+
+    //对方自己改了数据，有效期内看到的是旧值，失效后读到新值
+    v[0] = 0x77;
+    eiodpConfigWrite(pServer,12,1,v);
+    eiodpCacheRead(c,12,1,buf);
+    expect("stale within age",buf[0]==0x55);
+    eiodpCacheInvalidate(c,12,1);
+    eiodpCacheRead(c,12,1,buf);
+    expect("invalidate",buf[0]==0x77);
+    v[0] = 0x88;
+    eiodpConfigWrite(pServer,12,1,v);
+    usleep(250000);
+    eiodpCacheRead(c,12,1,buf);
+    expect("expired",buf[0]==0x88);
+    v[0] = 0x99;
+    eiodpConfigWrite(pServer,12,1,v);
+    eiodpCacheRefresh(c,0,16,nullptr);
+    eiodpCacheRead(c,12,1,buf);
+    expect("refresh",buf[0]==0x99);
+
+    //顺序扫描：每8字节读一次，预读使得读请求远少于块数
+    eiodpCacheInvalidate(c,0,0);
+    eiodpCacheGetStat(c,&st);
+    uint32 w0 = st.wireReads;
+    int ok = 1;
+    eiodpConfigRead(pServer,0,IODP_CONFIGMEM_SIZE,init);
+    for(i=0;i<IODP_CONFIGMEM_SIZE;i+=8){
+        if(eiodpCacheRead(c,i,8,buf)!=8 || memcmp(buf,&init[i],8)!=0)ok = 0;
+    }
+    eiodpCacheGetStat(c,&st);
+    printf("sequential %d reads of 8 bytes -> %u wire reads (%u blocks prefetched)\n",
+            IODP_CONFIGMEM_SIZE/8,st.wireReads-w0,st.prefetchBlocks);
+    expect("sequential data",ok);
+    expect("sequential prefetch",st.wireReads-w0 <= IODP_CFG_NBLOCK/3+1);
+
+    //随机寄存器轮询：有缓存与没有缓存的耗时
+    srand(1);
+    struct timespec ts0, ts1, ts2;
+    clock_gettime(CLOCK_MONOTONIC,&ts0);
+    for(i=0;i<200;i++)eiodpReadAddr(pdev,(rand()%64)*2,2,buf);
+    clock_gettime(CLOCK_MONOTONIC,&ts1);
+    for(i=0;i<200;i++)eiodpCacheRead(c,(rand()%64)*2,2,buf);
+    clock_gettime(CLOCK_MONOTONIC,&ts2);
+    printf("200 register reads: readaddr %ldms, cache %ldms\n",
+            (ts1.tv_sec-ts0.tv_sec)*1000+(ts1.tv_nsec-ts0.tv_nsec)/1000000,
+            (ts2.tv_sec-ts1.tv_sec)*1000+(ts2.tv_nsec-ts1.tv_nsec)/1000000);
+
+    eiodpCacheGetStat(c,&st);
+    printf("reads %u hits %u wire reads %u wire bytes %u writes %u\n",
+            st.reads,st.hits,st.wireReads,st.wireBytes,st.writes);
+    eiodpCacheDestroy(c);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp_co.hpp>
+#include <loopio.h>
+
+//C++20协程：单线程同时进行多个设备的大量会话，请求表满时排队，
+//检查读回的数据与调用结果、单次等待的期限、取消与嵌套的Task
+
+using namespace eiodp;
+
+#if (IODP_OS==IODP_OS_LINUX)
+#define NDEV 2          //设备个数，linux下每个句柄有自己的接收任务
+#else
+#define NDEV 8          //设备个数
+#endif
+#define NCONV 16        //每个设备的会话数
+#define NSTEP 20        //每个会话的请求数
+
+using Sum = Function<0x300,std::array<uint8,16>,uint32>;
+
+static int on_sum(const std::array<uint8,16>& a, uint32& r)
+{
+    r = 0;
+    for(uint8 v : a)r += v;
+    return 0;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+struct Stat
+{
+    int ok = 0;
+    int bad = 0;
+};
+
+//子协程：调用一次并检查结果
+static co::Task<int> checked_sum(eIODP_TYPE* dev, int seed)
+{
+    std::array<uint8,16> a;
+    uint32 expect_sum = 0;
+    for(int i=0;i<16;i++){a[i] = (uint8)(seed*7+i);expect_sum += a[i];}
+    uint32 r = 0;
+    int ret = co_await co::call<Sum>(dev,a,r);
+    co_return (ret == IODP_OK && r == expect_sum) ? 1 : 0;
+}
+
+//一个会话：交替读配置空间与调用函数
+static co::Task<> conversation(eIODP_TYPE* dev, eIODP_TYPE* peer, int id, Stat* st)
+{
+    unsigned char buf[64];
+    for(int s=0;s<NSTEP;s++){
+        if((id+s)&1){
+            uint16 addr = (uint16)((id*37+s*11)%(IODP_CONFIGMEM_SIZE-64));
+            uint16 len = (uint16)(1+(id+s)%64);
+            int r = co_await co::read(dev,addr,len,buf);
+            if(r == len && memcmp(buf,&peer->configmem[addr],len) == 0)st->ok++;
+            else st->bad++;
+        }
+        else{
+            if(co_await checked_sum(dev,id*NSTEP+s))st->ok++;
+            else st->bad++;
+        }
+    }
+}
+
+static int deadline_ret = 0, cancel_ret = 0, sleep_ret = -1;
+static long deadline_ms = 0;
+
+//对方不处理请求：单次等待的期限比RTO短
+static co::Task<> deadline_case(eIODP_TYPE* dev)
+{
+    unsigned char buf[8];
+    unsigned long long t0 = co::Executor::now();
+    deadline_ret = co_await co::read(dev,0,8,buf,{50000,nullptr});
+    deadline_ms = (long)((co::Executor::now()-t0)/1000);
+}
+
+static co::Task<> cancel_case(eIODP_TYPE* dev, co::CancelSource* cs)
+{
+    uint32 r;
+    std::array<uint8,16> a{};
+    cancel_ret = co_await co::call<Sum>(dev,a,r,{0,cs});
+}
+
+static co::Task<> canceller(co::CancelSource* cs)
+{
+    sleep_ret = co_await co::sleep(20000);
+    cs->cancel();
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 1000;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    co::Executor ex;
+    eIODP_TYPE* dev[NDEV];
+    eIODP_TYPE* srv[NDEV];
+    for(int d=0;d<NDEV;d++){
+        int fdMaster=0, fdServer=0;
+        if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+            printf("loopopen error\n");
+            return 1;
+        }
+        srv[d] = eiodp_init(fdServer,loopread,loopsend);
+        dev[d] = eiodp_init(fdMaster,loopread,loopsend);
+        serve<Sum,on_sum>(srv[d]);
+        for(int i=0;i<IODP_CONFIGMEM_SIZE;i++)srv[d]->configmem[i] = (char)(i*13+d);
+        ex.attach(srv[d]);
+        ex.attach(dev[d]);
+    }
+
+    //全部会话在一个线程中同时进行
+    Stat st;
+    for(int d=0;d<NDEV;d++){
+        for(int c=0;c<NCONV;c++)ex.spawn(conversation(dev[d],srv[d],d*NCONV+c,&st));
+    }
+    int maxq = 0;
+    unsigned long long t0 = co::Executor::now();
+    while(ex.live() > 0){
+        ex.poll();
+        if(ex.queued() > maxq)maxq = ex.queued();
+    }
+    long cost = (long)((co::Executor::now()-t0)/1000);
+    expect("conversations",st.ok == NDEV*NCONV*NSTEP && st.bad == 0);
+    printf("%d conversations on %d devices, %d requests: %ldms, max queued %d, ok=%d bad=%d\n",
+            NDEV*NCONV,NDEV,NDEV*NCONV*NSTEP,cost,maxq,st.ok,st.bad);
+
+    //期限与取消：对方不会返回（无操作系统下对方的句柄不由执行器驱动，linux下对方没有句柄）
+    int fdMaster=0, fdServer=0;
+    loopopen(&cfg, &cfg, &fdMaster, &fdServer);
+#if (IODP_OS==IODP_OS_NULL)
+    eIODP_TYPE* mute = eiodp_init(fdServer,loopread,loopsend);
+#else
+    eIODP_TYPE* mute = nullptr;
+#endif
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    ex.attach(pdev);
+    co::CancelSource cs;
+    ex.spawn(deadline_case(pdev));
+    ex.spawn(cancel_case(pdev,&cs));
+    ex.spawn(canceller(&cs));
+    ex.run();
+    expect("deadline",deadline_ret == IODP_ERROR_TIMEOUT && deadline_ms >= 50 && deadline_ms < 500);
+    expect("cancel",cancel_ret == IODP_ERROR_CANCELED && sleep_ret == IODP_OK && eiodpPendingCount(pdev) == 0);
+    //取消之后开始的等待立即返回
+    ex.spawn(cancel_case(pdev,&cs));
+    ex.run();
+    expect("cancelled source",cancel_ret == IODP_ERROR_CANCELED && eiodpPendingCount(pdev) == 0);
+    printf("deadline %ldms\n",deadline_ms);
+
+    for(int d=0;d<NDEV;d++){
+        eiodp_deinit(dev[d]);
+        eiodp_deinit(srv[d]);
+    }
+    eiodp_deinit(pdev);
+    eiodp_deinit(mute);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//条件读：从端的一大段数据变化很慢，主端分别用eiodpReadAddr与eiodpReadAddrIfChanged轮询，
+//检查缓存始终与从端一致，并比较从端发出的字节数
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+#define MAPLEN 384
+#define rounds 200
+
+//每5次轮询改变一个寄存器，偶尔整块改变
+static void mutate(eIODP_TYPE* pServer, int r)
+{
+    if(r%5)return;
+    unsigned char v[IODP_CFG_BLOCK];
+    if(r%50==0){
+        for(int i=0;i<IODP_CFG_BLOCK;i++)v[i]=rand();
+        eiodpConfigWrite(pServer,(rand()%(MAPLEN/IODP_CFG_BLOCK))*IODP_CFG_BLOCK,IODP_CFG_BLOCK,v);
+    }
+    else{
+        v[0]=r;
+        v[1]=r>>8;
+        eiodpConfigWrite(pServer,rand()%(MAPLEN-2),2,v);
+    }
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int errorcnt=0;
+    int r;
+    unsigned char cache[MAPLEN], truth[MAPLEN];
+    //初始内容：一半为0，一半为计数
+    for(r=0;r<MAPLEN;r++)truth[r] = (r<MAPLEN/2) ? 0 : r;
+    eiodpConfigWrite(pServer,0,MAPLEN,truth);
+    LOOPIO_STAT st0, st1, st2;
+
+    //全量轮询
+    srand(3);
+    loopstat(fdServer,&st0);
+    for(r=0;r<rounds;r++){
+        mutate(pServer,r);
+        if(eiodpReadAddr(pdev,0,MAPLEN,cache)!=MAPLEN)errorcnt++;
+    }
+    loopstat(fdServer,&st1);
+
+    //条件读轮询
+    uint32 ver = 0;
+    int notmod = 0, changed = 0;
+    srand(3);
+    for(r=0;r<rounds;r++){
+        mutate(pServer,r);
+        int ret = eiodpReadAddrIfChanged(pdev,0,MAPLEN,cache,&ver);
+        if(ret<0){printf("round %d ret %d\n",r,ret);errorcnt++;continue;}
+        if(ret==0)notmod++;
+        else changed++;
+        eiodpConfigRead(pServer,0,MAPLEN,truth);
+        if(memcmp(cache,truth,MAPLEN)!=0){
+            printf("round %d cache mismatch\n",r);
+            errorcnt++;
+        }
+    }
+    loopstat(fdServer,&st2);
+
+    unsigned long long full = st1.txBytes-st0.txBytes, cond = st2.txBytes-st1.txBytes;
+    printf("%d polls of %d bytes: readaddr %llu bytes, conditional %llu bytes (%.1fx), not modified %d changed %d\n",
+            rounds,MAPLEN,full,cond,(double)full/cond,notmod,changed);
+    if(cond*10 > full)errorcnt++;
+
+    //越界与参数检查
+    uint32 v2 = 0;
+    if(eiodpReadAddrIfChanged(pdev,IODP_CONFIGMEM_SIZE-4,8,cache,&v2)!=IODP_ERROR_PKT)errorcnt++;
+    if(eiodpReadAddrIfChanged(pdev,0,IODP_RETURN_BUFFER,cache,&v2)!=IODP_ERROR_PARAM)errorcnt++;
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.hpp>
+#include <loopio.h>
+
+//C++封装：检查编码长度与大端字节、类型化的服务函数与调用、返回长度检查，
+//并比较类型化调用与eiodpFunction的耗时
+
+struct MotorCmd
+{
+    uint16 speed;
+    int8_t dir;
+    float gain;
+    std::array<uint16,3> pid;
+    static constexpr auto eiodp_fields = std::make_tuple(&MotorCmd::speed,&MotorCmd::dir,
+                                                         &MotorCmd::gain,&MotorCmd::pid);
+};
+
+enum class Mode : uint8 { Idle = 1, Run = 2 };
+
+struct MotorState
+{
+    Mode mode;
+    int32_t pos;
+    bool fault;
+    static constexpr auto eiodp_fields = std::make_tuple(&MotorState::mode,&MotorState::pos,&MotorState::fault);
+};
+
+using SetMotor = eiodp::Function<0x200,MotorCmd,MotorState>;
+using Sum = eiodp::Function<0x201,std::array<uint32,8>,std::pair<uint32,uint16>>;
+using Ping = eiodp::Function<0x202>;
+using Big = eiodp::Function<0x203,uint8,std::array<uint8,200>>;
+
+static_assert(eiodp::Codec<MotorCmd>::size == 2+1+4+6, "MotorCmd");
+static_assert(SetMotor::resSize == 1+4+1, "MotorState");
+
+static int pings = 0;
+
+static int on_setmotor(const MotorCmd& c, MotorState& s)
+{
+    s.mode = c.speed ? Mode::Run : Mode::Idle;
+    s.pos = c.dir*(int32_t)c.speed + c.pid[0] + c.pid[1] + c.pid[2] + (int32_t)c.gain;
+    s.fault = c.gain < 0;
+    return 0;
+}
+
+static int on_sum(const std::array<uint32,8>& a, std::pair<uint32,uint16>& r)
+{
+    r.first = 0;
+    for(uint32 v : a)r.first += v;
+    r.second = 8;
+    return 0;
+}
+
+static int on_ping(const eiodp::None&, eiodp::None&)
+{
+    pings++;
+    return 0;
+}
+
+static int on_big(const uint8& fill, std::array<uint8,200>& r)
+{
+    r.fill(fill);
+    return 0;
+}
+
+#if (IODP_OS==IODP_OS_NULL)
+static volatile int running = 1;
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(running)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+static long elapsed_us(struct timespec* a, struct timespec* b)
+{
+    return (b->tv_sec-a->tv_sec)*1000000+(b->tv_nsec-a->tv_nsec)/1000;
+}
+
+#define rounds 200
+
+int main()
+{
+    //编码：成员紧密排列，大端
+    MotorCmd c{0x1234,-1,2.0f,{{1,2,3}}};
+    unsigned char enc[eiodp::Codec<MotorCmd>::size];
+    eiodp::Codec<MotorCmd>::encode(enc,c);
+    expect("encode",enc[0] == 0x12 && enc[1] == 0x34 && enc[2] == 0xff &&
+                    enc[3] == 0x40 && enc[4] == 0x00 && enc[7] == 0x00 && enc[8] == 0x01);
+    MotorCmd d{};
+    eiodp::Codec<MotorCmd>::decode(enc,d);
+    expect("decode",d.speed == 0x1234 && d.dir == -1 && d.gain == 2.0f && d.pid[2] == 3);
+
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    {
+        eiodp::Device server(fdServer,loopread,loopsend);
+        eiodp::Device dev(fdMaster,loopread,loopsend);
+        expect("serve",eiodp::serve<SetMotor,on_setmotor>(server) == 0 &&
+                       eiodp::serve<Sum,on_sum>(server) == 0 &&
+                       eiodp::serve<Ping,on_ping>(server) == 0 &&
+                       eiodp::serve<Big,on_big>(server) == 0);
+#if (IODP_OS==IODP_OS_NULL)
+        pthread_t t1;
+        pthread_create(&t1,NULL,slaver,server.get());
+#endif
+
+        //类型化调用
+        MotorState s{};
+        expect("call",eiodp::call<SetMotor>(dev,c,s) == IODP_OK &&
+                      s.mode == Mode::Run && s.pos == -0x1234+6+2 && !s.fault);
+        std::array<uint32,8> a;
+        for(int i=0;i<8;i++)a[i] = 1000000u*(i+1);
+        std::pair<uint32,uint16> sum;
+        expect("sum",eiodp::call<Sum>(dev,a,sum) == IODP_OK && sum.first == 36000000u && sum.second == 8);
+        expect("ping",eiodp::call<Ping>(dev) == IODP_OK && eiodp::call<Ping>(dev) == IODP_OK && pings == 2);
+        std::array<uint8,200> big;
+        expect("big",eiodp::call<Big>(dev,(uint8)0x5a,big) == IODP_OK && big[0] == 0x5a && big[199] == 0x5a);
+
+        //返回类型与服务端不一致
+        using ShortRes = eiodp::Function<0x201,std::array<uint32,8>,uint32>;
+        uint32 w = 0;
+        expect("short result",eiodp::call<ShortRes>(dev,a,w) == IODP_ERROR_RETSIZE);
+        using LongRes = eiodp::Function<0x201,std::array<uint32,8>,std::array<uint32,2>>;
+        std::array<uint32,2> w2;
+        expect("long result",eiodp::call<LongRes>(dev,a,w2) == IODP_ERROR_RECVLEN);
+        //参数长度不对，服务端返回0字节
+        using WrongArg = eiodp::Function<0x200,uint16,MotorState>;
+        expect("wrong arg",eiodp::call<WrongArg>(dev,(uint16)1,s) == IODP_ERROR_RECVLEN);
+
+        //C接口：返回超过调用者的缓存
+        unsigned char frame[IODP_FUNC_FRAMELEN(1)];
+        unsigned char ret[64];
+        uint8 fill = 7;
+        expect("retsize",eiodpFunctionEx(dev,0x203,1,&fill,ret,sizeof(ret),frame) == IODP_ERROR_RETSIZE);
+        unsigned char ret2[256];
+        expect("retcap",eiodpFunctionEx(dev,0x203,1,&fill,ret2,sizeof(ret2),frame) == 200 && ret2[100] == 7);
+
+        //类型化调用与eiodpFunction
+        struct timespec ts0, ts1, ts2;
+        unsigned char raw[32], rawret[8];
+        clock_gettime(CLOCK_MONOTONIC,&ts0);
+        for(int r=0;r<rounds;r++)eiodp::call<Sum>(dev,a,sum);
+        clock_gettime(CLOCK_MONOTONIC,&ts1);
+        eiodp::Codec<std::array<uint32,8>>::encode(raw,a);
+        for(int r=0;r<rounds;r++)eiodpFunction(dev,0x201,sizeof(raw),raw,rawret);
+        clock_gettime(CLOCK_MONOTONIC,&ts2);
+        printf("%d calls: typed %ldus, eiodpFunction %ldus\n",rounds,elapsed_us(&ts0,&ts1),elapsed_us(&ts1,&ts2));
+
+        //移动后原对象不再拥有句柄
+        eiodp::Device moved(std::move(dev));
+        expect("move",dev.get() == nullptr && moved.get() != nullptr);
+        expect("moved call",eiodp::call<Ping>(moved) == IODP_OK);
+
+#if (IODP_OS==IODP_OS_NULL)
+        running = 0;
+        pthread_join(t1,NULL);
+#endif
+    }
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//延迟返回的服务函数：服务函数要做IOTIME_US的io，
+//比较同步服务函数与延迟返回时，同一链路上并行的读请求能完成多少
+
+#define IOTIME_US 5000      //服务函数的io时间
+#define NSLOW 40            //服务函数调用次数
+#define QMAX 16
+#define RETRY_MAX 5         //同步调用超时后重新调用的次数
+
+static unsigned long long now_us(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (unsigned long long)tv.tv_sec*1000000 + tv.tv_nsec/1000;
+}
+
+static int arg_sum(uint16 len, void* data)
+{
+    int sum = 0;
+    unsigned char *ptr = (unsigned char *)data;
+    for(int i=0; i<len; i++)sum+=ptr[i];
+    return sum;
+}
+
+//同步服务函数：在接收任务里等io
+int func_slow(uint16 len, void* data,uint16* retlen,void* retdata){
+    usleep(IOTIME_US);
+    *retlen=4;
+    *(int*)retdata=arg_sum(len,data);
+    return 0;
+}
+
+//模拟的io队列，到期后完成
+typedef struct
+{
+    eIODP_DEFER token;
+    int sum;
+    unsigned long long due;
+}IOREQ;
+
+static IOREQ ioq[QMAX];
+static int ioqn = 0;
+static pthread_mutex_t ioq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//延迟返回：排进io队列后立即返回
+int func_defer(eIODP_DEFER token, uint16 len, void* data){
+    int ret = 0;
+    pthread_mutex_lock(&ioq_mutex);
+    if(ioqn < QMAX){
+        ioq[ioqn].token = token;
+        ioq[ioqn].sum = arg_sum(len,data);
+        ioq[ioqn].due = now_us()+IOTIME_US;
+        ioqn++;
+    }
+    else ret = -1;
+    pthread_mutex_unlock(&ioq_mutex);
+    return ret;
+}
+
+//拒绝请求，对方收到0字节
+int func_reject(eIODP_DEFER token, uint16 len, void* data){
+    return -1;
+}
+
+//保存token，由主流程完成，检查token不能重复完成
+static eIODP_DEFER held;
+static volatile int heldCnt = 0;
+int func_hold(eIODP_DEFER token, uint16 len, void* data){
+    held = token;
+    heldCnt++;
+    return 0;
+}
+
+//完成到期的io
+static void io_Service(void)
+{
+    IOREQ done[QMAX];
+    int n = 0;
+    unsigned long long now = now_us();
+    pthread_mutex_lock(&ioq_mutex);
+    for(int i=0;i<ioqn;){
+        if(ioq[i].due <= now){
+            done[n++] = ioq[i];
+            ioq[i] = ioq[--ioqn];
+        }
+        else i++;
+    }
+    pthread_mutex_unlock(&ioq_mutex);
+    for(int i=0;i<n;i++)eiodpComplete(done[i].token,4,&done[i].sum);
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+typedef struct
+{
+    eIODP_TYPE* pdev;
+    eIODP_TYPE* pServer;
+    uint16 code;
+    volatile int done;
+    int ok;
+    int retries;
+    int reads;
+    int readbad;
+}RUN;
+
+static void run_print(RUN* r, const char* name, unsigned long long cost)
+{
+    printf("%s: %d calls ok=%d (retries %d), %d reads (bad %d) in %llums\n",
+            name,NSLOW,r->ok,r->retries,r->reads,r->readbad,cost/1000);
+}
+
+static volatile int holdDone = 0;
+
+static void on_hold(void* ctx, int status, unsigned char* data, int len)
+{
+    holdDone = 1;
+}
+
+//处理两端一次，linux下由接收任务处理，只等一会
+static void poll_both(eIODP_TYPE* a, eIODP_TYPE* b)
+{
+#if (IODP_OS==IODP_OS_NULL)
+    eiodp_recvProcessTask_nos(a);
+    eiodp_recvProcessTask_nos(b);
+#else
+    usleep(100);
+#endif
+}
+
+#if (IODP_OS==IODP_OS_LINUX)
+
+static volatile int running = 1;
+
+void* ioworker(void* arg)
+{
+    while(running){
+        io_Service();
+        usleep(200);
+    }
+    return NULL;
+}
+
+void* caller(void* arg)
+{
+    RUN* r = (RUN*)arg;
+    unsigned char buf[32];
+    for(int c=0;c<NSLOW;c++){
+        int n = c%32+1, sum = 0, ret = 0;
+        for(int i=0;i<n;i++){buf[i]=rand();sum+=buf[i];}
+        //同步服务函数在接收任务里做io，调度抖动时返回可能晚于RTO；
+        //等迟到的返回到达后用同样的参数再调用，调用开始时会丢弃迟到的返回
+        for(int t=0;t<RETRY_MAX;t++){
+            if(eiodpFunction(r->pdev,r->code,n,buf,&ret) == 4 && ret == sum){r->ok++;break;}
+            r->retries++;
+            usleep(100000);
+        }
+    }
+    r->done = 1;
+    return NULL;
+}
+
+//另一个线程连续调用服务函数，本线程在同一链路上连续读
+static unsigned long long run(RUN* r)
+{
+    unsigned char buf[64];
+    pthread_t t;
+    unsigned long long t0 = now_us();
+    pthread_create(&t,NULL,caller,r);
+    while(!r->done){
+        uint16 addr = (uint16)(r->reads*7%(IODP_CONFIGMEM_SIZE-64));
+        if(eiodpReadAddr(r->pdev,addr,64,buf) == 64 && memcmp(buf,&r->pServer->configmem[addr],64) == 0)r->reads++;
+        else r->readbad++;
+    }
+    pthread_join(t,NULL);
+    return now_us()-t0;
+}
+
+#elif (IODP_OS==IODP_OS_NULL)
+
+static int readBusy = 0, callBusy = 0, expectSum = 0;
+static uint16 readAddr = 0;
+
+static void on_read(void* ctx, int status, unsigned char* data, int len)
+{
+    RUN* r = (RUN*)ctx;
+    readBusy = 0;
+    if(len == 64 && memcmp(data,&r->pServer->configmem[readAddr],64) == 0)r->reads++;
+    else r->readbad++;
+}
+
+static void on_call(void* ctx, int status, unsigned char* data, int len)
+{
+    RUN* r = (RUN*)ctx;
+    callBusy = 0;
+    if(len == 4 && *(int*)data == expectSum)r->ok++;
+    r->done++;
+}
+
+static void on_reject(void* ctx, int status, unsigned char* data, int len)
+{
+    RUN* r = (RUN*)ctx;
+    callBusy = 0;
+    if(status == 0 && len == 0)r->ok++;
+}
+
+//单线程主循环：保持一个服务函数调用和一个读请求在途，同时处理两端
+static unsigned long long run(RUN* r)
+{
+    unsigned char buf[32];
+    unsigned long long t0 = now_us();
+    while(r->done < NSLOW){
+        if(!callBusy){
+            int n = r->done%32+1;
+            expectSum = 0;
+            for(int i=0;i<n;i++){buf[i]=rand();expectSum+=buf[i];}
+            if(eiodpFunctionAsync(r->pdev,r->code,n,buf,on_call,r) == IODP_OK)callBusy = 1;
+        }
+        if(!readBusy){
+            readAddr = (uint16)(r->reads*7%(IODP_CONFIGMEM_SIZE-64));
+            if(eiodpReadAddrAsync(r->pdev,readAddr,64,on_read,r) == IODP_OK)readBusy = 1;
+        }
+        eiodp_recvProcessTask_nos(r->pServer);
+        io_Service();
+        eiodp_recvProcessTask_nos(r->pdev);
+    }
+    while(readBusy)eiodp_recvProcessTask_nos(r->pServer),eiodp_recvProcessTask_nos(r->pdev);
+    return now_us()-t0;
+}
+
+#endif
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 100;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    for(int i=0;i<IODP_CONFIGMEM_SIZE;i++)pServer->configmem[i] = (char)(i*13);
+    expect("register",eiodpRegister(pServer,0x500,func_slow) == IODP_OK &&
+                      eiodpRegisterDeferred(pServer,0x501,func_defer) == IODP_OK &&
+                      eiodpRegisterDeferred(pServer,0x502,func_reject) == IODP_OK &&
+                      eiodpRegisterDeferred(pServer,0x504,func_hold) == IODP_OK);
+    expect("repeat",eiodpRegisterDeferred(pServer,0x500,func_defer) == IODP_ERROR_REPEATCODE);
+    expect("null",eiodpRegisterDeferred(pServer,0x503,NULL) == IODP_ERROR_PARAM);
+    eiodpShowRegFunc(pServer);
+#if (IODP_OS==IODP_OS_LINUX)
+    pthread_t t1;
+    pthread_create(&t1,NULL,ioworker,NULL);
+#endif
+    srand(1);
+
+    RUN rs = {pdev,pServer,0x500};
+    unsigned long long costSync = run(&rs);
+    run_print(&rs,"sync",costSync);
+    RUN rd = {pdev,pServer,0x501};
+    unsigned long long costDefer = run(&rd);
+    run_print(&rd,"deferred",costDefer);
+
+    expect("sync calls",rs.ok == NSLOW && rs.readbad == 0);
+    expect("deferred calls",rd.ok == NSLOW && rd.readbad == 0);
+    //同步时读请求要等服务函数的io，延迟返回时不受影响
+    expect("throughput",rd.reads > 4*rs.reads);
+    expect("open",eiodpDeferredCount(pServer) == 0);
+
+#if (IODP_OS==IODP_OS_LINUX)
+    //拒绝的请求立即返回0字节
+    unsigned char arg = 1;
+    int ret = 0;
+    expect("reject",eiodpFunction(pdev,0x502,1,&arg,&ret) == 0 && eiodpDeferredCount(pServer) == 0);
+    running = 0;
+    pthread_join(t1,NULL);
+#elif (IODP_OS==IODP_OS_NULL)
+    unsigned char arg = 1;
+    RUN rj = {pdev,pServer,0x502};
+    callBusy = 1;
+    expect("reject",eiodpFunctionAsync(pdev,0x502,1,&arg,on_reject,&rj) == IODP_OK);
+    while(callBusy)eiodp_recvProcessTask_nos(pServer),eiodp_recvProcessTask_nos(pdev);
+    expect("reject",rj.ok == 1 && eiodpDeferredCount(pServer) == 0);
+#endif
+    //token只能完成一次，伪造的token不会发出返回
+    expect("hold",eiodpFunctionAsync(pdev,0x504,1,&arg,on_hold,NULL) == IODP_OK);
+    for(int i=0;i<100000 && heldCnt == 0;i++)poll_both(pServer,pdev);
+    static unsigned char big[IODP_FUNCPKT_RET_LEN];
+    int v = 7;
+    eIODP_DEFER forged = {pServer,0x504,0,0};
+    eIODP_DEFER moved = held;
+    moved.slot = (uint16)((held.slot+1)%IODP_DEFER_MAX);
+    expect("held",heldCnt == 1 && eiodpDeferredCount(pServer) == 1);
+    expect("retlen",eiodpComplete(held,IODP_FUNCPKT_RET_LEN-13,big) == IODP_ERROR_PARAM);
+    expect("forged",eiodpComplete(forged,4,&v) == IODP_ERROR_STALE &&
+                    eiodpComplete(moved,4,&v) == IODP_ERROR_STALE);
+    expect("complete",eiodpComplete(held,4,&v) == IODP_OK);
+    expect("double",eiodpComplete(held,4,&v) == IODP_ERROR_STALE && eiodpDeferredCount(pServer) == 0);
+    for(int i=0;i<100000 && !holdDone;i++)poll_both(pServer,pdev);
+
+    eiodp_deinit(pdev);
+    eiodp_deinit(pServer);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
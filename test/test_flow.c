@@ -0,0 +1,121 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//服务端处理速度远低于链路速度，主端连续写：
+//不开流量控制时链路缓存溢出丢包，开启后不再丢包，最后读回校验
+
+//慢速读：每次最多读64字节，读一次停1ms
+static int slowread(int fd, char* buf, int len)
+{
+    if(len > 64)len = 64;
+    int n = loopread(fd,buf,len);
+    if(n > 0)usleep(1000);
+    return n;
+}
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+#define testcnt 100
+#define testlen 200
+
+//连续写testcnt次，返回链路溢出丢弃的包数
+static int blast(eIODP_TYPE* pdev, eIODP_TYPE* pServer, int fdMaster, int flow, int* errorcnt)
+{
+    LOOPIO_STAT st0, st1;
+    eIODP_METRICS m0, m1;
+    unsigned char buf[testlen];
+    unsigned char rbuf[testlen];
+    int i, cnt;
+
+    eiodpSetFlowControl(pdev,flow);
+    loopstat(fdMaster,&st0);
+    eiodpGetMetrics(pServer,&m0);
+    for(cnt=0;cnt<testcnt;cnt++){
+        for(i=0;i<testlen;i++){
+            buf[i]=rand();
+        }
+        eiodpWriteAddr(pdev,(cnt%2)*testlen,testlen,buf);
+    }
+    //读请求排在所有写之后，返回时之前的写都已经处理完
+    int ret = eiodpReadAddr(pdev,((testcnt-1)%2)*testlen,testlen,rbuf);
+    loopstat(fdMaster,&st1);
+    eiodpGetMetrics(pServer,&m1);
+
+    int overflow = (int)(st1.overflowChunks-st0.overflowChunks);
+    printf("flow=%d overflow=%d rxFrames=%u crcErrors=%u resyncs=%u\n",flow,overflow,
+            m1.cnt.rxFrames-m0.cnt.rxFrames,m1.cnt.crcErrors-m0.cnt.crcErrors,m1.cnt.resyncs-m0.cnt.resyncs);
+    if(flow){
+        if(ret != testlen || memcmp(rbuf,buf,testlen) != 0){
+            printf("read back mismatch ret=%d\n",ret);
+            (*errorcnt)++;
+        }
+        if(overflow != 0 || m1.cnt.rxFrames-m0.cnt.rxFrames < testcnt+1){
+            printf("frames lost with flow control\n");
+            (*errorcnt)++;
+        }
+    }
+    return overflow;
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.queueLimit = 1024;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,slowread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pdev,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    srand(5);
+    int errorcnt=0;
+    int lost = blast(pdev,pServer,fdMaster,0,&errorcnt);
+    //等服务端把上一轮残留的数据处理完
+    usleep(200*1000);
+    blast(pdev,pServer,fdMaster,1,&errorcnt);
+
+    eIODP_METRICS m;
+    eiodpGetMetrics(pdev,&m);
+    printf("without flow control lost %d frames, flowStalls=%u flowProbes=%u\n",
+            lost,m.cnt.flowStalls,m.cnt.flowProbes);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+
+//多线程连续写日志，统计每条日志的调用开销，检查限速与格式化结果
+
+#define threadnum 4
+#define logcnt 200000
+
+static int linecnt = 0;
+static int suppresscnt = 0;
+static char lastline[IODP_LOG_LINE_LEN];
+
+static void sink(int level, const char* line)
+{
+    __atomic_fetch_add(&linecnt,1,__ATOMIC_RELAXED);
+    if(strstr(line,"suppressed"))__atomic_fetch_add(&suppresscnt,1,__ATOMIC_RELAXED);
+    strncpy(lastline,line,sizeof(lastline)-1);
+}
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static double nowns(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec*1e9 + tv.tv_nsec;
+}
+
+//所有线程共用同一个调用点
+static void logone(long id, int i)
+{
+    IODP_LOGW("writer %ld pkt type 0x%02x no match, len=%u\n",id,i&0xff,(unsigned)i);
+}
+
+void* writer(void* arg)
+{
+    long id = (long)arg;
+    for(int i=0;i<logcnt;i++){
+        logone(id,i);
+        //DEBUG级别默认不参与编译，参数不会被求值
+        IODP_LOGD("debug %d\n",abort());
+    }
+    return NULL;
+}
+
+int main()
+{
+    eiodp_logSetSink(sink);
+    eiodp_logSetClock(tick_ms);
+
+    pthread_t t[threadnum];
+    double start = nowns();
+    for(long i=0;i<threadnum;i++)pthread_create(&t[i],NULL,writer,(void*)i);
+    for(int i=0;i<threadnum;i++)pthread_join(t[i],NULL);
+    double cost = nowns()-start;
+
+    //限速窗口结束后的第一条带上被抑制的条数
+    usleep((IODP_LOG_RATE_MS+10)*1000);
+    logone(9,0);
+    IODP_LOGW("after window %s %d %05x %c\n",(long)"str",-5,0xabc,'z');
+    eiodp_logFlush();
+
+    printf("threads=%d calls=%d cost=%.1fns/call\n",threadnum,threadnum*logcnt,cost/(threadnum*logcnt));
+    printf("lines=%d suppressed-notes=%d dropped=%u\n",linecnt,suppresscnt,eiodp_logDropped());
+    printf("last: %s",lastline);
+
+    int err = 0;
+    if(suppresscnt != 1)err++;
+    if(strstr(lastline,"after window str -5 00abc z") == NULL)err++;
+    return err;
+}
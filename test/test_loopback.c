@@ -0,0 +1,145 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//在模拟的115200串口链路上跑读写与function，统计成功率与耗时
+
+int func_sum(uint16 len, void* data,uint16* retlen,void* retdata){
+    int sum = 0;
+    unsigned char *ptr = (unsigned char *)data;
+    for(int i=0; i<len; i++)
+    {
+        sum+=ptr[i];
+    }
+
+    *retlen=4;
+    *(int*)retdata=sum;
+    return 0;
+}
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+//无操作系统模式下给eiodp提供的时钟源
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static double nowms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec*1000.0 + tv.tv_nsec/1000000.0;
+}
+
+#define testpkt_len 64
+#define testcnt 200
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 115200);
+    cfg.latency_us = 2000;
+    cfg.jitter_us = 500;
+    cfg.ber = 1e-6;
+    cfg.droprate = 0.001;
+    cfg.seed = 1;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;  //无操作系统模式下靠轮询，读不能阻塞
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eiodpRegister(pServer,0x666,func_sum);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+
+#if (IODP_OS==IODP_OS_NULL)
+    eiodpSetTickSource(pdev,tick_ms,1000);
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    srand(1);
+    int errorcnt=0;
+    int i=0, cnt=0;
+    unsigned char buf[testpkt_len];
+    unsigned char recvbuf[testpkt_len];
+
+    double start = nowms();
+    for(cnt=0;cnt<testcnt;cnt++){
+        for(i=0;i<testpkt_len;i++){
+            buf[i]=rand()%testpkt_len;
+        }
+        int randlen = rand()%testpkt_len+1;
+        eiodpWriteAddr(pdev,0,randlen,buf);
+        int retlen = eiodpReadAddr(pdev,0,randlen,recvbuf);
+        if(retlen!=randlen || memcmp(buf,recvbuf,randlen)!=0){
+            errorcnt++;
+            continue;
+        }
+
+        int funcret=0;
+        retlen = eiodpFunction(pdev,0x666,randlen,buf,&funcret);
+        int sum=0;
+        for(i=0;i<randlen;i++) sum+=buf[i];
+        if(retlen!=4 || sum!=funcret) errorcnt++;
+    }
+    double cost = nowms()-start;
+
+    uint32 srtt=0,rttvar=0,rto=0;
+    eiodpGetRtt(pdev,IODP_RTT_ADDR,&srtt,&rttvar,&rto);
+    printf("addr srtt=%uus rttvar=%uus rto=%uus\n",srtt,rttvar,rto);
+
+    LOOPIO_STAT st;
+    loopstat(fdMaster,&st);
+    printf("cnt=%d errorcnt=%d time=%.1fms (%.2fms/op)\n",testcnt,errorcnt,cost,cost/testcnt);
+    printf("master->server tx=%llu chunks=%llu drop=%llu errbytes=%llu\n",
+            st.txBytes,st.txChunks,st.dropChunks,st.errBytes);
+    loopstat(fdServer,&st);
+    printf("server->master tx=%llu chunks=%llu drop=%llu errbytes=%llu\n",
+            st.txBytes,st.txChunks,st.dropChunks,st.errBytes);
+
+    static const char* opname[IODP_OP_NUM] = {"readaddr","function","rwrite"};
+    eIODP_METRICS_SUMMARY sum;
+    for(int side=0;side<2;side++){
+        int ret = side==0 ? eiodpGetMetricsSummary(pdev,&sum) : eiodpGetRemoteMetrics(pdev,&sum);
+        if(ret != IODP_OK){
+            printf("%s metrics error %d\n",side==0?"local":"remote",ret);
+            continue;
+        }
+        printf("[%s] rx=%u/%uB tx=%u/%uB crc=%u resync=%u unknown=%u timeout=%u retry=%u err=%u\n",
+                side==0?"master":"server",sum.cnt.rxFrames,sum.cnt.rxBytes,sum.cnt.txFrames,sum.cnt.txBytes,
+                sum.cnt.crcErrors,sum.cnt.resyncs,sum.cnt.unknownType,sum.cnt.timeouts,sum.cnt.retries,sum.cnt.errorPkts);
+        for(int op=0;op<IODP_OP_NUM;op++){
+            if(sum.lat[op].count == 0)continue;
+            printf("    %-8s n=%u p50<=%uus p90<=%uus p99<=%uus max=%uus\n",opname[op],sum.lat[op].count,
+                    sum.lat[op].p50,sum.lat[op].p90,sum.lat[op].p99,sum.lat[op].max);
+        }
+    }
+
+    return 0;
+}
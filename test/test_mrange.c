@@ -0,0 +1,125 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//多段读写：40个分散的寄存器一次读回，与逐个eiodpReadAddr比较耗时；
+//多段写中有一段越界时整包不写
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static double nowms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec*1000.0 + tv.tv_nsec/1000000.0;
+}
+
+#define rangecnt 40
+#define rangelen 4
+#define rangestep 12
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 2000;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pdev,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    srand(11);
+    int errorcnt=0;
+    int i, ret;
+    unsigned char wdata[rangecnt][rangelen];
+    unsigned char rdata[rangecnt][rangelen];
+    eIODP_RANGE wr[rangecnt], rr[rangecnt];
+    for(i=0;i<rangecnt;i++){
+        for(int j=0;j<rangelen;j++)wdata[i][j]=rand();
+        wr[i].addr = i*rangestep;
+        wr[i].len = rangelen;
+        wr[i].buf = wdata[i];
+        rr[i] = wr[i];
+        rr[i].buf = rdata[i];
+    }
+
+    //写入后多段读回
+    if(eiodpWriteMulti(pdev,wr,rangecnt)!=IODP_OK){
+        printf("write multi fail\n");
+        errorcnt++;
+    }
+    memset(rdata,0,sizeof(rdata));
+    ret = eiodpReadMulti(pdev,rr,rangecnt);
+    if(ret!=rangecnt*rangelen || memcmp(rdata,wdata,sizeof(wdata))!=0){
+        printf("read multi mismatch ret=%d\n",ret);
+        errorcnt++;
+    }
+
+    //逐段读与多段读的耗时
+    double start = nowms();
+    for(i=0;i<rangecnt;i++){
+        if(eiodpReadAddr(pdev,rr[i].addr,rangelen,rdata[i])!=rangelen)errorcnt++;
+    }
+    double single = nowms()-start;
+    start = nowms();
+    if(eiodpReadMulti(pdev,rr,rangecnt)!=rangecnt*rangelen)errorcnt++;
+    double multi = nowms()-start;
+    printf("%d ranges: readaddr %.1fms, readmulti %.1fms\n",rangecnt,single,multi);
+
+    //有一段越界，整包都不能写入
+    unsigned char bad[rangelen] = {0xaa,0xaa,0xaa,0xaa};
+    eIODP_RANGE br[2];
+    br[0].addr = 0; br[0].len = rangelen; br[0].buf = bad;
+    br[1].addr = IODP_CONFIGMEM_SIZE-2; br[1].len = rangelen; br[1].buf = bad;
+    eiodpWriteMulti(pdev,br,2);
+    ret = eiodpReadMulti(pdev,rr,1);
+    if(ret!=rangelen || memcmp(rdata[0],wdata[0],rangelen)!=0){
+        printf("partial multi write applied\n");
+        errorcnt++;
+    }
+    //读越界返回错误包
+    ret = eiodpReadMulti(pdev,br,2);
+    if(ret!=IODP_ERROR_PKT){
+        printf("out of range read multi ret=%d\n",ret);
+        errorcnt++;
+    }
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
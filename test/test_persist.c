@@ -0,0 +1,160 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//配置空间持久化：检查点后重新打开恢复到最新的检查点，检查点之后的写入在“崩溃”后丢弃，
+//最新的槽或者文件头损坏时恢复到前一个检查点，周期检查点只在有写入时写
+
+#define PATH "/tmp/eiodp_persist_test.bin"
+#define PATH2 "/tmp/eiodp_persist_test2.bin"
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+//新建一对主从句柄，从端先开启持久化再启动接收
+static eIODP_TYPE* open_server(const char* path, uint32 interval_ms, eIODP_TYPE** pdev, int* ret)
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        exit(1);
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eiodpSetTickSource(pServer,tick_ms,1000);
+    *ret = eiodpConfigPersist(pServer,path,interval_ms);
+    if(pdev)*pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t;
+    pthread_create(&t,NULL,slaver,pServer);
+#endif
+    return pServer;
+}
+
+//把文件中偏移off处的一个字节取反
+static void corrupt(uint32 off)
+{
+    int f = open(PATH,O_RDWR);
+    unsigned char b;
+    pread(f,&b,1,off);
+    b ^= 0xff;
+    pwrite(f,&b,1,off);
+    close(f);
+}
+
+//最新的检查点所在的槽
+static int newest_slot(void)
+{
+    eIODP_PERSIST_HDR h[2];
+    int f = open(PATH,O_RDONLY);
+    pread(f,&h[0],sizeof(h[0]),0);
+    pread(f,&h[1],sizeof(h[1]),IODP_PERSIST_ALIGN);
+    close(f);
+    return h[1].seq > h[0].seq ? 1 : 0;
+}
+
+#define AREA ((IODP_CONFIGMEM_SIZE+IODP_PERSIST_ALIGN-1)/IODP_PERSIST_ALIGN*IODP_PERSIST_ALIGN)
+#define SLOT_OFF(i) (2*IODP_PERSIST_ALIGN+(1+(i))*AREA)
+
+int main()
+{
+    unsigned char v1[64], v2[64], v3[64], buf[64];
+    int i, ret;
+    for(i=0;i<64;i++){v1[i]=i;v2[i]=0x80+i;v3[i]=0xff-i;}
+    unlink(PATH);
+    unlink(PATH2);
+
+    //新文件，远程写入后写检查点
+    eIODP_TYPE* pdev;
+    eIODP_TYPE* pA = open_server(PATH,0,&pdev,&ret);
+    expect("new file",ret==0 && eiodpConfigPersistSeq(pA)==1);
+    eiodpWriteAddr(pdev,0,64,v1);
+    eiodpReadAddr(pdev,0,64,buf);
+    expect("mapped rw",memcmp(buf,v1,64)==0);
+    expect("checkpoint",eiodpConfigCheckpoint(pA)==1);
+    expect("unchanged",eiodpConfigCheckpoint(pA)==0);
+    eiodpWriteAddr(pdev,0,64,v2);
+    eiodpReadAddr(pdev,0,64,buf);
+    expect("checkpoint 2",eiodpConfigCheckpoint(pA)==1 && eiodpConfigPersistSeq(pA)==3);
+    //检查点之后的写入，随后“崩溃”（不关闭直接重新打开）
+    eiodpWriteAddr(pdev,0,64,v3);
+    eiodpReadAddr(pdev,0,64,buf);
+
+    eIODP_TYPE* pB = open_server(PATH,0,nullptr,&ret);
+    eiodpConfigRead(pB,0,64,buf);
+    expect("restore",ret==1 && memcmp(buf,v2,64)==0 && eiodpConfigPersistSeq(pB)==3);
+
+    //最新的槽损坏（写检查点时崩溃），恢复到前一个检查点
+    corrupt(SLOT_OFF(newest_slot())+5);
+    eIODP_TYPE* pC = open_server(PATH,0,nullptr,&ret);
+    eiodpConfigRead(pC,0,64,buf);
+    expect("torn slot",ret==1 && memcmp(buf,v1,64)==0 && eiodpConfigPersistSeq(pC)==2);
+
+    //最新的文件头损坏（写文件头时崩溃）
+    eiodpConfigWrite(pC,0,64,v3);
+    expect("checkpoint 3",eiodpConfigCheckpoint(pC)==1);
+    corrupt(newest_slot()*IODP_PERSIST_ALIGN+8);
+    eIODP_TYPE* pD = open_server(PATH,0,nullptr,&ret);
+    eiodpConfigRead(pD,0,64,buf);
+    expect("torn header",ret==1 && memcmp(buf,v1,64)==0);
+    eiodpConfigPersistClose(pD);
+    eiodpConfigWrite(pD,0,64,v2);
+    expect("closed",eiodpConfigCheckpoint(pD)==IODP_ERROR_PARAM);
+
+    //周期检查点：没有写入时不写，写入后一个间隔内写
+    eIODP_TYPE* pE = open_server(PATH2,50,&pdev,&ret);
+    uint32 s0 = eiodpConfigPersistSeq(pE);
+    usleep(200000);
+    expect("idle",eiodpConfigPersistSeq(pE)==s0);
+    eiodpWriteAddr(pdev,100,64,v3);
+    eiodpReadAddr(pdev,100,64,buf);
+    usleep(200000);
+    expect("periodic",eiodpConfigPersistSeq(pE)==s0+1);
+    eIODP_TYPE* pF = open_server(PATH2,0,nullptr,&ret);
+    eiodpConfigRead(pF,100,64,buf);
+    expect("periodic restore",ret==1 && memcmp(buf,v3,64)==0);
+
+    unlink(PATH);
+    unlink(PATH2);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
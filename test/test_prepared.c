@@ -0,0 +1,158 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//预编码请求：检查增量修正的CRC与整包重算一致，预编码读、函数调用的结果与普通接口相同，
+//并比较修改参数时增量修正与整包重算CRC的耗时
+
+extern unsigned long crc32(void* input, int len);
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+int func_sum(uint16 len, void* data,uint16* retlen,void* retdata){
+    int sum = 0;
+    unsigned char *ptr = (unsigned char *)data;
+    for(int i=0; i<len; i++)
+    {
+        sum+=ptr[i];
+    }
+
+    *retlen=4;
+    memcpy(retdata,&sum,4);
+    return 0;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+static long elapsed_us(struct timespec* a, struct timespec* b)
+{
+    return (b->tv_sec-a->tv_sec)*1000000+(b->tv_nsec-a->tv_nsec)/1000;
+}
+
+#define ARGLEN 900
+#define rounds 100000
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpRegister(pServer,0x666,func_sum);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int i, r;
+    unsigned char arg[ARGLEN];
+    srand(1);
+    for(i=0;i<ARGLEN;i++)arg[i]=rand();
+
+    //crc32_patch与整段重算一致
+    unsigned char arg2[ARGLEN];
+    memcpy(arg2,arg,ARGLEN);
+    arg2[3] ^= 0x5a;
+    arg2[4] ^= 0x01;
+    expect("patch",crc32_patch((uint32)crc32(arg,ARGLEN),ARGLEN,3,&arg[3],&arg2[3],2)
+                    == (uint32)crc32(arg2,ARGLEN));
+
+    //随机位置修改参数，短尾与长尾都要覆盖
+    eIODP_PREPARED* pf = eiodpPrepareFunction(pdev,0x666,ARGLEN,arg);
+    expect("prepare function",pf != nullptr && checkpktcrc(pf->frame,pf->framelen));
+    int bad = 0;
+    for(r=0;r<2000;r++){
+        unsigned char v[8];
+        int n = 1+rand()%8;
+        int off = rand()%(ARGLEN-n+1);
+        for(i=0;i<n;i++)v[i]=rand();
+        eiodpPreparedSetArg(pf,off,v,n);
+        memcpy(&arg[off],v,n);
+        if(!checkpktcrc(pf->frame,pf->framelen) || memcmp(&pf->frame[10],arg,ARGLEN)!=0)bad++;
+    }
+    expect("incremental crc",bad == 0);
+    expect("setarg range",eiodpPreparedSetArg(pf,ARGLEN-2,arg,4) == IODP_ERROR_PARAM);
+
+    //预编码调用与普通调用结果相同
+    int s1 = 0, s2 = 0;
+    expect("call",eiodpPreparedCall(pf,&s1) == 4);
+    eiodpFunction(pdev,0x666,ARGLEN,arg,&s2);
+    expect("call result",s1 == s2);
+    unsigned char x = arg[0]+1;
+    eiodpPreparedSetArg(pf,0,&x,1);
+    eiodpPreparedCall(pf,&s1);
+    expect("call after setarg",s1 == s2+1);
+
+    //预编码读
+    unsigned char data[64], b1[64], b2[64];
+    for(i=0;i<64;i++)data[i]=i*3;
+    eiodpConfigWrite(pServer,100,64,data);
+    eIODP_PREPARED* pr = eiodpPrepareRead(pdev,100,64);
+    int ok = 1;
+    for(r=0;r<50;r++){
+        if(eiodpPreparedRead(pr,b1) != 64 || memcmp(b1,data,64) != 0)ok = 0;
+    }
+    eiodpReadAddr(pdev,100,64,b2);
+    expect("prepared read",ok && memcmp(b1,b2,64) == 0);
+    expect("type check",eiodpPreparedCall(pr,&s1) == IODP_ERROR_PARAM && eiodpPreparedRead(pf,b1) == IODP_ERROR_PARAM);
+
+    //只改4字节时，增量修正与整包重算CRC的耗时
+    struct timespec ts0, ts1, ts2;
+    unsigned int seq = 0;
+    clock_gettime(CLOCK_MONOTONIC,&ts0);
+    for(r=0;r<rounds;r++){
+        seq++;
+        memcpy(&pf->frame[10+ARGLEN-64],&seq,4);
+        updatepktcrc(pf->frame,pf->framelen);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&ts1);
+    for(r=0;r<rounds;r++){
+        seq++;
+        eiodpPreparedSetArg(pf,ARGLEN-64,&seq,4);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&ts2);
+    expect("final crc",checkpktcrc(pf->frame,pf->framelen));
+    printf("%d updates of 4 bytes in a %d byte frame: full crc %ldus, incremental %ldus\n",
+            rounds,pf->framelen,elapsed_us(&ts0,&ts1),elapsed_us(&ts1,&ts2));
+
+    eiodpPreparedFree(pf);
+    eiodpPreparedFree(pr);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//服务端没有io接口，只通过eiodp_process输入输出数据。
+//收到的数据被随机切成小块，并在块之间插入干扰字节，检查解析器能否跨调用拼包与重新同步
+
+int func_sum(uint16 len, void* data,uint16* retlen,void* retdata){
+    int sum = 0;
+    unsigned char *ptr = (unsigned char *)data;
+    for(int i=0; i<len; i++)
+    {
+        sum+=ptr[i];
+    }
+
+    *retlen=4;
+    *(int*)retdata=sum;
+    return 0;
+}
+
+#if (IODP_OS==IODP_OS_NULL)
+static int fdServer=0;
+static volatile int noisecnt=0;
+
+//模拟MCU主循环：取到多少数据就喂多少，回包由主循环自己发出去
+void* server_loop(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    unsigned char inbuf[512];
+    unsigned char outbuf[IODP_RECV_MAX_LEN];
+    unsigned int seed = 7;
+    while(1)
+    {
+        int n = loopread(fdServer,(char*)inbuf,sizeof(inbuf));
+        if(n <= 0)continue;
+        int off = 0;
+        while(off < n){
+            int chunk = rand_r(&seed)%7+1;
+            if(chunk > n-off)chunk = n-off;
+            int outlen = eiodp_process(pServer,&inbuf[off],chunk,outbuf,sizeof(outbuf));
+            if(outlen > 0)loopsend(fdServer,(char*)outbuf,outlen);
+            off += chunk;
+            //偶尔插入不是帧头的干扰字节，只能出现在包与包之间
+            if(off == n && rand_r(&seed)%4 == 0){
+                unsigned char noise[3] = {0x00,0x90,0x55};
+                eiodp_process(pServer,noise,3,outbuf,sizeof(outbuf));
+                noisecnt++;
+            }
+        }
+    }
+    return NULL;
+}
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+#define testpkt_len 200
+#define testcnt 300
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+    cfg.latency_us = 200;
+    cfg.readTimeout_us = 0;
+
+    //服务端的读可以阻塞等待，不和主站的轮询抢CPU（函数调用不重发，回包晚了就算超时）
+    LOOPIO_LINKCFG cfgServer = cfg;
+    cfgServer.readTimeout_us = 1000;
+
+    int fdMaster=0;
+    if(loopopen(&cfgServer, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+
+    eIODP_TYPE* pServer = eiodp_init(fdServer,NULL,NULL);
+    eiodpRegister(pServer,0x666,func_sum);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pdev,tick_ms,1000);
+
+    pthread_t t1;
+    pthread_create(&t1,NULL,server_loop,pServer);
+
+    srand(3);
+    int errorcnt=0;
+    unsigned char buf[testpkt_len];
+    unsigned char recvbuf[testpkt_len];
+    for(int cnt=0;cnt<testcnt;cnt++){
+        int randlen = rand()%testpkt_len+1;
+        for(int i=0;i<randlen;i++)buf[i]=rand();
+        eiodpWriteAddr(pdev,cnt%64,randlen,buf);
+        int retlen = eiodpReadAddr(pdev,cnt%64,randlen,recvbuf);
+        if(retlen!=randlen || memcmp(buf,recvbuf,randlen)!=0){
+            errorcnt++;
+            continue;
+        }
+        int funcret=0, sum=0;
+        retlen = eiodpFunction(pdev,0x666,randlen,buf,&funcret);
+        for(int i=0;i<randlen;i++)sum+=buf[i];
+        if(retlen!=4 || sum!=funcret)errorcnt++;
+    }
+
+    printf("cnt=%d errorcnt=%d noise=%d\n",testcnt,errorcnt,noisecnt);
+    return errorcnt;
+}
+#else
+//eiodp_process只在无操作系统构建中提供
+int main()
+{
+    printf("eiodp_process is only available with IODP_OS_NULL\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,152 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//在丢包、乱序的链路上做可靠写，全部确认后读回校验
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+//无操作系统模式下给eiodp提供的时钟源
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+static double nowms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return tv.tv_sec*1000.0 + tv.tv_nsec/1000000.0;
+}
+
+#define testcnt 50
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 115200);
+    cfg.latency_us = 2000;
+    cfg.jitter_us = 500;
+    cfg.droprate = 0.05;
+    cfg.reorderrate = 0.05;
+    cfg.seed = 7;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    eiodpSetTickSource(pdev,tick_ms,1000);
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    srand(3);
+    int errorcnt=0;
+    int i=0, cnt=0;
+    unsigned char buf[IODP_CONFIGMEM_SIZE];
+    unsigned long long bytes=0;
+
+    double start = nowms();
+    for(cnt=0;cnt<testcnt;cnt++){
+        for(i=0;i<IODP_CONFIGMEM_SIZE;i++){
+            buf[i]=rand();
+        }
+        //每次写整个配置空间，分成多个包流水发送，不等待确认
+        if(eiodpWriteAddrReliable(pdev,0,IODP_CONFIGMEM_SIZE,buf)!=IODP_OK){
+            printf("reliable write fail cnt=%d\n",cnt);
+            errorcnt++;
+            continue;
+        }
+        bytes += IODP_CONFIGMEM_SIZE;
+    }
+    if(eiodpWriteFlush(pdev)!=IODP_OK){
+        printf("reliable write flush fail\n");
+        errorcnt++;
+    }
+    //全部确认后服务端的配置空间必须与最后一次写入一致
+    if(memcmp(pServer->configmem,buf,IODP_CONFIGMEM_SIZE)!=0){
+        printf("configmem mismatch\n");
+        errorcnt++;
+    }
+    double cost = nowms()-start;
+
+    //放弃窗口后，旧会话迟到的包不能再写入，也不能打乱新会话
+    unsigned short oldEpoch = pdev->pRwTx->epoch;
+    for(i=0;i<IODP_CONFIGMEM_SIZE;i++)buf[i]=rand();
+    eiodpWriteAddrReliable(pdev,0,IODP_CONFIGMEM_SIZE,buf);
+    eiodpWriteDiscard(pdev);
+    for(i=0;i<IODP_CONFIGMEM_SIZE;i++)buf[i]=rand();
+    if(eiodpWriteAddrReliable(pdev,0,IODP_CONFIGMEM_SIZE,buf)!=IODP_OK || eiodpWriteFlush(pdev)!=IODP_OK){
+        printf("reliable write after discard fail\n");
+        errorcnt++;
+    }
+    //重放一个旧会话的seq 0，链路会丢包，多发几次
+    unsigned char old[14+16+4];
+    unsigned short oldsize=14+16;
+    old[0]=0xeb;
+    old[1]=0x90;
+    old[2]=(unsigned char)(oldsize>>8)&0xff;
+    old[3]=(unsigned char)(oldsize)&0xff;
+    old[4]=0xec;
+    old[5]=IODP_TYPE_RWRITE;
+    old[6]=(unsigned char)(oldEpoch>>8)&0xff;
+    old[7]=(unsigned char)(oldEpoch)&0xff;
+    old[8]=0;
+    old[9]=0;
+    old[10]=0;
+    old[11]=0;
+    old[12]=0;
+    old[13]=16;
+    for(i=0;i<16;i++)old[14+i]=~buf[i];
+    updatepktcrc(old,sizeof(old));
+    for(i=0;i<5;i++)loopsend(fdMaster,(char*)old,sizeof(old));
+    usleep(50*1000);
+    if(memcmp(pServer->configmem,buf,IODP_CONFIGMEM_SIZE)!=0){
+        printf("configmem overwritten by old epoch\n");
+        errorcnt++;
+    }
+    //新会话的窗口继续往后发，仍然能全部确认
+    for(i=0;i<IODP_CONFIGMEM_SIZE;i++)buf[i]=rand();
+    if(eiodpWriteAddrReliable(pdev,0,IODP_CONFIGMEM_SIZE,buf)!=IODP_OK || eiodpWriteFlush(pdev)!=IODP_OK){
+        printf("reliable write after old epoch replay fail\n");
+        errorcnt++;
+    }
+    if(memcmp(pServer->configmem,buf,IODP_CONFIGMEM_SIZE)!=0){
+        printf("configmem mismatch after old epoch replay\n");
+        errorcnt++;
+    }
+
+    LOOPIO_STAT st;
+    loopstat(fdMaster,&st);
+    printf("cnt=%d errorcnt=%d time=%.1fms goodput=%.1f B/s (link %d B/s)\n",
+            testcnt,errorcnt,cost,bytes*1000.0/cost,115200/10);
+    printf("master->server tx=%llu drop=%llu reorder=%llu\n",st.txBytes,st.dropChunks,st.reorderChunks);
+
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <eiodp_schema.h>
+#include <loopio.h>
+
+//寄存器表：检查生成的偏移、大端取值赋值、写回对方后的字节，
+//读计划的请求数，以及按计划读回与逐个字段读的耗时
+
+#define MOTOR_FIELDS(X,S) \
+    X(S,speed,U16,1) \
+    X(S,temp,I16,1) \
+    X(S,mode,U8,1) \
+    X(S,reserved,U8,3) \
+    X(S,setpoint,F32,1) \
+    X(S,counter,U32,4) \
+    X(S,offset,I32,1) \
+    X(S,trim,I8,2) \
+    X(S,spare,U8,40) \
+    X(S,label,U8,16) \
+    X(S,wave,U16,210)
+IODP_SCHEMA_DEFINE(MOTOR,2)
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+static long elapsed_us(struct timespec* a, struct timespec* b)
+{
+    return (b->tv_sec-a->tv_sec)*1000000+(b->tv_nsec-a->tv_nsec)/1000;
+}
+
+#define rounds 200
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int i, r;
+    const eIODP_SCHEMA* s = MOTOR_Schema();
+
+    //生成的偏移与字段表
+    expect("size",MOTOR_SIZE == 2+2+1+3+4+16+4+2+40+16+420 && s->size == MOTOR_SIZE);
+    expect("addr",IODP_FADDR(MOTOR,speed) == 2 && IODP_FADDR(MOTOR,setpoint) == 10 &&
+                  IODP_FADDR(MOTOR,counter) == 14 && IODP_FSIZE(MOTOR,counter) == 16);
+    expect("table",s->nfield == MOTOR_NFIELD && s->field[MOTOR_F_offset].off == 28 &&
+                   strcmp(s->field[MOTOR_F_wave].name,"wave") == 0);
+
+    //大端取值赋值
+    uint8 img[MOTOR_SIZE], img2[MOTOR_SIZE], cfgbuf[MOTOR_SIZE];
+    memset(img,0,sizeof(img));
+    MOTOR_set_speed(img,0x1234);
+    MOTOR_set_temp(img,-40);
+    MOTOR_set_mode(img,3);
+    MOTOR_set_setpoint(img,12.5f);
+    for(i=0;i<4;i++)MOTOR_seti_counter(img,i,0xA0B0C0D0u+i);
+    MOTOR_set_offset(img,-100000);
+    MOTOR_seti_trim(img,1,-7);
+    memcpy(&img[offsetof(MOTOR_layout,label)],"motor-1",8);
+    for(i=0;i<210;i++)MOTOR_seti_wave(img,i,i*7);
+    expect("big endian",img[0] == 0x12 && img[1] == 0x34 && img[12] == 0xA0 && img[15] == 0xD0);
+    expect("get",MOTOR_get_speed(img) == 0x1234 && MOTOR_get_temp(img) == -40 &&
+                 MOTOR_get_setpoint(img) == 12.5f && MOTOR_geti_counter(img,3) == 0xA0B0C0D3u &&
+                 MOTOR_get_offset(img) == -100000 && MOTOR_geti_trim(img,1) == -7);
+
+    //写回对方：除了spare都写，spare保持对方原来的值
+    unsigned char marker[40];
+    memset(marker,0x5a,sizeof(marker));
+    eiodpConfigWrite(pServer,IODP_FADDR(MOTOR,spare),40,marker);
+    expect("store",eiodpSchemaStore(pdev,s,IODP_FALL(MOTOR) & ~IODP_FBIT(MOTOR,spare),img) == IODP_OK);
+    eiodpReadAddr(pdev,2,2,cfgbuf);
+    eiodpConfigRead(pServer,2,MOTOR_SIZE,cfgbuf);
+    expect("stored bytes",memcmp(cfgbuf,img,offsetof(MOTOR_layout,spare)) == 0 &&
+                          memcmp(&cfgbuf[offsetof(MOTOR_layout,spare)],marker,40) == 0 &&
+                          memcmp(&cfgbuf[offsetof(MOTOR_layout,label)],&img[offsetof(MOTOR_layout,label)],16+420) == 0);
+
+    //标量字段：跨过reserved与trim的小空隙合并为一段，一次读完
+    eIODP_SCHEMA_PLAN plan;
+    unsigned long long status = IODP_FBIT(MOTOR,speed) | IODP_FBIT(MOTOR,temp) | IODP_FBIT(MOTOR,mode) |
+                                IODP_FBIT(MOTOR,setpoint) | IODP_FBIT(MOTOR,counter) | IODP_FBIT(MOTOR,offset) |
+                                IODP_FBIT(MOTOR,label);
+    expect("plan",eiodpSchemaPlan(&plan,s,status) == 1 && plan.nrange == 2);
+    memset(img2,0,sizeof(img2));
+    expect("fetch",eiodpSchemaFetch(pdev,&plan,img2) == (int)plan.wireBytes);
+    expect("fetched",MOTOR_get_speed(img2) == 0x1234 && MOTOR_get_temp(img2) == -40 &&
+                     MOTOR_get_mode(img2) == 3 && MOTOR_get_setpoint(img2) == 12.5f &&
+                     MOTOR_geti_counter(img2,2) == 0xA0B0C0D2u && MOTOR_get_offset(img2) == -100000 &&
+                     strcmp((char*)&img2[offsetof(MOTOR_layout,label)],"motor-1") == 0);
+    printf("%d fields: %d ranges, %d request, %u bytes\n",
+            7,plan.nrange,plan.ngroup,plan.wireBytes);
+
+    //超过返回缓存的字段集合分成多次读
+    eIODP_SCHEMA_PLAN all;
+    int ng = eiodpSchemaPlan(&all,s,IODP_FALL(MOTOR));
+    expect("plan all",ng == (MOTOR_SIZE+IODP_SCHEMA_MAXFETCH-1)/IODP_SCHEMA_MAXFETCH);
+    memset(img2,0,sizeof(img2));
+    expect("fetch all",eiodpSchemaFetch(pdev,&all,img2) == MOTOR_SIZE && memcmp(img2,cfgbuf,MOTOR_SIZE) == 0);
+
+    expect("empty set",eiodpSchemaPlan(&plan,s,0) == IODP_ERROR_PARAM &&
+                       eiodpSchemaPlan(&plan,s,1ULL<<MOTOR_NFIELD) == IODP_ERROR_PARAM);
+
+    //按计划读与逐个字段读
+    eiodpSchemaPlan(&plan,s,status);
+    struct timespec ts0, ts1, ts2;
+    clock_gettime(CLOCK_MONOTONIC,&ts0);
+    for(r=0;r<rounds;r++)eiodpSchemaFetch(pdev,&plan,img2);
+    clock_gettime(CLOCK_MONOTONIC,&ts1);
+    int naive = 0;
+    for(r=0;r<rounds;r++){
+        naive = 0;
+        for(i=0;i<s->nfield;i++){
+            if(!(status & (1ULL<<i)))continue;
+            eiodpReadAddr(pdev,s->base+s->field[i].off,s->field[i].size,&img2[s->field[i].off]);
+            naive++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC,&ts2);
+    printf("%d fetches: plan %d request %ldus, per field %d requests %ldus\n",
+            rounds,plan.ngroup,elapsed_us(&ts0,&ts1),naive,elapsed_us(&ts1,&ts2));
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//主端不停地用多段写更新两段相隔很远的数据，每次所有字节都是同一个计数值；
+//从端另一个线程用eiodpConfigRead读，任何时候都不能看到两段不一致或者一段内不一致
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+#define SEG 24
+#define SEG2 100
+static volatile int stop = 0;
+static eIODP_TYPE* pServer;
+static int torn = 0, rawtorn = 0, reads = 0, copies = 0;
+
+static int consistent(unsigned char* p, int n, unsigned char v)
+{
+    for(int i=0;i<n;i++)if(p[i]!=v)return 0;
+    return 1;
+}
+
+void* reader(void* arg)
+{
+    unsigned char buf[SEG2+SEG];
+    unsigned char raw[SEG2+SEG];
+    uint32 ver = 0;
+    while(!stop){
+        if(eiodpConfigRead(pServer,0,SEG2+SEG,buf)==SEG2+SEG){
+            if(!consistent(buf,SEG,buf[0]) || !consistent(&buf[SEG2],SEG,buf[0]))torn++;
+        }
+        //直接读内存，只用来对比
+        memcpy(raw,pServer->configmem,SEG2+SEG);
+        if(!consistent(raw,SEG,raw[0]) || !consistent(&raw[SEG2],SEG,raw[0]))rawtorn++;
+        if(eiodpConfigReadIfChanged(pServer,0,SEG2+SEG,buf,&ver)>0){
+            copies++;
+            if(!consistent(buf,SEG,buf[0]) || !consistent(&buf[SEG2],SEG,buf[0]))torn++;
+        }
+        reads++;
+    }
+    return NULL;
+}
+
+#define testcnt 3000
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    unsigned char init[SEG2+SEG];
+    memset(init,0,sizeof(init));
+    eiodpConfigWrite(pServer,0,sizeof(init),init);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+    pthread_t t2;
+    pthread_create(&t2,NULL,reader,NULL);
+
+    int errorcnt=0;
+    unsigned char a[SEG], b[SEG];
+    eIODP_RANGE r[2];
+    r[0].addr = 0; r[0].len = SEG; r[0].buf = a;
+    r[1].addr = SEG2; r[1].len = SEG; r[1].buf = b;
+    uint32 v0 = eiodpConfigVersion(pServer,0,SEG);
+    for(int cnt=1;cnt<=testcnt;cnt++){
+        memset(a,cnt&0xff,SEG);
+        memset(b,cnt&0xff,SEG);
+        eiodpWriteMulti(pdev,r,2);
+        if(cnt%500==0)usleep(1000);
+    }
+    //读一次保证全部写入已经处理
+    unsigned char check[SEG];
+    eiodpReadAddr(pdev,SEG2,SEG,check);
+    stop = 1;
+    pthread_join(t2,NULL);
+
+    if(!consistent(check,SEG,testcnt&0xff)){
+        printf("final value mismatch\n");
+        errorcnt++;
+    }
+    //写过的块版本变大，没写过的块不变
+    if(eiodpConfigVersion(pServer,0,SEG)==v0 ||
+       eiodpConfigVersion(pServer,SEG2+SEG+IODP_CFG_BLOCK,4)!=eiodpConfigVersion(pServer,IODP_CONFIGMEM_SIZE-4,4)){
+        printf("block version error\n");
+        errorcnt++;
+    }
+    if(torn)errorcnt++;
+    printf("reads=%d copies=%d torn=%d (raw memcpy torn=%d)\n",reads,copies,torn,rawtorn);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//流式服务函数：大结果按额度分块返回，检查内容与顺序、结束标记、额度限制在途的数据块、
+//取消、拒绝与出错，并与按游标反复调用写入器服务函数比较同一链路上的耗时
+
+#define BAUDRATE 2000000        //链路带宽bit/s，8N1每字节10bit
+#define LATENCY_US 2000
+#define TABLE_LEN (64*1024)
+static unsigned char table[TABLE_LEN];
+
+static unsigned long long now_us(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (unsigned long long)tv.tv_sec*1000000 + tv.tv_nsec/1000;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+//---------------------------从设备--------------------------
+
+typedef struct
+{
+    uint32 off;
+    uint32 total;
+    uint16 chunk;
+    int failAt;             //第几个数据块出错，<0为不出错
+    int n;
+}GEN;
+
+static volatile int nextCalls = 0, closeCalls = 0, closeStatus = 1;
+
+//参数：4字节总长+2字节块长（大端），按块引用table中的数据
+static int gen_open(const unsigned char* arg, uint16 arglen, void** state)
+{
+    if(arglen != 6)return -1;
+    GEN* g = (GEN*)malloc(sizeof(GEN));
+    if(g == NULL)return -1;
+    g->off = 0;
+    g->total = ((uint32)arg[0]<<24)|((uint32)arg[1]<<16)|((uint32)arg[2]<<8)|arg[3];
+    g->chunk = (uint16)((arg[4]<<8)|arg[5]);
+    g->failAt = -1;
+    g->n = 0;
+    if(g->total > TABLE_LEN || g->chunk == 0 || g->chunk > IODP_STREAM_CHUNK){
+        free(g);
+        return -1;
+    }
+    *state = g;
+    return 0;
+}
+
+static int gen_next(void* state, eIODP_WRITER* w)
+{
+    GEN* g = (GEN*)state;
+    nextCalls++;
+    if(g->n++ == g->failAt)return -1;
+    uint32 n = g->total-g->off;
+    if(n > g->chunk)n = g->chunk;
+    //块序号放在引用的数据前面
+    unsigned char* p = eiodpWriterReserve(w,1);
+    if(p == NULL)return -1;
+    p[0] = (unsigned char)g->n;
+    eiodpWriterCommit(w,1);
+    if(eiodpWriterRef(w,&table[g->off],(uint16)n) < 0)return -1;
+    g->off += n;
+    return g->off < g->total ? 1 : 0;
+}
+
+static void gen_close(void* state, int status)
+{
+    free(state);
+    closeStatus = status;
+    closeCalls++;
+}
+
+static int fail_open(const unsigned char* arg, uint16 arglen, void** state)
+{
+    int r = gen_open(arg,arglen,state);
+    if(r == 0)((GEN*)*state)->failAt = 2;
+    return r;
+}
+
+static const eIODP_STREAM_OPS genOps = {gen_open,gen_next,gen_close};
+static const eIODP_STREAM_OPS failOps = {fail_open,gen_next,gen_close};
+
+//按游标读取：参数4字节偏移（大端），返回从偏移开始最多IODP_FUNC_RESP_MAX字节
+static int func_cursor(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w)
+{
+    if(arglen != 4)return -1;
+    uint32 off = ((uint32)arg[0]<<24)|((uint32)arg[1]<<16)|((uint32)arg[2]<<8)|arg[3];
+    if(off > TABLE_LEN)return -1;
+    uint32 n = TABLE_LEN-off;
+    if(n > IODP_FUNC_RESP_MAX)n = IODP_FUNC_RESP_MAX;
+    return eiodpWriterRef(w,&table[off],(uint16)n);
+}
+
+//---------------------------主设备--------------------------
+
+typedef struct
+{
+    volatile int done;      //收到END或者失败
+    int status;             //最后的status
+    int chunks;
+    uint32 bytes;
+    int bad;                //内容或顺序错误
+    int overWindow;         //在途的数据块超过额度
+    int window;
+    int cancelAt;           //收到这么多数据块后在回调中取消，0为不取消
+    eIODP_TYPE* pdev;
+    unsigned char err;      //错误数据块的原因
+}RX;
+
+static void on_chunk(void* ctx, int sid, int status, const unsigned char* data, int len)
+{
+    RX* rx = (RX*)ctx;
+    if(rx->done){
+        rx->bad++;
+        return;
+    }
+    rx->status = status;
+    if(status < 0){
+        if(status == IODP_ERROR_PKT && len == 1)rx->err = data[0];
+        rx->done = 1;
+        return;
+    }
+    rx->chunks++;
+    if(len < 1 || data[0] != (unsigned char)rx->chunks || memcmp(&data[1],&table[rx->bytes],len-1) != 0)rx->bad++;
+    rx->bytes += len-1;
+    if(nextCalls - rx->chunks > rx->window)rx->overWindow++;
+    if(status == IODP_STREAM_END)rx->done = 1;
+    else if(rx->cancelAt && rx->chunks == rx->cancelAt){
+        if(eiodpStreamCancel(rx->pdev,sid) != IODP_OK)rx->bad++;
+        rx->done = 1;
+    }
+}
+
+static eIODP_TYPE* pServer;
+
+static eIODP_TYPE* pClient;
+
+//处理两端（无操作系统），或者等接收线程（Linux），直到cond成立或者超时
+static void wait_until(volatile int* cond, unsigned long long timeout_us)
+{
+    unsigned long long t0 = now_us();
+    while(!*cond && now_us()-t0 < timeout_us){
+#if (IODP_OS==IODP_OS_NULL)
+        eiodp_recvProcessTask_nos(pServer);
+        eiodp_recvProcessTask_nos(pClient);
+#else
+        usleep(500);
+#endif
+    }
+}
+
+static int open_gen(uint16 code, uint32 total, uint16 chunk, uint16 window, RX* rx)
+{
+    unsigned char arg[6] = {(unsigned char)(total>>24),(unsigned char)(total>>16),(unsigned char)(total>>8),
+                            (unsigned char)total,(unsigned char)(chunk>>8),(unsigned char)chunk};
+    memset(rx,0,sizeof(*rx));
+    rx->window = window ? window : IODP_STREAM_WINDOW;
+    rx->pdev = pClient;
+    nextCalls = 0;
+    return eiodpStreamOpen(pClient,code,6,arg,window,on_chunk,rx);
+}
+
+#if (IODP_OS==IODP_OS_NULL)
+typedef struct
+{
+    volatile int done;
+    int status;
+    unsigned char* ret;
+}CALL;
+
+static void on_ret(void* ctx, int status, unsigned char* data, int len)
+{
+    CALL* c = (CALL*)ctx;
+    if(status >= 0)memcpy(c->ret,data,len);
+    c->status = status;
+    c->done = 1;
+}
+
+static int call_cursor(uint32 off, unsigned char* ret)
+{
+    unsigned char arg[4] = {(unsigned char)(off>>24),(unsigned char)(off>>16),(unsigned char)(off>>8),(unsigned char)off};
+    CALL c = {0,0,ret};
+    int r = eiodpFunctionAsync(pClient,0x710,4,arg,on_ret,&c);
+    if(r < 0)return r;
+    wait_until(&c.done,5000000);
+    return c.done ? c.status : IODP_ERROR_TIMEOUT;
+}
+#else
+static int call_cursor(uint32 off, unsigned char* ret)
+{
+    unsigned char frame[IODP_FUNC_FRAMELEN(4)];
+    unsigned char arg[4] = {(unsigned char)(off>>24),(unsigned char)(off>>16),(unsigned char)(off>>8),(unsigned char)off};
+    return eiodpFunctionEx(pClient,0x710,4,arg,ret,IODP_FUNC_RESP_MAX,frame);
+}
+#endif
+
+int main()
+{
+    for(int i=0;i<TABLE_LEN;i++)table[i] = (unsigned char)(i*31+7+(i>>8));
+
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, BAUDRATE);
+    cfg.latency_us = LATENCY_US;
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    pServer = eiodp_init(fdServer,loopread,loopsend);
+    pClient = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetWritev(pServer,loopsendv);
+    expect("register",eiodpRegisterStream(pServer,0x700,&genOps) == IODP_OK &&
+                      eiodpRegisterStream(pServer,0x701,&failOps) == IODP_OK &&
+                      eiodpRegisterWriter(pServer,0x710,func_cursor) == IODP_OK);
+    expect("repeat",eiodpRegisterStream(pServer,0x710,&genOps) == IODP_ERROR_REPEATCODE);
+    expect("null",eiodpRegisterStream(pServer,0x702,NULL) == IODP_ERROR_PARAM);
+
+    RX rx;
+    //大结果：内容、顺序、结束标记、在途不超过额度
+    unsigned long long t0 = now_us();
+    int sid = open_gen(0x700,TABLE_LEN,IODP_STREAM_CHUNK-1,0,&rx);
+    expect("open",sid >= 0);
+    wait_until(&rx.done,10000000);
+    unsigned long long costStream = now_us()-t0;
+    expect("stream",rx.status == IODP_STREAM_END && rx.bytes == TABLE_LEN && rx.bad == 0 &&
+                    rx.chunks == (TABLE_LEN+IODP_STREAM_CHUNK-2)/(IODP_STREAM_CHUNK-1));
+    expect("window",rx.overWindow == 0);
+    wait_until(&closeCalls,1000000);
+    expect("close",closeCalls == 1 && closeStatus == IODP_OK && eiodpStreamCount(pClient,0) == 0 &&
+                   eiodpStreamCount(pServer,1) == 0);
+    //链路上每个数据块多出帧头与crc
+    double wire = (double)TABLE_LEN + rx.chunks*(17.0+1);
+    double linkUs = wire*10*1000000.0/BAUDRATE;
+    printf("stream: %d bytes in %d chunks %lluus, link time %.0fus (%.0f%%)\n",
+           TABLE_LEN,rx.chunks,costStream,linkUs,100.0*linkUs/costStream);
+
+    //同样的数据按游标反复调用
+    static unsigned char ret[IODP_FUNC_RESP_MAX];
+    int calls = 0;
+    t0 = now_us();
+    for(uint32 off=0;off<TABLE_LEN;){
+        int r = call_cursor(off,ret);
+        if(r <= 0 || memcmp(ret,&table[off],r) != 0){
+            expect("cursor",0);
+            break;
+        }
+        off += r;
+        calls++;
+    }
+    unsigned long long costCursor = now_us()-t0;
+    printf("cursor: %d bytes in %d calls %lluus\n",TABLE_LEN,calls,costCursor);
+    //额度内连续发出，接近链路速率；按游标调用每次都要等一个往返
+    expect("link speed",linkUs > 0.6*costStream);
+    expect("faster",costCursor > costStream*3/2);
+
+    //额度为1：每个数据块都要等额度
+    sid = open_gen(0x700,8*100,100,1,&rx);
+    wait_until(&rx.done,5000000);
+    expect("window 1",rx.status == IODP_STREAM_END && rx.chunks == 8 && rx.bad == 0 && rx.overWindow == 0);
+
+    //取消：之后不再回调，对方的close收到IODP_ERROR_CANCELED
+    closeCalls = 0;
+    sid = open_gen(0x700,TABLE_LEN,500,4,&rx);
+    rx.cancelAt = 3;
+    wait_until(&rx.done,5000000);
+    wait_until(&closeCalls,1000000);
+    RX after = rx;
+    rx.done = 0;
+    wait_until(&rx.done,100000);
+    expect("cancel",after.chunks == 3 && after.bad == 0 && rx.bad == 0 && rx.chunks == 3 &&
+                    closeCalls == 1 && closeStatus == IODP_ERROR_CANCELED && nextCalls < 3+4+2);
+    expect("cancel twice",eiodpStreamCancel(pClient,sid) == IODP_ERROR_PARAM);
+
+    //出错：前两个数据块照常，之后收到IODP_SERR_FAIL
+    closeCalls = 0;
+    sid = open_gen(0x701,TABLE_LEN,200,0,&rx);
+    wait_until(&rx.done,5000000);
+    wait_until(&closeCalls,1000000);
+    expect("fail",rx.status == IODP_ERROR_PKT && rx.err == IODP_SERR_FAIL && rx.chunks == 2 && rx.bad == 0 &&
+                  closeCalls == 1 && closeStatus < 0);
+
+    //拒绝：参数不对、没有这个服务函数
+    unsigned char bad = 0;
+    memset(&rx,0,sizeof(rx));
+    eiodpStreamOpen(pClient,0x700,1,&bad,0,on_chunk,&rx);
+    wait_until(&rx.done,5000000);
+    expect("reject",rx.status == IODP_ERROR_PKT && rx.err == IODP_SERR_REJECT && rx.chunks == 0);
+    memset(&rx,0,sizeof(rx));
+    eiodpStreamOpen(pClient,0x7ff,0,NULL,0,on_chunk,&rx);
+    wait_until(&rx.done,5000000);
+    expect("nofunc",rx.status == IODP_ERROR_PKT && rx.err == IODP_SERR_NOFUNC);
+
+    //本端流表已满
+    RX many[IODP_STREAM_MAX];
+    int opened = 0;
+    for(int i=0;i<IODP_STREAM_MAX;i++){
+        memset(&many[i],0,sizeof(many[i]));
+        many[i].window = IODP_STREAM_WINDOW;
+        if(eiodpStreamOpen(pClient,0x7ff,0,NULL,0,on_chunk,&many[i]) >= 0)opened++;
+    }
+    expect("busy",opened == IODP_STREAM_MAX && eiodpStreamOpen(pClient,0x7ff,0,NULL,0,on_chunk,&rx) == IODP_ERROR_BUSY);
+    for(int i=0;i<IODP_STREAM_MAX;i++)wait_until(&many[i].done,5000000);
+    expect("busy done",eiodpStreamCount(pClient,0) == 0);
+
+    eiodp_deinit(pClient);
+    eiodp_deinit(pServer);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
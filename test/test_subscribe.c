@@ -0,0 +1,186 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//订阅推送：主端订阅从端的几个范围，用推送维护本地镜像，检查
+//  镜像最终与从端一致，推送次数受最小间隔限制，丢包后重新同步，取消订阅与拒绝订阅
+
+#if (IODP_OS==IODP_OS_NULL)
+//无操作系统下主从两端都需要有人连续调用接收任务，推送回调在这里执行
+void* looper(void* arg)
+{
+    eIODP_TYPE* p = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(p);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+typedef struct
+{
+    unsigned char mirror[IODP_CONFIGMEM_SIZE];
+    volatile int calls;     //数据回调次数
+    volatile int fulls;     //整范围推送的回调次数
+    volatile int lost;
+    volatile int error;
+}SUBREC;
+
+static void on_push(void* ctx, int sid, int flags, unsigned short addr, unsigned short len, const unsigned char* data)
+{
+    SUBREC* r = (SUBREC*)ctx;
+    if(flags & IODP_PUSH_ERROR){r->error++;return;}
+    if(flags & IODP_PUSH_LOST){r->lost++;return;}
+    memcpy(&r->mirror[addr],data,len);
+    if(flags & IODP_PUSH_FULL)r->fulls++;
+    r->calls++;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+//等待镜像与从端一致
+static int wait_same(eIODP_TYPE* pServer, SUBREC* r, int addr, int len)
+{
+    unsigned char cur[IODP_CONFIGMEM_SIZE];
+    for(int i=0;i<500;i++){
+        eiodpConfigRead(pServer,addr,len,cur);
+        if(memcmp(cur,&r->mirror[addr],len)==0)return 1;
+        usleep(2000);
+    }
+    return 0;
+}
+
+static void link_open(LOOPIO_LINKCFG* m2s, LOOPIO_LINKCFG* s2m, eIODP_TYPE** pdev, eIODP_TYPE** pServer)
+{
+    int fdMaster=0, fdServer=0;
+    if(loopopen(m2s, s2m, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        exit(1);
+    }
+    *pServer = eiodp_init(fdServer,loopread,loopsend);
+    *pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(*pServer,tick_ms,1000);
+    eiodpSetTickSource(*pdev,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t;
+    pthread_create(&t,NULL,looper,*pServer);
+    pthread_create(&t,NULL,looper,*pdev);
+#endif
+}
+
+static SUBREC ra, rb, rc, rl;
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    eIODP_TYPE *pdev, *pServer;
+    link_open(&cfg,&cfg,&pdev,&pServer);
+
+    unsigned char data[64];
+    int i;
+    for(i=0;i<64;i++)data[i]=i+1;
+    eiodpConfigWrite(pServer,0,64,data);
+
+    //订阅后先收到整个范围
+    int sa = eiodpSubscribe(pdev,0,64,0,on_push,&ra);
+    int sb = eiodpSubscribe(pdev,200,64,50,on_push,&rb);
+    expect("subscribe",sa>=0 && sb>=0);
+    expect("full a",wait_same(pServer,&ra,0,64) && ra.fulls==1);
+    expect("full b",wait_same(pServer,&rb,200,64) && rb.fulls==1);
+
+    //零散的变化合并推送
+    int before = ra.calls;
+    unsigned char v[2] = {0xaa,0xbb};
+    eiodpConfigWrite(pServer,10,1,v);
+    eiodpConfigWrite(pServer,12,1,v);
+    eiodpConfigWrite(pServer,40,2,v);
+    expect("delta a",wait_same(pServer,&ra,0,64));
+    printf("delta calls %d\n",ra.calls-before);
+    expect("no full",ra.fulls==1);
+
+    //50ms间隔内连续100次写最多推送几次
+    before = rb.calls;
+    for(i=0;i<100;i++){
+        unsigned char x = i;
+        eiodpConfigWrite(pServer,200+(i%64),1,&x);
+        usleep(200);
+    }
+    expect("rate a",wait_same(pServer,&rb,200,64));
+    usleep(100000);
+    printf("100 writes -> %d pushes\n",rb.calls-before);
+    expect("rate limited",rb.calls-before <= 5);
+
+    //对方的写同样推送
+    eiodpWriteAddr(pdev,20,8,data);
+    expect("remote write",wait_same(pServer,&ra,0,64));
+
+    //取消后不再推送
+    eiodpUnsubscribe(pdev,sa);
+    usleep(20000);
+    before = ra.calls;
+    eiodpConfigWrite(pServer,0,4,v);
+    usleep(50000);
+    expect("unsubscribed",ra.calls==before);
+
+    //超出范围的订阅被拒绝
+    int sc = eiodpSubscribe(pdev,IODP_CONFIGMEM_SIZE-8,16,0,on_push,&rc);
+    for(i=0;i<200 && rc.error==0;i++)usleep(1000);
+    expect("reject",sc>=0 && rc.error==1 && rc.calls==0);
+
+    //丢包链路：镜像仍然最终一致
+    LOOPIO_LINKCFG lossy = cfg;
+    lossy.droprate = 0.2;
+    lossy.seed = 7;
+    eIODP_TYPE *pdev2, *pServer2;
+    link_open(&cfg,&lossy,&pdev2,&pServer2);
+    eiodpSubscribe(pdev2,0,256,0,on_push,&rl);
+    unsigned char cur[256];
+    srand(5);
+    for(i=0;i<300;i++){
+        unsigned char x = rand();
+        eiodpConfigWrite(pServer2,rand()%256,1,&x);
+        usleep(300);
+    }
+    //最后一次变化的推送也可能丢失，再写一次触发检查
+    for(i=0;i<20 && !wait_same(pServer2,&rl,0,256);i++){
+        eiodpConfigRead(pServer2,0,1,cur);
+        eiodpConfigWrite(pServer2,0,1,cur);
+    }
+    expect("lossy converge",wait_same(pServer2,&rl,0,256));
+    //镜像可能先靠后面的变化推送一致，重新同步的整范围推送稍后才到
+    for(i=0;i<200 && rl.fulls<rl.lost;i++)usleep(5000);
+    printf("lossy: lost %d, full %d, calls %d\n",rl.lost,rl.fulls,rl.calls);
+    //第一次整范围推送本身也可能丢失，这时它的重新同步同样计为一次丢失
+    expect("lossy resync",rl.lost>0 && rl.fulls>=rl.lost);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
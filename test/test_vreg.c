@@ -0,0 +1,138 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//虚拟读范围：从端把几个地址范围映射到填充函数，主端读取时检查填充的次数与读到的值
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static uint32 tick_ms(void)
+{
+    struct timespec tv;
+    clock_gettime(CLOCK_MONOTONIC, &tv);
+    return (uint32)(tv.tv_sec*1000 + tv.tv_nsec/1000000);
+}
+
+//模拟传感器，每次填充值加一
+typedef struct
+{
+    volatile int fills;
+    int fail;
+}SENSOR;
+
+static int sensor_fill(void* ctx, unsigned short addr, unsigned short len, unsigned char* buf)
+{
+    SENSOR* s = (SENSOR*)ctx;
+    if(s->fail)return -1;
+    s->fills++;
+    memset(buf,s->fills,len);
+    return 0;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int got, int want)
+{
+    if(got!=want){
+        printf("%s: got %d, expect %d\n",name,got,want);
+        errorcnt++;
+    }
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    eiodpSetTickSource(pServer,tick_ms,1000);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    SENSOR live, cached;
+    memset(&live,0,sizeof(live));
+    memset(&cached,0,sizeof(cached));
+    int idLive = eiodpMapRead(pServer,100,8,sensor_fill,&live,0);
+    int idCached = eiodpMapRead(pServer,200,8,sensor_fill,&cached,50000);
+    expect("overlap rejected",eiodpMapRead(pServer,104,8,sensor_fill,&live,0),IODP_ERROR_PARAM);
+
+    unsigned char buf[64];
+    //不碰虚拟范围的读不填充
+    eiodpReadAddr(pdev,0,64,buf);
+    expect("unrelated read",live.fills+cached.fills,0);
+
+    //ttl为0，每次读都填充
+    eiodpReadAddr(pdev,96,8,buf);
+    expect("live fill 1",live.fills,1);
+    expect("live value 1",buf[4],1);
+    eiodpReadAddr(pdev,104,2,buf);
+    expect("live fill 2",live.fills,2);
+    expect("live value 2",buf[0],2);
+
+    //ttl之内读缓存
+    eiodpReadAddr(pdev,200,8,buf);
+    eiodpReadAddr(pdev,202,2,buf);
+    expect("cached fill",cached.fills,1);
+    expect("cached value",buf[0],1);
+    usleep(60000);
+    eiodpReadAddr(pdev,200,8,buf);
+    expect("cached expired",cached.fills,2);
+    expect("cached value 2",buf[7],2);
+    eiodpInvalidateRead(pServer,idCached);
+    eiodpReadAddr(pdev,200,8,buf);
+    expect("cached invalidated",cached.fills,3);
+
+    //多段读：两段碰到同一个范围只填充一次
+    unsigned char a[4], b[4], c[4];
+    eIODP_RANGE r[3];
+    r[0].addr = 100; r[0].len = 4; r[0].buf = a;
+    r[1].addr = 104; r[1].len = 4; r[1].buf = b;
+    r[2].addr = 300; r[2].len = 4; r[2].buf = c;
+    eiodpReadMulti(pdev,r,3);
+    expect("multi fill",live.fills,3);
+    expect("multi value",a[0]==3 && b[3]==3,1);
+
+    //填充失败时返回原来的值
+    live.fail = 1;
+    eiodpReadAddr(pdev,100,8,buf);
+    expect("fail keeps value",buf[0],3);
+
+    //取消后返回最后的值，不再填充
+    live.fail = 0;
+    eiodpUnmapRead(pServer,idLive);
+    eiodpReadAddr(pdev,100,8,buf);
+    expect("unmapped fill",live.fills,3);
+    expect("unmapped value",buf[0],3);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
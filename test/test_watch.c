@@ -0,0 +1,126 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//写入监视：从端监视几个地址范围，主端写入后检查回调的次数与范围
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+typedef struct
+{
+    volatile int calls;
+    volatile unsigned short addr;
+    volatile unsigned short len;
+    unsigned char value[4];
+}WATCHREC;
+
+static eIODP_TYPE* pServer;
+
+static void on_write(void* ctx, unsigned short addr, unsigned short len)
+{
+    WATCHREC* w = (WATCHREC*)ctx;
+    w->addr = addr;
+    w->len = len;
+    //回调时新值已经可见
+    eiodpConfigRead(pServer,addr,len<4?len:4,w->value);
+    w->calls++;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, WATCHREC* w, int calls, int addr, int len)
+{
+    if(w->calls!=calls || (calls && (w->addr!=addr || w->len!=len))){
+        printf("%s: calls=%d addr=%d len=%d, expect calls=%d addr=%d len=%d\n",
+                name,w->calls,w->addr,w->len,calls,addr,len);
+        errorcnt++;
+    }
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    WATCHREC wa, wb, wc;
+    memset(&wa,0,sizeof(wa));
+    memset(&wb,0,sizeof(wb));
+    memset(&wc,0,sizeof(wc));
+    int ida = eiodpWatch(pServer,10,4,on_write,&wa);     //一个寄存器
+    int idb = eiodpWatch(pServer,60,40,on_write,&wb);    //跨两个块
+    eiodpWatch(pServer,300,8,on_write,&wc);
+    unsigned char sync[1];
+    unsigned char data[64];
+    for(int i=0;i<64;i++)data[i]=i+1;
+
+    //覆盖监视a的一部分
+    eiodpWriteAddr(pdev,8,4,data);
+    eiodpReadAddr(pdev,0,1,sync);
+    expect("write 8..12",&wa,1,10,2);
+    if(wa.value[0]!=3 || wa.value[1]!=4){printf("value not visible in callback\n");errorcnt++;}
+    expect("write 8..12 b",&wb,0,0,0);
+
+    //不重叠的写不触发
+    eiodpWriteAddr(pdev,20,30,data);
+    eiodpReadAddr(pdev,0,1,sync);
+    expect("write 20..50",&wa,1,10,2);
+    expect("write 20..50 b",&wb,0,0,0);
+
+    //多段写同时碰到b的两处，只回调一次，范围覆盖两处
+    eIODP_RANGE r[3];
+    r[0].addr = 62; r[0].len = 2; r[0].buf = data;
+    r[1].addr = 90; r[1].len = 20; r[1].buf = data;
+    r[2].addr = 302; r[2].len = 1; r[2].buf = data;
+    eiodpWriteMulti(pdev,r,3);
+    eiodpReadAddr(pdev,0,1,sync);
+    expect("multi b",&wb,1,62,38);
+    expect("multi c",&wc,1,302,1);
+
+    //本端写不触发
+    eiodpConfigWrite(pServer,10,4,data);
+    expect("local write",&wa,1,10,2);
+
+    //取消后不再触发
+    eiodpUnwatch(pServer,ida);
+    eiodpUnwatch(pServer,idb);
+    eiodpWriteAddr(pdev,0,128,data);
+    eiodpReadAddr(pdev,0,1,sync);
+    expect("after unwatch a",&wa,1,10,2);
+    expect("after unwatch b",&wb,1,62,38);
+
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//写入器服务函数：比IODP_FUNCPKT_RET_LEN长的返回、reserve/commit、引用已有数据（分段写与合并写）、
+//越界报告与丢弃，检查返回的内容与顺序
+
+#define TABLE_LEN 1024
+static unsigned char table[TABLE_LEN];
+
+//参数：2字节偏移+2字节长度（大端），返回2字节长度+table中的数据（引用，不复制）
+int func_dump(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w){
+    if(arglen != 4)return -1;
+    uint16 off = (uint16)((arg[0]<<8)|arg[1]);
+    uint16 n = (uint16)((arg[2]<<8)|arg[3]);
+    if(off+n > TABLE_LEN)return -1;
+    unsigned char* p = eiodpWriterReserve(w,2);
+    if(p == NULL)return -1;
+    p[0] = (unsigned char)(n>>8);
+    p[1] = (unsigned char)n;
+    eiodpWriterCommit(w,2);
+    return eiodpWriterRef(w,&table[off],n);
+}
+
+//引用与复制交替，引用超过IODP_WRITER_MAXREF段后按复制写入
+int func_mixed(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w){
+    for(int i=0;i<IODP_WRITER_MAXREF+4;i++){
+        unsigned char mark = (unsigned char)(0xa0+i);
+        if(eiodpWriterAppend(w,&mark,1) < 0)return -1;
+        if(eiodpWriterRef(w,&table[i*10],10) < 0)return -1;
+    }
+    //参数原样跟在最后
+    return eiodpWriterAppend(w,arg,arglen);
+}
+
+static int ovf_reserve = 0, ovf_append = 0, ovf_ref = 0, ovf_remain = -1, ovf_flag = 0;
+
+//写满后报告越界，已经写入的部分照常返回
+int func_overflow(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w){
+    eiodpWriterRef(w,table,IODP_FUNC_RESP_MAX-8);
+    ovf_reserve = eiodpWriterReserve(w,9) == NULL;
+    ovf_append = eiodpWriterAppend(w,table,9);
+    ovf_ref = eiodpWriterRef(w,table,9);
+    ovf_remain = eiodpWriterRemain(w);
+    ovf_flag = w->overflow;
+    unsigned char* p = eiodpWriterReserve(w,8);
+    if(p == NULL)return -1;
+    memset(p,0x55,8);
+    //只提交一半
+    return eiodpWriterCommit(w,4);
+}
+
+//写入后失败，返回0字节
+int func_fail(const unsigned char* arg, uint16 arglen, eIODP_WRITER* w){
+    eiodpWriterAppend(w,arg,arglen);
+    return -1;
+}
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+static long elapsed_us(struct timespec* a, struct timespec* b)
+{
+    return (b->tv_sec-a->tv_sec)*1000000+(b->tv_nsec-a->tv_nsec)/1000;
+}
+
+static eIODP_TYPE* pServer;
+
+#if (IODP_OS==IODP_OS_NULL)
+typedef struct
+{
+    int done;
+    int status;
+    unsigned char* ret;
+    uint16 retcap;
+}CALL;
+
+static void on_ret(void* ctx, int status, unsigned char* data, int len)
+{
+    CALL* c = (CALL*)ctx;
+    if(status >= 0 && len > c->retcap)status = IODP_ERROR_RETSIZE;
+    else if(status >= 0)memcpy(c->ret,data,len);
+    c->status = status;
+    c->done = 1;
+}
+
+//无操作系统：单线程发出异步请求，同时处理两端直到返回
+static int call(eIODP_TYPE* pdev, uint16 code, uint16 argsize, const void* arg, unsigned char* ret, uint16 retcap)
+{
+    CALL c = {0,0,ret,retcap};
+    int r = eiodpFunctionAsync(pdev,code,argsize,(void*)arg,on_ret,&c);
+    if(r < 0)return r;
+    while(!c.done){
+        eiodp_recvProcessTask_nos(pServer);
+        eiodp_recvProcessTask_nos(pdev);
+    }
+    return c.status;
+}
+#else
+static int call(eIODP_TYPE* pdev, uint16 code, uint16 argsize, const void* arg, unsigned char* ret, uint16 retcap)
+{
+    unsigned char frame[IODP_FUNC_FRAMELEN(16)];
+    return eiodpFunctionEx(pdev,code,argsize,arg,ret,retcap,frame);
+}
+#endif
+
+static int dump(eIODP_TYPE* pdev, uint16 off, uint16 n, unsigned char* ret, uint16 retcap)
+{
+    unsigned char arg[4] = {(unsigned char)(off>>8),(unsigned char)off,(unsigned char)(n>>8),(unsigned char)n};
+    return call(pdev,0x600,4,arg,ret,retcap);
+}
+
+#define rounds 200
+
+static void run(eIODP_TYPE* pdev, const char* name)
+{
+    unsigned char ret[IODP_FUNC_RESP_MAX];
+
+    //比IODP_FUNCPKT_RET_LEN长的返回
+    int n = IODP_FUNC_RESP_MAX-2;
+    int r = dump(pdev,100,n,ret,sizeof(ret));
+    expect("dump",r == n+2 && ret[0] == (n>>8) && ret[1] == (n&0xff) && memcmp(&ret[2],&table[100],n) == 0);
+    r = dump(pdev,0,0,ret,sizeof(ret));
+    expect("dump empty",r == 2 && ret[0] == 0 && ret[1] == 0);
+    //调用者的缓存不够
+    expect("retcap",dump(pdev,0,300,ret,100) == IODP_ERROR_RETSIZE);
+#if (IODP_OS==IODP_OS_LINUX)
+    //eiodpFunction只接收IODP_FUNCPKT_RET_LEN
+    unsigned char arg[4] = {0,0,0x01,0x40};
+    expect("legacy",eiodpFunction(pdev,0x600,4,arg,ret) == IODP_ERROR_RETSIZE);
+    arg[2] = 0;
+    expect("legacy short",eiodpFunction(pdev,0x600,4,arg,ret) == 0x40+2 && memcmp(&ret[2],table,0x40) == 0);
+#endif
+
+    //顺序：标记、引用交替，最后为参数
+    unsigned char marg[16];
+    for(int i=0;i<16;i++)marg[i] = (unsigned char)(0xf0+i);
+    r = call(pdev,0x601,16,marg,ret,sizeof(ret));
+    int ok = (r == (IODP_WRITER_MAXREF+4)*11+16);
+    for(int i=0;ok && i<IODP_WRITER_MAXREF+4;i++){
+        ok = ret[i*11] == 0xa0+i && memcmp(&ret[i*11+1],&table[i*10],10) == 0;
+    }
+    expect("mixed",ok && memcmp(&ret[(IODP_WRITER_MAXREF+4)*11],marg,16) == 0);
+
+    //越界报告
+    r = call(pdev,0x602,0,NULL,ret,sizeof(ret));
+    expect("overflow",r == IODP_FUNC_RESP_MAX-4 && memcmp(ret,table,IODP_FUNC_RESP_MAX-8) == 0 &&
+                      ret[IODP_FUNC_RESP_MAX-8] == 0x55 && ret[IODP_FUNC_RESP_MAX-5] == 0x55);
+    expect("overflow report",ovf_reserve && ovf_append == IODP_ERROR_RETSIZE && ovf_ref == IODP_ERROR_RETSIZE &&
+                             ovf_remain == 8 && ovf_flag == 1);
+    r = call(pdev,0x603,16,marg,ret,sizeof(ret));
+    expect("fail",r == 0);
+
+    struct timespec ts0, ts1;
+    clock_gettime(CLOCK_MONOTONIC,&ts0);
+    for(int i=0;i<rounds;i++){
+        int r = dump(pdev,(uint16)(i%500),IODP_FUNC_RESP_MAX-2,ret,sizeof(ret));
+        if(r != IODP_FUNC_RESP_MAX){
+            expect("rounds",0);
+            break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC,&ts1);
+    printf("%s: %d dumps of %d bytes %ldus\n",name,rounds,IODP_FUNC_RESP_MAX,elapsed_us(&ts0,&ts1));
+}
+
+int main()
+{
+    for(int i=0;i<TABLE_LEN;i++)table[i] = (unsigned char)(i*31+7);
+
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+    expect("register",eiodpRegisterWriter(pServer,0x600,func_dump) == IODP_OK &&
+                      eiodpRegisterWriter(pServer,0x601,func_mixed) == IODP_OK &&
+                      eiodpRegisterWriter(pServer,0x602,func_overflow) == IODP_OK &&
+                      eiodpRegisterWriter(pServer,0x603,func_fail) == IODP_OK);
+    expect("null",eiodpRegisterWriter(pServer,0x604,NULL) == IODP_ERROR_PARAM);
+
+    //引用的数据先复制到输出帧
+    run(pdev,"gather");
+    //引用的数据分段写出，crc逐段累加
+    eiodpSetWritev(pServer,loopsendv);
+    run(pdev,"writev");
+
+    eiodp_deinit(pdev);
+    eiodp_deinit(pServer);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}
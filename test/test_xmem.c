@@ -0,0 +1,126 @@
+#include <stdio.h>
+
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <eiodp.h>
+#include <loopio.h>
+
+//扩展地址空间：32位地址读写分散在整个空间的数据，检查只分配写过的页、
+//没写过的页读出为0、低地址与配置空间重合、越界与页数上限
+
+#if (IODP_OS==IODP_OS_NULL)
+void* slaver(void* arg)
+{
+    eIODP_TYPE* pServer = (eIODP_TYPE*)arg;
+    while(1)
+    {
+        eiodp_recvProcessTask_nos(pServer);
+    }
+    return NULL;
+}
+#endif
+
+static int errorcnt = 0;
+
+static void expect(const char* name, int ok)
+{
+    if(!ok){
+        printf("%s fail\n",name);
+        errorcnt++;
+    }
+}
+
+static int allzero(const unsigned char* p, int n)
+{
+    for(int i=0;i<n;i++)if(p[i])return 0;
+    return 1;
+}
+
+int main()
+{
+    LOOPIO_LINKCFG cfg;
+    loopio_defcfg(&cfg, 0);
+#if (IODP_OS==IODP_OS_NULL)
+    cfg.readTimeout_us = 0;
+#endif
+
+    int fdMaster=0, fdServer=0;
+    if(loopopen(&cfg, &cfg, &fdMaster, &fdServer) != 0){
+        printf("loopopen error\n");
+        return 1;
+    }
+    eIODP_TYPE* pServer = eiodp_init(fdServer,loopread,loopsend);
+    eIODP_TYPE* pdev = eiodp_init(fdMaster,loopread,loopsend);
+#if (IODP_OS==IODP_OS_NULL)
+    pthread_t t1;
+    pthread_create(&t1,NULL,slaver,pServer);
+#endif
+
+    int i;
+    unsigned char data[256], buf[256];
+    for(i=0;i<256;i++)data[i]=i+1;
+
+    //分散在整个空间的写，只分配用到的页
+    uint32 addrs[] = {0x100000, 0x500010, IODP_XMEM_SIZE-256, 0x20000};
+    int n = sizeof(addrs)/sizeof(addrs[0]);
+    for(i=0;i<n;i++)eiodpWriteAddr32(pdev,addrs[i],256,data);
+    int ok = 1;
+    for(i=0;i<n;i++){
+        memset(buf,0,sizeof(buf));
+        if(eiodpReadAddr32(pdev,addrs[i],256,buf)!=256 || memcmp(buf,data,256)!=0)ok = 0;
+    }
+    expect("sparse rw",ok);
+    expect("pages",eiodpXmemPages(pServer)==(uint32)n);
+
+    //跨页写分配两页
+    eiodpWriteAddr32(pdev,0x300000-100,200,data);
+    eiodpReadAddr32(pdev,0x300000-100,200,buf);
+    expect("cross page",memcmp(buf,data,200)==0 && eiodpXmemPages(pServer)==(uint32)n+2);
+
+    //没有写过的页读出为0，并且不分配
+    uint32 pages = eiodpXmemPages(pServer);
+    memset(buf,0xff,sizeof(buf));
+    expect("untouched",eiodpReadAddr32(pdev,0x700000,256,buf)==256 && allzero(buf,256));
+    memset(buf,0xff,sizeof(buf));
+    expect("untouched tail",eiodpReadAddr32(pdev,0x100000+256,128,buf)==128 && allzero(buf,128));
+    expect("no alloc on read",eiodpXmemPages(pServer)==pages);
+
+    //低地址就是配置空间：16位写、32位读，32位写、16位读
+    unsigned char v[4] = {0x11,0x22,0x33,0x44};
+    eiodpWriteAddr(pdev,10,4,v);
+    eiodpReadAddr32(pdev,10,4,buf);
+    expect("alias 16->32",memcmp(buf,v,4)==0);
+    eiodpWriteAddr32(pdev,20,4,v);
+    eiodpReadAddr(pdev,20,4,buf);
+    expect("alias 32->16",memcmp(buf,v,4)==0);
+
+    //跨过配置空间结尾的读写
+    eiodpWriteAddr32(pdev,IODP_CONFIGMEM_SIZE-8,16,data);
+    eiodpReadAddr32(pdev,IODP_CONFIGMEM_SIZE-8,16,buf);
+    expect("straddle",memcmp(buf,data,16)==0);
+    eiodpConfigRead(pServer,IODP_CONFIGMEM_SIZE-8,8,buf);
+    expect("straddle configmem",memcmp(buf,data,8)==0);
+
+    //越界
+    expect("out of range",eiodpReadAddr32(pdev,IODP_XMEM_SIZE,4,buf)==IODP_ERROR_PKT);
+    expect("too long",eiodpReadAddr32(pdev,0x100000,IODP_RETURN_BUFFER,buf)==IODP_ERROR_PARAM);
+
+    //本端接口与页数上限
+    int full = 0;
+    for(i=0;i<IODP_XMEM_MAXPAGES+16;i++){
+        if(eiodpXmemWrite(pServer,(uint32)i*IODP_XMEM_PAGE+IODP_XMEM_PAGE/2,1,v)==IODP_ERROR_HEAPOVER)full++;
+    }
+    expect("page limit",eiodpXmemPages(pServer)==IODP_XMEM_MAXPAGES && full>0);
+    eiodpXmemRead(pServer,0x100000,256,buf);
+    expect("local read",memcmp(buf,data,256)==0);
+
+    printf("%lu byte space, %u pages of %d bytes allocated\n",
+            (unsigned long)IODP_XMEM_SIZE,eiodpXmemPages(pServer),IODP_XMEM_PAGE);
+    printf("errorcnt=%d\n",errorcnt);
+    return errorcnt ? 1 : 0;
+}